@@ -11,24 +11,39 @@ Redistribution and use in source and binary forms, with or without modification,
 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "NetworkInterface.h"
+#include "netstream/shmstream.h"
 #include <sstream>
 
 namespace Booksim
 {
 
+    NetworkInterface::NetworkInterface()
+        : m_channel(NULL), m_quantum(1), m_lookahead(1), m_sync_cycles(0), m_sync_cycle(0)
+    {
+    }
+
     /**
-     * Establish this as a server over a socket and wait for the client (TrafficManager)
-     * to connect.
+     * Establish this as a server over a socket (or a shared memory segment if
+     * in_shm_name is given) and wait for the client (TrafficManager) to connect.
      */
-    int NetworkInterface::Init(char * in_socket_path) {
-        SocketStream listenSocket;
-        listenSocket.socket_path = in_socket_path;
+    int NetworkInterface::Init(char * in_socket_path, char * in_shm_name) {
+        if(in_shm_name && in_shm_name[0]) {
+            ShmStream * shm = new ShmStream();
+            if(shm->listen(in_shm_name) < 0 || shm->accept() < 0) {
+                delete shm;
+                return -1;
+            }
+            m_channel = shm;
+        } else {
+            SocketStream listenSocket;
+            listenSocket.socket_path = in_socket_path;
 
-        if(listenSocket.listen(in_socket_path) < 0) {
-            return -1;
-    }
+            if(listenSocket.listen(in_socket_path) < 0) {
+                return -1;
+            }
 
-        m_channel = listenSocket.accept();
+            m_channel = listenSocket.accept();
+        }
 
         // Initialize client
         InitializeReqMsg req;
@@ -43,12 +58,26 @@ namespace Booksim
      * destination (based on your network simulator), indicate that all packets have
      * been created for the current cycle (STEP_REQ), or end the simulation.
      *
+     * A SYNC_REQ instead covers a whole quantum: the following calls release its
+     * injections cycle by cycle without touching the socket, and the call after
+     * its last cycle answers with every ejection before reading the next request.
+     *
      * @return 0 if the simulation is to continue, 1 if the simulation is to end.
      */
     int NetworkInterface::Step(queue<InjectReqMsg> * Injection, queue<EjectResMsg> * Ejection){
         bool process_more = true;
         StreamMessage *msg = NULL;
-        
+
+        if(m_sync_cycles > 0) {
+            // Ejections of the cycle just simulated
+            CollectEjections(Ejection, m_sync_cycle - 1);
+            if(m_sync_cycle < m_sync_cycles) {
+                ReleaseInjections(Injection);
+                return 0;
+            }
+            FinishSync();
+        }
+
     //	InjectResMsg res1;
     //	*m_channel << res1;
         while (process_more && m_channel && m_channel->isAlive())
@@ -82,16 +111,7 @@ namespace Booksim
                 //     << " coType " << req->coType
                 //     << " address " << req->address
                 //     << endl;
-                int type = req->msgType;
-                int cotype = req->coType;
-                if(type == REQUEST && (cotype == WRITE || cotype == READ || cotype == PUTC || cotype == PUTD)) {
-                    req->cl = 0;        
-                } else if(type == RESPONSE && cotype == DATA) {
-                    req->cl = 1;
-                } else {
-                    assert((type == REQUEST && cotype == INV) || (type == RESPONSE && ( cotype == ACK || cotype == WB_ACK || cotype == UNBLOCK)));
-                    req->cl = 2;
-                }
+                Classify(*req);
                 Injection->push(*req);
 
                 // acknowledge receipt of packet to TrafficManager
@@ -123,6 +143,16 @@ namespace Booksim
 
                 break;
             }
+            case SYNC_REQ:
+            {
+                StartSync((SyncReqMsg*) msg);
+                ReleaseInjections(Injection);
+
+                // the first cycle of the quantum runs now
+                process_more = false;
+
+                break;
+            }
             case QUIT_REQ:
             {
                 // acknowledge quit
@@ -144,4 +174,104 @@ namespace Booksim
 
         return 0;
     }
+
+    void NetworkInterface::SetQuantum(int quantum, int lookahead) {
+        assert(quantum > 0 && lookahead > 0);
+        m_quantum = quantum;
+        m_lookahead = lookahead;
+    }
+
+    void NetworkInterface::Classify(InjectReqMsg & req) const {
+        int type = req.msgType;
+        int cotype = req.coType;
+        if(type == REQUEST && (cotype == WRITE || cotype == READ || cotype == PUTC || cotype == PUTD)) {
+            req.cl = 0;
+        } else if(type == RESPONSE && cotype == DATA) {
+            req.cl = 1;
+        } else {
+            assert((type == REQUEST && cotype == INV) || (type == RESPONSE && ( cotype == ACK || cotype == WB_ACK || cotype == UNBLOCK)));
+            req.cl = 2;
+        }
+    }
+
+    void NetworkInterface::StartSync(SyncReqMsg * req) {
+        if((req->cycles < 1) || (req->cycles > m_quantum)) {
+            cout << "Error: SynFull sync request for " << req->cycles
+                 << " cycles exceeds the quantum (" << m_quantum << ")." << endl;
+            exit(-1);
+        }
+        if((req->count < 0) ||
+           ((size_t)req->size != sizeof(SyncReqMsg) + req->count * sizeof(InjectRecord))) {
+            cout << "Error: Malformed SynFull sync request." << endl;
+            exit(-1);
+        }
+        m_sync_cycles = req->cycles;
+        m_sync_cycle = 0;
+        if((int)m_sync_injections.size() < m_sync_cycles) {
+            m_sync_injections.resize(m_sync_cycles);
+        }
+        InjectRecord const * records = req->records();
+        for(int i = 0; i < req->count; ++i) {
+            InjectRecord const & r = records[i];
+            if((r.offset < 0) || (r.offset >= m_sync_cycles)) {
+                cout << "Error: SynFull injection at cycle " << r.offset
+                     << " is outside the quantum." << endl;
+                exit(-1);
+            }
+            InjectReqMsg inj;
+            inj.source = r.source;
+            inj.dest = r.dest;
+            inj.id = r.id;
+            inj.packetSize = r.packetSize;
+            inj.network = r.network;
+            inj.cl = r.cl;
+            inj.miss_pred = r.miss_pred;
+            inj.msgType = r.msgType;
+            inj.coType = r.coType;
+            inj.address = r.address;
+            Classify(inj);
+            m_sync_injections[r.offset].push_back(inj);
+        }
+    }
+
+    void NetworkInterface::ReleaseInjections(queue<InjectReqMsg> * Injection) {
+        vector<InjectReqMsg> & cycle = m_sync_injections[m_sync_cycle];
+        for(size_t i = 0; i < cycle.size(); ++i) {
+            Injection->push(cycle[i]);
+        }
+        cycle.clear();
+        ++m_sync_cycle;
+    }
+
+    void NetworkInterface::CollectEjections(queue<EjectResMsg> * Ejection, int offset) {
+        while(!Ejection->empty()) {
+            EjectResMsg const & ej = Ejection->front();
+            EjectRecord r;
+            r.offset = offset;
+            r.id = ej.id;
+            r.source = ej.source;
+            r.dest = ej.dest;
+            r.packetSize = ej.packetSize;
+            r.network = ej.network;
+            r.cl = ej.cl;
+            r.miss_pred = ej.miss_pred;
+            m_sync_ejections.push_back(r);
+            Ejection->pop();
+        }
+    }
+
+    void NetworkInterface::FinishSync() {
+        SyncResMsg * res = SyncResMsg::create(m_sync_ejections.size());
+        res->cycles = m_sync_cycles;
+        res->quantum = m_quantum;
+        res->lookahead = m_lookahead;
+        if(!m_sync_ejections.empty()) {
+            memcpy(res->records(), &m_sync_ejections[0], m_sync_ejections.size() * sizeof(EjectRecord));
+        }
+        *m_channel << *res;
+        StreamMessage::destroy(res);
+        m_sync_ejections.clear();
+        m_sync_cycles = 0;
+        m_sync_cycle = 0;
+    }
 } // namespace Booksim
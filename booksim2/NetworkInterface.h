@@ -17,6 +17,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "netstream/messages.h"
 #include "booksim.hpp"
 #include <queue>
+#include <vector>
 
 namespace Booksim
 {
@@ -40,11 +41,28 @@ namespace Booksim
 
     class NetworkInterface {
     public:
-        int Init(char * in_socket_path);
+        NetworkInterface();
+        int Init(char * in_socket_path, char * in_shm_name = NULL);
         int Step(queue<InjectReqMsg> * Injection, queue<EjectResMsg> * Ejection);
+        // Largest number of cycles a SYNC_REQ may advance; the lookahead is
+        // the minimum network latency, reported to the client.
+        void SetQuantum(int quantum, int lookahead);
     //	void ReqStepMsg(); // is it spare?
     private:
+        void Classify(InjectReqMsg & req) const;
+        void StartSync(SyncReqMsg * req);
+        void ReleaseInjections(queue<InjectReqMsg> * Injection);
+        void CollectEjections(queue<EjectResMsg> * Ejection, int offset);
+        void FinishSync();
+
         SocketStream* m_channel;
+        int m_quantum;
+        int m_lookahead;
+        // Quantum in progress (m_sync_cycles == 0 if none)
+        int m_sync_cycles;
+        int m_sync_cycle;
+        vector<vector<InjectReqMsg> > m_sync_injections;
+        vector<EjectRecord> m_sync_ejections;
     };
 } // namespace Booksim
 #endif
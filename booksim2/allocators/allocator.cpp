@@ -41,6 +41,9 @@
 #include "selalloc.hpp"
 #include "separable_input_first.hpp"
 #include "separable_output_first.hpp"
+#include "bit_separable_input_first.hpp"
+#include "bit_islip.hpp"
+#include "bit_wavefront.hpp"
 
 namespace Booksim
 {
@@ -471,6 +474,20 @@ namespace Booksim
         string arb_type = param_str.empty() ? (config ? config->GetStr("arb_type") : "round_robin") : param_str;
         a = new SeparableOutputFirstAllocator( parent, name, inputs, outputs,
                            arb_type );
+      } else if ( alloc_name == "bit_islip" ) {
+        int iters = param_str.empty() ? (config ? config->GetInt("alloc_iters") : 1) : atoi(param_str.c_str());
+        a = new iSLIP_Bit( parent, name, inputs, outputs, iters );
+      } else if ( alloc_name == "bit_wavefront" ) {
+        a = new BitWavefront( parent, name, inputs, outputs );
+      } else if ( alloc_name == "bit_rr_wavefront" ) {
+        a = new BitWavefront( parent, name, inputs, outputs, true );
+      } else if (alloc_name == "bit_separable_input_first") {
+        string arb_type = param_str.empty() ? (config ? config->GetStr("arb_type") : "round_robin") : param_str;
+        if ( arb_type != "round_robin" ) {
+          cout << "Error: bit_separable_input_first only supports round_robin arbiters." << endl;
+          exit(-1);
+        }
+        a = new BitSeparableInputFirstAllocator( parent, name, inputs, outputs );
       }
 
     //==================================================
@@ -0,0 +1,101 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "booksim.hpp"
+
+#include "bit_islip.hpp"
+
+namespace Booksim
+{
+
+    iSLIP_Bit::iSLIP_Bit( Module *parent, const string& name,
+                          int inputs, int outputs, int iters ) :
+      BitAllocator( parent, name, inputs, outputs ),
+      _iSLIP_iter(iters)
+    {
+      _gptrs.resize(_outputs, 0);
+      _aptrs.resize(_inputs, 0);
+      _free_in.resize(_out_words, 0);
+      _granted.resize(_inputs * _in_words, 0);
+      _granted_occ.resize(_out_words, 0);
+    }
+
+    void iSLIP_Bit::Allocate( )
+    {
+      // Only the inputs with requests can be granted
+      for ( int w = 0; w < _out_words; ++w ) {
+        _free_in[w] = _in_occ[w];
+      }
+      _ForEach(&_in_occ[0], _out_words, [this]( int input ) {
+        if ( _inmatch[input] != -1 ) {
+          _Reset(&_free_in[0], input);
+        }
+      });
+
+      for ( int iter = 0; iter < _iSLIP_iter; ++iter ) {
+        // Grant phase: each free output grants the first free input from
+        // its pointer on
+        _ForEach(&_out_occ[0], _in_words, [this]( int output ) {
+          if ( _outmatch[output] != -1 ) {
+            return;
+          }
+          int const input = _FindFrom(_Column(output), &_free_in[0],
+                                      _inputs, _gptrs[output]);
+          if ( input >= 0 ) {
+            _Set(&_granted[input * _in_words], output);
+            _Set(&_granted_occ[0], input);
+          }
+        });
+
+        // Accept phase: each input accepts the first grant from its
+        // pointer on
+        _ForEach(&_granted_occ[0], _out_words, [this, iter]( int input ) {
+          tWord * const granted = &_granted[input * _in_words];
+          int const output = _FindFrom(granted, _outputs, _aptrs[input]);
+          assert(output >= 0);
+
+          _inmatch[input]   = output;
+          _outmatch[output] = input;
+          _Reset(&_free_in[0], input);
+
+          // Only update pointers if accepted during the 1st iteration
+          if ( iter == 0 ) {
+            _gptrs[output] = ( input + 1 ) % _inputs;
+            _aptrs[input]  = ( output + 1 ) % _outputs;
+          }
+
+          for ( int w = 0; w < _in_words; ++w ) {
+            granted[w] = 0;
+          }
+        });
+        for ( int w = 0; w < _out_words; ++w ) {
+          _granted_occ[w] = 0;
+        }
+      }
+    }
+} // namespace Booksim
@@ -0,0 +1,59 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef _BIT_ISLIP_HPP_
+#define _BIT_ISLIP_HPP_
+
+#include <vector>
+
+#include "bitalloc.hpp"
+
+namespace Booksim
+{
+
+    // iSLIP on packed request bitmaps, with the same grants as iSLIP_Sparse
+    class iSLIP_Bit : public BitAllocator {
+      int _iSLIP_iter;
+
+      vector<int> _gptrs;
+      vector<int> _aptrs;
+
+      // Unmatched inputs, and outputs granting each input
+      vector<tWord> _free_in;
+      vector<tWord> _granted;
+      vector<tWord> _granted_occ;
+
+    public:
+      iSLIP_Bit( Module *parent, const string& name,
+                 int inputs, int outputs, int iters );
+
+      void Allocate( );
+    };
+} // namespace Booksim
+
+#endif
@@ -0,0 +1,137 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// ----------------------------------------------------------------------
+//
+//  BitSeparableInputFirstAllocator: Separable Input-First Allocator on
+//  packed request bitmaps
+//
+// ----------------------------------------------------------------------
+
+#include "bit_separable_input_first.hpp"
+
+#include "booksim.hpp"
+
+#include <cassert>
+
+namespace Booksim
+{
+
+    BitSeparableInputFirstAllocator::
+    BitSeparableInputFirstAllocator( Module* parent, const string& name,
+                                     int inputs, int outputs )
+      : BitAllocator( parent, name, inputs, outputs )
+    {
+      _in_ptr.resize(_inputs, 0);
+      _out_ptr.resize(_outputs, 0);
+      _grant.resize(_outputs * _out_words, 0);
+      _grant_occ.resize(_in_words, 0);
+    }
+
+    // Round-robin arbitration among the requests of an input: highest
+    // in_pri first, then the first output from the pointer on
+    int BitSeparableInputFirstAllocator::_PickOutput( int input ) const
+    {
+      tWord const * const row = _Row(input);
+      if ( _same_pri ) {
+        return _FindFrom(row, _outputs, _in_ptr[input]);
+      }
+      int best = -1;
+      int best_pri = 0;
+      int output = _in_ptr[input];
+      for ( int i = 0; i < _outputs; ++i ) {
+        if ( _Test(row, output) ) {
+          int const pri = _request[input * _outputs + output].in_pri;
+          if ( ( best < 0 ) || ( pri > best_pri ) ) {
+            best = output;
+            best_pri = pri;
+          }
+        }
+        if ( ++output == _outputs ) {
+          output = 0;
+        }
+      }
+      return best;
+    }
+
+    // Same for the inputs granted by an output, using out_pri
+    int BitSeparableInputFirstAllocator::_PickInput( int output ) const
+    {
+      tWord const * const column = &_grant[output * _out_words];
+      if ( _same_pri ) {
+        return _FindFrom(column, _inputs, _out_ptr[output]);
+      }
+      int best = -1;
+      int best_pri = 0;
+      int input = _out_ptr[output];
+      for ( int i = 0; i < _inputs; ++i ) {
+        if ( _Test(column, input) ) {
+          int const pri = _request[input * _outputs + output].out_pri;
+          if ( ( best < 0 ) || ( pri > best_pri ) ) {
+            best = input;
+            best_pri = pri;
+          }
+        }
+        if ( ++input == _inputs ) {
+          input = 0;
+        }
+      }
+      return best;
+    }
+
+    void BitSeparableInputFirstAllocator::Allocate() {
+
+      // Execute the input arbiters and propagate the grants to the
+      // output arbiters.
+      _ForEach(&_in_occ[0], _out_words, [this]( int input ) {
+        int const output = _PickOutput(input);
+        assert(output > -1);
+        _Set(&_grant[output * _out_words], input);
+        _Set(&_grant_occ[0], output);
+      });
+
+      // Execute the output arbiters.
+      _ForEach(&_grant_occ[0], _in_words, [this]( int output ) {
+        int const input = _PickInput(output);
+        assert(input > -1);
+        assert((_inmatch[input] == -1) && (_outmatch[output] == -1));
+
+        _inmatch[input] = output ;
+        _outmatch[output] = input ;
+        _in_ptr[input] = ( output + 1 ) % _outputs;
+        _out_ptr[output] = ( input + 1 ) % _inputs;
+
+        for ( int w = 0; w < _out_words; ++w ) {
+          _grant[output * _out_words + w] = 0;
+        }
+      });
+      for ( int w = 0; w < _in_words; ++w ) {
+        _grant_occ[w] = 0;
+      }
+    }
+} // namespace Booksim
@@ -0,0 +1,70 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+// ----------------------------------------------------------------------
+//
+//  BitSeparableInputFirstAllocator: Separable Input-First Allocator on
+//  packed request bitmaps. Grants are the same as the ones of
+//  SeparableInputFirstAllocator with round-robin arbiters.
+//
+// ----------------------------------------------------------------------
+
+#ifndef _BIT_SEPARABLE_INPUT_FIRST_HPP_
+#define _BIT_SEPARABLE_INPUT_FIRST_HPP_
+
+#include <vector>
+
+#include "bitalloc.hpp"
+
+namespace Booksim
+{
+
+    class BitSeparableInputFirstAllocator : public BitAllocator {
+
+      // Round-robin pointers of the input and output arbiters
+      vector<int> _in_ptr;
+      vector<int> _out_ptr;
+
+      // Inputs whose arbiter picked each output, and outputs picked
+      vector<tWord> _grant;
+      vector<tWord> _grant_occ;
+
+      int _PickInput( int output ) const;
+      int _PickOutput( int input ) const;
+
+    public:
+
+      BitSeparableInputFirstAllocator( Module* parent, const string& name,
+                                       int inputs, int outputs );
+
+      virtual void Allocate() ;
+
+    } ;
+} // namespace Booksim
+
+#endif
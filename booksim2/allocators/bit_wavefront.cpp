@@ -0,0 +1,161 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/*bit_wavefront.cpp
+ *
+ *The wave front allocator on packed request bitmaps
+ *
+ */
+#include "booksim.hpp"
+
+#include <algorithm>
+
+#include "bit_wavefront.hpp"
+
+namespace Booksim
+{
+
+    BitWavefront::BitWavefront( Module *parent, const string& name,
+                                int inputs, int outputs, bool skip_diags ) :
+      BitAllocator( parent, name, inputs, outputs ),
+      _last_in(-1), _last_out(-1), _skip_diags(skip_diags),
+      _square(max(inputs, outputs)), _pri(0), _num_requests(0)
+    {
+      _free_in.resize(_out_words, 0);
+      _free_out.resize(_in_words, 0);
+    }
+
+    void BitWavefront::AddRequest( int in, int out, int label,
+                                   int in_pri, int out_pri )
+    {
+      BitAllocator::AddRequest(in, out, label, in_pri, out_pri);
+      pair<int, int> const priority(out_pri, in_pri);
+      if(_num_requests == 0) {
+        _first_priority = priority;
+      } else if(_priorities.empty() && (priority != _first_priority)) {
+        _priorities.insert(_first_priority);
+      }
+      if(!_priorities.empty()) {
+        _priorities.insert(priority);
+      }
+      _num_requests++;
+      _last_in = in;
+      _last_out = out;
+    }
+
+    void BitWavefront::_Sweep( pair<int, int> const * pri, int & first_diag )
+    {
+      for ( int p = 0; p < _square; ++p ) {
+        int const diag = ( _pri + p ) % _square;
+        // The cells of a diagonal do not share inputs or outputs, so only
+        // the output order matters for first_diag
+        for ( int w = 0; w < _in_words; ++w ) {
+          tWord word = _free_out[w];
+          while ( word ) {
+            int const output = w * _word_bits + __builtin_ctzll(word);
+            word &= word - 1;
+            int const input = ( diag + ( _square - output ) ) % _square;
+            if ( ( input < _inputs ) && _Test( &_free_in[0], input ) &&
+                 _Test( _Row( input ), output ) &&
+                 ( !pri ||
+                   ( ( _request[input * _outputs + output].in_pri == pri->second ) &&
+                     ( _request[input * _outputs + output].out_pri == pri->first ) ) ) ) {
+              // Grant!
+              _inmatch[input] = output;
+              _outmatch[output] = input;
+              _Reset( &_free_in[0], input );
+              _Reset( &_free_out[0], output );
+              if(first_diag < 0) {
+                first_diag = input + output;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    void BitWavefront::Allocate( )
+    {
+
+      int first_diag = -1;
+
+      if(_num_requests == 0)
+
+        // bypass allocator completely if there were no requests
+        return;
+
+      if(_num_requests == 1) {
+
+        // if we only had a single request, we can immediately grant it
+        _inmatch[_last_in] = _last_out;
+        _outmatch[_last_out] = _last_in;
+        first_diag = _last_in + _last_out;
+
+      } else {
+
+        // otherwise we have to loop through the diagonals of request matrix,
+        // only looking at the free inputs and outputs with requests
+        for ( int w = 0; w < _out_words; ++w ) {
+          _free_in[w] = _in_occ[w];
+        }
+        for ( int w = 0; w < _in_words; ++w ) {
+          _free_out[w] = _out_occ[w];
+        }
+        _ForEach(&_in_occ[0], _out_words, [this]( int input ) {
+          if ( _inmatch[input] != -1 ) {
+            _Reset( &_free_in[0], input );
+          }
+        });
+        _ForEach(&_out_occ[0], _in_words, [this]( int output ) {
+          if ( _outmatch[output] != -1 ) {
+            _Reset( &_free_out[0], output );
+          }
+        });
+
+        if(_priorities.empty()) {
+          _Sweep(NULL, first_diag);
+        } else {
+          for(set<pair<int, int> >::const_reverse_iterator iter =
+                _priorities.rbegin();
+              iter != _priorities.rend(); ++iter) {
+            _Sweep(&*iter, first_diag);
+          }
+        }
+      }
+
+      _num_requests = 0;
+      _last_in = -1;
+      _last_out = -1;
+      _priorities.clear();
+
+      assert(first_diag >= 0);
+
+      // Round-robin the priority diagonal
+      _pri = ( ( _skip_diags ? first_diag : _pri ) + 1 ) % _square;
+    }
+} // namespace Booksim
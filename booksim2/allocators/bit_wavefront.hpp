@@ -0,0 +1,75 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef _BIT_WAVEFRONT_HPP_
+#define _BIT_WAVEFRONT_HPP_
+
+#include <set>
+#include <vector>
+
+#include "bitalloc.hpp"
+
+namespace Booksim
+{
+
+    // Wavefront allocator on packed request bitmaps, with the same grants
+    // as Wavefront
+    class BitWavefront : public BitAllocator {
+
+    private:
+      int _last_in;
+      int _last_out;
+      // (out_pri, in_pri) of the requests since the last Allocate(); only
+      // filled once two of them differ
+      pair<int, int> _first_priority;
+      set<pair<int, int> > _priorities;
+      bool _skip_diags;
+
+      // Unmatched inputs and outputs
+      vector<tWord> _free_in;
+      vector<tWord> _free_out;
+
+      // Grants the requests with priorities pri (all of them if NULL)
+      void _Sweep( pair<int, int> const * pri, int & first_diag );
+
+    protected:
+      int _square;
+      int _pri;
+      int _num_requests;
+
+    public:
+      BitWavefront( Module *parent, const string& name,
+                    int inputs, int outputs, bool skip_diags = false );
+
+      virtual void AddRequest( int in, int out, int label = 1,
+                               int in_pri = 0, int out_pri = 0 );
+      virtual void Allocate( );
+    };
+} // namespace Booksim
+
+#endif
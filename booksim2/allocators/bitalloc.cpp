@@ -0,0 +1,246 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/*bitalloc.cpp
+ *
+ *Base class of the bit-matrix allocators
+ *
+ */
+
+#include "booksim.hpp"
+#include <iostream>
+#include <sstream>
+#include <cassert>
+
+#include "bitalloc.hpp"
+
+namespace Booksim
+{
+
+    BitAllocator::BitAllocator( Module *parent, const string& name,
+                                int inputs, int outputs ) :
+      Allocator( parent, name, inputs, outputs ),
+      _in_words( ( outputs + _word_bits - 1 ) / _word_bits ),
+      _out_words( ( inputs + _word_bits - 1 ) / _word_bits ),
+      _num_reqs( 0 ), _same_pri( true ), _first_in_pri( 0 ), _first_out_pri( 0 )
+    {
+      _in_req.resize(_inputs * _in_words, 0);
+      _out_req.resize(_outputs * _out_words, 0);
+      _in_occ.resize(_out_words, 0);
+      _out_occ.resize(_in_words, 0);
+      _in_count.resize(_inputs, 0);
+      _out_count.resize(_outputs, 0);
+      _request.resize(_inputs * _outputs);
+    }
+
+    int BitAllocator::_FindFrom( tWord const * bits, int size, int start )
+    {
+      int const words = ( size + _word_bits - 1 ) / _word_bits;
+      int w = start / _word_bits;
+      tWord word = bits[w] & ( ~0ULL << ( start % _word_bits ) );
+      // The last pass looks at the bits of the first word below start
+      for ( int i = 0; i <= words; ++i ) {
+        if ( word ) {
+          return w * _word_bits + __builtin_ctzll(word);
+        }
+        if ( ++w == words ) {
+          w = 0;
+        }
+        word = bits[w];
+      }
+      return -1;
+    }
+
+    int BitAllocator::_FindFrom( tWord const * bits, tWord const * mask,
+                                 int size, int start )
+    {
+      int const words = ( size + _word_bits - 1 ) / _word_bits;
+      int w = start / _word_bits;
+      tWord word = bits[w] & mask[w] & ( ~0ULL << ( start % _word_bits ) );
+      for ( int i = 0; i <= words; ++i ) {
+        if ( word ) {
+          return w * _word_bits + __builtin_ctzll(word);
+        }
+        if ( ++w == words ) {
+          w = 0;
+        }
+        word = bits[w] & mask[w];
+      }
+      return -1;
+    }
+
+    void BitAllocator::Clear( )
+    {
+      if ( _num_reqs > 0 ) {
+        for ( int w = 0; w < _out_words; ++w ) {
+          tWord word = _in_occ[w];
+          while ( word ) {
+            int const in = w * _word_bits + __builtin_ctzll(word);
+            word &= word - 1;
+            for ( int i = 0; i < _in_words; ++i ) {
+              _in_req[in * _in_words + i] = 0;
+            }
+            _in_count[in] = 0;
+          }
+          _in_occ[w] = 0;
+        }
+        for ( int w = 0; w < _in_words; ++w ) {
+          tWord word = _out_occ[w];
+          while ( word ) {
+            int const out = w * _word_bits + __builtin_ctzll(word);
+            word &= word - 1;
+            for ( int i = 0; i < _out_words; ++i ) {
+              _out_req[out * _out_words + i] = 0;
+            }
+            _out_count[out] = 0;
+          }
+          _out_occ[w] = 0;
+        }
+        _num_reqs = 0;
+      }
+      _same_pri = true;
+      Allocator::Clear();
+    }
+
+    int BitAllocator::ReadRequest( int in, int out ) const
+    {
+      assert( ( in >= 0 ) && ( in < _inputs ) );
+      assert( ( out >= 0 ) && ( out < _outputs ) );
+
+      if ( !_Test( _Row( in ), out ) ) {
+        return -1;
+      }
+      return _request[in * _outputs + out].label;
+    }
+
+    bool BitAllocator::ReadRequest( sRequest &req, int in, int out ) const
+    {
+      assert( ( in >= 0 ) && ( in < _inputs ) );
+      assert( ( out >= 0 ) && ( out < _outputs ) );
+
+      if ( !_Test( _Row( in ), out ) ) {
+        return false;
+      }
+      req = _request[in * _outputs + out];
+      return true;
+    }
+
+    void BitAllocator::AddRequest( int in, int out, int label,
+                                   int in_pri, int out_pri )
+    {
+      Allocator::AddRequest(in, out, label, in_pri, out_pri);
+      assert( !_Test( _Row( in ), out ) );
+
+      if ( _num_reqs == 0 ) {
+        _first_in_pri = in_pri;
+        _first_out_pri = out_pri;
+      } else if ( ( in_pri != _first_in_pri ) || ( out_pri != _first_out_pri ) ) {
+        _same_pri = false;
+      }
+      ++_num_reqs;
+
+      _Set( &_in_req[in * _in_words], out );
+      _Set( &_out_req[out * _out_words], in );
+      if ( _in_count[in]++ == 0 ) {
+        _Set( &_in_occ[0], in );
+      }
+      if ( _out_count[out]++ == 0 ) {
+        _Set( &_out_occ[0], out );
+      }
+
+      sRequest & req = _request[in * _outputs + out];
+      req.port    = out;
+      req.label   = label;
+      req.in_pri  = in_pri;
+      req.out_pri = out_pri;
+    }
+
+    void BitAllocator::RemoveRequest( int in, int out, int label )
+    {
+      assert( ( in >= 0 ) && ( in < _inputs ) );
+      assert( ( out >= 0 ) && ( out < _outputs ) );
+      assert( _Test( _Row( in ), out ) );
+      assert( _request[in * _outputs + out].label == label );
+
+      _Reset( &_in_req[in * _in_words], out );
+      _Reset( &_out_req[out * _out_words], in );
+      if ( --_in_count[in] == 0 ) {
+        _Reset( &_in_occ[0], in );
+      }
+      if ( --_out_count[out] == 0 ) {
+        _Reset( &_out_occ[0], out );
+      }
+    }
+
+    bool BitAllocator::InputHasRequests( int in ) const
+    {
+      return _in_count[in] > 0;
+    }
+
+    bool BitAllocator::OutputHasRequests( int out ) const
+    {
+      return _out_count[out] > 0;
+    }
+
+    int BitAllocator::NumInputRequests( int in ) const
+    {
+      return _in_count[in];
+    }
+
+    int BitAllocator::NumOutputRequests( int out ) const
+    {
+      return _out_count[out];
+    }
+
+    void BitAllocator::PrintRequests( ostream * os ) const
+    {
+      if(!os) os = &cout;
+
+      *os << "Input requests = [ ";
+      for ( int input = 0; input < _inputs; ++input ) {
+        if ( _in_count[input] > 0 ) {
+          *os << input << " -> [ ";
+          _ForEach( _Row( input ), _in_words, [&]( int output ) {
+            *os << output << "@" << _request[input * _outputs + output].in_pri << " ";
+          } );
+          *os << "]  ";
+        }
+      }
+      *os << "], output requests = [ ";
+      for ( int output = 0; output < _outputs; ++output ) {
+        if ( _out_count[output] > 0 ) {
+          *os << output << " -> [ ";
+          _ForEach( _Column( output ), _out_words, [&]( int input ) {
+            *os << input << "@" << _request[input * _outputs + output].out_pri << " ";
+          } );
+          *os << "]  ";
+        }
+      }
+      *os << "]." << endl;
+    }
+} // namespace Booksim
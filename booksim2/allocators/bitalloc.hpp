@@ -0,0 +1,128 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/*bitalloc.hpp
+ *
+ *Base class of the bit-matrix allocators. Requests are kept in packed
+ *bitmaps, one row of output bits per input and one column of input bits
+ *per output, so the allocators can look for requests a 64-bit word at a
+ *time and Clear() only touches the rows and columns that were used.
+ *
+ */
+
+#ifndef _BITALLOC_HPP_
+#define _BITALLOC_HPP_
+
+#include <vector>
+
+#include "allocator.hpp"
+
+namespace Booksim
+{
+
+    class BitAllocator : public Allocator {
+    protected:
+      typedef unsigned long long tWord;
+      static const int _word_bits = 64;
+
+      // Words of a row (outputs) and of a column (inputs)
+      const int _in_words;
+      const int _out_words;
+
+      // Outputs requested by each input and inputs requesting each output
+      vector<tWord> _in_req;
+      vector<tWord> _out_req;
+      // Inputs and outputs with requests
+      vector<tWord> _in_occ;
+      vector<tWord> _out_occ;
+      vector<int> _in_count;
+      vector<int> _out_count;
+
+      // Label and priorities, only valid where the request bit is set
+      vector<sRequest> _request;
+
+      // Requests since the last Clear(), and whether all of them had the
+      // same priorities (then the kernels do not have to look at them)
+      int _num_reqs;
+      bool _same_pri;
+      int _first_in_pri;
+      int _first_out_pri;
+
+      static inline bool _Test( tWord const * bits, int i ) {
+        return (bits[i / _word_bits] >> (i % _word_bits)) & 1ULL;
+      }
+      static inline void _Set( tWord * bits, int i ) {
+        bits[i / _word_bits] |= (1ULL << (i % _word_bits));
+      }
+      static inline void _Reset( tWord * bits, int i ) {
+        bits[i / _word_bits] &= ~(1ULL << (i % _word_bits));
+      }
+      // First set bit in round-robin order starting at start, -1 if none
+      static int _FindFrom( tWord const * bits, int size, int start );
+      // Same, only looking at the bits also set in mask
+      static int _FindFrom( tWord const * bits, tWord const * mask,
+                            int size, int start );
+      // Calls f(i) for every set bit, in increasing order
+      template<class F>
+      static inline void _ForEach( tWord const * bits, int words, F f ) {
+        for ( int w = 0; w < words; ++w ) {
+          tWord word = bits[w];
+          while ( word ) {
+            f( w * _word_bits + __builtin_ctzll(word) );
+            word &= word - 1;
+          }
+        }
+      }
+
+      inline tWord const * _Row( int in ) const { return &_in_req[in * _in_words]; }
+      inline tWord const * _Column( int out ) const { return &_out_req[out * _out_words]; }
+
+    public:
+      BitAllocator( Module *parent, const string& name,
+                    int inputs, int outputs );
+
+      void Clear( );
+
+      int  ReadRequest( int in, int out ) const;
+      bool ReadRequest( sRequest &req, int in, int out ) const;
+
+      void AddRequest( int in, int out, int label = 1,
+                       int in_pri = 0, int out_pri = 0 );
+      void RemoveRequest( int in, int out, int label = 1 );
+
+      bool OutputHasRequests( int out ) const;
+      bool InputHasRequests( int in ) const;
+
+      int NumOutputRequests( int out ) const;
+      int NumInputRequests( int in ) const;
+
+      void PrintRequests( ostream * os = NULL ) const;
+    };
+} // namespace Booksim
+
+#endif
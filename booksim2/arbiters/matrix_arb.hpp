@@ -43,7 +43,7 @@ namespace Booksim
 
     using namespace std;
 
-    class MatrixArbiter : public Arbiter {
+    class MatrixArbiter final : public Arbiter {
 
       // Priority matrix
       vector<vector<int> > _matrix ;
@@ -39,7 +39,7 @@
 namespace Booksim
 {
 
-    class RoundRobinArbiter : public Arbiter {
+    class RoundRobinArbiter final : public Arbiter {
 
       // Priority pointer
       int  _pointer ;
@@ -217,6 +217,9 @@ namespace Booksim
       _int_map["injection_rate_uses_flits"] = 0;
 
       AddStrField( "injection_process", "bernoulli" );
+      // Sample the next injection cycle of each source instead of polling
+      // every source every cycle (bernoulli and on_off processes only)
+      _int_map["injection_skip_ahead"] = 0;
 
       _float_map["burst_alpha"] = 0.5; // burst interval
       _float_map["burst_beta"]  = 0.5; // burst length
@@ -252,6 +255,14 @@ namespace Booksim
       //whether to enable per pair statistics, caution N^2 memory usage
       _int_map["pair_stats"] = 0;
 
+      // Bins of the latency histograms: "linear" (fixed width) or "log"
+      // (log-linear, 2^latency_histogram_precision bins per power of two;
+      // adds percentiles to the output and only stores the bins in use)
+      AddStrField("latency_histogram", "linear");
+      _int_map["latency_histogram_precision"] = 5;
+      // binary dump of the latency histograms after each simulation
+      AddStrField("histogram_out", "");
+
       // if avg. latency exceeds the threshold, assume unstable
       _float_map["latency_thres"] = 500.0;
       AddStrField("latency_thres", ""); // workaround to allow for vector specification
@@ -285,7 +296,49 @@ namespace Booksim
 
       _int_map["print_csv_results"] = 0;
 
+      // Abort a latency run once a class is provably saturated: its backlog
+      // grows significantly over saturation_periods sample periods and less
+      // than (1 - saturation_margin) of the offered flits are accepted
+      _int_map["saturation_detect"] = 1;
+      _int_map["saturation_periods"] = 5;
+      _float_map["saturation_margin"] = 0.02;
+
+      // Fork this many measurement runs (with their own random streams) from
+      // the first warm-up; warmup_fork_rates gives each fork its own load
+      _int_map["warmup_forks"] = 1;
+      AddStrField("warmup_fork_rates", "");
+
       _int_map["deadlock_warn_timeout"] = 256;
+      // Look for cyclic waits among the blocked VCs every this many cycles
+      // while there are flits in flight (0 = only deadlock_warn_timeout)
+      _int_map["deadlock_check_period"] = 64;
+
+      // Flit pool: one slab arena per subnet, and poison freed flits instead
+      // of recycling them to catch use-after-free bugs
+      _int_map["flit_pool_per_subnet"] = 0;
+      _int_map["flit_pool_debug"] = 0;
+
+      // Only clock the channels and routers that have work to do
+      _int_map["activity_scheduling"] = 1;
+      // Channels with data in flight sleep until it arrives (needs
+      // activity_scheduling)
+      _int_map["timing_wheel"] = 1;
+      // Workload simulations jump over the cycles in which the network is
+      // empty and no packet is due (results are identical)
+      _int_map["fast_forward"] = 1;
+
+      // Threads that clock the routers and channels; results are identical
+      // for any value
+      _int_map["sim_threads"] = 1;
+
+      // Sweep mode: run one simulation per value of sweep_param (e.g.
+      // sweep_param = injection_rate; sweep_values = {0.05,0.1,0.15}) on
+      // sweep_threads threads (0: one per core), and write the overall
+      // stats of every point to the sweep_csv file ("-" for stdout)
+      AddStrField("sweep_param", "");
+      AddStrField("sweep_values", "");
+      _int_map["sweep_threads"] = 0;
+      AddStrField("sweep_csv", "-");
 
       _int_map["viewer_trace"] = 0;
 
@@ -300,7 +353,11 @@ namespace Booksim
 
       AddStrField("stats_out", "");
 
-#ifdef TRACK_FLOWS
+      // Per router flow and stall counters, dumped every sample period to
+      // the *_out files below
+      _int_map["track_flows"] = 0;
+      _int_map["track_stalls"] = 0;
+
       AddStrField("injected_flits_out", "");
       AddStrField("received_flits_out", "");
       AddStrField("stored_flits_out", "");
@@ -308,9 +365,7 @@ namespace Booksim
       AddStrField("outstanding_credits_out", "");
       AddStrField("ejected_flits_out", "");
       AddStrField("active_packets_out", "");
-#endif
 
-#ifdef TRACK_STALLS
       AddStrField("switch_arbiter_input_stalls_out", "");
       AddStrField("buffer_busy_stalls_out", "");
       AddStrField("buffer_conflict_stalls_out", "");
@@ -325,9 +380,7 @@ namespace Booksim
       AddStrField("la_buffer_reserved_out", "");
       AddStrField("la_crossbar_conflict_out", "");
       AddStrField("la_sa_winners_killed_out", "");
-      AddStrField("la_sa_winners_killed_out", "");
       AddStrField("la_output_blocked_out", "");
-#endif
 
 #ifdef TRACK_CREDITS
       AddStrField("used_credits_out", "");
@@ -351,10 +404,20 @@ namespace Booksim
 
       //==================Network file===========================
       AddStrField("network_file","");
+      // AnyNet: directory of the cached topology and routing tables (empty: off)
+      AddStrField("anynet_cache","");
+      // AnyNet: offer every minimal output port instead of a single one
+      _int_map["anynet_ecmp"] = 0;
+      // AnyNet: threads that build the routing tables (0: all cores)
+      _int_map["anynet_threads"] = 0;
 
       //=========================SynFull=========================
       _int_map["synfull"] = 0;
       AddStrField("synfull_socket","./socket");
+      // Shared memory segment name (e.g. /booksim); replaces the socket
+      AddStrField("synfull_shm","");
+      // Largest number of cycles per batched sync request (0: lookahead)
+      _int_map["synfull_quantum"] = 0;
 
       //=====================Bypass Router=======================
       
@@ -381,6 +444,8 @@ namespace Booksim
       AddStrField("smart_dimensions", "n");
       // SMART bypass destination
       _int_map["smart_dest_bypass"] = 0;
+      // SMART memoize the SSR paths (deterministic routing functions only)
+      _int_map["smart_route_cache"] = 1;
 
       AddStrField("switch_arbiter_input_policy", "strict_round_robin");
     }
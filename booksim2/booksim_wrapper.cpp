@@ -30,6 +30,7 @@
 #include "globals.hpp"
 #include "trafficmanager_wrapper.hpp"
 #include "credit.hpp"
+#include "sim_context.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -44,50 +45,28 @@ namespace Booksim
     //Global declarations
     //////////////////////
 
-     /* the current traffic manager instance */
-    TrafficManager * trafficManager = NULL;
+    // Each wrapper owns the context of its simulation (see sim_context.hpp)
+    // and makes it current on every call, so several wrappers can coexist
 
     //BSMOD: Change time to long long
     long long GetSimTime() {
-      return trafficManager->getTime();
+      return gSim->traffic_manager->getTime();
     }
 
 
     Stats * GetStats(const std::string & name) {
-      Stats* test =  trafficManager->getStats(name);
+      Stats* test =  gSim->traffic_manager->getStats(name);
       if(test == 0){
         cout<<"warning statistics "<<name<<" not found"<<endl;
       }
       return test;
     }
 
-    /* printing activity factor*/
-    bool gPrintActivity;
-
-    int gK;//radix
-    int gN;//dimension
-    /**
-    concentration. 
-    XXX: By default 1 instead of 0. It is relevant in lookahead bypass router models
-    to avoid mem leaks.
-     */
-    int gC = 1;
-    vector<int> gKvector;
-    vector<int> gCvector;//concentration
-
-    int gNodes;
-
-    // SynFull Network Interface
-    NetworkInterface * ni;
-
-    //generate nocviewer trace
-    bool gTrace;
-
-    ostream * gWatchOut;
-
 
     BooksimWrapper::BooksimWrapper(string const & config_file)
     {
+        _context = new SimContext;
+        gSim = _context;
 
         BookSimConfig config;
 
@@ -129,13 +108,16 @@ namespace Booksim
         // Create traffic manager
         _traffic_manager = new TrafficManagerWrapper(config, net) ;
         // global assignment
-        trafficManager = _traffic_manager;
+        gSim->traffic_manager = _traffic_manager;
     }
 
 
     BooksimWrapper::~BooksimWrapper()
     {
+        gSim = _context;
         delete _traffic_manager;
+        gSim = NULL;
+        delete _context;
     }
 
     //BSMOD: Change flit and packet id to long
@@ -146,83 +128,92 @@ namespace Booksim
                                    int cl,
                                    long time)
     {
+        gSim = _context;
         return _traffic_manager->GeneratePacket(source ,dest, size, cl, time);
     }
 
+    int
+    BooksimWrapper::GeneratePackets(vector<NewPacket> & packets)
+    {
+        gSim = _context;
+        int generated = 0;
+        for(size_t i = 0; i < packets.size(); ++i) {
+            NewPacket & p = packets[i];
+            p.pid = _traffic_manager->GeneratePacket(p.src, p.dst, p.size, p.c, p.time);
+            if(p.pid >= 0) {
+                ++generated;
+            }
+        }
+        return generated;
+    }
+
     // XXX: carefull, we are not taking packets from the ejection queues.
     // Safe call with a value of 1 for cycles parameter
     void
     BooksimWrapper::RunCycles(const unsigned int cycles)
     {
+        gSim = _context;
         _traffic_manager->RunCycles(cycles);
     }
 
+    long
+    BooksimWrapper::NextEventCycle()
+    {
+        gSim = _context;
+        return _traffic_manager->NextEventCycle();
+    }
+
+    void
+    BooksimWrapper::RunUntil(long cycle)
+    {
+        gSim = _context;
+        _traffic_manager->RunUntil(cycle);
+    }
+
 
     // Call it until returning null
     BooksimWrapper::RetiredPacket
     BooksimWrapper::RetirePacket()
     {
-
-        pair<Flit,Flit> rp = _traffic_manager->RetirePacket();
-        Flit head = rp.first;
-        Flit tail = rp.second;
-        RetiredPacket p = {head.pid,
-                            head.src,
-                            head.dest,
-                            head.cl,
-                            head.packet_size,
-                            (int)(tail.atime-head.ctime),
-                            (int)(tail.atime-head.itime),
-                            head.hops,
-                            (int)head.hpc.size(),
-                            0};
-        return p;
+        gSim = _context;
+        return _traffic_manager->RetirePacket();
     }
 
     //BSMOD: Retire for a host
     BooksimWrapper::RetiredPacket
     BooksimWrapper::RetirePacket(int destination)
     {
-
-        pair<Flit,Flit> rp = _traffic_manager->RetirePacket(destination);
-        Flit head = rp.first;
-        Flit tail = rp.second;
-        RetiredPacket p = {head.pid,
-                            head.src,
-                            head.dest,
-                            head.cl,
-                            head.packet_size,
-                            (int)(tail.atime-head.ctime),
-                            (int)(tail.atime-head.itime),
-                            head.hops,
-                            (int)head.hpc.size(),
-                            0};
-        return p;
+        gSim = _context;
+        return _traffic_manager->RetirePacket(destination);
     }
 
     BooksimWrapper::RetiredPacket
     BooksimWrapper::NextPacket(int destination)
     {
+        gSim = _context;
+        return _traffic_manager->NextPacket(destination);
+    }
 
-        pair<Flit,Flit> rp = _traffic_manager->NextPacket(destination);
-        Flit head = rp.first;
-        Flit tail = rp.second;
-        RetiredPacket p = {head.pid,
-                            head.src,
-                            head.dest,
-                            head.cl,
-                            head.packet_size,
-                            (int)(tail.atime-head.ctime),
-                            (int)(tail.atime-head.itime),
-                            head.hops,
-                            (int)head.hpc.size(),
-                            0};
-        return p;
+    int
+    BooksimWrapper::RetirePackets(vector<RetiredPacket> & packets)
+    {
+        gSim = _context;
+        packets.clear();
+        return _traffic_manager->RetirePackets(
+            [&packets](RetiredPacket const & p) { packets.push_back(p); });
+    }
+
+    int
+    BooksimWrapper::RetirePackets(function<void(RetiredPacket const &)> const & callback)
+    {
+        gSim = _context;
+        return _traffic_manager->RetirePackets(callback);
     }
 
     bool
     BooksimWrapper::CheckInFlightPackets()
     {
+        gSim = _context;
         return _traffic_manager->CheckInFlightPackets();
     }
 
@@ -230,12 +221,14 @@ namespace Booksim
     bool
     BooksimWrapper::CheckInFlightCredits()
     {
+        gSim = _context;
         return Credit::OutStanding()!=0;
     }
     
     int
     BooksimWrapper::CheckInjectionQueue(int source, int cl)
     {
+        gSim = _context;
         return _traffic_manager->CheckInjectionQueue(source, cl);
     }
 
@@ -243,6 +236,7 @@ namespace Booksim
     void
     BooksimWrapper::UpdateSimTime(int cycles)
     {
+        gSim = _context;
         assert(!CheckInFlightPackets());
         _traffic_manager->UpdateSimTime(cycles);
     }
@@ -251,6 +245,7 @@ namespace Booksim
     void
     BooksimWrapper::PrintStats(std::ostream & os)
     {
+        gSim = _context;
         _traffic_manager->UpdateStats();
         _traffic_manager->DisplayStats(os);
     }
@@ -258,6 +253,7 @@ namespace Booksim
     void
     BooksimWrapper::ResetStats()
     {
+        gSim = _context;
         _traffic_manager->ClearStats();
     }
 
@@ -265,6 +261,7 @@ namespace Booksim
     long
     BooksimWrapper::GetSimTime()
     {
+        gSim = _context;
         return _traffic_manager->getTime();
     }
 } // namespace Booksim
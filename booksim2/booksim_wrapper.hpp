@@ -29,15 +29,19 @@
 #define _BOOKSIMWRAPPER_HPP_
 
 #include <string>
+#include <vector>
+#include <functional>
 
 namespace Booksim
 {
     class TrafficManagerWrapper;
+    class SimContext;
 
     class BooksimWrapper {
 
         private:
             TrafficManagerWrapper * _traffic_manager;
+            SimContext * _context;
 
         public:
             BooksimWrapper(std::string const & config_file);
@@ -59,6 +63,16 @@ namespace Booksim
                 int br; // bypassed routers
             };
 
+            // Packet for GeneratePackets()
+            struct NewPacket {
+                int src; // source
+                int dst; // destination
+                int size; // packet size
+                int c; // packet class
+                long time; // creation time, in cycles before the current one
+                long pid; // set to the packet ID (-1 if not possible)
+            };
+
             //! Returns the number of free slots in the injection queue
             //Note: implement this method if you set finite inj. queues in
             //BookSim. In gem5 there are already injection queues so we use
@@ -71,10 +85,22 @@ namespace Booksim
             //BSMOD: Change flit and packet id to long
             long GeneratePacket(int source, int dest, int size, int cl,
                                long time);
+            //! Generate a batch of packets, in order. Sets the pid of each
+            //! one and returns the number of packets generated.
+            int GeneratePackets(std::vector<NewPacket> & packets);
 
             //! Run "cycles" internal cycles
             void RunCycles(const unsigned int cycles);
 
+            //! Lower bound of the next cycle in which the network may eject
+            //! a packet or change its state; -1 if nothing happens until a
+            //! new packet is generated
+            long NextEventCycle();
+
+            //! Run up to cycle, skipping the spans with nothing to simulate.
+            //! Equivalent to RunCycles(cycle - GetSimTime()).
+            void RunUntil(long cycle);
+
             //! Check if there are packets in the ejection queue.
             //! Get first packet in the consumption queue
             RetiredPacket RetirePacket();
@@ -86,6 +112,13 @@ namespace Booksim
             //! Look up the following packet at the ejection queue for an specific destination.
             RetiredPacket NextPacket(int destination);
 
+            //! Retire every packet ejected since the last call, in ejection
+            //! order, in one pass. Clears and fills packets (reusing its
+            //! storage) and returns the number of packets.
+            int RetirePackets(std::vector<RetiredPacket> & packets);
+            //! Same, calling callback for each packet instead.
+            int RetirePackets(std::function<void(RetiredPacket const &)> const & callback);
+
             //! Checks if there are flits inside the network
             bool CheckInFlightPackets();
             
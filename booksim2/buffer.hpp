@@ -111,13 +111,19 @@ namespace Booksim
       // Sets route to the front flit in the virtual channel
       inline void SetRouteSet( int vc, OutputSet * output_set )
       {
-    //    set<OutputSet::sSetElement> const route = output_set->GetSet();
+    //    OutputSet::ElementList const route = output_set->GetSet();
     //    for(auto route_iter : route) {
     //        *gWatchOut << "Name: " << FullName() << " vc " << vc << " Next Output Port: " << route_iter.output_port << " ptr: " << output_set << std::endl;
     //    }
         _vc[vc]->SetRouteSet(output_set);
       }
 
+      // Sets route to the front flit from the route set carried by a lookahead
+      inline void CopyRouteSet( int vc, OutputSet const & output_set )
+      {
+        _vc[vc]->CopyRouteSet(output_set);
+      }
+
       // Sets output (output port + output vc) of the virtual channel
       inline void SetOutput( int vc, int out_port, int out_vc )
       {
@@ -181,6 +187,11 @@ namespace Booksim
         return _occupancy;
       }
 
+      inline int NumVCs( ) const
+      {
+        return (int)_vc.size( );
+      }
+
       inline int GetOccupancy( int vc ) const
       {
         return _vc[vc]->GetOccupancy( );
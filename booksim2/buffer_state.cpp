@@ -952,10 +952,9 @@ namespace Booksim
         assert( c );
 
 
-        set<int>::iterator iter = c->vc.begin();
-        while(iter != c->vc.end()) {
+        for(unsigned long long vcs = c->vc.Mask(); vcs; vcs &= vcs - 1) {
 
-            int const vc = *iter;
+            int const vc = __builtin_ctzll(vcs);
 
 
             assert( ( vc >= 0 ) && ( vc < _vcs ) );
@@ -1005,8 +1004,6 @@ namespace Booksim
 
 
             _buffer_policy->FreeSlotFor(vc);
-
-            ++iter;
         }
     }
 
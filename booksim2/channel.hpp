@@ -37,7 +37,8 @@
 #ifndef _CHANNEL_HPP
 #define _CHANNEL_HPP
 
-#include <queue>
+#include <algorithm>
+#include <vector>
 #include <cassert>
 
 #include "globals.hpp"
@@ -69,18 +70,43 @@ namespace Booksim
         virtual void Evaluate() {}
         virtual void WriteOutputs();
 
+        // Module woken when the channel delivers data
+        void SetWakeSink(TimedModule * sink) { _wake_sink = sink; }
+        // With a timing wheel the channel sleeps while its data is in flight
+        // and is woken by the network the cycle the first item is due
+        virtual bool Idle() const {
+            return !_input && !_output && (!_count || HasTimingWheel());
+        }
+        virtual long long NextEvent() const {
+            return _count ? _ring[_head].first : -1;
+        }
+        virtual long long NextActivity(long long now) const {
+            if(_input || _output) {
+                return now;
+            }
+            return _count ? max(now, _ring[_head].first) : -1;
+        }
+
     protected:
         int _delay;
+        TimedModule * _wake_sink;
         T * _input;
         T * _output;
+        // Data in flight and the cycle it is delivered, in a ring of _delay
+        // slots: at most one item enters the channel per cycle
         //BSMOD: Change time to long long
-        queue<pair<long long, T *> > _wait_queue;
+        vector<pair<long long, T *> > _ring;
+        size_t _head;
+        size_t _count;
+
+        void _Push(long long time, T * data);
 
     };
 
     template<typename T>
     Channel<T>::Channel(Module * parent, string const & name)
-        : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+        : TimedModule(parent, name), _delay(1), _wake_sink(0), _input(0), _output(0),
+          _ring(1), _head(0), _count(0) {
     }
 
     template<typename T>
@@ -89,11 +115,36 @@ namespace Booksim
         //    Error("Channel must have positive delay.");
         //  }
         _delay = cycles ;
+        assert(!_count);
+        _ring.assign(max(cycles, 1), make_pair(-1LL, (T *)0));
+        _head = 0;
+    }
+
+    template<typename T>
+    void Channel<T>::_Push(long long time, T * data) {
+        if(_count == _ring.size()) {
+            // Only if the channel is clocked more than once per cycle
+            vector<pair<long long, T *> > ring(2 * _ring.size());
+            for(size_t i = 0; i < _count; ++i) {
+                ring[i] = _ring[(_head + i) % _ring.size()];
+            }
+            _ring.swap(ring);
+            _head = 0;
+        }
+        size_t tail = _head + _count;
+        if(tail >= _ring.size()) {
+            tail -= _ring.size();
+        }
+        _ring[tail] = make_pair(time, data);
+        ++_count;
     }
 
     template<typename T>
     void Channel<T>::Send(T * data) {
         _input = data;
+        if(data) {
+            Wake();
+        }
     }
 
     template<typename T>
@@ -108,7 +159,7 @@ namespace Booksim
     template<typename T>
     void Channel<T>::ReadInputs() {
         if(_input) {
-            _wait_queue.push(make_pair(GetSimTime() + _delay - 1, _input));
+            _Push(GetSimTime() + _delay - 1, _input);
             //*gWatchOut << GetSimTime() << " IVAN, channel: " << FullName() << " , ReadInputs: " << _input->id << std::endl;
             _input = 0;
         }
@@ -116,13 +167,13 @@ namespace Booksim
 
     template<typename T>
     void Channel<T>::WriteOutputs() {
-        if(_wait_queue.empty()) {
+        if(!_count) {
             _output = 0;
             return;
         }
         
         //BSMOD: Change time to long long
-        pair<long long, T *> const & item = _wait_queue.front();
+        pair<long long, T *> const & item = _ring[_head];
         long long const & time = item.first;
         if(GetSimTime() < time) {
             //*gWatchOut << GetSimTime() << " IVAN, channel: " << FullName() << " WriteOutputs time: " << time << " No Pass " << item.second->id << std::endl;
@@ -134,7 +185,13 @@ namespace Booksim
         _output = item.second;
         //*gWatchOut << GetSimTime() << " IVAN, channel: " << FullName() << " WriteOutputs _output: " << _output->id << " Pass " << std::endl;
         assert(_output);
-        _wait_queue.pop();
+        if(++_head == _ring.size()) {
+            _head = 0;
+        }
+        --_count;
+        if(_wake_sink) {
+            _wake_sink->Wake();
+        }
     }
 } // namespace Booksim
 
@@ -155,6 +155,7 @@ namespace Booksim
         exit(-1);
       }
 
+      theConfig = this;
       yyparse();
 
       fclose(_config_file);
@@ -164,6 +165,7 @@ namespace Booksim
     void Configuration::ParseString(string const & str)
     {
       _config_string = str + ';';
+      theConfig = this;
       yyparse();
       _config_string = "";
     }
@@ -41,6 +41,8 @@ namespace Booksim
     extern "C" int yyparse();
 
     class Configuration {
+      // Configuration being parsed. The parser is not reentrant, so parse
+      // from one thread only (the sweep mode copies the parsed config).
       static Configuration * theConfig;
       FILE * _config_file;
       string _config_string;
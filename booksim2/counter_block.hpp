@@ -0,0 +1,126 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*counter_block.hpp
+ *
+ *Flat block of event counters used by the flow and stall instrumentation
+ *(track_flows and track_stalls options).
+ *
+ *Each owner registers its counters as class x port matrices when it is
+ *built and the block enables or disables itself from the configuration.
+ *A disabled block only costs the test of a flag that never changes during
+ *the run. An enabled block keeps every count in one contiguous array owned
+ *by the router (or traffic manager) that updates it. A router is always
+ *stepped by the same thread, so no counter is shared between threads. The
+ *traffic manager reads and clears the blocks once per sample period.
+ */
+
+#ifndef _COUNTER_BLOCK_HPP_
+#define _COUNTER_BLOCK_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    class CounterBlock {
+
+    public:
+      CounterBlock( ) : _enabled(false) {}
+
+      // Adds a rows x cols matrix of counters and returns its handle.
+      // Handles are given in registration order.
+      int Register( int rows, int cols = 1 ) {
+        assert((rows > 0) && (cols > 0));
+        Matrix m = {_counts.size(), rows, cols};
+        _matrices.push_back(m);
+        _counts.resize(_counts.size() + rows * cols, 0);
+        return (int)_matrices.size() - 1;
+      }
+
+      inline void Enable( bool enabled ) { _enabled = enabled; }
+      inline bool Enabled( ) const { return _enabled; }
+
+      inline void Add( int id, int row, int col, int n ) {
+        if(_enabled) {
+          _At(id, row, col) += n;
+        }
+      }
+      inline void Inc( int id, int row, int col = 0 ) { Add(id, row, col, 1); }
+      inline void Dec( int id, int row, int col = 0 ) { Add(id, row, col, -1); }
+
+      inline int Get( int id, int row, int col = 0 ) const {
+        return _counts[_Index(id, row, col)];
+      }
+
+      // Copy of one row, for the sample dumps
+      vector<int> Row( int id, int row ) const {
+        Matrix const & m = _Matrix(id, row);
+        vector<int>::const_iterator first = _counts.begin() + m.offset + row * m.cols;
+        return vector<int>(first, first + m.cols);
+      }
+
+      void ClearRow( int id, int row ) {
+        Matrix const & m = _Matrix(id, row);
+        fill(_counts.begin() + m.offset + row * m.cols,
+             _counts.begin() + m.offset + (row + 1) * m.cols, 0);
+      }
+
+    private:
+      struct Matrix {
+        size_t offset;
+        int rows;
+        int cols;
+      };
+
+      vector<Matrix> _matrices;
+      vector<int> _counts;
+      bool _enabled;
+
+      inline Matrix const & _Matrix( int id, int row ) const {
+        assert((id >= 0) && (id < (int)_matrices.size()));
+        Matrix const & m = _matrices[id];
+        assert((row >= 0) && (row < m.rows));
+        return m;
+      }
+
+      inline size_t _Index( int id, int row, int col ) const {
+        Matrix const & m = _Matrix(id, row);
+        assert((col >= 0) && (col < m.cols));
+        return m.offset + row * m.cols + col;
+      }
+      inline int & _At( int id, int row, int col ) {
+        return _counts[_Index(id, row, col)];
+      }
+    };
+} // namespace Booksim
+
+#endif
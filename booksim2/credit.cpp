@@ -32,13 +32,12 @@
 
 #include "booksim.hpp"
 #include "credit.hpp"
+#include "thread_pool.hpp"
+#include "sim_context.hpp"
 
 namespace Booksim
 {
 
-    stack<Credit *> Credit::_all;
-    stack<Credit *> Credit::_free;
-
     std::ostream& operator<< (std::ostream& os, const Credit& credit) {
         credit.print(os);
         return os;
@@ -61,14 +60,17 @@ namespace Booksim
 
     Credit * Credit::New() {
       Credit * c;
+      CreditPool & pool = *gSim->credit_pool;
+      stack<Credit *> & free = pool.free[ThreadPool::ThreadId()];
       
-      if(_free.empty()) {
+      if(free.empty()) {
         c = new Credit();
-        _all.push(c);
+        lock_guard<mutex> lock(pool.all_lock);
+        pool.all.push(c);
       } else {
-        c = _free.top();
+        c = free.top();
         c->Reset();
-        _free.pop();
+        free.pop();
       }
       
       //c = new Credit();
@@ -76,19 +78,50 @@ namespace Booksim
     }
 
     void Credit::Free() {
-      _free.push(this);
+      gSim->credit_pool->free[ThreadPool::ThreadId()].push(this);
       //delete this;
     }
 
     void Credit::FreeAll() {
-      while(!_all.empty()) {
-        delete _all.top();
-        _all.pop();
+      CreditPool & pool = *gSim->credit_pool;
+      while(!pool.all.empty()) {
+        delete pool.all.top();
+        pool.all.pop();
+      }
+      for(size_t t = 0; t < pool.free.size(); ++t) {
+        while(!pool.free[t].empty()) {
+          pool.free[t].pop();
+        }
+      }
+    }
+
+    void Credit::ConfigurePool(int threads) {
+      assert(OutStanding() == 0);
+      vector<stack<Credit *> > & free = gSim->credit_pool->free;
+      // Keep the credits recycled so far on thread 0
+      for(size_t t = 1; t < free.size(); ++t) {
+        while(!free[t].empty()) {
+          free[0].push(free[t].top());
+          free[t].pop();
+        }
       }
+      free.resize(threads);
     }
 
 
     int Credit::OutStanding(){
-      return _all.size()-_free.size();
+      CreditPool const & pool = *gSim->credit_pool;
+      int free = 0;
+      for(size_t t = 0; t < pool.free.size(); ++t) {
+        free += pool.free[t].size();
+      }
+      return pool.all.size()-free;
+    }
+
+    CreditPool::~CreditPool() {
+      while(!all.empty()) {
+        delete all.top();
+        all.pop();
+      }
     }
 } // namespace Booksim
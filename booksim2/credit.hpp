@@ -28,19 +28,70 @@
 #ifndef _CREDIT_HPP_
 #define _CREDIT_HPP_
 
-#include <set>
+#include <cassert>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <sstream>
+#include <vector>
 
 namespace Booksim
 {
 
+    // Set of the VCs a credit returns, kept as a bitmask. It offers the
+    // parts of the set<int> interface the routers use; iteration visits the
+    // VCs in increasing order.
+    class VCSet {
+
+    public:
+      static const int kMaxVCs = 64;
+
+      VCSet( ) : _mask(0) {}
+
+      inline void insert( int vc ) {
+        assert((vc >= 0) && (vc < kMaxVCs));
+        _mask |= (unsigned long long)1 << vc;
+      }
+      inline void erase( int vc ) {
+        assert((vc >= 0) && (vc < kMaxVCs));
+        _mask &= ~((unsigned long long)1 << vc);
+      }
+      inline int count( int vc ) const {
+        assert((vc >= 0) && (vc < kMaxVCs));
+        return (_mask >> vc) & 1;
+      }
+      inline bool empty( ) const { return _mask == 0; }
+      inline int size( ) const { return __builtin_popcountll(_mask); }
+      inline void clear( ) { _mask = 0; }
+
+      inline unsigned long long Mask( ) const { return _mask; }
+
+      class const_iterator {
+      public:
+        const_iterator( ) : _bits(0) {}
+        explicit const_iterator( unsigned long long bits ) : _bits(bits) {}
+        inline int operator*( ) const { return __builtin_ctzll(_bits); }
+        inline const_iterator & operator++( ) { _bits &= _bits - 1; return *this; }
+        inline const_iterator operator++( int ) { const_iterator old = *this; ++*this; return old; }
+        inline bool operator==( const_iterator const & other ) const { return _bits == other._bits; }
+        inline bool operator!=( const_iterator const & other ) const { return _bits != other._bits; }
+      private:
+        unsigned long long _bits;
+      };
+      typedef const_iterator iterator;
+
+      inline const_iterator begin( ) const { return const_iterator(_mask); }
+      inline const_iterator end( ) const { return const_iterator(0); }
+
+    private:
+      unsigned long long _mask;
+    };
+
     class Credit {
 
     public:
 
-      set<int> vc;
+      VCSet vc;
 
       // these are only used by the event router
       bool head, tail;
@@ -55,6 +106,10 @@ namespace Booksim
       static void FreeAll();
       static int OutStanding();
 
+      // One free list per simulation thread (sim_threads), so that routers
+      // evaluated in parallel can recycle credits without locking
+      static void ConfigurePool(int threads);
+
       void print(std::ostream& out) const {
         out << " Credit ID: " << id << " Head: " << head << " Tail: " << tail
             << " Packet size: " << packet_size << " VC: ";
@@ -67,14 +122,23 @@ namespace Booksim
 
     private:
 
-      static stack<Credit *> _all;
-      static stack<Credit *> _free;
+      friend class CreditPool;
 
       Credit();
       ~Credit() {}
 
     };
 
+    // Credits of one simulation (see SimContext)
+    class CreditPool {
+    public:
+      CreditPool( ) : free(1) {}
+      ~CreditPool( );
+
+      stack<Credit *> all;
+      mutex all_lock;
+      vector<stack<Credit *> > free;
+    };
 } // namespace Booksim
 
 #endif
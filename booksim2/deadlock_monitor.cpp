@@ -0,0 +1,194 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "deadlock_monitor.hpp"
+#include "vc.hpp"
+
+namespace Booksim
+{
+
+    DeadlockMonitor::DeadlockMonitor( Configuration const & config,
+                                      vector<vector<Router *> > const & routers )
+      : _routers(routers), _max_inputs(0)
+    {
+      _period = config.GetInt("deadlock_check_period");
+      assert(_period > 0);
+      _max_vcs = config.GetInt("num_vcs");
+      for(size_t s = 0; s < _routers.size(); ++s) {
+        for(size_t r = 0; r < _routers[s].size(); ++r) {
+          _max_inputs = max(_max_inputs, _routers[s][r]->NumInputs());
+        }
+      }
+    }
+
+    bool DeadlockMonitor::Check( )
+    {
+      _nodes.clear();
+      map<long long, int> index;
+      vector<Router::VCWait> waits;
+      for(size_t s = 0; s < _routers.size(); ++s) {
+        for(size_t r = 0; r < _routers[s].size(); ++r) {
+          Router const * const router = _routers[s][r];
+          waits.clear();
+          router->DeadlockWaits(waits);
+          for(size_t w = 0; w < waits.size(); ++w) {
+            Node n;
+            n.subnet = s;
+            n.router = router;
+            n.wait = waits[w];
+            index[_Key(s, router->GetID(), n.wait.input, n.wait.vc)] = _nodes.size();
+            _nodes.push_back(n);
+          }
+        }
+      }
+
+      // Greatest set of nodes that only wait for nodes of the set: a node
+      // with an output VC that is not blocked is dropped, and so are the
+      // nodes that wait for it
+      int const nodes = _nodes.size();
+      vector<vector<int> > pred(nodes);
+      vector<bool> alive(nodes, true);
+      vector<int> dropped;
+      for(int i = 0; i < nodes; ++i) {
+        Node & n = _nodes[i];
+        if(n.wait.input_vc >= 0) {
+          map<long long, int>::const_iterator iter =
+            index.find(_Key(n.subnet, n.router->GetID(), n.wait.input, n.wait.input_vc));
+          assert(iter != index.end());
+          n.succ.push_back(iter->second);
+          pred[iter->second].push_back(i);
+        }
+        for(size_t t = 0; t < n.wait.targets.size(); ++t) {
+          FlitChannel const * const channel = n.router->GetOutputChannel(n.wait.targets[t].first);
+          Router const * const sink = channel->GetSink();
+          assert(sink);
+          map<long long, int>::const_iterator iter =
+            index.find(_Key(n.subnet, sink->GetID(), channel->GetSinkPort(), n.wait.targets[t].second));
+          if(iter == index.end()) {
+            if(alive[i]) {
+              alive[i] = false;
+              dropped.push_back(i);
+            }
+          } else {
+            n.succ.push_back(iter->second);
+            pred[iter->second].push_back(i);
+          }
+        }
+      }
+      while(!dropped.empty()) {
+        int const j = dropped.back();
+        dropped.pop_back();
+        for(size_t p = 0; p < pred[j].size(); ++p) {
+          int const i = pred[j][p];
+          if(alive[i]) {
+            alive[i] = false;
+            dropped.push_back(i);
+          }
+        }
+      }
+
+      vector<pair<long long, long> > signature;
+      _deadlocked.clear();
+      for(int i = 0; i < nodes; ++i) {
+        if(alive[i]) {
+          Node const & n = _nodes[i];
+          _deadlocked.push_back(i);
+          signature.push_back(make_pair(_Key(n.subnet, n.router->GetID(), n.wait.input, n.wait.vc),
+                                        n.wait.flit->id));
+        }
+      }
+      bool const confirmed = !signature.empty() && (signature == _signature);
+      _signature.swap(signature);
+      return confirmed;
+    }
+
+    void DeadlockMonitor::_Print( ostream & os, Node const & n ) const
+    {
+      Flit const * const f = n.wait.flit;
+      os << "  subnet " << n.subnet
+         << " router " << n.router->GetID()
+         << " input " << n.wait.input
+         << " vc " << n.wait.vc
+         << " state " << VC::VCSTATE[n.wait.state]
+         << " flit " << f->id
+         << " packet " << f->pid
+         << (f->head ? " head" : " body")
+         << " class " << f->cl
+         << " src " << f->src
+         << " dest " << f->dest
+         << " waits for";
+      if(n.wait.input_vc >= 0) {
+        os << " (input arbiter, vc " << n.wait.input_vc << ")";
+      }
+      for(size_t t = 0; t < n.wait.targets.size(); ++t) {
+        FlitChannel const * const channel = n.router->GetOutputChannel(n.wait.targets[t].first);
+        os << " (router " << channel->GetSink()->GetID()
+           << " input " << channel->GetSinkPort()
+           << " vc " << n.wait.targets[t].second << ")";
+      }
+      os << endl;
+    }
+
+    void DeadlockMonitor::Report( ostream & os, long long time ) const
+    {
+      assert(!_deadlocked.empty());
+
+      // Every deadlocked node waits for at least another one, so following
+      // the first of them ends in a cycle
+      vector<int> position(_nodes.size(), -1);
+      vector<int> path;
+      int i = _deadlocked.front();
+      while(position[i] < 0) {
+        position[i] = path.size();
+        path.push_back(i);
+        assert(!_nodes[i].succ.empty());
+        i = _nodes[i].succ.front();
+      }
+      vector<bool> in_cycle(_nodes.size(), false);
+      for(size_t p = position[i]; p < path.size(); ++p) {
+        in_cycle[path[p]] = true;
+      }
+
+      os << "Deadlock detected at cycle " << time << ": "
+         << _deadlocked.size() << " blocked VCs." << endl;
+      os << "Cycle of " << path.size() - position[i] << " VCs:" << endl;
+      for(size_t p = position[i]; p < path.size(); ++p) {
+        _Print(os, _nodes[path[p]]);
+      }
+      if(_deadlocked.size() > path.size() - position[i]) {
+        os << "Other deadlocked VCs:" << endl;
+        for(size_t d = 0; d < _deadlocked.size(); ++d) {
+          if(!in_cycle[_deadlocked[d]]) {
+            _Print(os, _nodes[_deadlocked[d]]);
+          }
+        }
+      }
+    }
+} // namespace Booksim
@@ -0,0 +1,104 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*deadlock_monitor.hpp
+ *
+ *Wait-for graph of the blocked input VCs, checked every
+ *deadlock_check_period cycles while there are flits in flight.
+ *
+ *Each router reports its input VCs whose front flit cannot advance together
+ *with the output VCs it waits for (Router::DeadlockWaits), which are mapped
+ *to the input VCs of the next routers. The VCs that only wait for other
+ *blocked VCs form a closed set: none of them can advance until another one
+ *does. Since a credit or a flit in flight can still free one of them, the
+ *deadlock is only reported when the same set, with the same front flits, is
+ *found in two consecutive checks.
+ */
+
+#ifndef _DEADLOCK_MONITOR_HPP_
+#define _DEADLOCK_MONITOR_HPP_
+
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "config_utils.hpp"
+#include "router.hpp"
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    class DeadlockMonitor {
+
+    public:
+      DeadlockMonitor( Configuration const & config,
+                       vector<vector<Router *> > const & routers );
+
+      // Whether a check is due in cycle time
+      inline bool Due( long long time ) const { return (time % _period) == 0; }
+      // First cycle from time on in which a check is due
+      inline long long NextCheck( long long time ) const {
+        return ((time + _period - 1) / _period) * _period;
+      }
+
+      // Builds the wait-for graph, returns true when a deadlock is confirmed
+      bool Check( );
+      // Writes the VCs of the confirmed deadlock: first a cycle of the wait-for
+      // graph, then the rest of the deadlocked VCs
+      void Report( ostream & os, long long time ) const;
+
+    private:
+      struct Node {
+        int subnet;
+        Router const * router;
+        Router::VCWait wait;
+        // Indices of the nodes of the output VCs it waits for
+        vector<int> succ;
+      };
+
+      int _period;
+      vector<vector<Router *> > _routers;
+      int _max_inputs;
+      int _max_vcs;
+
+      vector<Node> _nodes;
+      // Deadlocked nodes of the last check and their (key, front flit id)
+      vector<int> _deadlocked;
+      vector<pair<long long, long> > _signature;
+
+      inline long long _Key( int subnet, int router, int input, int vc ) const {
+        return ((((long long)subnet * _routers[0].size() + router) * _max_inputs)
+                + input) * _max_vcs + vc;
+      }
+      void _Print( ostream & os, Node const & n ) const;
+    };
+} // namespace Booksim
+
+#endif
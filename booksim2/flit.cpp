@@ -36,13 +36,11 @@
 
 #include "booksim.hpp"
 #include "flit.hpp"
+#include "globals.hpp"
 
 namespace Booksim
 {
 
-    stack<Flit *> Flit::_all;
-    stack<Flit *> Flit::_free;
-
     ostream& operator<<( ostream& os, const Flit& f )
     {
       os << "  Flit ID: " << f.id 
@@ -56,7 +54,7 @@ namespace Booksim
       return os;
     }
 
-    Flit::Flit() 
+    Flit::Flit() : _pool(NULL), _arena(0), _freed(false)
     {  
       Reset();
     }  
@@ -83,33 +81,55 @@ namespace Booksim
       intm =-1;
       ph = -1;
       data = 0;
+      router_id = -1;
+      port_id = -1;
+      packet_size = 0;
+      subnetwork = -1;
+      rubydest = -1;
+      // Recycled flits keep the storage of these containers
+      hpc.clear();
+      la_route_set.Clear();
     }  
 
-    Flit * Flit::New() {
-      Flit * f;
-      /*
-      if(_free.empty()) {
-        f = new Flit;
-        _all.push(f);
-      } else {
-        f = _free.top();
-        f->Reset();
-        _free.pop();
-      }
-      */
-      f = new Flit;
-      return f;
+    // Overwrite a freed flit with values no live flit can have, so stale
+    // pointers are noticed (flit_pool_debug). IDs are kept for the error
+    // messages.
+    void Flit::Poison()
+    {
+      long const poisoned_id = id;
+      long const poisoned_pid = pid;
+      Reset();
+      id = poisoned_id;
+      pid = poisoned_pid;
+      vc = cl = src = dest = -0xDEAD;
+      la_route_set.Poison();
+    }
+
+    void Flit::_FreedFlitError() const
+    {
+      cout << GetSimTime() << " Error: use of flit " << id << " (packet " << pid
+           << ") after it was freed." << endl;
+      exit(-1);
+    }
+
+    Flit * Flit::New(int arena) {
+      return gSim->flit_pool->Allocate(arena);
     }
 
     void Flit::Free() {
-      //_free.push(this);
-      delete this;
+      if(_pool) {
+        _pool->Recycle(this);
+      } else {
+        delete this;
+      }
     }
 
     void Flit::FreeAll() {
-      while(!_all.empty()) {
-        delete _all.top();
-        _all.pop();
-      }
+      gSim->flit_pool->Release();
+    }
+
+    void Flit::ConfigurePool(int arenas, bool debug) {
+      gSim->flit_pool->SetArenas(arenas);
+      gSim->flit_pool->SetDebug(debug);
     }
 } // namespace Booksim
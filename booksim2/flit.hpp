@@ -29,11 +29,11 @@
 #define _FLIT_HPP_
 
 #include <iostream>
-#include <stack>
 #include <vector>
 
 #include "booksim.hpp"
 #include "outputset.hpp"
+#include "flit_pool.hpp"
 
 namespace Booksim
 {
@@ -122,15 +122,36 @@ namespace Booksim
 
             void Reset();
 
-            static Flit * New();
+            // Pooled allocation. The arena selects the slabs the flit is
+            // carved from (see ConfigurePool).
+            static Flit * New(int arena = 0);
             void Free();
             static void FreeAll();
 
+            // Number of arenas (1 or one per subnet) and flit_pool_debug mode
+            static void ConfigurePool(int arenas, bool debug);
+
+            inline int Arena() const { return _arena; }
+
+            // Abort if the flit has already been returned to the pool
+            inline void CheckLive() const
+            {
+              if(_freed) {
+                _FreedFlitError();
+              }
+            }
+
         private:
 
+            template<class T> friend class FlitPool;
+
+            // Pool this flit was carved from (NULL if not pooled)
+            FlitPoolBase * _pool;
+            int _arena;
+            bool _freed;
 
-            static stack<Flit *> _all;
-            static stack<Flit *> _free;
+            void Poison();
+            void _FreedFlitError() const;
 
     };
 
@@ -0,0 +1,184 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*flit_pool.hpp
+ *
+ *Slab allocator used by Flit::New() and Lookahead::New().
+ *
+ *Objects are carved from cache-line aligned slabs and are never destroyed
+ *while the pool is alive: Free() only pushes them onto the free list of the
+ *arena they came from, and New() calls Reset() on them. This way a recycled
+ *flit also keeps the storage of its hpc vector. Release() destroys every
+ *object and returns the slabs to the system (end of simulation).
+ *
+ *In debug mode freed objects are poisoned and never handed out again, so a
+ *stale pointer to a freed flit reads garbage that trips Flit::CheckLive()
+ *instead of silently aliasing a new flit.
+ */
+
+#ifndef _FLIT_POOL_HPP_
+#define _FLIT_POOL_HPP_
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    class Flit;
+
+    // Lets Flit::Free() return an object to its pool without knowing
+    // whether it is a plain flit or a lookahead.
+    class FlitPoolBase {
+    public:
+      virtual ~FlitPoolBase() {}
+      virtual void Recycle( Flit * f ) = 0;
+    };
+
+    template<class T>
+    class FlitPool : public FlitPoolBase {
+
+    public:
+      FlitPool( ) : _debug(false), _outstanding(0) { _arenas.resize(1); }
+      virtual ~FlitPool( ) { Release( ); }
+
+      // One arena per subnet keeps the flits of each subnet in their own
+      // slabs. Must be called while no object is allocated.
+      void SetArenas( int arenas );
+      inline int Arenas( ) const { return (int)_arenas.size(); }
+
+      inline void SetDebug( bool debug ) { _debug = debug; }
+      inline bool Debug( ) const { return _debug; }
+
+      T * Allocate( int arena );
+      virtual void Recycle( Flit * f );
+      void Release( );
+
+      inline int OutStanding( ) const { return _outstanding; }
+
+    private:
+      static const size_t _line_size = 64;
+      static const size_t _slab_objects = 256;
+      // Object stride rounded up to a whole number of cache lines
+      static const size_t _stride = ((sizeof(T) + _line_size - 1) / _line_size) * _line_size;
+
+      struct Arena {
+        vector<char *> slabs;
+        vector<T *> free;
+        // Objects already carved from the last slab
+        size_t carved;
+        Arena( ) : carved(_slab_objects) {}
+      };
+
+      vector<Arena> _arenas;
+      bool _debug;
+      int _outstanding;
+    };
+
+    template<class T>
+    void FlitPool<T>::SetArenas( int arenas )
+    {
+      assert(arenas > 0);
+      assert(_outstanding == 0);
+      Release( );
+      _arenas.resize(arenas);
+    }
+
+    template<class T>
+    T * FlitPool<T>::Allocate( int arena )
+    {
+      assert((arena >= 0) && (arena < (int)_arenas.size()));
+      Arena & a = _arenas[arena];
+      T * f;
+      if(!a.free.empty()) {
+        f = a.free.back();
+        a.free.pop_back();
+        f->Reset();
+      } else {
+        if(a.carved == _slab_objects) {
+          void * slab = NULL;
+          if(posix_memalign(&slab, _line_size, _stride * _slab_objects)) {
+            throw bad_alloc();
+          }
+          a.slabs.push_back(static_cast<char *>(slab));
+          a.carved = 0;
+        }
+        f = new (a.slabs.back() + _stride * a.carved) T();
+        ++a.carved;
+      }
+      f->_pool = this;
+      f->_arena = arena;
+      f->_freed = false;
+      ++_outstanding;
+      return f;
+    }
+
+    template<class T>
+    void FlitPool<T>::Recycle( Flit * f )
+    {
+      T * const t = static_cast<T *>(f);
+      if(t->_freed) {
+        cout << "Error: flit " << t->id << " (packet " << t->pid
+             << ") freed twice." << endl;
+        exit(-1);
+      }
+      t->_freed = true;
+      --_outstanding;
+      if(_debug) {
+        // Quarantine: poisoned objects are only reclaimed by Release()
+        t->Poison();
+        return;
+      }
+      _arenas[t->_arena].free.push_back(t);
+    }
+
+    template<class T>
+    void FlitPool<T>::Release( )
+    {
+      for(size_t i = 0; i < _arenas.size(); ++i) {
+        Arena & a = _arenas[i];
+        for(size_t s = 0; s < a.slabs.size(); ++s) {
+          size_t const count = (s + 1 == a.slabs.size()) ? a.carved : _slab_objects;
+          for(size_t o = 0; o < count; ++o) {
+            reinterpret_cast<T *>(a.slabs[s] + _stride * o)->~T();
+          }
+          free(a.slabs[s]);
+        }
+        a.slabs.clear();
+        a.free.clear();
+        a.carved = _slab_objects;
+      }
+      _outstanding = 0;
+    }
+} // namespace Booksim
+
+#endif
@@ -66,6 +66,7 @@ namespace Booksim
 
     void FlitChannel::Send(Flit * f) {
       if(f) {
+        f->CheckLive();
         ++_active[f->cl];
       } else {
         ++_idle;
@@ -31,6 +31,7 @@
 #include <vector>
 #include <iostream>
 #include "NetworkInterface.h"
+#include "sim_context.hpp"
 
 namespace Booksim
 {
@@ -42,22 +43,23 @@ namespace Booksim
     class Stats;
     Stats * GetStats(const std::string & name);
 
-    extern bool gPrintActivity;
+    // Per-simulation state, see sim_context.hpp
+#define gPrintActivity (gSim->print_activity)
 
-    extern int gK;
-    extern int gN;
-    extern int gC;
+#define gK (gSim->k)
+#define gN (gSim->n)
+#define gC (gSim->c)
 
-    extern vector<int> gKvector;
-    extern vector<int> gCvector;
+#define gKvector (gSim->k_vector)
+#define gCvector (gSim->c_vector)
 
-    extern int gNodes;
+#define gNodes (gSim->nodes)
 
-    extern bool gTrace;
+#define gTrace (gSim->trace)
 
-    extern std::ostream * gWatchOut;
+#define gWatchOut (gSim->watch_out)
 
-    extern NetworkInterface * ni;
+#define gNI (gSim->ni)
 } // namespace Booksim
 
 #endif
@@ -0,0 +1,259 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*id_map.hpp
+ *
+ *Map from flit or packet IDs to objects, for IDs that are handed out in
+ *increasing order and mostly released in order (in-flight flits, packets
+ *waiting for their tail).
+ *
+ *The IDs of a window [_head, _tail) live in a power-of-two ring of slots,
+ *so insert, find and erase are O(1) array accesses. The window grows up to
+ *_max_ring slots; when a new ID does not fit, the oldest entries (e.g. a
+ *packet that is stuck in the network) move to a map of stragglers and the
+ *window slides forward. Iteration visits the IDs in increasing order, like
+ *the map<long, T *> this replaces.
+ */
+
+#ifndef _ID_MAP_HPP_
+#define _ID_MAP_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    template<class T>
+    class IdMap {
+
+    public:
+      IdMap( ) : _ring(_min_ring), _head(0), _tail(0), _ring_size(0), _size(0) {}
+
+      inline bool Empty( ) const { return _size == 0; }
+      inline size_t Size( ) const { return _size; }
+
+      T * Find( long id ) const;
+      void Insert( long id, T * value );
+      // Returns the erased object (NULL if the ID was not in the map)
+      T * Erase( long id );
+
+      class const_iterator {
+      public:
+        const_iterator( ) : _map(NULL), _id(0) {}
+        inline pair<long, T *> const & operator*( ) const { return _cur; }
+        inline pair<long, T *> const * operator->( ) const { return &_cur; }
+        inline bool operator==( const_iterator const & other ) const {
+          return (_straggler == other._straggler) && (_id == other._id);
+        }
+        inline bool operator!=( const_iterator const & other ) const {
+          return !(*this == other);
+        }
+        const_iterator & operator++( ) { _Advance(false); return *this; }
+        const_iterator operator++( int ) { const_iterator old = *this; _Advance(false); return old; }
+
+      private:
+        friend class IdMap;
+
+        IdMap const * _map;
+        typename map<long, T *>::const_iterator _straggler;
+        long _id;
+        pair<long, T *> _cur;
+
+        const_iterator( IdMap const * m, bool end ) : _map(m) {
+          if(end) {
+            _straggler = m->_stragglers.end();
+            _id = m->_tail;
+          } else {
+            _straggler = m->_stragglers.begin();
+            _id = m->_head;
+            _Advance(true);
+          }
+        }
+        // Moves to the next entry (or to the current one if it is live)
+        void _Advance( bool first ) {
+          if(_straggler != _map->_stragglers.end()) {
+            if(!first) {
+              ++_straggler;
+            }
+            if(_straggler != _map->_stragglers.end()) {
+              _cur = *_straggler;
+              return;
+            }
+            first = true;
+          }
+          if(!first) {
+            ++_id;
+          }
+          while((_id < _map->_tail) && !_map->_Slot(_id)) {
+            ++_id;
+          }
+          if(_id < _map->_tail) {
+            _cur = make_pair(_id, _map->_Slot(_id));
+          }
+        }
+      };
+
+      inline const_iterator begin( ) const { return const_iterator(this, false); }
+      inline const_iterator end( ) const { return const_iterator(this, true); }
+
+    private:
+      static const size_t _min_ring = 1024;
+      static const size_t _max_ring = 1 << 16;
+
+      vector<T *> _ring;
+      // Window of IDs held by the ring, _head is live if _ring_size > 0
+      long _head;
+      long _tail;
+      size_t _ring_size;
+      map<long, T *> _stragglers;
+      size_t _size;
+
+      inline T * const & _Slot( long id ) const { return _ring[id & (_ring.size() - 1)]; }
+      inline T * & _Slot( long id ) { return _ring[id & (_ring.size() - 1)]; }
+
+      void _Grow( long id );
+    };
+
+    template<class T>
+    T * IdMap<T>::Find( long id ) const
+    {
+      if((id >= _head) && (id < _tail)) {
+        return _Slot(id);
+      }
+      if(id < _head) {
+        typename map<long, T *>::const_iterator iter = _stragglers.find(id);
+        if(iter != _stragglers.end()) {
+          return iter->second;
+        }
+      }
+      return NULL;
+    }
+
+    template<class T>
+    void IdMap<T>::Insert( long id, T * value )
+    {
+      assert(value);
+      assert(!Find(id));
+      ++_size;
+      if(_ring_size == 0) {
+        if(_stragglers.empty() || (id > _stragglers.rbegin()->first)) {
+          // Restart the window at this ID
+          _head = id;
+          _tail = id;
+        } else {
+          _stragglers.insert(make_pair(id, value));
+          return;
+        }
+      } else if(id < _head) {
+        _stragglers.insert(make_pair(id, value));
+        return;
+      }
+      if(id >= _head + (long)_ring.size()) {
+        _Grow(id);
+      }
+      if(id >= _tail) {
+        _tail = id + 1;
+      }
+      _Slot(id) = value;
+      ++_ring_size;
+    }
+
+    template<class T>
+    T * IdMap<T>::Erase( long id )
+    {
+      if((id < _head) || (id >= _tail)) {
+        typename map<long, T *>::iterator iter = _stragglers.find(id);
+        if(iter == _stragglers.end()) {
+          return NULL;
+        }
+        T * const value = iter->second;
+        _stragglers.erase(iter);
+        --_size;
+        return value;
+      }
+      T * const value = _Slot(id);
+      if(!value) {
+        return NULL;
+      }
+      _Slot(id) = NULL;
+      --_size;
+      if(--_ring_size == 0) {
+        _head = _tail;
+      } else if(id == _head) {
+        while(!_Slot(_head)) {
+          ++_head;
+        }
+      }
+      return value;
+    }
+
+    template<class T>
+    void IdMap<T>::_Grow( long id )
+    {
+      size_t size = _ring.size();
+      while((size < _max_ring) && (id >= _head + (long)size)) {
+        size *= 2;
+      }
+      if(size != _ring.size()) {
+        vector<T *> ring(size, NULL);
+        for(long i = _head; i < _tail; ++i) {
+          ring[i & (size - 1)] = _Slot(i);
+        }
+        _ring.swap(ring);
+      }
+      // Still too far ahead: the oldest entries become stragglers
+      long const head = id - (long)_ring.size() + 1;
+      if(_head < head) {
+        long const last = (head < _tail) ? head : _tail;
+        for(long i = _head; i < last; ++i) {
+          T * & slot = _Slot(i);
+          if(slot) {
+            _stragglers.insert(make_pair(i, slot));
+            slot = NULL;
+            --_ring_size;
+          }
+        }
+        if(_ring_size == 0) {
+          _head = id;
+          _tail = id;
+        } else {
+          _head = head;
+          while(!_Slot(_head)) {
+            ++_head;
+          }
+        }
+      }
+    }
+} // namespace Booksim
+
+#endif
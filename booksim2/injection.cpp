@@ -28,6 +28,7 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include "random_utils.hpp"
 #include "injection.hpp"
@@ -56,6 +57,34 @@ namespace Booksim
 
     }
 
+    long InjectionProcess::next(int source, long time)
+    {
+      cout << "Error: Injection process does not support skip-ahead injection." << endl;
+      exit(-1);
+      return -1;
+    }
+
+    // Number of Bernoulli trials with success probability p up to and
+    // including the first success (-1 if p is zero)
+    static long GeometricTrials(double p)
+    {
+      if(p >= 1.0) {
+        return 1;
+      }
+      if(p <= 0.0) {
+        return -1;
+      }
+      double u = 1.0 - RandomFloat();
+      if(u <= 0.0) {
+        u = numeric_limits<double>::min();
+      }
+      double const trials = floor(log(u) / log1p(-p));
+      if(trials >= (double)(numeric_limits<long>::max() / 2)) {
+        return -1;
+      }
+      return 1 + (long)trials;
+    }
+
     InjectionProcess * InjectionProcess::New(string const & inject, int nodes, 
                          double load, 
                          Configuration const * const config)
@@ -164,6 +193,13 @@ namespace Booksim
       return (RandomFloat() < _rate);
     }
 
+    long BernoulliInjectionProcess::next(int source, long time)
+    {
+      assert((source >= 0) && (source < _nodes));
+      long const trials = GeometricTrials(_rate);
+      return (trials < 0) ? -1 : (time + trials - 1);
+    }
+
     //BSMOD: Add AcmeVasMemTilesTrafficPattern
     AcmeMemoryTrafficInjectionProcess::AcmeMemoryTrafficInjectionProcess(int nodes, double rate, vector<int> kVect, string mem_tiles_location)
       : BernoulliInjectionProcess(nodes, rate)
@@ -196,6 +232,14 @@ namespace Booksim
       return result;
     }
 
+    long AcmeMemoryTrafficInjectionProcess::next(int source, long time)
+    {
+      if(_mem_tiles.count(source)) {
+        return -1;
+      }
+      return BernoulliInjectionProcess::next(source, time);
+    }
+
     //=============================================================
 
     OnOffInjectionProcess::OnOffInjectionProcess(int nodes, double rate, 
@@ -238,4 +282,39 @@ namespace Booksim
       // generate packet
       return _state[source] && (RandomFloat() < _r1);
     }
+
+    long OnOffInjectionProcess::next(int source, long time)
+    {
+      assert((source >= 0) && (source < _nodes));
+
+      // Each cycle spent off turns the source on with probability alpha; a
+      // cycle spent on either turns it off (beta) or injects ((1-beta)*r1).
+      // The cycle in which the source turns on may inject as well.
+      double const on_event = _beta + (1.0 - _beta) * _r1;
+      while(true) {
+        if(!_state[source]) {
+          long const trials = GeometricTrials(_alpha);
+          if(trials < 0) {
+            return -1;
+          }
+          time += trials - 1;
+          _state[source] = 1;
+          if(RandomFloat() < _r1) {
+            return time;
+          }
+          ++time;
+        } else {
+          long const trials = GeometricTrials(on_event);
+          if(trials < 0) {
+            return -1;
+          }
+          time += trials - 1;
+          if(RandomFloat() * on_event >= _beta) {
+            return time;
+          }
+          _state[source] = 0;
+          ++time;
+        }
+      }
+    }
 } // namespace Booksim
@@ -45,6 +45,11 @@ namespace Booksim
       virtual ~InjectionProcess() {}
       virtual bool test(int source) = 0;
       virtual void reset();
+      // Skip-ahead support: next() samples the first cycle at or after time
+      // in which source injects (-1 if it never does), consuming the same
+      // per-cycle trials test() would in one draw per idle stretch.
+      virtual bool skip_ahead() const { return false; }
+      virtual long next(int source, long time);
       static InjectionProcess * New(string const & inject, int nodes, double load, 
                     Configuration const * const config = NULL);
     };
@@ -53,6 +58,8 @@ namespace Booksim
     public:
       BernoulliInjectionProcess(int nodes, double rate);
       virtual bool test(int source);
+      virtual bool skip_ahead() const { return true; }
+      virtual long next(int source, long time);
     };
 
     //BSMOD: Add AcmeMemoryTrafficInjectionProcess
@@ -62,6 +69,7 @@ namespace Booksim
     public:
       AcmeMemoryTrafficInjectionProcess(int nodes, double rate, vector<int> kVect, string mem_tiles_location);
       virtual bool test(int source);
+      virtual long next(int source, long time);
     };
 
     class OnOffInjectionProcess : public InjectionProcess {
@@ -76,6 +84,8 @@ namespace Booksim
                 double r1, vector<int> initial);
       virtual void reset();
       virtual bool test(int source);
+      virtual bool skip_ahead() const { return true; }
+      virtual long next(int source, long time);
     };
 } // namespace Booksim
 
@@ -35,6 +35,7 @@
 
 #include "booksim.hpp"
 #include "lookahead.hpp"
+#include "sim_context.hpp"
 
 namespace Booksim
 {
@@ -54,6 +55,11 @@ namespace Booksim
         return os;
     }
 
+    Lookahead::Lookahead()
+    {
+        ssr_hops = 0;
+    }
+
     Lookahead::Lookahead(Flit * f)
     {
         id = f->id;
@@ -90,6 +96,37 @@ namespace Booksim
         ssr_hops = 0;
     }
 
+    void Lookahead::Reset()
+    {
+        Flit::Reset();
+        ssr_hops = 0;
+    }
+
+    Lookahead * Lookahead::New(Flit * f)
+    {
+        Lookahead * la = gSim->lookahead_pool->Allocate(f->Arena());
+        la->SetLookahead(f);
+        return la;
+    }
+
+    Lookahead * Lookahead::New(Lookahead * la)
+    {
+        Lookahead * la_n = gSim->lookahead_pool->Allocate(la->Arena());
+        la_n->CloneLookahead(la);
+        return la_n;
+    }
+
+    void Lookahead::FreeAll()
+    {
+        gSim->lookahead_pool->Release();
+    }
+
+    void Lookahead::ConfigurePool(int arenas, bool debug)
+    {
+        gSim->lookahead_pool->SetArenas(arenas);
+        gSim->lookahead_pool->SetDebug(debug);
+    }
+
     // Deprecated???
     void Lookahead::ConvertLookaheadToFlit(Flit * f)
     {
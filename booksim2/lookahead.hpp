@@ -30,7 +30,6 @@
 #define _LOOKAHEAD_HPP_
 
 #include <iostream>
-#include <stack>
 
 #include "booksim.hpp"
 #include "flit.hpp"
@@ -47,9 +46,18 @@ namespace Booksim
 
             int ssr_hops;
 
+            Lookahead();
             Lookahead(Flit * f);
             Lookahead(Lookahead * la);
-            ~Lookahead();
+            ~Lookahead() {}
+
+            void Reset();
+
+            // Pooled allocation, in the same arena as the source flit
+            static Lookahead * New(Flit * f);
+            static Lookahead * New(Lookahead * la);
+            static void FreeAll();
+            static void ConfigurePool(int arenas, bool debug);
 
             void ConvertLookaheadToFlit(Flit * f);
             void SetLookahead(Flit * f);
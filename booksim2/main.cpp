@@ -41,10 +41,11 @@
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
-
-
-
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
 #include "booksim.hpp"
 #include "routefunc.hpp"
 #include "traffic.hpp"
@@ -55,6 +56,7 @@
 #include "injection.hpp"
 #include "power_module.hpp"
 #include "NetworkInterface.h"
+#include "sim_context.hpp"
 
 namespace Booksim
 {
@@ -63,52 +65,47 @@ namespace Booksim
     //Global declarations
     //////////////////////
 
-     /* the current traffic manager instance */
-    TrafficManager * trafficManager = NULL;
+    // The state of the current simulation (traffic manager, gK, gN, ...)
+    // lives in its SimContext, see sim_context.hpp
 
     //BSMOD: Change time to long long
     long long GetSimTime() {
-      return trafficManager->getTime();
+      return gSim->traffic_manager->getTime();
     }
 
     class Stats;
     Stats * GetStats(const std::string & name) {
-      Stats* test =  trafficManager->getStats(name);
+      Stats* test =  gSim->traffic_manager->getStats(name);
       if(test == 0){
         cout<<"warning statistics "<<name<<" not found"<<endl;
       }
       return test;
     }
 
-    /* printing activity factor*/
-    bool gPrintActivity;
-
-    int gK;//radix
-    int gN;//dimension
-    /**
-    concentration. 
-    XXX: By default 1 instead of 0. It is relevant in lookahead bypass router models
-    to avoid mem leaks.
-     */
-    int gC = 1;
-    vector<int> gKvector;
-    vector<int> gCvector;//concentration
-
-    int gNodes;
-
-    // SynFull Network Interface
-    NetworkInterface * ni;
-
-    //generate nocviewer trace
-    bool gTrace;
-
-    ostream * gWatchOut;
-
-
+    // Sets up the current simulation context from the configuration
+    void InitializeSimulation( BookSimConfig const & config )
+    {
+      /*initialize routing, traffic, injection functions
+       */
+      InitializeRoutingMap( config );
+
+      gPrintActivity = (config.GetInt("print_activity") > 0);
+      gTrace = (config.GetInt("viewer_trace") > 0);
+
+      string watch_out_file = config.GetStr( "watch_out" );
+      if(watch_out_file == "") {
+        gWatchOut = NULL;
+      } else if(watch_out_file == "-") {
+        gWatchOut = &cout;
+      } else {
+        gWatchOut = new ofstream(watch_out_file.c_str());
+      }
+    }
 
     /////////////////////////////////////////////////////////////////////////////
 
-    bool Simulate( BookSimConfig const & config )
+    // csv: if not NULL, receives the overall stats of the run
+    bool Simulate( BookSimConfig const & config, ostream * csv = NULL )
     {
       vector<Network *> net;
 
@@ -127,8 +124,9 @@ namespace Booksim
        *not sure how to use them 
        */
 
-      assert(trafficManager == NULL);
-      trafficManager = TrafficManager::New( config, net ) ;
+      assert(gSim->traffic_manager == NULL);
+      TrafficManager * trafficManager = TrafficManager::New( config, net ) ;
+      gSim->traffic_manager = trafficManager;
 
       /*Start the simulation run
        */
@@ -149,6 +147,11 @@ namespace Booksim
 				    (double)(start_time.tv_usec)/1000000.0);
 
 	    cerr<<"Total run time "<<total_time<<endl;
+	    cerr<<"Simulated cycles per second "<<GetSimTime()/total_time<<endl;
+
+      if(csv && result) {
+        trafficManager->DisplayOverallStatsCSV(*csv);
+      }
 
 
       for (int i=0; i<subnets; ++i) {
@@ -163,10 +166,176 @@ namespace Booksim
       }
 
       delete trafficManager;
-      trafficManager = NULL;
+      gSim->traffic_manager = NULL;
 
       return result;
     }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Sweep mode: one simulation per value of sweep_param, several of them
+    // running at the same time, each on its own thread and SimContext
+
+    // Name of the point simulated by the calling thread ("" if none)
+    thread_local string gSweepPoint;
+
+    // Line buffered cout/cerr: whole lines are written at once and prefixed
+    // with the sweep point of the thread, so that the output of concurrent
+    // simulations does not get mixed within a line
+    class SweepStreamBuf : public streambuf {
+
+    public:
+      SweepStreamBuf( streambuf * out, int stream ) : _out(out), _stream(stream) {}
+
+      // Writes the unfinished line of the calling thread, if any
+      void FlushLine( ) {
+        string & line = _line[_stream];
+        if(!line.empty()) {
+          line += '\n';
+          _WriteLine(line);
+        }
+      }
+
+    protected:
+      virtual int overflow( int c ) {
+        if(c != EOF) {
+          char const ch = (char)c;
+          xsputn(&ch, 1);
+        }
+        return c == EOF ? 0 : c;
+      }
+
+      virtual streamsize xsputn( char const * s, streamsize n ) {
+        string & line = _line[_stream];
+        for(streamsize i = 0; i < n; ++i) {
+          line += s[i];
+          if(s[i] == '\n') {
+            _WriteLine(line);
+          }
+        }
+        return n;
+      }
+
+      virtual int sync( ) {
+        lock_guard<mutex> lock(_lock);
+        return _out->pubsync();
+      }
+
+    private:
+      streambuf * _out;
+      int _stream;
+
+      static mutex _lock;
+      static thread_local string _line[2];
+
+      void _WriteLine( string & line ) {
+        lock_guard<mutex> lock(_lock);
+        if(!gSweepPoint.empty()) {
+          _out->sputn(gSweepPoint.data(), gSweepPoint.size());
+        }
+        _out->sputn(line.data(), line.size());
+        line.clear();
+      }
+    };
+
+    mutex SweepStreamBuf::_lock;
+    thread_local string SweepStreamBuf::_line[2];
+
+    bool Sweep( BookSimConfig const & config )
+    {
+      string const param = config.GetStr("sweep_param");
+      vector<string> const values = config.GetStrArray("sweep_values");
+      if(values.empty()) {
+        cout << "Error: sweep_param is set but sweep_values is empty." << endl;
+        exit(-1);
+      }
+      string const watch_out_file = config.GetStr("watch_out");
+      if((watch_out_file != "") && (watch_out_file != "-")) {
+        cout << "Error: watch_out can only be \"-\" in sweep mode." << endl;
+        exit(-1);
+      }
+
+      // The configuration parser is not reentrant: parse every point before
+      // starting the threads
+      vector<BookSimConfig> points(values.size(), config);
+      for(size_t p = 0; p < values.size(); ++p) {
+        points[p].ParseString(param + "=" + values[p]);
+      }
+
+      int threads = config.GetInt("sweep_threads");
+      if(threads <= 0) {
+        threads = max((int)thread::hardware_concurrency(), 1);
+      }
+      threads = min(threads, (int)values.size());
+
+      vector<ostringstream> csv(values.size());
+      vector<char> results(values.size(), 0);
+      atomic<size_t> next(0);
+
+      SweepStreamBuf out_buf(cout.rdbuf(), 0);
+      SweepStreamBuf err_buf(cerr.rdbuf(), 1);
+      streambuf * const cout_buf = cout.rdbuf(&out_buf);
+      streambuf * const cerr_buf = cerr.rdbuf(&err_buf);
+
+      auto run_points = [&]( ) {
+        size_t p;
+        while((p = next.fetch_add(1)) < points.size()) {
+          gSweepPoint = "[" + param + "=" + values[p] + "] ";
+          SimContext context;
+          gSim = &context;
+          InitializeSimulation( points[p] );
+          results[p] = Simulate( points[p], &csv[p] );
+          gSim = NULL;
+          out_buf.FlushLine();
+          err_buf.FlushLine();
+          gSweepPoint.clear();
+        }
+      };
+
+      vector<thread> workers;
+      for(int t = 1; t < threads; ++t) {
+        workers.push_back(thread(run_points));
+      }
+      run_points();
+      for(size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+      }
+
+      cout.rdbuf(cout_buf);
+      cerr.rdbuf(cerr_buf);
+
+      // Merge the stats of all points, prefixing each row with its value
+      string const csv_file = config.GetStr("sweep_csv");
+      ostream * os = &cout;
+      if(csv_file != "-") {
+        os = new ofstream(csv_file.c_str());
+      }
+      bool header = false;
+      bool all_results = true;
+      for(size_t p = 0; p < values.size(); ++p) {
+        if(!results[p]) {
+          cout << "Sweep point " << param << " = " << values[p]
+               << " did not finish, it is left out of the CSV." << endl;
+          all_results = false;
+          continue;
+        }
+        istringstream rows(csv[p].str());
+        string row;
+        // The first line of each point is the header
+        getline(rows, row);
+        if(!header) {
+          *os << param << ',' << row << endl;
+          header = true;
+        }
+        while(getline(rows, row)) {
+          *os << values[p] << ',' << row << endl;
+        }
+      }
+      if(os != &cout) {
+        delete os;
+      }
+
+      return all_results;
+    }
 } // namespace Booksim
 
 using namespace Booksim;
@@ -183,22 +352,6 @@ int main( int argc, char **argv )
  } 
 
   
-  /*initialize routing, traffic, injection functions
-   */
-  InitializeRoutingMap( config );
-
-  gPrintActivity = (config.GetInt("print_activity") > 0);
-  gTrace = (config.GetInt("viewer_trace") > 0);
-  
-  string watch_out_file = config.GetStr( "watch_out" );
-  if(watch_out_file == "") {
-    gWatchOut = NULL;
-  } else if(watch_out_file == "-") {
-    gWatchOut = &cout;
-  } else {
-    gWatchOut = new ofstream(watch_out_file.c_str());
-  }
-  
   /*configure and run the simulator
    */
   string write_config_file = config.GetStr("write_config_file");
@@ -206,6 +359,15 @@ int main( int argc, char **argv )
       config.WriteFile(write_config_file);
   }
 
+  if(config.GetStr("sweep_param") != "") {
+    return Sweep( config ) ? 0 : -1;
+  }
+
+  SimContext context;
+  gSim = &context;
+
+  InitializeSimulation( config );
+
   bool result = Simulate( config );
   return result ? 0 : -1;
 }
@@ -27,6 +27,97 @@
  */
 
 #include "netrace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/types.h>
+#include <bzlib.h>
+#ifdef NT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Trace files are decoded in-process: bzip2 and (optionally) zstd streams are
+// recognized by their magic number, anything else is read as an uncompressed
+// trace. Decoded offsets are tracked so region seeks only decode forward.
+struct nt_stream {
+	FILE* file;
+	int format;
+	char* in_buffer;
+	char* out_buffer;
+	size_t out_pos;
+	size_t out_size;
+	unsigned long long int offset;  // Decoded bytes consumed so far
+	int eof;
+	bz_stream bz;
+	int bz_active;
+#ifdef NT_HAVE_ZSTD
+	ZSTD_DStream* zstd;
+	ZSTD_inBuffer zstd_in;
+	size_t zstd_ret;
+	int zstd_pending;
+#endif
+};
+
+// Lock-free single-producer/single-consumer ring of packet pointers
+typedef struct nt_packet_ring nt_packet_ring_t;
+struct nt_packet_ring {
+	nt_packet_t** slots;
+	unsigned long long int mask;
+	unsigned long long int head __attribute__((aligned(64)));  // Next slot to pop
+	unsigned long long int tail __attribute__((aligned(64)));  // Next slot to push
+};
+
+// The reader thread decodes packets ahead of the simulator into the packets
+// ring. Packets freed by the simulator flow back through the pool ring, so in
+// steady state no packet or dependency buffer is allocated.
+struct nt_reader {
+	nt_stream_t* stream;
+	nt_packet_ring_t* packets;
+	nt_packet_ring_t* pool;
+	pthread_t thread;
+	int running;
+	int stop;
+	int done;
+};
+
+static nt_packet_ring_t* nt_ring_new( unsigned int size ) {
+	void* ptr = NULL;
+	if( posix_memalign( &ptr, 64, sizeof(nt_packet_ring_t) ) != 0 ) {
+		nt_error( "bad allocation of packet ring" );
+	}
+	nt_packet_ring_t* ring = (nt_packet_ring_t*) ptr;
+	memset( ring, 0, sizeof(nt_packet_ring_t) );
+	ring->slots = (nt_packet_t**) nt_checked_malloc( size * sizeof(nt_packet_t*) );
+	ring->mask = size - 1;
+	return ring;
+}
+
+static void nt_ring_free( nt_packet_ring_t* ring ) {
+	free( ring->slots );
+	free( ring );
+}
+
+// Producer side
+static int nt_ring_push( nt_packet_ring_t* ring, nt_packet_t* packet ) {
+	unsigned long long int tail = __atomic_load_n( &ring->tail, __ATOMIC_RELAXED );
+	if( tail - __atomic_load_n( &ring->head, __ATOMIC_ACQUIRE ) > ring->mask ) {
+		return 0;
+	}
+	ring->slots[tail & ring->mask] = packet;
+	__atomic_store_n( &ring->tail, tail + 1, __ATOMIC_RELEASE );
+	return 1;
+}
+
+// Consumer side
+static nt_packet_t* nt_ring_pop( nt_packet_ring_t* ring ) {
+	unsigned long long int head = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+	if( head == __atomic_load_n( &ring->tail, __ATOMIC_ACQUIRE ) ) {
+		return NULL;
+	}
+	nt_packet_t* packet = ring->slots[head & ring->mask];
+	__atomic_store_n( &ring->head, head + 1, __ATOMIC_RELEASE );
+	return packet;
+}
 
 const char* nt_packet_types[] = { "InvalidCmd", "ReadReq", "ReadResp",
 				"ReadRespWithInvalidate", "WriteReq", "WriteResp",
@@ -53,15 +144,11 @@ const char* nt_node_types[] = { "L1 Data Cache", "L1 Instruction Cache",
 
 void nt_open_trfile( nt_context_t* ctx, const char* trfilename ) {
 	nt_close_trfile( ctx );
-	int i;
-	int length = 20;
-	for( i = 0; trfilename[i] != 0; i++, length++ );
-	ctx->input_popencmd = (char*) nt_checked_malloc( length * sizeof(char) );
-	sprintf( ctx->input_popencmd, "bzip2 -dc %s", trfilename );
-	ctx->input_tracefile = popen( ctx->input_popencmd, "r" );
+	ctx->input_tracefile = fopen( trfilename, "rb" );
 	if( ctx->input_tracefile == NULL ) {
-		nt_error( "failed to open pipe to trace file" );
+		nt_error( "failed to open trace file" );
 	}
+	ctx->input_reader = nt_reader_new( ctx->input_tracefile );
 	ctx->input_trheader = nt_read_trheader( ctx );
 	if( ctx->dependency_array == NULL ) {
 		ctx->dependency_array = nt_checked_malloc( sizeof(nt_dep_ref_node_t*) * NT_DEPENDENCY_ARRAY_SIZE );
@@ -89,15 +176,17 @@ nt_header_t* nt_read_trheader( nt_context_t* ctx ) {
 	};
 	#pragma pack(pop)
 
-	int err = 0;
 	char strerr[180];
+	nt_stream_t* stream = ctx->input_reader->stream;
 
 	// Read Header
 	struct nt_header_pack* in_header = nt_checked_malloc( sizeof(struct nt_header_pack) );
-	fseek( ctx->input_tracefile, 0, SEEK_SET );
-	if( (err = fread( in_header, sizeof(struct nt_header_pack), 1, ctx->input_tracefile )) < 0 ) {
-		sprintf( strerr, "failed to read trace file header: err = %d", err );
-		nt_error( strerr );
+	nt_reader_stop( ctx->input_reader );
+	if( nt_stream_offset( stream ) != 0 ) {
+		nt_stream_rewind( stream );
+	}
+	if( nt_stream_read( stream, in_header, sizeof(struct nt_header_pack) ) != sizeof(struct nt_header_pack) ) {
+		nt_error( "failed to read trace file header" );
 	}
 
 	// Copy data from struct to header
@@ -128,9 +217,8 @@ nt_header_t* nt_read_trheader( nt_context_t* ctx ) {
 	// Read Rest of Header
 	if( to_return->notes_length > 0 && to_return->notes_length < 8192 ) {
 		to_return->notes = (char*) nt_checked_malloc( to_return->notes_length * sizeof(char) );
-		if( (err = fread( to_return->notes, sizeof(char), to_return->notes_length, ctx->input_tracefile )) < 0 ) {
-			sprintf( strerr, "failed to read trace file header notes: err = %d\n", err );
-			nt_error( strerr );
+		if( nt_stream_read( stream, to_return->notes, to_return->notes_length ) != to_return->notes_length ) {
+			nt_error( "failed to read trace file header notes" );
 		}
 	} else {
 		to_return->notes = NULL;
@@ -138,9 +226,9 @@ nt_header_t* nt_read_trheader( nt_context_t* ctx ) {
 	if( to_return->num_regions > 0 ) {
 		if( to_return->num_regions <= 100 ) {
 			to_return->regions = (nt_regionhead_t*) nt_checked_malloc( to_return->num_regions * sizeof(nt_regionhead_t) );
-			if( (err = fread( to_return->regions, sizeof(nt_regionhead_t), to_return->num_regions, ctx->input_tracefile )) < 0 ) {
-				sprintf( strerr, "failed to read trace file header regions: error = %d\n", err );
-				nt_error( strerr );
+			size_t length = to_return->num_regions * sizeof(nt_regionhead_t);
+			if( nt_stream_read( stream, to_return->regions, length ) != length ) {
+				nt_error( "failed to read trace file header regions" );
 			}
 		} else {
 			nt_error( "lots of regions... is this correct?" );
@@ -159,31 +247,20 @@ void nt_disable_dependencies( nt_context_t* ctx ) {
 }
 
 void nt_seek_region( nt_context_t* ctx, nt_regionhead_t* region ) {
-	int err = 0;
-	char strerr[180];
 	if( ctx->input_tracefile != NULL ) {
 		if( region != NULL ) {
 			// Clear all existing dependencies
 			nt_delete_all_dependencies( ctx );
-			// Reopen file to fast-forward to region
-			// fseek doesn't work on compressed file
-			pclose( ctx->input_tracefile );
-			ctx->input_tracefile = popen( ctx->input_popencmd, "r" );
+			// Packets the reader thread decoded ahead are discarded; it
+			// restarts from the region on the next read
+			nt_reader_stop( ctx->input_reader );
+			nt_stream_t* stream = ctx->input_reader->stream;
 			unsigned long long int seek_offset = nt_get_headersize( ctx ) + region->seek_offset;
-			unsigned long long int read_length = 4096;
-			char* buffer = (char*) nt_checked_malloc( read_length );
-			while( seek_offset > read_length ) {
-				if( (err = fread( buffer, 1, read_length, ctx->input_tracefile )) < 0 ) {
-					sprintf( strerr, "failed to seek region: error = %d\n", err );
-					nt_error( strerr );
-				}
-				seek_offset -= read_length;
-			}
-			if( (err = fread( buffer, 1, seek_offset, ctx->input_tracefile )) < 0 ) {
-				sprintf( strerr, "failed to seek region: error = %d\n", err );
-				nt_error( strerr );
+			if( seek_offset < nt_stream_offset( stream ) ) {
+				// Compressed streams only decode forward
+				nt_stream_rewind( stream );
 			}
-			free( buffer );
+			nt_stream_skip( stream, seek_offset - nt_stream_offset( stream ) );
 			if( ctx->self_throttling ) {
 				// Prime the pump to read in self throttled packets
 				nt_prime_self_throttle( ctx );
@@ -197,37 +274,14 @@ void nt_seek_region( nt_context_t* ctx, nt_regionhead_t* region ) {
 }
 
 nt_packet_t* nt_read_packet( nt_context_t* ctx ) {
-
-	#pragma pack(push,1)
-	struct nt_packet_pack {
-		unsigned long long int cycle;
-		unsigned int id;
-		unsigned int addr;
-		unsigned char type;
-		unsigned char src;
-		unsigned char dst;
-		unsigned char node_types;
-		unsigned char num_deps;
-	};
-	#pragma pack(pop)
-
-	int err = 0;
 	unsigned int i;
-	char strerr[180];
 	nt_packet_t* to_return = NULL;
 	if( ctx->input_tracefile != NULL ) {
-		to_return = nt_packet_malloc();
-		if( (err = fread( to_return, 1, sizeof(struct nt_packet_pack), ctx->input_tracefile )) < 0 ) {
-			sprintf( strerr, "failed to read packet: err = %d", err );
-			nt_error( strerr );
-		}
-		if( err > 0 && err < sizeof(struct nt_packet_pack) ) {
-			// Bad packet - end of file
-			nt_error( "unexpectedly reached end of trace file - perhaps corrupt" );
-		} else if( err == 0 ) {
+		// Decoded by the reader thread; dependencies are tracked here, in
+		// trace order
+		to_return = nt_reader_next( ctx->input_reader );
+		if( to_return == NULL ) {
 			// End of file
-			free( to_return );
-			to_return = NULL;
 			return to_return;
 		}
 		if( !ctx->dependencies_off ) {
@@ -240,24 +294,15 @@ nt_packet_t* nt_read_packet( nt_context_t* ctx ) {
 		}
 		ctx->num_active_packets++;
 		ctx->latest_active_packet_cycle = to_return->cycle;
-		if( to_return->num_deps == 0 ) {
-			to_return->deps = NULL;
-		} else {
-			to_return->deps = nt_dependency_malloc( to_return->num_deps );
-			if( (err = fread( to_return->deps, sizeof(nt_dependency_t), to_return->num_deps, ctx->input_tracefile )) < 0 ) {
-				sprintf( strerr, "failed to read dependencies: err = %d", err );
-				nt_error( strerr );
-			}
-			if( !ctx->dependencies_off ) {
-				// Track dependencies: add to_return downward dependencies to array
-				for( i = 0; i < to_return->num_deps; i++ ) {
-					unsigned int dep_id = to_return->deps[i];
-					nt_dep_ref_node_t* node_ptr = nt_get_dependency_node( ctx, dep_id );
-					if( node_ptr == NULL ) {
-						node_ptr = nt_add_dependency_node( ctx, dep_id );
-					}
-					node_ptr->ref_count++;
+		if( !ctx->dependencies_off ) {
+			// Track dependencies: add to_return downward dependencies to array
+			for( i = 0; i < to_return->num_deps; i++ ) {
+				unsigned int dep_id = to_return->deps[i];
+				nt_dep_ref_node_t* node_ptr = nt_get_dependency_node( ctx, dep_id );
+				if( node_ptr == NULL ) {
+					node_ptr = nt_add_dependency_node( ctx, dep_id );
 				}
+				node_ptr->ref_count++;
 			}
 		}
 	} else {
@@ -406,7 +451,7 @@ void nt_clear_dependencies_free_packet( nt_context_t* ctx, nt_packet_t* packet )
 				}
 			}
 			nt_remove_dependency_node( ctx, packet->id );
-			nt_packet_free( packet );
+			nt_recycle_packet( ctx, packet );
 			ctx->num_active_packets--;
 		}
 	} else {
@@ -471,13 +516,11 @@ void nt_empty_cleared_packets_list( nt_context_t* ctx ) {
 
 void nt_close_trfile( nt_context_t* ctx ) {
 	if( ctx->input_tracefile != NULL ) {
-		pclose( ctx->input_tracefile );
+		nt_reader_free( ctx->input_reader );
+		ctx->input_reader = NULL;
+		fclose( ctx->input_tracefile );
 		ctx->input_tracefile = NULL;
 		nt_free_trheader( ctx->input_trheader );
-		if( ctx->input_popencmd != NULL ) {
-			free( ctx->input_popencmd );
-		}
-		ctx->input_popencmd = NULL;
 		nt_delete_all_dependencies( ctx );
 		free(ctx->dependency_array);
 		ctx->dependency_array = NULL;
@@ -548,9 +591,10 @@ float nt_get_trversion( nt_context_t* ctx ) {
 }
 
 nt_packet_t* nt_packet_malloc() {
-	// TODO: v1.1?
-	// Allocate large array (1+ pages) to reduce # system calls
-	return (nt_packet_t*) nt_checked_malloc( sizeof(nt_packet_t) );
+	// Packets read from a trace are recycled through the reader's pool
+	nt_packet_t* packet = (nt_packet_t*) nt_checked_malloc( sizeof(nt_packet_t) );
+	memset( packet, 0, sizeof(nt_packet_t) );
+	return packet;
 }
 
 nt_dependency_t* nt_dependency_malloc( unsigned char num_deps ) {
@@ -595,8 +639,11 @@ nt_packet_t* nt_packet_copy( nt_packet_t* packet ) {
 	if( packet != NULL ) {
 		nt_packet_t* to_return = nt_packet_malloc();
 		memcpy( to_return, packet, sizeof(nt_packet_t) );
+		to_return->deps = NULL;
+		to_return->deps_capacity = 0;
 		if( packet->num_deps > 0 ) {
 			to_return->deps = nt_dependency_malloc( to_return->num_deps );
+			to_return->deps_capacity = to_return->num_deps;
 			memcpy( to_return->deps, packet->deps, sizeof(nt_dependency_t) * to_return->num_deps );
 		}
 		return to_return;
@@ -606,7 +653,7 @@ nt_packet_t* nt_packet_copy( nt_packet_t* packet ) {
 
 void nt_packet_free( nt_packet_t* packet ) {
 	if( packet != NULL ) {
-		if( packet->num_deps > 0 ) {
+		if( packet->deps != NULL ) {
 			free( packet->deps );
 		}
 		free( packet );
@@ -708,6 +755,363 @@ void _nt_error( const char* str, char* file, int line ) {
 #endif
 }
 
+void nt_recycle_packet( nt_context_t* ctx, nt_packet_t* packet ) {
+	if( ctx->input_reader == NULL || !nt_ring_push( ctx->input_reader->pool, packet ) ) {
+		nt_packet_free( packet );
+	}
+}
+
+static void nt_stream_bzip2_init( nt_stream_t* stream ) {
+	// Keep pending input across concatenated streams (e.g. written by pbzip2)
+	char* next_in = stream->bz.next_in;
+	unsigned int avail_in = stream->bz.avail_in;
+	memset( &stream->bz, 0, sizeof(bz_stream) );
+	if( BZ2_bzDecompressInit( &stream->bz, 0, 0 ) != BZ_OK ) {
+		nt_error( "failed to initialize bzip2 decoder" );
+	}
+	stream->bz.next_in = next_in;
+	stream->bz.avail_in = avail_in;
+	stream->bz_active = 1;
+}
+
+nt_stream_t* nt_stream_open( FILE* file ) {
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	nt_stream_t* stream = (nt_stream_t*) nt_checked_malloc( sizeof(nt_stream_t) );
+	memset( stream, 0, sizeof(nt_stream_t) );
+	stream->file = file;
+	stream->in_buffer = (char*) nt_checked_malloc( NT_STREAM_BUFFER_SIZE );
+	stream->out_buffer = (char*) nt_checked_malloc( NT_STREAM_BUFFER_SIZE );
+	size_t length = fread( magic, 1, 4, file );
+	if( length >= 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h' ) {
+		stream->format = NT_FORMAT_BZIP2;
+	} else if( length == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD ) {
+#ifdef NT_HAVE_ZSTD
+		stream->format = NT_FORMAT_ZSTD;
+		stream->zstd = ZSTD_createDStream();
+		if( stream->zstd == NULL ) {
+			nt_error( "failed to initialize zstd decoder" );
+		}
+#else
+		nt_error( "zstd trace files need netrace built with NT_HAVE_ZSTD" );
+#endif
+	} else {
+		stream->format = NT_FORMAT_RAW;
+	}
+	nt_stream_rewind( stream );
+	return stream;
+}
+
+void nt_stream_close( nt_stream_t* stream ) {
+	if( stream != NULL ) {
+		if( stream->bz_active ) {
+			BZ2_bzDecompressEnd( &stream->bz );
+		}
+#ifdef NT_HAVE_ZSTD
+		if( stream->zstd != NULL ) {
+			ZSTD_freeDStream( stream->zstd );
+		}
+#endif
+		free( stream->in_buffer );
+		free( stream->out_buffer );
+		free( stream );
+	}
+}
+
+void nt_stream_rewind( nt_stream_t* stream ) {
+	if( fseeko( stream->file, 0, SEEK_SET ) != 0 ) {
+		nt_error( "failed to rewind trace file" );
+	}
+	stream->out_pos = stream->out_size = 0;
+	stream->offset = 0;
+	stream->eof = 0;
+	if( stream->format == NT_FORMAT_BZIP2 ) {
+		if( stream->bz_active ) {
+			BZ2_bzDecompressEnd( &stream->bz );
+		}
+		stream->bz.avail_in = 0;
+		nt_stream_bzip2_init( stream );
+	}
+#ifdef NT_HAVE_ZSTD
+	if( stream->format == NT_FORMAT_ZSTD ) {
+		size_t ret = ZSTD_initDStream( stream->zstd );
+		if( ZSTD_isError( ret ) ) {
+			nt_error( ZSTD_getErrorName( ret ) );
+		}
+		stream->zstd_in.src = stream->in_buffer;
+		stream->zstd_in.size = 0;
+		stream->zstd_in.pos = 0;
+		stream->zstd_ret = 0;
+		stream->zstd_pending = 0;
+	}
+#endif
+}
+
+// Decodes the next chunk of the trace into the output buffer and returns its
+// length (0 at the end of the trace)
+static size_t nt_stream_fill( nt_stream_t* stream ) {
+	char strerr[180];
+	size_t length;
+	int exhausted;
+	stream->out_pos = stream->out_size = 0;
+	while( stream->out_size == 0 && !stream->eof ) {
+		switch( stream->format ) {
+		case NT_FORMAT_RAW:
+			stream->out_size = fread( stream->out_buffer, 1, NT_STREAM_BUFFER_SIZE, stream->file );
+			if( stream->out_size == 0 ) {
+				if( ferror( stream->file ) ) {
+					nt_error( "failed to read trace file" );
+				}
+				stream->eof = 1;
+			}
+			break;
+		case NT_FORMAT_BZIP2:
+			exhausted = 0;
+			if( stream->bz.avail_in == 0 ) {
+				length = fread( stream->in_buffer, 1, NT_STREAM_BUFFER_SIZE, stream->file );
+				if( length == 0 ) {
+					if( ferror( stream->file ) ) {
+						nt_error( "failed to read trace file" );
+					}
+					if( !stream->bz_active ) {
+						stream->eof = 1;
+						break;
+					}
+					exhausted = 1;
+				}
+				stream->bz.next_in = stream->in_buffer;
+				stream->bz.avail_in = length;
+			}
+			if( !stream->bz_active ) {
+				nt_stream_bzip2_init( stream );
+			}
+			stream->bz.next_out = stream->out_buffer;
+			stream->bz.avail_out = NT_STREAM_BUFFER_SIZE;
+			int ret = BZ2_bzDecompress( &stream->bz );
+			if( ret == BZ_STREAM_END ) {
+				BZ2_bzDecompressEnd( &stream->bz );
+				stream->bz_active = 0;
+			} else if( ret != BZ_OK ) {
+				sprintf( strerr, "failed to decompress trace file: bzip2 error %d", ret );
+				nt_error( strerr );
+			}
+			stream->out_size = NT_STREAM_BUFFER_SIZE - stream->bz.avail_out;
+			if( stream->out_size == 0 && exhausted && stream->bz_active ) {
+				nt_error( "unexpectedly reached end of compressed trace file - perhaps corrupt" );
+			}
+			break;
+#ifdef NT_HAVE_ZSTD
+		case NT_FORMAT_ZSTD:
+			exhausted = 0;
+			if( stream->zstd_in.pos == stream->zstd_in.size && !stream->zstd_pending ) {
+				length = fread( stream->in_buffer, 1, NT_STREAM_BUFFER_SIZE, stream->file );
+				if( length == 0 ) {
+					if( ferror( stream->file ) ) {
+						nt_error( "failed to read trace file" );
+					}
+					if( stream->zstd_ret == 0 ) {
+						stream->eof = 1;
+						break;
+					}
+					exhausted = 1;
+				}
+				stream->zstd_in.size = length;
+				stream->zstd_in.pos = 0;
+			}
+			ZSTD_outBuffer out = { stream->out_buffer, NT_STREAM_BUFFER_SIZE, 0 };
+			stream->zstd_ret = ZSTD_decompressStream( stream->zstd, &out, &stream->zstd_in );
+			if( ZSTD_isError( stream->zstd_ret ) ) {
+				nt_error( ZSTD_getErrorName( stream->zstd_ret ) );
+			}
+			// A full output buffer may leave decoded data inside the decoder
+			stream->zstd_pending = (out.pos == out.size);
+			stream->out_size = out.pos;
+			if( stream->out_size == 0 && exhausted ) {
+				nt_error( "unexpectedly reached end of compressed trace file - perhaps corrupt" );
+			}
+			break;
+#endif
+		default:
+			nt_error( "unknown trace file format" );
+		}
+	}
+	return stream->out_size;
+}
+
+size_t nt_stream_read( nt_stream_t* stream, void* buffer, size_t length ) {
+	char* dst = (char*) buffer;
+	size_t done = 0;
+	while( done < length ) {
+		if( stream->out_pos == stream->out_size && nt_stream_fill( stream ) == 0 ) {
+			break;
+		}
+		size_t chunk = stream->out_size - stream->out_pos;
+		if( chunk > length - done ) {
+			chunk = length - done;
+		}
+		memcpy( dst + done, stream->out_buffer + stream->out_pos, chunk );
+		stream->out_pos += chunk;
+		done += chunk;
+	}
+	stream->offset += done;
+	return done;
+}
+
+void nt_stream_skip( nt_stream_t* stream, unsigned long long int length ) {
+	unsigned long long int buffered = stream->out_size - stream->out_pos;
+	if( stream->format == NT_FORMAT_RAW && length > buffered ) {
+		// Uncompressed traces seek directly
+		if( fseeko( stream->file, (off_t)(length - buffered), SEEK_CUR ) != 0 ) {
+			nt_error( "failed to seek region" );
+		}
+		stream->out_pos = stream->out_size = 0;
+		stream->offset += length;
+		stream->eof = 0;
+		return;
+	}
+	while( length > 0 ) {
+		if( stream->out_pos == stream->out_size && nt_stream_fill( stream ) == 0 ) {
+			nt_error( "failed to seek region: past the end of the trace file" );
+		}
+		size_t chunk = stream->out_size - stream->out_pos;
+		if( chunk > length ) {
+			chunk = length;
+		}
+		stream->out_pos += chunk;
+		stream->offset += chunk;
+		length -= chunk;
+	}
+}
+
+unsigned long long int nt_stream_offset( nt_stream_t* stream ) {
+	return stream->offset;
+}
+
+int nt_stream_read_packet( nt_stream_t* stream, nt_packet_t* packet ) {
+
+	#pragma pack(push,1)
+	struct nt_packet_pack {
+		unsigned long long int cycle;
+		unsigned int id;
+		unsigned int addr;
+		unsigned char type;
+		unsigned char src;
+		unsigned char dst;
+		unsigned char node_types;
+		unsigned char num_deps;
+	};
+	#pragma pack(pop)
+
+	size_t length = nt_stream_read( stream, packet, sizeof(struct nt_packet_pack) );
+	if( length == 0 ) {
+		// End of file
+		return 0;
+	} else if( length < sizeof(struct nt_packet_pack) ) {
+		// Bad packet - end of file
+		nt_error( "unexpectedly reached end of trace file - perhaps corrupt" );
+	}
+	if( packet->num_deps > packet->deps_capacity ) {
+		if( packet->deps != NULL ) {
+			free( packet->deps );
+		}
+		packet->deps = nt_dependency_malloc( packet->num_deps );
+		packet->deps_capacity = packet->num_deps;
+	}
+	if( packet->num_deps > 0 ) {
+		length = packet->num_deps * sizeof(nt_dependency_t);
+		if( nt_stream_read( stream, packet->deps, length ) != length ) {
+			nt_error( "failed to read dependencies: unexpected end of trace file" );
+		}
+	}
+	return 1;
+}
+
+static void* nt_reader_main( void* arg ) {
+	nt_reader_t* reader = (nt_reader_t*) arg;
+	struct timespec backoff = { 0, 50000 };
+	while( !__atomic_load_n( &reader->stop, __ATOMIC_ACQUIRE ) ) {
+		nt_packet_t* packet = nt_ring_pop( reader->pool );
+		if( packet == NULL ) {
+			packet = nt_packet_malloc();
+		}
+		if( !nt_stream_read_packet( reader->stream, packet ) ) {
+			nt_packet_free( packet );
+			__atomic_store_n( &reader->done, 1, __ATOMIC_RELEASE );
+			break;
+		}
+		while( !nt_ring_push( reader->packets, packet ) ) {
+			// Far enough ahead of the simulator
+			if( __atomic_load_n( &reader->stop, __ATOMIC_ACQUIRE ) ) {
+				nt_packet_free( packet );
+				return NULL;
+			}
+			nanosleep( &backoff, NULL );
+		}
+	}
+	return NULL;
+}
+
+nt_reader_t* nt_reader_new( FILE* file ) {
+	nt_reader_t* reader = (nt_reader_t*) nt_checked_malloc( sizeof(nt_reader_t) );
+	memset( reader, 0, sizeof(nt_reader_t) );
+	reader->stream = nt_stream_open( file );
+	reader->packets = nt_ring_new( NT_PACKET_RING_SIZE );
+	reader->pool = nt_ring_new( NT_PACKET_POOL_SIZE );
+	return reader;
+}
+
+void nt_reader_free( nt_reader_t* reader ) {
+	if( reader != NULL ) {
+		nt_packet_t* packet;
+		nt_reader_stop( reader );
+		while( (packet = nt_ring_pop( reader->pool )) != NULL ) {
+			nt_packet_free( packet );
+		}
+		nt_ring_free( reader->packets );
+		nt_ring_free( reader->pool );
+		nt_stream_close( reader->stream );
+		free( reader );
+	}
+}
+
+void nt_reader_start( nt_reader_t* reader ) {
+	if( !reader->running ) {
+		reader->stop = 0;
+		reader->done = 0;
+		if( pthread_create( &reader->thread, NULL, nt_reader_main, reader ) != 0 ) {
+			nt_error( "failed to start trace reader thread" );
+		}
+		reader->running = 1;
+	}
+}
+
+void nt_reader_stop( nt_reader_t* reader ) {
+	if( reader->running ) {
+		nt_packet_t* packet;
+		__atomic_store_n( &reader->stop, 1, __ATOMIC_RELEASE );
+		pthread_join( reader->thread, NULL );
+		reader->running = 0;
+		// Packets decoded ahead go back to the pool
+		while( (packet = nt_ring_pop( reader->packets )) != NULL ) {
+			if( !nt_ring_push( reader->pool, packet ) ) {
+				nt_packet_free( packet );
+			}
+		}
+	}
+}
+
+nt_packet_t* nt_reader_next( nt_reader_t* reader ) {
+	nt_packet_t* packet;
+	nt_reader_start( reader );
+	while( (packet = nt_ring_pop( reader->packets )) == NULL ) {
+		if( __atomic_load_n( &reader->done, __ATOMIC_ACQUIRE ) ) {
+			// Everything was pushed before done was set
+			return nt_ring_pop( reader->packets );
+		}
+		sched_yield();
+	}
+	return packet;
+}
+
 // Backend functions for creating trace files
 void nt_dump_header( nt_header_t* header, FILE* fp ) {
 
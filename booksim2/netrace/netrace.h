@@ -48,6 +48,12 @@
 #define NT_NODE_TYPE_L2		2
 #define NT_NODE_TYPE_MC		3
 #define NT_READ_AHEAD		1000000
+#define NT_STREAM_BUFFER_SIZE	(1 << 16)
+#define NT_PACKET_RING_SIZE	4096	// Packets decoded ahead by the reader thread (power of two)
+#define NT_PACKET_POOL_SIZE	8192	// Freed packets kept for reuse (power of two)
+#define NT_FORMAT_RAW		0
+#define NT_FORMAT_BZIP2		1
+#define NT_FORMAT_ZSTD		2
 
 // Type Declaration
 typedef unsigned int nt_dependency_t;
@@ -57,6 +63,8 @@ typedef struct nt_packet nt_packet_t;
 typedef struct nt_dep_ref_node nt_dep_ref_node_t;
 typedef struct nt_packet_list nt_packet_list_t;
 typedef struct nt_context nt_context_t;
+typedef struct nt_stream nt_stream_t;
+typedef struct nt_reader nt_reader_t;
 
 struct nt_header {
 	unsigned int nt_magic;
@@ -87,6 +95,7 @@ struct nt_packet {
 	unsigned char node_types;
 	unsigned char num_deps;
 	nt_dependency_t* deps;
+	unsigned int deps_capacity;  // Entries allocated in deps (pooled packets keep their buffer)
 };
 
 struct nt_dep_ref_node {
@@ -102,8 +111,8 @@ struct nt_packet_list {
 };
 
 struct nt_context {
-  char*	input_popencmd;
   FILE*	input_tracefile;
+  nt_reader_t*	input_reader;
   char*	input_buffer;
   nt_header_t*	input_trheader;
   int	dependencies_off;
@@ -164,6 +173,19 @@ void			nt_packet_free( nt_packet_t* );
 void			nt_read_ahead( nt_context_t*, unsigned long long int );
 void			nt_prime_self_throttle( nt_context_t* );
 void			nt_add_cleared_packet_to_list( nt_context_t*, nt_packet_t* );
+void			nt_recycle_packet( nt_context_t*, nt_packet_t* );
+nt_stream_t*		nt_stream_open( FILE* );
+void			nt_stream_close( nt_stream_t* );
+void			nt_stream_rewind( nt_stream_t* );
+size_t			nt_stream_read( nt_stream_t*, void*, size_t );
+void			nt_stream_skip( nt_stream_t*, unsigned long long int );
+unsigned long long int	nt_stream_offset( nt_stream_t* );
+int			nt_stream_read_packet( nt_stream_t*, nt_packet_t* );
+nt_reader_t*		nt_reader_new( FILE* );
+void			nt_reader_free( nt_reader_t* );
+void			nt_reader_start( nt_reader_t* );
+void			nt_reader_stop( nt_reader_t* );
+nt_packet_t*		nt_reader_next( nt_reader_t* );
 void*			_nt_checked_malloc( size_t, char*, int ); // Use the macro defined above instead of this function
 void			_nt_error( const char*, char*, int ); // Use the macro defined above instead of this functio
 
@@ -20,6 +20,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "messages.h"
 #include <cassert>
 #include <cstdlib>
+#include <new>
 
 namespace Booksim
 {
@@ -32,16 +33,18 @@ namespace Booksim
         std::cout << "<MessageSend> Sending message: " << msg.type << ", size: " << msg.size << std::endl;
 #endif
 
-        // cork the connection
+        // cork the connection (shared memory streams have no socket)
         int flag = 1;
-        setsockopt (os.so, SOL_TCP, TCP_CORK, &flag, sizeof (flag));
+        if (os.so >= 0)
+            setsockopt (os.so, SOL_TCP, TCP_CORK, &flag, sizeof (flag));
 
         os.put(&(msg.size), sizeof(int));
         os.put(&msg, msg.size);
 
         // uncork the connection
         flag = 0;
-        setsockopt (os.so, SOL_TCP, TCP_CORK, &flag, sizeof (flag));
+        if (os.so >= 0)
+            setsockopt (os.so, SOL_TCP, TCP_CORK, &flag, sizeof (flag));
 
         // os.flush();
 
@@ -100,4 +103,32 @@ namespace Booksim
         assert (msg != NULL);
         free(msg);
     }
+
+    SyncReqMsg * SyncReqMsg::create(int count)
+    {
+        assert (count >= 0);
+        size_t const bytes = sizeof(SyncReqMsg) + count * sizeof(InjectRecord);
+        void * mem = malloc(bytes);
+        assert (mem != NULL);
+        SyncReqMsg * msg = new (mem) SyncReqMsg();
+        msg->size = bytes;
+        msg->cycles = 1;
+        msg->count = count;
+        return msg;
+    }
+
+    SyncResMsg * SyncResMsg::create(int count)
+    {
+        assert (count >= 0);
+        size_t const bytes = sizeof(SyncResMsg) + count * sizeof(EjectRecord);
+        void * mem = malloc(bytes);
+        assert (mem != NULL);
+        SyncResMsg * msg = new (mem) SyncResMsg();
+        msg->size = bytes;
+        msg->cycles = 0;
+        msg->quantum = 1;
+        msg->lookahead = 1;
+        msg->count = count;
+        return msg;
+    }
 } // namespace Booksim
@@ -37,6 +37,8 @@ namespace Booksim
 #define EJECT_RES  		7
 #define QUIT_REQ  		8
 #define QUIT_RES  		9
+#define SYNC_REQ  		10
+#define SYNC_RES  		11
 
     struct StreamMessage
     {
@@ -174,6 +176,71 @@ namespace Booksim
             type = QUIT_RES;
         }
     };
+
+    /*
+     * Batched synchronization. Instead of a STEP_REQ round trip per cycle,
+     * the client sends one SYNC_REQ with every injection of the next
+     * `cycles` cycles and gets one SYNC_RES with every ejection that
+     * happened in them. Records are stored right after the message header,
+     * so the messages are variable sized: build them with create() and
+     * release them with StreamMessage::destroy().
+     */
+    struct InjectRecord
+    {
+        int offset;     // cycle within the quantum
+        int source;
+        int dest;
+        int id;
+        int packetSize;
+        int network;
+        int cl;
+        int miss_pred;
+        int msgType;
+        int coType;
+        unsigned long long address;
+    };
+
+    struct EjectRecord
+    {
+        int offset;     // cycle within the quantum
+        int id;
+        int source;
+        int dest;
+        int packetSize;
+        int network;
+        int cl;
+        int miss_pred;
+    };
+
+    struct SyncReqMsg: StreamMessage
+    {
+        SyncReqMsg()
+        {
+            size = sizeof(SyncReqMsg);
+            type = SYNC_REQ;
+        }
+        int cycles;     // cycles to advance, at most the server quantum
+        int count;      // injection records that follow
+
+        InjectRecord * records() { return (InjectRecord *)(this + 1); }
+        static SyncReqMsg * create(int count);
+    };
+
+    struct SyncResMsg: StreamMessage
+    {
+        SyncResMsg()
+        {
+            size = sizeof(SyncResMsg);
+            type = SYNC_RES;
+        }
+        int cycles;     // cycles advanced
+        int quantum;    // largest quantum the server accepts
+        int lookahead;  // minimum network latency
+        int count;      // ejection records that follow
+
+        EjectRecord * records() { return (EjectRecord *)(this + 1); }
+        static SyncResMsg * create(int count);
+    };
 } // namespace Booksim
 
 #endif /* MESSAGES_H_ */
@@ -0,0 +1,225 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "shmstream.h"
+
+#include <cerrno>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Booksim
+{
+
+    // Spin first, then yield, then sleep while the peer is idle
+    static void backoff(unsigned int & spins)
+    {
+        ++spins;
+        if (spins > 4096) {
+            struct timespec ts = { 0, 10000 };
+            nanosleep(&ts, NULL);
+        } else if (spins > 256) {
+            sched_yield();
+        }
+    }
+
+    ShmStream::~ShmStream()
+    {
+        if (segment != NULL)
+        {
+            segment->closed.store(1, memory_order_release);
+            munmap(segment, sizeof(ShmSegment));
+            if (server)
+            {
+                shm_unlink(name.c_str());
+            }
+        }
+    }
+
+    int ShmStream::map(char *in_shm_name, int flags)
+    {
+        name = in_shm_name;
+        int fd = shm_open(in_shm_name, flags, 0600);
+        if (fd < 0) {
+            return -1;
+        }
+        if ((flags & O_CREAT) && ftruncate(fd, sizeof(ShmSegment)) != 0) {
+            close(fd);
+            return -1;
+        }
+        void *ptr = mmap(NULL, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            return -1;
+        }
+        segment = (ShmSegment *) ptr;
+        return 0;
+    }
+
+    int ShmStream::listen(char *in_shm_name)
+    {
+        shm_unlink(in_shm_name);
+        if (map(in_shm_name, O_CREAT | O_EXCL | O_RDWR) < 0) {
+            cout << "Error creating shared memory segment " << in_shm_name << "." << endl;
+            return -1;
+        }
+        // ftruncate zero-fills the segment, so rings start empty
+        server = true;
+        rx = &segment->to_server;
+        tx = &segment->to_client;
+        segment->ring_size = SHM_STREAM_RING_SIZE;
+        segment->server_pid.store(getpid(), memory_order_relaxed);
+        segment->magic.store(SHM_STREAM_MAGIC, memory_order_release);
+
+#ifdef NS_DEBUG
+        cout << "Listening on shared memory segment " << in_shm_name << endl;
+#endif
+
+        return 0;
+    }
+
+    int ShmStream::accept()
+    {
+        while (!segment->attached.load(memory_order_acquire)) {
+            struct timespec ts = { 0, 1000000 };
+            nanosleep(&ts, NULL);
+        }
+        bIsAlive = true;
+        return 0;
+    }
+
+    int ShmStream::connect(char *in_shm_name)
+    {
+        if (map(in_shm_name, O_RDWR) < 0) {
+            cout << "Connection failed." << endl;
+            return -1;
+        }
+        if (segment->magic.load(memory_order_acquire) != SHM_STREAM_MAGIC ||
+            segment->ring_size != SHM_STREAM_RING_SIZE) {
+            cout << "Connection failed: incompatible shared memory segment." << endl;
+            munmap(segment, sizeof(ShmSegment));
+            segment = NULL;
+            return -1;
+        }
+        rx = &segment->to_client;
+        tx = &segment->to_server;
+        segment->client_pid.store(getpid(), memory_order_relaxed);
+        segment->attached.store(1, memory_order_release);
+        bIsAlive = true;
+
+#ifdef NS_DEBUG
+        cout << "Connected to host" << endl;
+#endif
+
+        return 0;
+    }
+
+    bool ShmStream::peerClosed(unsigned int spins)
+    {
+        if (segment->closed.load(memory_order_acquire)) {
+            return true;
+        }
+        // Only probe the peer process once in a while
+        if (spins > 0 && (spins & 0xfff) == 0) {
+            int const pid = server ? segment->client_pid.load(memory_order_relaxed)
+                                   : segment->server_pid.load(memory_order_relaxed);
+            if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int ShmStream::get(void *data, int number)
+    {
+        char *dst = (char *) data;
+        int received = 0;
+        unsigned int spins = 0;
+        while (received < number)
+        {
+            uint64_t const head = rx->head.load(memory_order_relaxed);
+            uint64_t available = rx->tail.load(memory_order_acquire) - head;
+            if (available == 0)
+            {
+                // Data written before the peer closed is still delivered
+                if (peerClosed(spins) &&
+                    rx->tail.load(memory_order_acquire) == head)
+                {
+                    bIsAlive = false;
+                    break;
+                }
+                backoff(spins);
+                continue;
+            }
+            spins = 0;
+            size_t const pos = head % SHM_STREAM_RING_SIZE;
+            size_t const chunk = min((size_t) available,
+                                     min((size_t) (number - received),
+                                         (size_t) SHM_STREAM_RING_SIZE - pos));
+            memcpy(dst + received, rx->data + pos, chunk);
+            rx->head.store(head + chunk, memory_order_release);
+            received += chunk;
+        }
+        return received;
+    }
+
+    int ShmStream::put(const void *data, int number)
+    {
+        const char *src = (const char *) data;
+        int sent = 0;
+        unsigned int spins = 0;
+        while (sent < number)
+        {
+            uint64_t const tail = tx->tail.load(memory_order_relaxed);
+            uint64_t const space = SHM_STREAM_RING_SIZE - (tail - tx->head.load(memory_order_acquire));
+            if (space == 0)
+            {
+                if (peerClosed(spins))
+                {
+                    bIsAlive = false;
+                    break;
+                }
+                backoff(spins);
+                continue;
+            }
+            spins = 0;
+            size_t const pos = tail % SHM_STREAM_RING_SIZE;
+            size_t const chunk = min((size_t) space,
+                                     min((size_t) (number - sent),
+                                         (size_t) SHM_STREAM_RING_SIZE - pos));
+            memcpy(tx->data + pos, src + sent, chunk);
+            tx->tail.store(tail + chunk, memory_order_release);
+            sent += chunk;
+        }
+        return sent;
+    }
+} // namespace Booksim
@@ -0,0 +1,110 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * shmstream.h
+ *
+ * Shared-memory transport for traffic generators running on the same host.
+ * The server creates a POSIX shared memory segment holding one
+ * single-producer/single-consumer byte ring per direction; the client maps
+ * it by name. Messages use the same framing as SocketStream, so everything
+ * in messages.h works unchanged over either transport.
+ *
+ * Waiting is done by spinning and then backing off to short sleeps, which
+ * keeps round trips well below a socket system call while the peer is
+ * active.
+ */
+
+#ifndef SHMSTREAM_H_
+#define SHMSTREAM_H_
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#include "socketstream.h"
+
+namespace Booksim
+{
+
+#define SHM_STREAM_MAGIC 0x52534d42
+#define SHM_STREAM_RING_SIZE (1 << 20)
+
+    // One direction of the connection. head and tail are free-running byte
+    // counts; only the reader moves head and only the writer moves tail.
+    struct ShmRing
+    {
+        alignas(64) atomic<uint64_t> head;
+        alignas(64) atomic<uint64_t> tail;
+        alignas(64) char data[SHM_STREAM_RING_SIZE];
+    };
+
+    struct ShmSegment
+    {
+        atomic<uint32_t> magic;
+        uint32_t ring_size;
+        atomic<int> attached;
+        atomic<int> closed;
+        // lets either side notice a peer that died without closing
+        atomic<int> server_pid;
+        atomic<int> client_pid;
+        ShmRing to_server;
+        ShmRing to_client;
+    };
+
+    class ShmStream : public SocketStream
+    {
+    public:
+        ShmStream() : segment(NULL), rx(NULL), tx(NULL), server(false)
+        {
+        }
+
+        virtual ~ShmStream();
+
+        // server side: create the segment and wait for the client to map it
+        int listen(char *in_shm_name);
+        int accept();
+
+        // client side
+        int connect(char *in_shm_name);
+
+        virtual int get(void *data, int number);
+        virtual int put(const void *data, int number);
+
+    private:
+        int map(char *in_shm_name, int flags);
+        bool peerClosed(unsigned int spins);
+
+        ShmSegment *segment;
+        ShmRing *rx;
+        ShmRing *tx;
+        bool server;
+        string name;
+    };
+} // namespace Booksim
+
+#endif /* SHMSTREAM_H_ */
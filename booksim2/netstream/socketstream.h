@@ -60,7 +60,7 @@ namespace Booksim
         {
         }
 
-        ~SocketStream()
+        virtual ~SocketStream()
         {
             if (so != -1)
             {
@@ -83,10 +83,10 @@ namespace Booksim
         int connect();
 
         // read from the socket
-        int get(void *data, int number);
+        virtual int get(void *data, int number);
 
         // write to socket
-        int put(const void *data, int number);
+        virtual int put(const void *data, int number);
 
         bool isAlive()
         {
@@ -48,19 +48,58 @@
  *Credit channel latency follows the channel latency, even though it travels in revse
  * direction this might not be desired
  *
+ *The routing tables are dense: one output port per (router, destination router),
+ * built with a heap-based Dijkstra per source router, the sources being split
+ * among anynet_threads threads. With anynet_ecmp every minimal port is kept and
+ * min_anynet offers all of them. If anynet_cache names a directory, the parsed
+ * topology and the tables are stored there in binary form, keyed by a hash of the
+ * network file, and later runs on the same file skip the parsing and the routing.
+ *
  */
 
 #include "anynet.hpp"
+#include <atomic>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <sstream>
 #include <limits>
 #include <algorithm>
+#include <queue>
+#include <thread>
+#include <map>
+#include <unistd.h>
+#include "thread_pool.hpp"
 
 namespace Booksim
 {
 
     //this is a hack, I can't easily get the routing talbe out of the network
-    map<int, int>* global_routing_table;
+#define global_anynet (gSim->anynet)
+
+    //bump the version when the layout of the cache file changes
+    static char const cache_magic[8] = {'A','N','Y','N','E','T','0','1'};
+
+    template<class T>
+    static void writeVector(ostream &out, const vector<T> &v){
+      unsigned long long size = v.size();
+      out.write((const char *)&size, sizeof(size));
+      if(size > 0){
+        out.write((const char *)v.data(), size * sizeof(T));
+      }
+    }
+
+    //limit: bytes left in the file, rejects corrupted sizes before allocating
+    template<class T>
+    static bool readVector(istream &in, vector<T> &v, unsigned long long limit){
+      unsigned long long size;
+      if(!in.read((char *)&size, sizeof(size)) || size > limit / sizeof(T)){
+        return false;
+      }
+      v.resize(size);
+      return size == 0 || (bool)in.read((char *)v.data(), size * sizeof(T));
+    }
 
     AnyNet::AnyNet( const Configuration &config, const string & name )
       :  Network( config, name ){
@@ -72,12 +111,8 @@ namespace Booksim
     }
 
     AnyNet::~AnyNet(){
-      for(int i = 0; i < 2; ++i) {
-        for(map<int, map<int, pair<int,int> > >::iterator iter = router_list[i].begin();
-        iter != router_list[i].end();
-        ++iter) {
-          iter->second.clear();
-        }
+      if(gSim && global_anynet == this){
+        global_anynet = NULL;
       }
     }
 
@@ -87,42 +122,61 @@ namespace Booksim
         cout<<"No network file name provided"<<endl;
         exit(-1);
       }
-      //parse the network description file
-      readFile();
+      cache_dir = config.GetStr("anynet_cache");
+      ecmp = (config.GetInt("anynet_ecmp") != 0);
+      threads = config.GetInt("anynet_threads");
+      if(threads < 0){
+        cout<<"Error: anynet_threads must not be negative."<<endl;
+        exit(-1);
+      }
+
+      ifstream network_list(file_name.c_str(), ios::binary);
+      if(!network_list.is_open()){
+        cout<<"Anynet:can't open network file "<<file_name<<endl;
+        exit(-1);
+      }
+      ostringstream contents;
+      contents<<network_list.rdbuf();
+      string const data = contents.str();
+      //FNV-1a
+      file_hash = 14695981039346656037ULL;
+      for(size_t i = 0; i<data.size(); i++){
+        file_hash ^= (unsigned char)data[i];
+        file_hash *= 1099511628211ULL;
+      }
+
+      //parse the network description file unless it is cached
+      if(!loadCache()){
+        readFile(data);
+      }
 
       _channels =0;
       cout<<"========================Network File Parsed=================\n";
       cout<<"******************node listing**********************\n";
-      map<int,  int >::iterator iter;
-      for(iter = node_list.begin(); iter!=node_list.end(); iter++){
-        cout<<"Node "<<iter->first;
-        cout<<"\tRouter "<<iter->second<<endl;
+      for(size_t n = 0; n<node_list.size(); n++){
+        cout<<"Node "<<n;
+        cout<<"\tRouter "<<node_list[n]<<endl;
       }
 
-      map<int,   map<int, pair<int,int> > >::iterator iter3;
       cout<<"\n****************router to node listing*************\n";
-      for(iter3 = router_list[0].begin(); iter3!=router_list[0].end(); iter3++){
-        cout<<"Router "<<iter3->first<<endl;
-        map<int, pair<int,int> >::iterator iter2;
-        for(iter2 = iter3->second.begin(); 
-        iter2!=iter3->second.end(); 
-        iter2++){
-          cout<<"\t Node "<<iter2->first<<" lat "<<iter2->second.second<<endl;
+      for(size_t r = 0; r<router_list[0].size(); r++){
+        cout<<"Router "<<r<<endl;
+        const vector<Link> &links = router_list[0][r];
+        for(size_t l = 0; l<links.size(); l++){
+          cout<<"\t Node "<<links[l].other<<" lat "<<links[l].latency<<endl;
         }
       }
 
       cout<<"\n*****************router to router listing************\n";
-      for(iter3 = router_list[1].begin(); iter3!=router_list[1].end(); iter3++){
-        cout<<"Router "<<iter3->first<<endl;
-        map<int, pair<int,int> >::iterator iter2;
-        if(iter3->second.size() == 0){
-          cout<<"Caution Router "<<iter3->first
+      for(size_t r = 0; r<router_list[1].size(); r++){
+        cout<<"Router "<<r<<endl;
+        const vector<Link> &links = router_list[1][r];
+        if(links.size() == 0){
+          cout<<"Caution Router "<<r
           <<" is not connected to any other Router\n"<<endl;
         }
-        for(iter2 = iter3->second.begin(); 
-        iter2!=iter3->second.end(); 
-        iter2++){
-          cout<<"\t Router "<<iter2->first<<" lat "<<iter2->second.second<<endl;
+        for(size_t l = 0; l<links.size(); l++){
+          cout<<"\t Router "<<links[l].other<<" lat "<<links[l].latency<<endl;
           _channels++;
         }
       }
@@ -135,20 +189,13 @@ namespace Booksim
 
 
     void AnyNet::_BuildNet( const Configuration &config ){
-      
-
-      //I need to keep track the output ports for each router during build
-      int * outport = (int*)malloc(sizeof(int)*_size);
-      for(int i = 0; i<_size; i++){outport[i] = 0;}
 
       cout<<"==========================Node to Router =====================\n";
       //adding the injection/ejection chanenls first
-      map<int,   map<int, pair<int,int> > >::iterator niter;
-      for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-        map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
+      for(int node = 0; node<_size; node++){
+        const vector<Link> &nodes = router_list[0][node];
         //calculate radix
-        int radix = niter->second.size()+riter->second.size();
-        int node = niter->first;
+        int radix = nodes.size()+router_list[1][node].size();
         cout<<"router "<<node<<" radix "<<radix<<endl;
         //decalre the routers 
         ostringstream router_name;
@@ -157,19 +204,15 @@ namespace Booksim
         _routers[node] = Router::NewRouter( config, this, router_name.str( ), 
                             node, radix, radix );
         _timed_modules.push_back(_routers[node]);
-        //add injeciton ejection channels
-        map<int, pair<int,int> >::iterator nniter;
-        for(nniter = niter->second.begin();nniter!=niter->second.end(); nniter++){
-          int link = nniter->first;
-          //add the outport port assined to the map
-          (niter->second)[link].first = outport[node];
-          outport[node]++;
-          cout<<"\t connected to node "<<link<<" at outport "<<nniter->second.first
-          <<" lat "<<nniter->second.second<<endl;
-          _inject[link]->SetLatency(nniter->second.second);
-          _inject_cred[link]->SetLatency(nniter->second.second);
-          _eject[link]->SetLatency(nniter->second.second);
-          _eject_cred[link]->SetLatency(nniter->second.second);
+        //add injeciton ejection channels, their output ports come first
+        for(size_t n = 0; n<nodes.size(); n++){
+          int link = nodes[n].other;
+          cout<<"\t connected to node "<<link<<" at outport "<<nodes[n].port
+          <<" lat "<<nodes[n].latency<<endl;
+          _inject[link]->SetLatency(nodes[n].latency);
+          _inject_cred[link]->SetLatency(nodes[n].latency);
+          _eject[link]->SetLatency(nodes[n].latency);
+          _eject_cred[link]->SetLatency(nodes[n].latency);
 
           _routers[node]->AddInputChannel( _inject[link], _inject_cred[link] );
           _routers[node]->AddOutputChannel( _eject[link], _eject_cred[link] );
@@ -182,23 +225,18 @@ namespace Booksim
       //since there is no way to systematically number the channels we just start from 0
       //the map, is a mapping of output->input
       int channel_count = 0; 
-      for(niter = router_list[0].begin(); niter!=router_list[0].end(); niter++){
-        map<int,   map<int, pair<int,int> > >::iterator riter = router_list[1].find(niter->first);
-        int node = niter->first;
-        map<int, pair<int,int> >::iterator rriter;
+      for(int node = 0; node<_size; node++){
+        const vector<Link> &routers = router_list[1][node];
         cout<<"router "<<node<<endl;
-        for(rriter = riter->second.begin();rriter!=riter->second.end(); rriter++){
-          int other_node = rriter->first;
+        for(size_t r = 0; r<routers.size(); r++){
+          int other_node = routers[r].other;
           int link = channel_count;
-          //add the outport port assined to the map
-          (riter->second)[other_node].first = outport[node];
-          outport[node]++;
           cout<<"\t connected to router "<<other_node<<" using link "<<link
-          <<" at outport "<<rriter->second.first
-          <<" lat "<<rriter->second.second<<endl;
+          <<" at outport "<<routers[r].port
+          <<" lat "<<routers[r].latency<<endl;
 
-          _chan[link]->SetLatency(rriter->second.second);
-          _chan_cred[link]->SetLatency(rriter->second.second);
+          _chan[link]->SetLatency(routers[r].latency);
+          _chan_cred[link]->SetLatency(routers[r].latency);
 
           _routers[node]->AddOutputChannel( _chan[link], _chan_cred[link] );
           _routers[other_node]->AddInputChannel( _chan[link], _chan_cred[link]);
@@ -206,7 +244,14 @@ namespace Booksim
         }
       }
 
-      buildRoutingTable();
+      cout<<"========================== Routing table  =====================\n";  
+      if(routing_table.empty()){
+        buildRoutingTable();
+        if(cache_dir != ""){
+          saveCache();
+        }
+      }
+      global_anynet = this;
 
     }
 
@@ -217,105 +262,154 @@ namespace Booksim
 
     void min_anynet( const Router *r, const Flit *f, int in_channel, 
              OutputSet *outputs, bool inject ){
-      int out_port=-1;
-      if(!inject){
-        assert(global_routing_table[r->GetID()].count(f->dest)!=0);
-        out_port=global_routing_table[r->GetID()][f->dest];
-      }
-     
 
       int vcBegin = gBeginVCs[f->cl];
       int vcEnd = gEndVCs[f->cl];
 
       outputs->Clear( );
 
-      outputs->AddRange( out_port , vcBegin, vcEnd );
+      if(inject){
+        outputs->AddRange( -1 , vcBegin, vcEnd );
+        return;
+      }
+
+      const AnyNet *net = global_anynet;
+      assert(net);
+      if(net->Multipath()){
+        pair<int const *, int const *> ports = net->NextPorts(r->GetID(), f->dest);
+        for(int const *p = ports.first; p != ports.second; p++){
+          outputs->AddRange( *p , vcBegin, vcEnd );
+        }
+      } else {
+        outputs->AddRange( net->NextPort(r->GetID(), f->dest) , vcBegin, vcEnd );
+      }
     }
 
     void AnyNet::buildRoutingTable(){
-      cout<<"========================== Routing table  =====================\n";  
-      routing_table.resize(_size);
-      for(int i = 0; i<_size; i++){
-        route(i);
+      routing_table.assign((size_t)_size * _size, -1);
+      //ecmp: the port count of entry i goes to ecmp_offset[i + 1] and the ports
+      //of each source router to their own row, both are merged at the end
+      vector<vector<int> > row_ports(ecmp ? _size : 0);
+      if(ecmp){
+        ecmp_offset.assign((size_t)_size * _size + 1, 0);
+      }
+
+      int workers = threads;
+      if(workers == 0){
+        workers = thread::hardware_concurrency();
+      }
+      workers = max(1, min(workers, _size));
+
+      atomic<int> next_source(0);
+      vector<int> unused;
+      function<void(int)> job = [&](int) {
+        vector<int> dist;
+        vector<int> hop;
+        vector<vector<int> > hops(ecmp ? _size : 0);
+        int r;
+        while((r = next_source.fetch_add(1)) < _size){
+          route(r, dist, hop, hops, ecmp ? row_ports[r] : unused);
+        }
+      };
+      if(workers > 1){
+        ThreadPool pool(workers);
+        pool.Run(job);
+      } else {
+        job(0);
+      }
+
+      if(ecmp){
+        for(size_t i = 1; i<ecmp_offset.size(); i++){
+          ecmp_offset[i] += ecmp_offset[i - 1];
+        }
+        ecmp_ports.clear();
+        ecmp_ports.reserve(ecmp_offset.back());
+        for(int r = 0; r<_size; r++){
+          ecmp_ports.insert(ecmp_ports.end(), row_ports[r].begin(), row_ports[r].end());
+          vector<int>().swap(row_ports[r]);
+        }
       }
-      global_routing_table = &routing_table[0];
     }
 
 
     //11/7/2012
     //basically djistra's, tested on a large dragonfly anynet configuration
-    void AnyNet::route(int r_start){
-      int* dist = new int[_size];
-      int* prev = new int[_size];
-      set<int> rlist;
-      for(int i = 0; i<_size; i++){
-        dist[i] =  numeric_limits<int>::max();
-        prev[i] = -1;
-        rlist.insert(i);
+    //the heap pops routers by (distance, id), the same order as the former
+    //linear scan, so ties resolve to the same ports
+    void AnyNet::route(int r_start, vector<int> &dist, vector<int> &hop,
+                       vector<vector<int> > &hops, vector<int> &row_ports){
+      typedef pair<int, int> Entry;
+      priority_queue<Entry, vector<Entry>, greater<Entry> > heap;
+      dist.assign(_size, numeric_limits<int>::max());
+      //output port of r_start on the shortest path found so far
+      hop.assign(_size, -1);
+      for(size_t i = 0; i<hops.size(); i++){
+        hops[i].clear();
       }
+      vector<int> merged;
+
       dist[r_start] = 0;
-      while(!rlist.empty()){
-        //find min 
-        int min_dist = numeric_limits<int>::max();
-        int min_cand = -1;
-        for(set<int>::iterator i = rlist.begin();
-        i!=rlist.end();
-        i++){
-          if(dist[*i]<min_dist){
-        min_dist = dist[*i];
-        min_cand = *i;
-          }
+      heap.push(Entry(0, r_start));
+      while(!heap.empty()){
+        Entry const top = heap.top();
+        heap.pop();
+        int const u = top.second;
+        if(top.first != dist[u]){
+          continue; //stale entry
         }
-        rlist.erase(min_cand);
 
         //neighbor
-        for(map<int,pair<int,int> >::iterator i = router_list[1][min_cand].begin(); 
-        i!=router_list[1][min_cand].end(); 
-        i++){
-          int new_dist = dist[min_cand] + i->second.second;//distance is hops not cycles
-          if(new_dist < dist[i->first]){
-        dist[i->first] = new_dist;
-        prev[i->first] = min_cand;
+        const vector<Link> &links = router_list[1][u];
+        for(size_t l = 0; l<links.size(); l++){
+          int const v = links[l].other;
+          int const new_dist = top.first + links[l].latency;
+          if(new_dist < dist[v]){
+            dist[v] = new_dist;
+            hop[v] = (u == r_start) ? links[l].port : hop[u];
+            if(ecmp){
+              if(u == r_start){
+                hops[v].assign(1, links[l].port);
+              } else {
+                hops[v] = hops[u];
+              }
+            }
+            heap.push(Entry(new_dist, v));
+          } else if(ecmp && new_dist == dist[v] && v != r_start){
+            //equal cost path, add its first hops
+            merged.clear();
+            if(u == r_start){
+              merged.push_back(links[l].port);
+            } else {
+              merged = hops[u];
+            }
+            vector<int> ports;
+            set_union(hops[v].begin(), hops[v].end(), merged.begin(), merged.end(),
+                      back_inserter(ports));
+            hops[v].swap(ports);
           }
         }
       }
-      
-      //post process from the prev list
+
+      int *row = &routing_table[(size_t)r_start * _size];
       for(int i = 0; i<_size; i++){
-        if(prev[i] ==-1){ //self
-          assert(i == r_start);
-          for(map<int, pair<int, int> >::iterator iter = router_list[0][i].begin();
-          iter!=router_list[0][i].end();
-          iter++){
-        routing_table[r_start][iter->first]=iter->second.first;
-        //cout<<"node "<<iter->first<<" port "<< iter->second.first<<endl;
-          }
-        } else {
-          int distance=0;
-          int neighbor=i;
-          while(prev[neighbor]!=r_start){
-        assert(router_list[1][neighbor].count(prev[neighbor])>0);
-        distance+=router_list[1][prev[neighbor]][neighbor].second;//REVERSE lat
-        neighbor= prev[neighbor];
-          }
-          distance+=router_list[1][prev[neighbor]][neighbor].second;//lat
-
-          assert( router_list[1][r_start].count(neighbor)!=0);
-          int port = router_list[1][r_start][neighbor].first;
-          for(map<int, pair<int,int> >::iterator iter = router_list[0][i].begin();
-          iter!=router_list[0][i].end();
-          iter++){
-        routing_table[r_start][iter->first]=port;
-        //cout<<"node "<<iter->first<<" port "<< port<<" dist "<<distance<<endl;
-          }
+        if(i == r_start){
+          continue; //ejection, see NextPort
+        }
+        if(hop[i] == -1){
+          cout<<"Anynet:router "<<i<<" can't be reached from router "<<r_start<<endl;
+          exit(-1);
+        }
+        row[i] = hop[i];
+        if(ecmp){
+          row_ports.insert(row_ports.end(), hops[i].begin(), hops[i].end());
+          ecmp_offset[(size_t)r_start * _size + i + 1] = hops[i].size();
         }
       }
     }
 
 
-    void AnyNet::readFile(){
+    void AnyNet::readFile(const string &data){
 
-      ifstream network_list;
       string line;
       enum ParseState{HEAD_TYPE=0,
               HEAD_ID,
@@ -326,169 +420,304 @@ namespace Booksim
              ROUTER,
              UNKNOWN};
 
-      network_list.open(file_name.c_str());
-      if(!network_list.is_open()){
-        cout<<"Anynet:can't open network file "<<file_name<<endl;
-        exit(-1);
-      }
-      
+      //[link type][router][node or router]=latency
+      vector<map<int, int> > links[2];
+      //routers that appear in the file
+      vector<bool> routers;
+      node_list.clear();
+
+      istringstream network_list(data);
       //loop through the entire file
-      while(!network_list.eof()){
-        getline(network_list,line);
-        if(line==""){
-          continue;
-        }
+      while(getline(network_list,line)){
+        istringstream tokens(line);
+        string temp;
 
         ParseState state=HEAD_TYPE;
-        //position to parse out white sspace
-        int pos = 0;
-        int next_pos=-1;
-        string temp;
         //the first node and its type
         int head_id = -1;
         ParseType head_type = UNKNOWN;
         //stuff that head are linked to
         ParseType body_type = UNKNOWN;
         int body_id = -1;
-        int link_weight = 1;
-
-        do{
-
-          //skip empty spaces
-          next_pos = line.find(" ",pos);
-          temp = line.substr(pos,next_pos-pos);
-          pos = next_pos+1;
-          if(temp=="" || temp==" "){
-        continue;
-          }
-
+        //link the next weight applies to
+        ParseType link_type = UNKNOWN;
+        int link_router = -1;
+        int link_other = -1;
+        bool empty = true;
+
+        while(tokens>>temp){
+          empty = false;
           switch(state){
           case HEAD_TYPE:
-        if(temp=="router"){
-          head_type = ROUTER;
-        } else if (temp == "node"){
-          head_type = NODE;
-        } else {
-          cout<<"Anynet:Unknow head of line type "<<temp<<"\n";
-          assert(false);
-        }
-        state=HEAD_ID;
-        break;
+            if(temp=="router"){
+              head_type = ROUTER;
+            } else if (temp == "node"){
+              head_type = NODE;
+            } else {
+              cout<<"Anynet:Unknow head of line type "<<temp<<"\n";
+              exit(-1);
+            }
+            state=HEAD_ID;
+            break;
           case HEAD_ID:
-        //need better error check
-        head_id = atoi(temp.c_str());
-
-        //intialize router structures
-        if(router_list[NODE].count(head_id) == 0){
-          router_list[NODE][head_id] = map<int, pair<int,int> >();
-        }
-        if(router_list[ROUTER].count(head_id) == 0){
-          router_list[ROUTER][head_id] = map<int, pair<int,int> >();
-        }  
-
-        state=BODY_TYPE;
-        break;
+            //need better error check
+            head_id = atoi(temp.c_str());
+            if(head_id < 0){
+              cout<<"Anynet:Negative id in line: "<<line<<endl;
+              exit(-1);
+            }
+
+            //intialize router structures
+            if(head_type==ROUTER){
+              if((int)routers.size() <= head_id){
+                routers.resize(head_id + 1, false);
+                links[NODE].resize(head_id + 1);
+                links[ROUTER].resize(head_id + 1);
+              }
+              routers[head_id] = true;
+            }
+
+            state=BODY_TYPE;
+            break;
           case LINK_WEIGHT:
-        if(temp=="router"||
-           temp == "node"){
-          //ignore
-        } else {
-          link_weight= atoi(temp.c_str());
-          router_list[head_type][head_id][body_id].second=link_weight;
-          break;
-        }
-        //intentionally letting it flow through
+            if(temp=="router"||
+               temp == "node"){
+              //ignore
+            } else {
+              links[link_type][link_router][link_other]=atoi(temp.c_str());
+              break;
+            }
+            //intentionally letting it flow through
           case BODY_TYPE:
-        if(temp=="router"){
-          body_type = ROUTER;
-        } else if (temp == "node"){
-          body_type = NODE;
-        } else {
-          cout<<"Anynet:Unknow body type "<<temp<<"\n";
-          assert(false);
-        }
-        state=BODY_ID;
-        break;
+            if(temp=="router"){
+              body_type = ROUTER;
+            } else if (temp == "node"){
+              body_type = NODE;
+            } else {
+              cout<<"Anynet:Unknow body type "<<temp<<"\n";
+              exit(-1);
+            }
+            state=BODY_ID;
+            break;
           case BODY_ID:
-        body_id = atoi(temp.c_str());	
-        //intialize router structures if necessary
-        if(body_type==ROUTER){
-          if(router_list[NODE].count(body_id) ==0){
-            router_list[NODE][body_id] = map<int, pair<int,int> >();
-          }
-          if(router_list[ROUTER].count(body_id) == 0){
-            router_list[ROUTER][body_id] = map<int, pair<int,int> >();
+            body_id = atoi(temp.c_str());
+            if(body_id < 0){
+              cout<<"Anynet:Negative id in line: "<<line<<endl;
+              exit(-1);
+            }
+            //intialize router structures if necessary
+            if(body_type==ROUTER){
+              if((int)routers.size() <= body_id){
+                routers.resize(body_id + 1, false);
+                links[NODE].resize(body_id + 1);
+                links[ROUTER].resize(body_id + 1);
+              }
+              routers[body_id] = true;
+            }
+
+            if(head_type==NODE && body_type==NODE){ 
+
+              cout<<"Anynet:Cannot connect node to node "<<temp<<"\n";
+              exit(-1);
+
+            } else if(head_type==ROUTER && body_type==ROUTER){
+              links[ROUTER][head_id][body_id]=1;
+              if(links[ROUTER][body_id].count(head_id)==0){
+                links[ROUTER][body_id][head_id]=1;
+              }
+              link_type = ROUTER;
+              link_router = head_id;
+              link_other = body_id;
+            } else {
+              //insert and check node
+              int const node = (head_type==NODE) ? head_id : body_id;
+              int const router = (head_type==NODE) ? body_id : head_id;
+              if((int)node_list.size() <= node){
+                node_list.resize(node + 1, -1);
+              }
+              if(node_list[node]!=-1 &&
+                 node_list[node]!=router){
+                cout<<"Anynet:Node "<<node<<" trying to connect to multiple router "
+                <<router<<" and "<<node_list[node]<<endl;
+                exit(-1);
+              }
+              node_list[node] = router;
+              links[NODE][router][node]=1;
+              link_type = NODE;
+              link_router = router;
+              link_other = node;
+            }
+            state=LINK_WEIGHT;
+            break ;
+          default:
+            cout<<"Anynet:Unknow parse state\n";
+            exit(-1);
+            break;
           }
         }
+        if(!empty &&
+           state!=LINK_WEIGHT &&
+           state!=BODY_TYPE){
+          cout<<"Anynet:Incomplete parse of the line: "<<line<<endl;
+        }
 
-        if(head_type==NODE && body_type==NODE){ 
+      }
 
-          cout<<"Anynet:Cannot connect node to node "<<temp<<"\n";
-          assert(false);
+      //routers are indexed by number, so they must be sequential as well
+      for(size_t r = 0; r<routers.size(); r++){
+        if(!routers[r]){
+          cout<<"Anynet:router numbering must be sequential starting at 0, router "
+          <<r<<" is missing\n";
+          exit(-1);
+        }
+      }
 
-        } else if(head_type==NODE && body_type==ROUTER){
+      //traffic generator assumes node list is sequenctial and starts at 0
+      for(size_t n = 0; n<node_list.size(); n++){
+        if(node_list[n] == -1){
+          cout<<"Anynet:booksim trafficmanager assumes sequential node numbering starting at 0\n";
+          exit(-1);
+        }
+      }
 
-          if(node_list.count(head_id)!=0 &&
-             node_list[head_id]!=body_id){
-            cout<<"Anynet:Node "<<body_id<<" trying to connect to multiple router "
-            <<body_id<<" and "<<node_list[head_id]<<endl;
-            assert(false);
-          }
-          node_list[head_id]=body_id;
-          router_list[NODE][body_id][head_id]=pair<int, int>(-1,1);
-
-        } else if(head_type==ROUTER && body_type==NODE){
-          //insert and check node
-          if(node_list.count(body_id) != 0 &&
-             node_list[body_id]!=head_id){
-            cout<<"Anynet:Node "<<body_id<<" trying to connect to multiple router "
-            <<body_id<<" and "<<node_list[head_id]<<endl;
-            assert(false);
+      //output ports: the nodes first, then the other routers, by id
+      node_port.assign(node_list.size(), -1);
+      for(int type = 0; type < 2; type++){
+        router_list[type].assign(routers.size(), vector<Link>());
+      }
+      for(size_t r = 0; r<routers.size(); r++){
+        int port = 0;
+        for(int type = 0; type < 2; type++){
+          vector<Link> &flat = router_list[type][r];
+          flat.reserve(links[type][r].size());
+          for(map<int, int>::const_iterator iter = links[type][r].begin();
+              iter!=links[type][r].end();
+              iter++){
+            Link link;
+            link.other = iter->first;
+            link.port = port++;
+            link.latency = iter->second;
+            flat.push_back(link);
+            if(type == NODE){
+              node_port[link.other] = link.port;
+            }
           }
-          node_list[body_id] = head_id;
-          router_list[NODE][head_id][body_id]=pair<int, int>(-1,1);
+        }
+      }
+      
+    }
 
-        } else if(head_type==ROUTER && body_type==ROUTER){
-          router_list[ROUTER][head_id][body_id]=pair<int, int>(-1,1);
-          if(router_list[ROUTER][body_id].count(head_id)==0){
-            router_list[ROUTER][body_id][head_id]=pair<int, int>(-1,1);
-          }
+
+    string AnyNet::cacheFile() const {
+      ostringstream path;
+      path<<cache_dir<<"/anynet_"<<hex<<setw(16)<<setfill('0')<<file_hash
+          <<(ecmp ? "_ecmp" : "")<<".bin";
+      return path.str();
+    }
+
+    bool AnyNet::loadCache(){
+      if(cache_dir == ""){
+        return false;
+      }
+      string const path = cacheFile();
+      ifstream in(path.c_str(), ios::binary | ios::ate);
+      if(!in.is_open()){
+        return false;
+      }
+      unsigned long long const limit = in.tellg();
+      in.seekg(0);
+
+      char magic[sizeof(cache_magic)];
+      unsigned long long hash = 0;
+      int multipath = -1;
+      in.read(magic, sizeof(magic));
+      in.read((char *)&hash, sizeof(hash));
+      in.read((char *)&multipath, sizeof(multipath));
+      bool valid = in && equal(magic, magic + sizeof(magic), cache_magic) &&
+        hash == file_hash && multipath == (int)ecmp;
+
+      valid = valid && readVector(in, node_list, limit) &&
+        readVector(in, node_port, limit) &&
+        node_port.size() == node_list.size();
+      size_t routers = 0;
+      for(int type = 0; valid && type < 2; type++){
+        vector<int> counts;
+        vector<Link> links;
+        valid = readVector(in, counts, limit) && readVector(in, links, limit);
+        if(!valid){
+          break;
         }
-        state=LINK_WEIGHT;
-        break ;
-          default:
-        cout<<"Anynet:Unknow parse state\n";
-        assert(false);
-        break;
+        if(type == 0){
+          routers = counts.size();
+        }
+        valid = (counts.size() == routers);
+        router_list[type].assign(routers, vector<Link>());
+        size_t next = 0;
+        for(size_t r = 0; valid && r<routers; r++){
+          valid = (counts[r] >= 0) && (next + counts[r] <= links.size());
+          if(valid){
+            router_list[type][r].assign(links.begin() + next, links.begin() + next + counts[r]);
+            next += counts[r];
           }
-
-        } while(pos!=0);
-        if(state!=LINK_WEIGHT &&
-           state!=BODY_TYPE){
-          cout<<"Anynet:Incomplete parse of the line: "<<line<<endl;
         }
-
+        valid = valid && (next == links.size());
+      }
+      valid = valid && readVector(in, routing_table, limit) &&
+        routing_table.size() == routers * routers;
+      if(valid && ecmp){
+        valid = readVector(in, ecmp_offset, limit) && readVector(in, ecmp_ports, limit) &&
+          ecmp_offset.size() == routers * routers + 1 &&
+          ecmp_offset.back() == ecmp_ports.size();
       }
 
-      //map verification, make sure the information contained in bother maps
-      //are the same
-      assert(router_list[0].size() == router_list[1].size());
+      if(!valid){
+        cout<<"Anynet:ignoring invalid cache file "<<path<<endl;
+        node_list.clear();
+        node_port.clear();
+        router_list[0].clear();
+        router_list[1].clear();
+        routing_table.clear();
+        ecmp_offset.clear();
+        ecmp_ports.clear();
+        return false;
+      }
+      cout<<"Anynet:network and routing tables loaded from "<<path<<endl;
+      return true;
+    }
 
-      //traffic generator assumes node list is sequenctial and starts at 0
-      vector<unsigned int> node_check;
-      for(map<int,int>::iterator i = node_list.begin();
-          i!=node_list.end();
-          i++){
-        node_check.push_back(i->first);
-      }
-      sort(node_check.begin(), node_check.end());
-      for(size_t i = 0; i<node_check.size(); i++){
-        if(node_check[i] != i){
-          cout<<"Anynet:booksim trafficmanager assumes sequential node numbering starting at 0\n";
-          assert(false);
+    void AnyNet::saveCache() const {
+      string const path = cacheFile();
+      //concurrent runs on the same file each write their own copy
+      ostringstream tmp_path;
+      tmp_path<<path<<"."<<getpid()<<".tmp";
+      ofstream out(tmp_path.str().c_str(), ios::binary | ios::trunc);
+
+      int const multipath = ecmp;
+      out.write(cache_magic, sizeof(cache_magic));
+      out.write((const char *)&file_hash, sizeof(file_hash));
+      out.write((const char *)&multipath, sizeof(multipath));
+      writeVector(out, node_list);
+      writeVector(out, node_port);
+      for(int type = 0; type < 2; type++){
+        vector<int> counts;
+        vector<Link> links;
+        for(size_t r = 0; r<router_list[type].size(); r++){
+          counts.push_back(router_list[type][r].size());
+          links.insert(links.end(), router_list[type][r].begin(), router_list[type][r].end());
         }
+        writeVector(out, counts);
+        writeVector(out, links);
+      }
+      writeVector(out, routing_table);
+      if(ecmp){
+        writeVector(out, ecmp_offset);
+        writeVector(out, ecmp_ports);
+      }
+      out.close();
+
+      if(!out || rename(tmp_path.str().c_str(), path.c_str()) != 0){
+        cout<<"Anynet:can't write cache file "<<path<<endl;
+        remove(tmp_path.str().c_str());
       }
-      
     }
 } // namespace Booksim
-
@@ -32,28 +32,53 @@
 #include "routefunc.hpp"
 #include <cassert>
 #include <string>
-#include <map>
-#include <list>
+#include <vector>
 
 namespace Booksim
 {
 
     class AnyNet : public Network {
 
+      //a link from a router to a node or to another router
+      struct Link {
+        int other;
+        int port;
+        int latency;
+      };
+
       string file_name;
-      //associtation between  nodes and routers
-      map<int, int > node_list;
-      //[link type][src router][dest router]=(port, latency)
-      vector<map<int,  map<int, pair<int,int> > > > router_list;
-      //stores minimal routing information from every router to every node
-      //[router][dest_node]=port
-      vector<map<int, int> > routing_table;
+      //hash of the network file contents (cache key)
+      unsigned long long file_hash;
+      //directory of the cached topology and tables, empty to disable
+      string cache_dir;
+      bool ecmp;
+      int threads;
+
+      //associtation between nodes and routers
+      //[node]=router
+      vector<int> node_list;
+      //[node]=ejection port at its router
+      vector<int> node_port;
+      //[link type][src router]=links sorted by node/router id
+      vector<vector<vector<Link> > > router_list;
+      //minimal routing information from every router to every other router
+      //[src router * routers + dest router]=port
+      vector<int> routing_table;
+      //ecmp = 1: all minimal ports, ecmp_ports[ecmp_offset[i]..ecmp_offset[i+1])
+      //for the same index i as routing_table
+      vector<size_t> ecmp_offset;
+      vector<int> ecmp_ports;
 
       void _ComputeSize( const Configuration &config );
       void _BuildNet( const Configuration &config );
-      void readFile();
+      void readFile(const string &data);
       void buildRoutingTable();
-      void route(int r_start);
+      void route(int r_start, vector<int> &dist, vector<int> &hop,
+                 vector<vector<int> > &hops, vector<int> &row_ports);
+
+      string cacheFile() const;
+      bool loadCache();
+      void saveCache() const;
 
     public:
       AnyNet( const Configuration &config, const string & name );
@@ -62,6 +87,28 @@ namespace Booksim
       int GetN( ) const{ return -1;}
       int GetK( ) const{ return -1;}
 
+      //minimal output port from router r towards node dest
+      inline int NextPort( int r, int dest ) const {
+        int const dest_router = node_list[dest];
+        if(dest_router == r) {
+          return node_port[dest];
+        }
+        return routing_table[(size_t)r * _size + dest_router];
+      }
+
+      inline bool Multipath( ) const { return ecmp; }
+
+      //all the minimal output ports from router r towards node dest
+      inline pair<int const *, int const *> NextPorts( int r, int dest ) const {
+        int const dest_router = node_list[dest];
+        if(dest_router == r) {
+          return make_pair(&node_port[dest], &node_port[dest] + 1);
+        }
+        size_t const i = (size_t)r * _size + dest_router;
+        int const * base = ecmp_ports.data();
+        return make_pair(base + ecmp_offset[i], base + ecmp_offset[i + 1]);
+      }
+
       static void RegisterRoutingFunctions();
       double Capacity( ) const {return -1;}
       void InsertRandomFaults( const Configuration &config ){}
@@ -53,8 +53,8 @@ namespace Booksim
       int GetN() const { return _n; };
       int GetK() const { return _k; };
       int GetC() const { return _c; };
-      int GetCX() const { return _cX; };
-      int GetCY() const { return _cY; };
+      int GetCX() const { return gSim->cmesh.cx; };
+      int GetCY() const { return gSim->cmesh.cy; };
 
       static int NodeToRouter( int address ) ;
       static int NodeToPort( int address ) ;
@@ -63,13 +63,6 @@ namespace Booksim
 
     private:
 
-      static int _cX ;
-      static int _cY ;
-
-      static int _memo_NodeShiftX ;
-      static int _memo_NodeShiftY ;
-      static int _memo_PortShiftY ;
-
       void _ComputeSize( const Configuration &config );
       void _BuildNet( const Configuration& config );
 
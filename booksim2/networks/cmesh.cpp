@@ -50,11 +50,13 @@
 namespace Booksim
 {
 
-    int CMesh::_cX = 0 ;
-    int CMesh::_cY = 0 ;
-    int CMesh::_memo_NodeShiftX = 0 ;
-    int CMesh::_memo_NodeShiftY = 0 ;
-    int CMesh::_memo_PortShiftY = 0 ;
+    // Shared with the static routing functions, so they are kept in the
+    // context of the current simulation (see sim_context.hpp)
+#define _cX (gSim->cmesh.cx)
+#define _cY (gSim->cmesh.cy)
+#define _memo_NodeShiftX (gSim->cmesh.node_shift_x)
+#define _memo_NodeShiftY (gSim->cmesh.node_shift_y)
+#define _memo_PortShiftY (gSim->cmesh.port_shift_y)
 
     CMesh::CMesh( const Configuration& config, const string & name ) 
         : Network(config, name) 
@@ -40,7 +40,10 @@
 namespace Booksim
 {
 
-    int gP, gA, gG;
+    // Topology parameters of the current simulation (see sim_context.hpp)
+#define gP (gSim->dragonfly.p)
+#define gA (gSim->dragonfly.a)
+#define gG (gSim->dragonfly.g)
 
     //calculate the hop count between src and estination
     int dragonflynew_hopcnt(int src, int dest) 
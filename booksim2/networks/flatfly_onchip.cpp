@@ -63,10 +63,11 @@ namespace Booksim
 
     //#define DEBUG_FLATFLY
 
-    static int _xcount;
-    static int _ycount;
-    static int _xrouter;
-    static int _yrouter;
+    // Topology parameters of the current simulation (see sim_context.hpp)
+#define _xcount (gSim->flatfly.xcount)
+#define _ycount (gSim->flatfly.ycount)
+#define _xrouter (gSim->flatfly.xrouter)
+#define _yrouter (gSim->flatfly.yrouter)
 
     FlatFlyOnChip::FlatFlyOnChip( const Configuration &config, const string & name ) :
       Network( config, name )
@@ -33,6 +33,7 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
@@ -58,6 +59,8 @@
 namespace Booksim
 {
 
+    thread_local vector<TimedModule *> * gDeferredWakes = NULL;
+
     //TODO: Optimize the declaration of Lookahead channels only when they are requirer, i.e. when a bypass router is being used and remove injection and ejection channels if they are not going to be used.
 
     Network::Network(const Configuration &config, const string & name) :
@@ -67,6 +70,10 @@ namespace Booksim
         _nodes    = -1; 
         _channels = -1;
         _classes  = config.GetInt("classes");
+        _activity_scheduling = (config.GetInt("activity_scheduling") > 0);
+        _sorted_routers = 0;
+        _use_timing_wheel = (config.GetInt("timing_wheel") > 0);
+        _thread_pool = NULL;
     }
 
     Network::~Network()
@@ -116,9 +123,10 @@ namespace Booksim
         string sim_type = config.GetStr("sim_type");
         bool synfull = sim_type == "synfull" ? true : false;
         if (synfull) {
-            ni = new NetworkInterface();
+            gNI = new NetworkInterface();
             cout << "Waiting for Traffic Generator client\n";
-            ni->Init((char *) config.GetStr("synfull_socket").c_str());
+            gNI->Init((char *) config.GetStr("synfull_socket").c_str(),
+                      (char *) config.GetStr("synfull_shm").c_str());
         }
 
         if (topo == "torus") {
@@ -180,6 +188,10 @@ namespace Booksim
             n->InsertRandomFaults(config);
         }
 
+        if (n) {
+            n->_BuildSchedule();
+        }
+
         return n;
     }
 
@@ -255,32 +267,248 @@ namespace Booksim
         }
     }
 
-    void Network::ReadInputs()
+    static bool _ScheduleOrderLess(TimedModule const * a, TimedModule const * b)
     {
+        return a->ScheduleOrder() < b->ScheduleOrder();
+    }
+
+    void Network::_BuildSchedule()
+    {
+        if (!_activity_scheduling) {
+            return;
+        }
+        // Everything starts awake; idle modules drop out after the first cycle
+        int order = 0;
+        int max_latency = 1;
         for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
                 iter != _timed_modules.end();
                 ++iter) {
-            (*iter)->ReadInputs();
+            TimedModule * const m = *iter;
+            if (dynamic_cast<Router *>(m)) {
+                m->SetWakeList(&_awake_routers, order++);
+            } else {
+                m->SetWakeList(&_awake_channels, order++,
+                               _use_timing_wheel ? &_timing_wheel : NULL);
+                if (FlitChannel const * const c = dynamic_cast<FlitChannel *>(m)) {
+                    max_latency = max(max_latency, c->GetLatency());
+                } else if (CreditChannel const * const c = dynamic_cast<CreditChannel *>(m)) {
+                    max_latency = max(max_latency, c->GetLatency());
+                } else if (LookaheadChannel const * const c = dynamic_cast<LookaheadChannel *>(m)) {
+                    max_latency = max(max_latency, c->GetLatency());
+                }
+            }
+            m->Wake();
+        }
+        _timing_wheel.Resize(max_latency);
+        _sorted_routers = _awake_routers.size();
+    }
+
+    void Network::_SortAwakeRouters()
+    {
+        if (_sorted_routers == _awake_routers.size()) {
+            return;
+        }
+        vector<TimedModule *>::iterator const woken = _awake_routers.begin() + _sorted_routers;
+        sort(woken, _awake_routers.end(), _ScheduleOrderLess);
+        inplace_merge(_awake_routers.begin(), woken, _awake_routers.end(), _ScheduleOrderLess);
+        _sorted_routers = _awake_routers.size();
+    }
+
+    void Network::_RetireIdle(vector<TimedModule *> & modules)
+    {
+        size_t awake = 0;
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (modules[i]->StayAwake()) {
+                modules[awake++] = modules[i];
+            }
+        }
+        modules.resize(awake);
+    }
+
+    void Network::SetThreadPool(ThreadPool * pool)
+    {
+        _thread_pool = pool;
+        _deferred_wakes.clear();
+        _all_modules.clear();
+        if (!_thread_pool) {
+            return;
+        }
+        _deferred_wakes.resize(_thread_pool->Threads());
+        _all_modules.assign(_timed_modules.begin(), _timed_modules.end());
+    }
+
+    void Network::_ParallelPhase(void (TimedModule::*phase)(),
+                                 vector<TimedModule *> const & first,
+                                 vector<TimedModule *> const & second)
+    {
+        size_t const modules = first.size() + second.size();
+        size_t const threads = _thread_pool->Threads();
+        function<void(int)> const job = [&](int t) {
+            gDeferredWakes = &_deferred_wakes[t];
+            size_t const end = modules * (t + 1) / threads;
+            for (size_t i = modules * t / threads; i < end; ++i) {
+                TimedModule * const m = (i < first.size()) ? first[i] : second[i - first.size()];
+                (m->*phase)();
+            }
+            gDeferredWakes = NULL;
+        };
+        _thread_pool->Run(job);
+        for (size_t t = 0; t < threads; ++t) {
+            vector<TimedModule *> & wakes = _deferred_wakes[t];
+            for (size_t i = 0; i < wakes.size(); ++i) {
+                wakes[i]->Wake();
+            }
+            wakes.clear();
+        }
+    }
+
+    void Network::ReadInputs()
+    {
+        if (_activity_scheduling) {
+            _timing_wheel.WakeDue(GetSimTime());
+        }
+        if (_thread_pool) {
+            if (!_activity_scheduling) {
+                _ParallelPhase(&TimedModule::ReadInputs, _all_modules, vector<TimedModule *>());
+                return;
+            }
+            _SortAwakeRouters();
+            _ParallelPhase(&TimedModule::ReadInputs, _awake_channels, _awake_routers);
+            return;
+        }
+        if (!_activity_scheduling) {
+            for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+                    iter != _timed_modules.end();
+                    ++iter) {
+                (*iter)->ReadInputs();
+            }
+            return;
+        }
+        for (size_t i = 0; i < _awake_channels.size(); ++i) {
+            _awake_channels[i]->ReadInputs();
+        }
+        _SortAwakeRouters();
+        for (size_t i = 0; i < _awake_routers.size(); ++i) {
+            _awake_routers[i]->ReadInputs();
         }
-        
     }
 
     void Network::Evaluate()
     {
-        for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-                iter != _timed_modules.end();
-                ++iter) {
-            (*iter)->Evaluate();
+        if (_thread_pool) {
+            if (!_activity_scheduling) {
+                _ParallelPhase(&TimedModule::Evaluate, _all_modules, vector<TimedModule *>());
+                return;
+            }
+            _SortAwakeRouters();
+            _ParallelPhase(&TimedModule::Evaluate, _awake_channels, _awake_routers);
+            return;
+        }
+        if (!_activity_scheduling) {
+            for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+                    iter != _timed_modules.end();
+                    ++iter) {
+                (*iter)->Evaluate();
+            }
+            return;
+        }
+        for (size_t i = 0; i < _awake_channels.size(); ++i) {
+            _awake_channels[i]->Evaluate();
+        }
+        _SortAwakeRouters();
+        for (size_t i = 0; i < _awake_routers.size(); ++i) {
+            _awake_routers[i]->Evaluate();
         }
     }
 
     void Network::WriteOutputs()
     {
+        if (_thread_pool) {
+            if (!_activity_scheduling) {
+                _ParallelPhase(&TimedModule::WriteOutputs, _all_modules, vector<TimedModule *>());
+                return;
+            }
+            // The routers woken by a delivery of this cycle are not clocked
+            // here, unlike in the serial sweep below; they were idle, so
+            // their WriteOutputs() would not have done anything
+            _SortAwakeRouters();
+            _ParallelPhase(&TimedModule::WriteOutputs, _awake_channels, _awake_routers);
+            _SortAwakeRouters();
+            _RetireIdle(_awake_routers);
+            _sorted_routers = _awake_routers.size();
+            _RetireIdle(_awake_channels);
+            return;
+        }
+        if (!_activity_scheduling) {
+            for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+                    iter != _timed_modules.end();
+                    ++iter) {
+                (*iter)->WriteOutputs();
+            }
+            return;
+        }
+        // Channels deliver first and wake their sinks, so a router that
+        // receives something this cycle is not retired below
+        for (size_t i = 0; i < _awake_channels.size(); ++i) {
+            _awake_channels[i]->WriteOutputs();
+        }
+        _SortAwakeRouters();
+        for (size_t i = 0; i < _awake_routers.size(); ++i) {
+            _awake_routers[i]->WriteOutputs();
+        }
+        _RetireIdle(_awake_routers);
+        _sorted_routers = _awake_routers.size();
+        _RetireIdle(_awake_channels);
+    }
+
+    bool Network::Quiescent() const
+    {
+        if (_activity_scheduling) {
+            return _awake_channels.empty() && _awake_routers.empty() && _timing_wheel.Empty();
+        }
         for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
                 iter != _timed_modules.end();
                 ++iter) {
-            (*iter)->WriteOutputs();
+            if (!(*iter)->Idle()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static long long _EarlierEvent(long long a, long long b)
+    {
+        return ((a < 0) || ((b >= 0) && (b < a))) ? b : a;
+    }
+
+    long long Network::NextEventCycle() const
+    {
+        long long const now = GetSimTime();
+        long long next = -1;
+        if (!_activity_scheduling) {
+            for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+                    iter != _timed_modules.end();
+                    ++iter) {
+                next = _EarlierEvent(next, (*iter)->NextActivity(now));
+                if (next == now) {
+                    return now;
+                }
+            }
+            return next;
+        }
+        for (size_t i = 0; i < _awake_channels.size(); ++i) {
+            next = _EarlierEvent(next, _awake_channels[i]->NextActivity(now));
+            if (next == now) {
+                return now;
+            }
+        }
+        for (size_t i = 0; i < _awake_routers.size(); ++i) {
+            next = _EarlierEvent(next, _awake_routers[i]->NextActivity(now));
+            if (next == now) {
+                return now;
+            }
         }
+        return _EarlierEvent(next, _timing_wheel.Next());
     }
 
     void Network::WriteFlit(Flit *f, int source)
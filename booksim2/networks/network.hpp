@@ -42,6 +42,7 @@
 #include "channel.hpp"
 #include "config_utils.hpp"
 #include "globals.hpp"
+#include "thread_pool.hpp"
 
 namespace Booksim
 {
@@ -73,6 +74,34 @@ namespace Booksim
 
       deque<TimedModule *> _timed_modules;
 
+      // Activity-driven scheduling: only the modules on the wake lists are
+      // clocked. Channels do not interact with each other, so their list is
+      // unordered; routers are clocked in _timed_modules order because they
+      // share the random number generators.
+      bool _activity_scheduling;
+      vector<TimedModule *> _awake_channels;
+      vector<TimedModule *> _awake_routers;
+      size_t _sorted_routers;
+      // Wakes the channels the cycle their data arrives, so they are not
+      // clocked while it is in flight
+      bool _use_timing_wheel;
+      TimingWheel _timing_wheel;
+
+      void _BuildSchedule();
+      void _SortAwakeRouters();
+      static void _RetireIdle(vector<TimedModule *> & modules);
+
+      // sim_threads > 1: the modules of a phase are split in contiguous
+      // chunks, one per thread, and the wakes they issue are applied after
+      // the phase in chunk order, i.e. in the order of a serial cycle
+      ThreadPool * _thread_pool;
+      vector<TimedModule *> _all_modules;
+      vector<vector<TimedModule *> > _deferred_wakes;
+
+      void _ParallelPhase(void (TimedModule::*phase)(),
+                          vector<TimedModule *> const & first,
+                          vector<TimedModule *> const & second);
+
       virtual void _ComputeSize(const Configuration &config) = 0;
       virtual void _BuildNet(const Configuration &config) = 0;
 
@@ -100,10 +129,19 @@ namespace Booksim
 
       virtual double Capacity() const;
 
+      void SetThreadPool(ThreadPool * pool);
+
       virtual void ReadInputs();
       virtual void Evaluate();
       virtual void WriteOutputs();
 
+      // True if no module would change state if clocked: nothing is in
+      // flight and only new injections can wake the network up
+      bool Quiescent() const;
+      // Conservative lower bound of the next cycle in which clocking the
+      // network may change its state (-1: not before a new injection)
+      long long NextEventCycle() const;
+
       void Display(ostream & os = cout) const;
       void DumpChannelMap(ostream & os = cout, string const & prefix = "") const;
       void DumpNodeMap(ostream & os = cout, string const & prefix = "") const;
@@ -34,14 +34,77 @@
  */
 
 #include <cassert>
+#include <iostream>
 
 #include "booksim.hpp"
 #include "outputset.hpp"
+#include "globals.hpp"
 
 namespace Booksim
 {
 
-    OutputSet::OutputSet(OutputSet * out_set)
+    OutputSet::ElementList::ElementList( ElementList const & l )
+      : _size(0), _capacity(_inline_size), _elements(_inline)
+    {
+      *this = l;
+    }
+
+    OutputSet::ElementList::~ElementList( )
+    {
+      if(_elements != _inline) {
+        delete [] _elements;
+      }
+    }
+
+    OutputSet::ElementList & OutputSet::ElementList::operator=( ElementList const & l )
+    {
+      if(this != &l) {
+        if(l._size > _capacity) {
+          _Reserve(l._size);
+        }
+        for(int i = 0; i < l._size; ++i) {
+          _elements[i] = l._elements[i];
+        }
+        _size = l._size;
+      }
+      return *this;
+    }
+
+    void OutputSet::ElementList::_Reserve( int capacity )
+    {
+      assert(capacity > _capacity);
+      sSetElement * elements = new sSetElement[capacity];
+      for(int i = 0; i < _size; ++i) {
+        elements[i] = _elements[i];
+      }
+      if(_elements != _inline) {
+        delete [] _elements;
+      }
+      _elements = elements;
+      _capacity = capacity;
+    }
+
+    bool OutputSet::ElementList::insert( sSetElement const & s )
+    {
+      int pos = 0;
+      while((pos < _size) && (_elements[pos] < s)) {
+        ++pos;
+      }
+      if((pos < _size) && !(s < _elements[pos])) {
+        return false;
+      }
+      if(_size == _capacity) {
+        _Reserve(2 * _capacity);
+      }
+      for(int i = _size; i > pos; --i) {
+        _elements[i] = _elements[i-1];
+      }
+      _elements[pos] = s;
+      ++_size;
+      return true;
+    }
+
+    OutputSet::OutputSet(OutputSet * out_set) : _poisoned(false)
     {
       _outputs = out_set->GetSet();
     }
@@ -49,6 +112,19 @@ namespace Booksim
     void OutputSet::Clear( )
     {
       _outputs.clear( );
+      _poisoned = false;
+    }
+
+    void OutputSet::Poison( )
+    {
+      _outputs.clear( );
+      _poisoned = true;
+    }
+
+    void OutputSet::_PoisonError( ) const
+    {
+      cout << GetSimTime() << " Error: route set of a freed flit used." << endl;
+      exit(-1);
     }
 
     void OutputSet::Add( int output_port, int vc, int pri  )
@@ -71,8 +147,9 @@ namespace Booksim
     //legacy support, for performance, just use GetSet()
     int OutputSet::NumVCs( int output_port ) const
     {
+      _CheckPoison( );
       int total = 0;
-      set<sSetElement>::const_iterator i = _outputs.begin( );
+      ElementList::const_iterator i = _outputs.begin( );
       while(i!=_outputs.end( )){
         if(i->output_port == output_port){
           total += (i->vc_end - i->vc_start + 1);
@@ -84,7 +161,8 @@ namespace Booksim
 
     bool OutputSet::OutputEmpty( int output_port ) const
     {
-      set<sSetElement>::const_iterator i = _outputs.begin( );
+      _CheckPoison( );
+      ElementList::const_iterator i = _outputs.begin( );
       while(i!=_outputs.end( )){
         if(i->output_port == output_port){
           return false;
@@ -95,7 +173,8 @@ namespace Booksim
     }
 
 
-    const set<OutputSet::sSetElement> & OutputSet::GetSet() const{
+    const OutputSet::ElementList & OutputSet::GetSet() const{
+      _CheckPoison( );
       return _outputs;
     }
 
@@ -107,9 +186,10 @@ namespace Booksim
       int remaining = vc_index;
       int vc = -1;
       
+      _CheckPoison( );
       if ( pri ) { *pri = -1; }
 
-      set<sSetElement>::const_iterator i = _outputs.begin( );
+      ElementList::const_iterator i = _outputs.begin( );
       while(i!=_outputs.end( )){
         if(i->output_port == output_port){
           range = i->vc_end - i->vc_start + 1;
@@ -136,7 +216,8 @@ namespace Booksim
       bool single_output = false;
       int  used_outputs  = 0;
 
-      set<sSetElement>::const_iterator i = _outputs.begin( );
+      _CheckPoison( );
+      ElementList::const_iterator i = _outputs.begin( );
       if(i!=_outputs.end( )){
         used_outputs = i->output_port;
       }
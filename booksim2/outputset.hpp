@@ -28,8 +28,6 @@
 #ifndef _OUTPUTSET_HPP_
 #define _OUTPUTSET_HPP_
 
-#include <set>
-
 namespace Booksim
 {
 
@@ -37,7 +35,7 @@ namespace Booksim
 
     public:
       OutputSet(OutputSet * out_set);
-      OutputSet(){}
+      OutputSet() : _poisoned(false) {}
 
       // Set element type
       struct sSetElement {
@@ -47,6 +45,42 @@ namespace Booksim
         int output_port;
       };
 
+      // Route candidates sorted by decreasing priority. Routing functions
+      // produce a handful of them, so the first _inline_size elements live
+      // inside the object and only larger (adaptive) sets spill to the heap.
+      // Like the std::set it replaces, elements are compared by priority
+      // only: adding a second element with an existing priority is a no-op.
+      class ElementList {
+
+      public:
+        typedef sSetElement const * const_iterator;
+        typedef const_iterator iterator;
+
+        ElementList( ) : _size(0), _capacity(_inline_size), _elements(_inline) {}
+        ElementList( ElementList const & l );
+        ~ElementList( );
+        ElementList & operator=( ElementList const & l );
+
+        inline const_iterator begin( ) const { return _elements; }
+        inline const_iterator end( ) const { return _elements + _size; }
+        inline int size( ) const { return _size; }
+        inline bool empty( ) const { return _size == 0; }
+        inline void clear( ) { _size = 0; }
+
+        // Returns false if an element with the same priority is present
+        bool insert( sSetElement const & s );
+
+      private:
+        static const int _inline_size = 4;
+
+        int _size;
+        int _capacity;
+        sSetElement * _elements;
+        sSetElement _inline[_inline_size];
+
+        void _Reserve( int capacity );
+      };
+
       void Clear( );
       void Add( int output_port, int vc, int pri = 0 );
       void AddRange( int output_port, int vc_start, int vc_end, int pri = 0 );
@@ -54,12 +88,24 @@ namespace Booksim
       bool OutputEmpty( int output_port ) const;
       int NumVCs( int output_port ) const;
       
-      const set<sSetElement> & GetSet() const;
+      const ElementList & GetSet() const;
 
       int  GetVC( int output_port,  int vc_index, int *pri = 0 ) const;
       bool GetPortVC( int *out_port, int *out_vc ) const;
+
+      // Mark the set of a freed flit; any later read aborts (flit_pool_debug)
+      void Poison( );
     private:
-      set<sSetElement> _outputs;
+      ElementList _outputs;
+      bool _poisoned;
+
+      inline void _CheckPoison( ) const
+      {
+        if(_poisoned) {
+          _PoisonError( );
+        }
+      }
+      void _PoisonError( ) const;
     };
 
     inline bool operator<(const OutputSet::sSetElement & se1, 
@@ -69,5 +115,3 @@ namespace Booksim
 } // namespace Booksim
 
 #endif
-
-
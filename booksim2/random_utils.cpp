@@ -32,8 +32,10 @@
 namespace Booksim
 {
 
-    extern long ran_x[];
-    extern double ran_u[];
+    // The generator state is per thread, so that the simulations of a sweep
+    // (see main.cpp) do not share it
+    extern thread_local long ran_x[];
+    extern thread_local double ran_u[];
 #define KK 100
 
     void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u ) {
@@ -0,0 +1,110 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*ring_queue.hpp
+ *
+ *FIFO of pointers backed by a circular buffer, used for the source queues
+ *of the traffic managers.
+ *
+ *Reserve() allocates the ring once (the injection queue size), so steady
+ *traffic never touches the heap; a push into a full ring doubles it, which
+ *only happens when the caller admits a packet that straddles the limit.
+ */
+
+#ifndef _RING_QUEUE_HPP_
+#define _RING_QUEUE_HPP_
+
+#include <cassert>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    template<class T>
+    class RingQueue {
+
+    public:
+      RingQueue( ) : _head(0), _count(0) {}
+
+      void Reserve( size_t capacity ) {
+        if(capacity > _ring.size()) {
+          _Grow(capacity);
+        }
+      }
+      inline size_t Capacity( ) const { return _ring.size(); }
+
+      inline bool Empty( ) const { return _count == 0; }
+      inline size_t Size( ) const { return _count; }
+
+      inline T const & Front( ) const {
+        assert(_count > 0);
+        return _ring[_head];
+      }
+
+      inline void PushBack( T const & value ) {
+        if(_count == _ring.size()) {
+          _Grow(_ring.empty() ? 1 : (2 * _ring.size()));
+        }
+        size_t tail = _head + _count;
+        if(tail >= _ring.size()) {
+          tail -= _ring.size();
+        }
+        _ring[tail] = value;
+        ++_count;
+      }
+
+      inline void PopFront( ) {
+        assert(_count > 0);
+        if(++_head == _ring.size()) {
+          _head = 0;
+        }
+        --_count;
+      }
+
+    private:
+      vector<T> _ring;
+      size_t _head;
+      size_t _count;
+
+      void _Grow( size_t capacity ) {
+        vector<T> ring(capacity);
+        for(size_t i = 0; i < _count; ++i) {
+          size_t j = _head + i;
+          if(j >= _ring.size()) {
+            j -= _ring.size();
+          }
+          ring[i] = _ring[j];
+        }
+        _ring.swap(ring);
+        _head = 0;
+      }
+    };
+} // namespace Booksim
+
+#endif
@@ -24,7 +24,7 @@ namespace Booksim
 #define LL  37                     /* the short lag */
 #define mod_sum(x,y) (((x)+(y))-(int)((x)+(y)))   /* (x+y) mod 1.0 */
 
-    double ran_u[KK];           /* the generator state */
+    thread_local double ran_u[KK];         /* the generator state */
 
 #ifdef __STDC__
     void ranf_array(double aa[], int n)
@@ -45,9 +45,9 @@ namespace Booksim
     /* after calling ranf_start, get new randoms by, e.g., "x=ranf_arr_next()" */
 
 #define QUALITY 1009 /* recommended quality level for high-res use */
-    double ranf_arr_buf[QUALITY];
-    double ranf_arr_dummy=-1.0, ranf_arr_started=-1.0;
-    double *ranf_arr_ptr=&ranf_arr_dummy; /* the next random fraction, or -1 */
+    thread_local double ranf_arr_buf[QUALITY];
+    thread_local double ranf_arr_dummy=-1.0, ranf_arr_started=-1.0;
+    thread_local double *ranf_arr_ptr=&ranf_arr_dummy; /* the next random fraction, or -1 */
 
 #define TT  70   /* guaranteed separation between streams */
 #define is_odd(s) ((s)&1)
@@ -24,7 +24,7 @@ namespace Booksim
     #define MM (1L<<30)                 /* the modulus */
     #define mod_diff(x,y) (((x)-(y))&(MM-1)) /* subtraction mod MM */
     
-    long ran_x[KK];                    /* the generator state */
+    thread_local long ran_x[KK];                  /* the generator state */
     
     #ifdef __STDC__
     void ran_array(long aa[],int n)
@@ -45,9 +45,9 @@ namespace Booksim
     /* after calling ran_start, get new randoms by, e.g., "x=ran_arr_next()" */
     
     #define QUALITY 1009 /* recommended quality level for high-res use */
-    long ran_arr_buf[QUALITY];
-    long ran_arr_dummy=-1, ran_arr_started=-1;
-    long *ran_arr_ptr=&ran_arr_dummy; /* the next random number, or -1 */
+    thread_local long ran_arr_buf[QUALITY];
+    thread_local long ran_arr_dummy=-1, ran_arr_started=-1;
+    thread_local long *ran_arr_ptr=&ran_arr_dummy; /* the next random number, or -1 */
     
     #define TT  70   /* guaranteed separation between streams */
     #define is_odd(x)  ((x)&1)          /* units bit of x */
@@ -25,6 +25,8 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include "thread_pool.hpp"
+
 #define main rng_main
 #include "rng.hpp"
 
@@ -33,6 +35,9 @@ namespace Booksim
 
     long ran_next( )
     {
+      if(ThreadPool::InPhase( )) {
+        ThreadPool::SharedStateError("random number generator");
+      }
       return ran_arr_next( );
     }
 } // namespace Booksim
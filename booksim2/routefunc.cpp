@@ -55,16 +55,6 @@
 namespace Booksim
 {
 
-    map<string, tRoutingFunction> gRoutingFunctionMap;
-
-    /* Global information used by routing functions */
-
-    int gNumVCs;
-    int gNumClasses;
-
-    vector<int> gBeginVCs;
-    vector<int> gEndVCs;
-
     // ============================================================
     //  QTree: Nearest Common Ancestor
     // ===
@@ -418,7 +408,7 @@ namespace Booksim
 
       } else {
         // Fixme: if we use lookahead routing we can't use f->vc to know if the flit is using x then y or y then x. We must to analyze the current route set
-        set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
+        OutputSet::ElementList sl = f->la_route_set.GetSet();
 
         //each class must have at least 2 vcs assigned or else xy_yx will deadlock
         int const available_vcs = (vcEnd - vcBegin + 1) / 2;
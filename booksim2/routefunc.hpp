@@ -35,20 +35,20 @@
 #include "router.hpp"
 #include "outputset.hpp"
 #include "config_utils.hpp"
+#include "sim_context.hpp"
 
 namespace Booksim
 {
 
-    typedef void (*tRoutingFunction)( const Router *, const Flit *, int in_channel, OutputSet *, bool );
-
     void InitializeRoutingMap( const Configuration & config );
 
-    extern map<string, tRoutingFunction> gRoutingFunctionMap;
+    // Per-simulation state, see sim_context.hpp
+#define gRoutingFunctionMap (gSim->routing_function_map)
 
-    extern int gNumVCs;
-    extern int gNumClasses;
-    extern vector<int> gBeginVCs;
-    extern vector<int> gEndVCs;
+#define gNumVCs (gSim->num_vcs)
+#define gNumClasses (gSim->num_classes)
+#define gBeginVCs (gSim->begin_vcs)
+#define gEndVCs (gSim->end_vcs)
 } // namespace Booksim
 
 #endif
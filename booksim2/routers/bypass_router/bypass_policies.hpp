@@ -0,0 +1,100 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*bypass_policies.hpp
+ *
+ *Policies the bypass router cores are instantiated with (see Router::NewRouter):
+ *
+ *  - Flow control: WormholeFlowControl and FBFCLFlowControl for the wormhole
+ *    cores (BypassRouter, HybridBypassRouter), VCTFlowControl and
+ *    BubbleFlowControl for VCTBypassRouter. The bubble variants keep room for
+ *    one more flit (FBFCL) or for one more packet (bubble) in the next buffer
+ *    when a packet changes dimension, which breaks the deadlocks of the rings.
+ *  - Lookahead arbitration (BypassRouter only): with LookaheadArbitration
+ *    lookaheads that want the same output are arbitrated, with
+ *    NoLookaheadArbitration only a lookahead without competitors bypasses.
+ *
+ *The policies only hold compile-time constants, so the branches they select
+ *are folded when the cores are instantiated.
+ */
+
+#ifndef _BYPASS_POLICIES_HPP_
+#define _BYPASS_POLICIES_HPP_
+
+#include <string>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    struct WormholeFlowControl {
+        static const bool vct = false;
+        static const bool bubble = false;
+    };
+
+    // Flit Bubble Flow Control Localized
+    struct FBFCLFlowControl {
+        static const bool vct = false;
+        static const bool bubble = true;
+    };
+
+    struct VCTFlowControl {
+        static const bool vct = true;
+        static const bool bubble = false;
+    };
+
+    struct BubbleFlowControl {
+        static const bool vct = true;
+        static const bool bubble = true;
+    };
+
+    struct LookaheadArbitration {
+        static const bool arbitrate = true;
+    };
+
+    struct NoLookaheadArbitration {
+        static const bool arbitrate = false;
+    };
+
+    // Priority of the requests to the input switch arbiters
+    // (switch_arbiter_input_policy), parsed once per router
+    enum SwitchArbiterInputPolicy {
+        // Head flits with their priority, body flits first
+        sai_body_first,
+        // Every flit with its priority
+        sai_strict_round_robin,
+        // Priority plus the credits of the requested output VC
+        sai_credit_based,
+        // Body flits first only right after their VC won the arbiter
+        sai_round_robin_on_miss
+    };
+
+    SwitchArbiterInputPolicy ParseSwitchArbiterInputPolicy( string const & policy );
+} // namespace Booksim
+
+#endif
@@ -25,7 +25,7 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include "bypass_arb_router.hpp"
+#include "bypass_router.hpp"
 
 #include <string>
 #include <sstream>
@@ -51,12 +51,17 @@ namespace Booksim
 {
 
 
-    BypassArbRouter::BypassArbRouter( Configuration const & config, Module *parent, 
+    template<class FlowControl, class Arbitration>
+    BypassRouter<FlowControl, Arbitration>::BypassRouter( Configuration const & config, Module *parent, 
             string const & name, int id, int inputs, int outputs )
     : Router( config, parent, name, id, inputs, outputs )
     {
         // TODO: Check that this router is being constructed with route_delay=0 and noq=0, required for lookahead routing
-        _empty_vc = config.GetInt("bypass_empty_vc");
+        // Only the bypass_arb router waits for an empty VC (bypass_empty_vc),
+        // FBFCL already checks the room of the whole packet
+        _empty_vc = Arbitration::arbitrate && !FlowControl::bubble && config.GetInt("bypass_empty_vc");
+        // Only the bypass_arb router reports flits stuck for more than 1000 cycles
+        _stale_flit_warnings = Arbitration::arbitrate && !FlowControl::bubble;
 
         // Number of Virtual channel per channel.
         _vcs = config.GetInt("num_vcs");
@@ -102,7 +107,7 @@ namespace Booksim
         {
             ostringstream module_name;
             module_name << "SA-I_" << input;
-            _switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "round_robin", _vcs);
+            _switch_arbiter_input[input] = new RoundRobinArbiter(this, module_name.str(), _vcs);
             //_switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "matrix", _vcs);
         }
 
@@ -114,7 +119,7 @@ namespace Booksim
         {
             ostringstream module_name;
             module_name << "SA-O_" << output;
-            _switch_arbiter_output[output] = Arbiter::NewArbiter(this, module_name.str() , "matrix", _inputs);
+            _switch_arbiter_output[output] = new MatrixArbiter(this, module_name.str(), _inputs);
         }
 
         // Output queues
@@ -135,22 +140,22 @@ namespace Booksim
         
         // Optimization for single-flit packets
         _single_flit_optimization = config.GetInt("single_flit_optimization");
-        if(config.GetStr("router") == "hybrid_simplified") {
+        string const router = config.GetStr("router");
+        if(router == "hybrid_simplified" || router == "hybrid_simplified_fbfcl") {
             _single_flit_optimization = true;
         }
 
         // Give priority to LA over flits: 1 or Flits over LA: 0
         _lookaheads_kill_flits = config.GetInt("lookaheads_kill_flits");
 
-#ifdef TRACK_FLOWS
-        for(int c = 0; c < _classes; ++c) {
-            _stored_flits[c].resize(_inputs, 0);
-            _active_packets[c].resize(_inputs, 0);
-        }
-#endif
+        // Policy to place a request in the input switch arbiter
+        _switch_arbiter_input_policy = FlowControl::bubble ?
+            ParseSwitchArbiterInputPolicy(config.GetStr("switch_arbiter_input_policy")) : sai_body_first;
+        _switch_arbiter_input_winner.resize(_inputs,-1); // Used by round_robin_on_miss
     }
 
-    BypassArbRouter::~BypassArbRouter( )
+    template<class FlowControl, class Arbitration>
+    BypassRouter<FlowControl, Arbitration>::~BypassRouter( )
     {
         // TODO: delete buffers
         for(int i = 0; i < _inputs; ++i)
@@ -170,7 +175,8 @@ namespace Booksim
 
     // The following three methods are evaluated cycle by cycle
     // Read and prepare flits, credits and lookahead information for pipeline stages
-    void BypassArbRouter::ReadInputs()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::ReadInputs()
     {
         // Read incoming flits
         bool have_flits = _ReceiveFlits();
@@ -183,7 +189,8 @@ namespace Booksim
         _active = _active || have_flits || have_credits || have_lookahead;
     }
 
-    void BypassArbRouter::_InternalStep()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_InternalStep()
     {
         if(!_active){
             return;
@@ -206,7 +213,8 @@ namespace Booksim
                   !_lookahead_conflict_check_lookaheads.empty();
     }
 
-    void BypassArbRouter::WriteOutputs()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::WriteOutputs()
     {
         _SendFlits();
         _SendCredits();
@@ -217,7 +225,8 @@ namespace Booksim
     // read inputs
     //------------------------------------------------------------------------------
 
-    bool BypassArbRouter::_ReceiveFlits()
+    template<class FlowControl, class Arbitration>
+    bool BypassRouter<FlowControl, Arbitration>::_ReceiveFlits()
     {
         bool activity = false;
         // Check the input channels
@@ -230,9 +239,7 @@ namespace Booksim
             if(f)
             {
 
-#ifdef TRACK_FLOWS
-                ++_received_flits[f->cl][input];
-#endif
+                _flows.Inc(received_flits, f->cl, input);
 
 #ifdef FLIT_DEBUG
                 if(f->watch)
@@ -240,7 +247,7 @@ namespace Booksim
                     *gWatchOut << "Cycle: " << GetSimTime() << " | Router: " << FullName() << " | Stage: ReceiveFlits | Flit: " << f->id << " pid " << f->pid << " head? " << f->head << " tail? " << f->tail << " | Input: " << input << " VC: " << f->vc << " | Bypass? " << _bypass_path[input] << std::endl;
                 }
 #endif
-		if(f->ctime + 1000 < GetSimTime())
+		if(_stale_flit_warnings && f->ctime + 1000 < GetSimTime())
 		{
 		    std::cerr << "Warning: Cycle: " << GetSimTime()
 			      << " | Router: " << FullName()
@@ -325,7 +332,8 @@ namespace Booksim
         return activity;
     }
 
-    bool BypassArbRouter::_ReceiveCredits()
+    template<class FlowControl, class Arbitration>
+    bool BypassRouter<FlowControl, Arbitration>::_ReceiveCredits()
     {
         bool activity = false;
         // Check the output channels for credits
@@ -348,7 +356,8 @@ namespace Booksim
         return activity;
     }
 
-    bool BypassArbRouter::_ReceiveLookahead()
+    template<class FlowControl, class Arbitration>
+    bool BypassRouter<FlowControl, Arbitration>::_ReceiveLookahead()
     {
         bool activity = false;
         // Read lookahead signals
@@ -379,7 +388,8 @@ namespace Booksim
         return activity;
     }
 
-    void BypassArbRouter::_SwitchTraversal( )
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SwitchTraversal( )
     {
         // (flit, output port))
         for(auto const iter : _crossbar_flits)
@@ -395,7 +405,7 @@ namespace Booksim
                 *gWatchOut << "Cycle: " << GetSimTime() << " | Router: " << FullName() << " | Stage: SwitchTraversal | Flit: " << f->id << " pid " << f->pid << " head? " << f->head << " tail? " << f->tail << " | Output: " << output << std::endl;
             }
 #endif
-	    if(f->ctime + 1000 < GetSimTime())
+	    if(_stale_flit_warnings && f->ctime + 1000 < GetSimTime())
 	    {
 	        std::cerr << "Warning: Cycle: " << GetSimTime()
 	    	      << " | Router: " << FullName()
@@ -412,14 +422,13 @@ namespace Booksim
         _crossbar_flits.clear();
     }
 
-    void BypassArbRouter::_SwitchArbiterOutput()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SwitchArbiterOutput()
     {
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_winner};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // (expanded input)
         for(auto const iter : _switch_arbiter_output_flits)
@@ -434,7 +443,7 @@ namespace Booksim
             
             //assert(cur_buf->GetState(in_vc) == VC::sa_output || cur_buf->GetState(in_vc) == VC::active);
            
-	    if(f->ctime + 1000 < GetSimTime())
+	    if(_stale_flit_warnings && f->ctime + 1000 < GetSimTime())
 	    {
 	        std::cerr << "Warning: Cycle: " << GetSimTime()
 	    	      << " | Router: " << FullName()
@@ -457,7 +466,7 @@ namespace Booksim
 #endif
 
                 // Output port
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 int stop = false;
 
                 for(auto iter : route)
@@ -503,13 +512,16 @@ namespace Booksim
 #endif
                         //bool available_space = _empty_vc ? dest_buf->AvailableFor(dest_vc) == dest_buf->LimitFor(dest_vc) : dest_buf->AvailableFor(dest_vc) > 0;
                         bool available_space = _empty_vc ? dest_buf->IsEmptyFor(dest_vc) : dest_buf->AvailableFor(dest_vc) > 0;
+                        // FBFCL: room for the entire packet plus one flit if the packet changes of dimension
+                        if(_DimensionChange(input, output_port))
+                            available_space = dest_buf->AvailableFor(dest_vc) > f->packet_size;
                         if(dest_buf->IsAvailableFor(dest_vc) && available_space)
                         {
 
-#ifdef TRACK_STALLS
-                            cs = ei_crossbar_conflicts;
-                            conflicts_record[input] = make_pair(cs,f->cl);
-#endif
+                            if(_stalls.Enabled()) {
+                                cs = ei_crossbar_conflicts;
+                                conflicts_record[input] = make_pair(cs,f->cl);
+                            }
 
                             // TODO: Maybe we can use the position of the element in the _switch_arbiter_output vector to identify the winner quickly
                             _switch_arbiter_output[output_port]->AddRequest(input, input*_vcs+f->vc, f->pri);
@@ -523,8 +535,7 @@ namespace Booksim
                             stop = true;
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -538,7 +549,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,f->cl);
                         }
-#endif
                         
                     }
 
@@ -572,10 +582,10 @@ namespace Booksim
                 if(dest_buf->AvailableFor(dest_vc) > 0 && dest_buf->UsedBy(dest_vc) == f->pid)
                 {
 
-#ifdef TRACK_STALLS
-                            cs = ei_crossbar_conflicts;
-                            conflicts_record[input] = make_pair(cs,f->cl);
-#endif
+                            if(_stalls.Enabled()) {
+                                cs = ei_crossbar_conflicts;
+                                conflicts_record[input] = make_pair(cs,f->cl);
+                            }
 
 #ifdef FLIT_DEBUG
                     if(f->watch)
@@ -584,8 +594,7 @@ namespace Booksim
                     // Add Request
                     _switch_arbiter_output[output_port]->AddRequest(input, input*_vcs+f->vc, priority+1); // IMPORTANT NOTE: We add 1 to the priority of bodyflits because if preferible to generate lookaheads contiguosly than interleved (if a previous flit is buffered, the next ones also)
                 }
-#ifdef TRACK_STALLS
-                else
+                else if(_stalls.Enabled())
                 {
                     if(!dest_buf->IsAvailableFor(dest_vc)) {
                         cs = ei_buffer_busy;
@@ -599,7 +608,6 @@ namespace Booksim
                     }
                     conflicts_record[input] = make_pair(cs,f->cl);
                 }
-#endif
             }
         }
 
@@ -634,39 +642,38 @@ namespace Booksim
         // Cannot be more winners than outputs
         assert((int)_lookahead_conflict_check_flits.size() <= _outputs);
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_buffer_busy_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_buffer_reserved_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_buffer_full_stalls[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_crossbar_conflict_stalls[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_output_blocked_stalls[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(buffer_busy_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(buffer_reserved_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(buffer_full_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(crossbar_conflict_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(output_blocked_stalls, conflicts_record[i].second);
+                        break;
+                }
             }
         }
-#endif
     }
 
     // TODO: I don't like this code. Maybe we can improve it adding all the lookahead
     // requests to the arbiter prioritizing body over head lookaheads.
-    void BypassArbRouter::_LookAheadConflictCheck()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_LookAheadConflictCheck()
     {
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_sao_winner_killed, ei_ignore};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // ((Lookahead *, input), bypass_state)
         vector<pair<pair<Lookahead *, int>,BypassOutput>> lookahead_candidates;
@@ -692,10 +699,10 @@ namespace Booksim
             // Compute lookahead routing
             //_LookAheadRouteCompute(la);
         
-#ifdef TRACK_STALLS
-            cs = ei_crossbar_conflicts;
-            conflicts_record[input] = make_pair(cs,la->cl);
-#endif
+            if(_stalls.Enabled()) {
+                cs = ei_crossbar_conflicts;
+                conflicts_record[input] = make_pair(cs,la->cl);
+            }
 
             if(la->head)
             {
@@ -711,7 +718,7 @@ namespace Booksim
                     }
                 }
 
-                set<OutputSet::sSetElement> const route = la->la_route_set.GetSet();
+                OutputSet::ElementList const route = la->la_route_set.GetSet();
                 bool stop = false;
                 for(auto route_iter : route)
                 {
@@ -746,7 +753,9 @@ namespace Booksim
                     //{
                         //bool available_space = _empty_vc ? dest_buf->AvailableFor(dest_vc) == dest_buf->LimitFor(dest_vc) : dest_buf->AvailableFor(dest_vc) > 0;
                         bool available_space = _empty_vc ? dest_buf->IsEmptyFor(dest_vc) : dest_buf->AvailableFor(dest_vc) > 0;
-                        //if(dest_buf->IsAvailableFor(dest_vc) && dest_buf->AvailableFor(dest_vc) > 0)
+                        // FBFCL: room for the entire packet plus one flit if the packet changes of dimension
+                        if(_DimensionChange(input, route_iter.output_port))
+                            available_space = dest_buf->AvailableFor(dest_vc) > la->packet_size;
                         if(dest_buf->IsAvailableFor(dest_vc) && available_space)
                         {
                 //            la->vc = dest_vc;
@@ -767,8 +776,7 @@ namespace Booksim
                             stop = true;
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -782,7 +790,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,la->cl);
                         }
-#endif
                     }
                     
                     if(stop)
@@ -819,8 +826,7 @@ namespace Booksim
                         lookahead_candidates.push_back(make_pair(iter,bypass_state));
                         lookahead_requests_per_output[bypass_state.output_port]++;
                     }
-#ifdef TRACK_STALLS
-                    else
+                    else if(_stalls.Enabled())
                     {
                         if(!dest_buf->IsAvailableFor(dest_vc)) {
                             cs = ei_buffer_busy;
@@ -834,7 +840,6 @@ namespace Booksim
                         }
                         conflicts_record[input] = make_pair(cs,la->cl);
                     }
-#endif
                 }
                 else
                 {
@@ -859,19 +864,24 @@ namespace Booksim
 
             int in_vc = la->vc;
 
-            if(_lookaheads_kill_flits){
-#ifdef TRACK_STALLS
-                ++_la_sa_winners_killed[la->cl];
-#endif
-                _lookahead_conflict_check_flits.erase(bypass_state.output_port);
-            } else if(_lookahead_conflict_check_flits.find(bypass_state.output_port) != _lookahead_conflict_check_flits.end()){
-                continue;
+            bool const single_request = lookahead_requests_per_output[bypass_state.output_port] == 1;
+
+            // Without arbitration only a lookahead alone in its output can bypass.
+            // The wormhole router keeps the SA-O winner of the outputs that
+            // several lookaheads request, the FBFCL one kills it anyway.
+            if(Arbitration::arbitrate || FlowControl::bubble || single_request) {
+                if(_lookaheads_kill_flits){
+                    _stalls.Inc(la_sa_winners_killed, la->cl);
+                    _lookahead_conflict_check_flits.erase(bypass_state.output_port);
+                } else if(_lookahead_conflict_check_flits.find(bypass_state.output_port) != _lookahead_conflict_check_flits.end()){
+                    continue;
+                }
             }
 
-            if(lookahead_requests_per_output[bypass_state.output_port] == 1)
+            if(single_request)
             {
 
-                Lookahead * la_n = new Lookahead(la);
+                Lookahead * la_n = Lookahead::New(la);
                 //_lookahead_route_compute_lookaheads.pushback(make_pair(la_n,bypass_state.output_port));
                 la_n->vc = bypass_state.dest_vc;
                 
@@ -891,16 +901,16 @@ namespace Booksim
                     // Set VC
                     Buffer * const cur_buf = _buf[input];
                     cur_buf->SetState(in_vc, VC::active);
-                    cur_buf->SetRouteSet(in_vc, &la_n->la_route_set);
+                    cur_buf->CopyRouteSet(in_vc, la_n->la_route_set);
                     cur_buf->SetOutput(in_vc,bypass_state.output_port, bypass_state.dest_vc);
                 }
 
-                dest_buf->SendingFlit(la_n);
+                dest_buf->SendingFlit(la_n, _DimensionChange(input, bypass_state.output_port));
 
-#ifdef TRACK_STALLS
-                    cs = ei_ignore;
-                    conflicts_record[input] = make_pair(cs,la_n->cl);
-#endif
+                    if(_stalls.Enabled()) {
+                        cs = ei_ignore;
+                        conflicts_record[input] = make_pair(cs,la_n->cl);
+                    }
                     
                 // Send credit, as the corresponding flit is not going to be stored
                 if(_credit_buffer[input])
@@ -926,7 +936,7 @@ namespace Booksim
                 _lookahead_buffer[bypass_state.output_port] = la_n;
 
             }
-            else
+            else if(Arbitration::arbitrate)
             {
                 if(!output_granted[bypass_state.output_port])
                 {
@@ -936,18 +946,18 @@ namespace Booksim
                     if(!la->head)
                     {
                         _bypass_path[input] = true;
-                        Lookahead * la_n = new Lookahead(la);
+                        Lookahead * la_n = Lookahead::New(la);
                         la_n->vc = bypass_state.dest_vc;
                     
                         // Decrement credit count
                         BufferState * const dest_buf = _next_buf[bypass_state.output_port];
                         //dest_buf->TakeBuffer(bypass_state.dest_vc, la_n->pid);
-                        dest_buf->SendingFlit(la_n);
+                        dest_buf->SendingFlit(la_n, _DimensionChange(input, bypass_state.output_port));
 
-#ifdef TRACK_STALLS
-                    cs = ei_ignore;
-                    conflicts_record[input] = make_pair(cs,la_n->cl);
-#endif
+                    if(_stalls.Enabled()) {
+                        cs = ei_ignore;
+                        conflicts_record[input] = make_pair(cs,la_n->cl);
+                    }
 
                         // Send credit, as the corresponding flit is not going to be stored
                         if(_credit_buffer[input])
@@ -986,79 +996,81 @@ namespace Booksim
         }
         
         // Arbitration
-        for(int output = 0; output < _outputs; output++)
-        {
-            Lookahead * la;
-            //BSMOD: Change flit and packet id to long
-            long la_id;
-            int input;
-            int priority;
-            input = _switch_arbiter_output[output]->Arbitrate(&la_id,&priority);
-            if(input > -1)
+        if(Arbitration::arbitrate) {
+            for(int output = 0; output < _outputs; output++)
             {
-                _bypass_path[input] = true;
+                Lookahead * la;
+                //BSMOD: Change flit and packet id to long
+                long la_id;
+                int input;
+                int priority;
+                input = _switch_arbiter_output[output]->Arbitrate(&la_id,&priority);
+                if(input > -1)
+                {
+                    _bypass_path[input] = true;
 
-                la = la_id_to_ptr[la_id].first;
-                BypassOutput bypass_state = la_id_to_ptr[la_id].second;
+                    la = la_id_to_ptr[la_id].first;
+                    BypassOutput bypass_state = la_id_to_ptr[la_id].second;
 
-                int in_vc = la->vc;
+                    int in_vc = la->vc;
 
-                Lookahead * la_n = new Lookahead(la);
-                la_n->vc = bypass_state.dest_vc;
-                //_lookahead_route_compute_lookaheads.pushback(make_pair(la_n,output));
-                // TODO: store the lookahead in the list of lookaheads to send. See _SendLookahead
+                    Lookahead * la_n = Lookahead::New(la);
+                    la_n->vc = bypass_state.dest_vc;
+                    //_lookahead_route_compute_lookaheads.pushback(make_pair(la_n,output));
+                    // TODO: store the lookahead in the list of lookaheads to send. See _SendLookahead
             
 
-                // Decrement credit count
-                BufferState * const dest_buf = _next_buf[output];
-                if(la->head)
-                {
-                    // Compute lookahead routing
-                    _LookAheadRouteCompute(la_n, bypass_state.output_port);
-                    _dateline_partition[input*_vcs+in_vc] = la_n->ph;
-                    dest_buf->TakeBuffer(la_n->vc, la_n->pid);
-                }
+                    // Decrement credit count
+                    BufferState * const dest_buf = _next_buf[output];
+                    if(la->head)
+                    {
+                        // Compute lookahead routing
+                        _LookAheadRouteCompute(la_n, bypass_state.output_port);
+                        _dateline_partition[input*_vcs+in_vc] = la_n->ph;
+                        dest_buf->TakeBuffer(la_n->vc, la_n->pid);
+                    }
                 
-                dest_buf->SendingFlit(la_n);
+                    dest_buf->SendingFlit(la_n, _DimensionChange(input, bypass_state.output_port));
 
-#ifdef TRACK_STALLS
-                    cs = ei_ignore;
-                    conflicts_record[input] = make_pair(cs,la_n->cl);
-#endif
+                        if(_stalls.Enabled()) {
+                            cs = ei_ignore;
+                            conflicts_record[input] = make_pair(cs,la_n->cl);
+                        }
                 
-                // Set router's bypass state
-                if(la->head)
-                {
-                    // Set VC
-                    Buffer * const cur_buf = _buf[input];
-                    cur_buf->SetState(in_vc, VC::active);
-                    cur_buf->SetRouteSet(in_vc, &la_n->la_route_set);
-                    cur_buf->SetOutput(in_vc,bypass_state.output_port, bypass_state.dest_vc);
-                }
+                    // Set router's bypass state
+                    if(la->head)
+                    {
+                        // Set VC
+                        Buffer * const cur_buf = _buf[input];
+                        cur_buf->SetState(in_vc, VC::active);
+                        cur_buf->CopyRouteSet(in_vc, la_n->la_route_set);
+                        cur_buf->SetOutput(in_vc,bypass_state.output_port, bypass_state.dest_vc);
+                    }
                 
-                // Send credit, as the corresponding flit is not going to be stored
-                if(_credit_buffer[input])
-                {
-                    _credit_buffer[input]->vc.insert(in_vc);
-                }
-                else
-                {
-                    Credit * c = Credit::New();
-                    c->vc.insert(in_vc);
-                    c->id = la_n->id;
-                    _credit_buffer[input] = c;
-                }
+                    // Send credit, as the corresponding flit is not going to be stored
+                    if(_credit_buffer[input])
+                    {
+                        _credit_buffer[input]->vc.insert(in_vc);
+                    }
+                    else
+                    {
+                        Credit * c = Credit::New();
+                        c->vc.insert(in_vc);
+                        c->id = la_n->id;
+                        _credit_buffer[input] = c;
+                    }
 
 #ifdef LOOKAHEAD_DEBUG
-            if(la->watch)
-            {
-                *gWatchOut << "Cycle: " << GetSimTime() << " | Router: " << FullName() << " | Stage: LookAhead Conflict Check Winner (arbitration) | Lookahead: " << la->id << " pid " << la->pid << " head? " << la->head << " tail? " << la->tail << " Preparing credit: input " << input << " VC: " << in_vc << " output port " << output << std::endl;
-            }
+                if(la->watch)
+                {
+                    *gWatchOut << "Cycle: " << GetSimTime() << " | Router: " << FullName() << " | Stage: LookAhead Conflict Check Winner (arbitration) | Lookahead: " << la->id << " pid " << la->pid << " head? " << la->head << " tail? " << la->tail << " Preparing credit: input " << input << " VC: " << in_vc << " output port " << output << std::endl;
+                }
 #endif
 
-                // Send Lookahead
-                _lookahead_buffer[output] = la_n;
-                _switch_arbiter_output[output]->Clear();
+                    // Send Lookahead
+                    _lookahead_buffer[output] = la_n;
+                    _switch_arbiter_output[output]->Clear();
+                }
             }
         }
 
@@ -1087,11 +1099,13 @@ namespace Booksim
             // FIXME: if this flit is a head we don't have the destination vc here yet. This should be transfer in _lookahead_conflict_check_flits
             f_n->vc = cur_buf->GetOutputVC(in_vc);
                 
-            Lookahead * la_n = new Lookahead(f_n);
+            Lookahead * la_n = Lookahead::New(f_n);
             _lookahead_buffer[output_port] = la_n;
 
             // Move flit to ST
             _crossbar_flits.push_back(make_pair(f_n,output_port));
+            // Switch Arbiter Policy (round_robin_on_miss)
+            _switch_arbiter_input_winner[input] = in_vc;
             
             // Decrement credit count
             BufferState * const dest_buf = _next_buf[output_port];
@@ -1103,7 +1117,7 @@ namespace Booksim
                 cur_buf->SetRouteSet(in_vc, &f->la_route_set);
                 cur_buf->SetOutput(in_vc, output_port, f_n->vc);
             }
-            dest_buf->SendingFlit(f_n);
+            dest_buf->SendingFlit(f_n, _DimensionChange(input, output_port));
             
             // Send credit. This flit moves to SA-O input buffers
             if(_credit_buffer[input])
@@ -1139,27 +1153,27 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_la_buffer_busy[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_la_buffer_reserved[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_la_buffer_full[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_la_crossbar_conflict[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_la_output_blocked[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(la_buffer_busy, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(la_buffer_reserved, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(la_buffer_full, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(la_crossbar_conflict, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(la_output_blocked, conflicts_record[i].second);
+                        break;
+                }
             }
         }
-#endif
 
         // Free lookahead memory
         for(auto iter : _lookahead_conflict_check_lookaheads) 
@@ -1174,7 +1188,8 @@ namespace Booksim
     }
 
     // Next Hop Routing
-    void BypassArbRouter::_LookAheadRouteCompute(Flit * f, int output_port) {
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_LookAheadRouteCompute(Flit * f, int output_port) {
 #ifdef FLIT_DEBUG
                 if(f->watch)
                     *gWatchOut << "Cycle: " << GetSimTime() << " Name " << FullName() << " LookAheadRouteCompute of Flit/Lookahead (l: 835): " << *f << std::endl;
@@ -1198,7 +1213,8 @@ namespace Booksim
     }
 
     // Buffer Write
-    void BypassArbRouter::_BufferWrite()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_BufferWrite()
     {
         // Read all flits in the input of the BW stage
         for(auto const iter : _buffer_write_flits)
@@ -1211,10 +1227,8 @@ namespace Booksim
 
             Buffer * const cur_buf = _buf[input];
 
-#ifdef TRACK_FLOWS
-            ++_stored_flits[f->cl][input];
-            if(f->head) ++_active_packets[f->cl][input];
-#endif
+            _flows.Inc(stored_flits, f->cl, input);
+            if(f->head) _flows.Inc(active_packets, f->cl, input);
 
 #ifdef FLIT_DEBUG
             if(f->watch)
@@ -1248,12 +1262,11 @@ namespace Booksim
 
     }
 
-    void BypassArbRouter::_SwitchArbiterInput()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SwitchArbiterInput()
     {
 
-#ifdef TRACK_STALLS
         int sa_i_conflicts[_classes] = {0};
-#endif
 
         for(int expanded_input = 0; expanded_input < _inputs*_vcs; expanded_input++)
         {
@@ -1277,7 +1290,7 @@ namespace Booksim
             //    _switch_arbiter_input[input]->Clear();
             //}
 	
-	    if(f->ctime + 1000 < GetSimTime())
+	    if(_stale_flit_warnings && f->ctime + 1000 < GetSimTime())
 	    {
 	        std::cerr << "Warning: Cycle: " << GetSimTime()
 	    	      << " | Router: " << FullName()
@@ -1292,16 +1305,52 @@ namespace Booksim
               *gWatchOut << "Cycle: " << GetSimTime() << " SA-I adding request " << input << " in vc " << in_vc << " Flit: " << f << " ID " << f->id << " pid " << f->pid << std::endl;
 #endif
 
-#ifdef TRACK_STALLS
             ++sa_i_conflicts[f->cl];
-#endif
             //// Add request to the input arbiter
             //_switch_arbiter_input[input]->AddRequest(in_vc, f->id, 0);
             // Add request to the input arbiter
-            if(f->head) {
-             _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
-            } else {
-                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX);
+            switch(_switch_arbiter_input_policy) {
+            case sai_strict_round_robin:
+                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                break;
+            case sai_credit_based:
+                if(f->head) {
+                    //FIXME: Only working for determinist routing (1 port per hop) We are taking the first available output port
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
+                    for(auto iter : route)
+                    {
+                        int output_port = iter.output_port;
+                        // Check that there is room for the flit
+                        BufferState const * const dest_buf = _next_buf[output_port];
+                        int dest_vc = dest_buf->GetAvailVCMinOccupancy(iter.vc_start, iter.vc_end);
+                        if(dest_vc > -1) {
+                            if(dest_buf->IsAvailableFor(dest_vc)){
+                                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri + dest_buf->AvailableFor(dest_vc));
+                                break;
+                            }
+                        }
+                    }
+                } else {
+                    int output_port = cur_buf->GetOutputPort(in_vc);
+                    BufferState const * const dest_buf = _next_buf[output_port];
+                    int dest_vc = cur_buf->GetOutputVC(in_vc);
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri + dest_buf->AvailableFor(dest_vc));
+                }
+                break;
+            case sai_round_robin_on_miss:
+                if(!f->head && _switch_arbiter_input_winner[input] == in_vc) {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX);
+                    _switch_arbiter_input_winner[input] = -1;
+                } else {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                }
+                break;
+            default:
+                if(f->head) {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                } else {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX); // FIXME: This can be the cause of deadlocks in FBFCL
+                }
             }
         }
 
@@ -1327,9 +1376,7 @@ namespace Booksim
             Flit * const f = cur_buf->FrontFlit(in_vc);
             assert(f);
 
-#ifdef TRACK_STALLS
             --sa_i_conflicts[f->cl];
-#endif
 
 #ifdef FLIT_DEBUG
             if(f->watch)
@@ -1343,19 +1390,20 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int cl=0; cl < _classes; cl++)
-        {
-            _switch_arbiter_input_stalls[cl] += sa_i_conflicts[cl];
+        if(_stalls.Enabled()) {
+            for(int cl=0; cl < _classes; cl++)
+            {
+                _stalls.Add(switch_arbiter_input_stalls, cl, 0, sa_i_conflicts[cl]);
+            }
         }
-#endif
     }
 
     //------------------------------------------------------------------------------
     // write outputs
     //------------------------------------------------------------------------------
 
-    void BypassArbRouter::_SendFlits( )
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SendFlits( )
     {
         for(int output = 0; output < _outputs; ++output)
         {
@@ -1368,9 +1416,7 @@ namespace Booksim
                 // Add flit to the output channel
                 _output_channels[output]->Send(f);
 
-#ifdef TRACK_FLOWS
-                ++_sent_flits[f->cl][output];
-#endif
+                _flows.Inc(sent_flits, f->cl, output);
 
 #ifdef FLIT_DEBUG
                 if(f->watch)
@@ -1383,7 +1429,8 @@ namespace Booksim
         }
     }
 
-    void BypassArbRouter::_SendCredits( )
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SendCredits( )
     {
         for(int input = 0; input < _inputs; ++input)
         {
@@ -1403,7 +1450,8 @@ namespace Booksim
         }
     }
 
-    void BypassArbRouter::_SendLookahead()
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::_SendLookahead()
     {
         // IMPORTANT NOTE: Note that the loop doesn't iterate through the last output port which corresponds with the terminal node, because it doesn't handle lookaheads
         for(int output = 0; output < _outputs; ++output)
@@ -1438,7 +1486,28 @@ namespace Booksim
     //-----------------------------------------------------------
     // misc.
     // ----------------------------------------------------------
-    void BypassArbRouter::Display( ostream & os ) const
+    template<class FlowControl, class Arbitration>
+    bool BypassRouter<FlowControl, Arbitration>::_HeadFits( BufferState const * dest_buf, int vc,
+            Flit const * f, int input, int output ) const
+    {
+        bool available_space = _empty_vc ? dest_buf->IsEmptyFor(vc) : dest_buf->AvailableFor(vc) > 0;
+        if(_DimensionChange(input, output))
+            available_space = dest_buf->AvailableFor(vc) > f->packet_size;
+        return dest_buf->IsAvailableFor(vc) && available_space;
+    }
+
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::DeadlockWaits( vector<VCWait> & waits ) const
+    {
+        size_t const first = waits.size();
+        _CollectVCWaits(_buf, _next_buf, true, waits);
+        if(_switch_arbiter_input_policy == sai_body_first) {
+            _CollectInputArbiterWaits(_buf, first, waits);
+        }
+    }
+
+    template<class FlowControl, class Arbitration>
+    void BypassRouter<FlowControl, Arbitration>::Display( ostream & os ) const
     {
       for(int input = 0; input < _inputs; ++input){
         for(int in_vc = 0; in_vc < _vcs; ++in_vc){
@@ -1478,4 +1547,8 @@ namespace Booksim
           //_buf[input]->Display( os );
       }
     }
+    template class BypassRouter<WormholeFlowControl, LookaheadArbitration>;
+    template class BypassRouter<WormholeFlowControl, NoLookaheadArbitration>;
+    template class BypassRouter<FBFCLFlowControl, LookaheadArbitration>;
+    template class BypassRouter<FBFCLFlowControl, NoLookaheadArbitration>;
 } // namespace Booksim
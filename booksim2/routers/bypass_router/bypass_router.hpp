@@ -25,8 +25,20 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#ifndef _BYPASS_NO_ARB_FBFCL_ROUTER_HPP_
-#define _BYPASS_NO_ARB_FBFCL_ROUTER_HPP_
+/*bypass_router.hpp
+ *
+ *Bypass router with one bypass path per input (NEBB-WH baseline). The flow
+ *control and whether conflicting lookaheads are arbitrated are template
+ *policies (see bypass_policies.hpp); the instantiations are:
+ *
+ *  BypassArbRouter         wormhole, lookahead arbitration (bypass_arb, hybrid_simplified)
+ *  BypassNoArbRouter       wormhole, no lookahead arbitration (bypass_no_arb)
+ *  BypassArbFBFCLRouter    FBFCL, lookahead arbitration (bypass_arb_fbfcl, hybrid_simplified_fbfcl)
+ *  BypassNoArbFBFCLRouter  FBFCL, no lookahead arbitration (bypass_no_arb_fbfcl)
+ */
+
+#ifndef _BYPASS_ROUTER_HPP_
+#define _BYPASS_ROUTER_HPP_
 
 #include <string>
 #include <deque>
@@ -36,7 +48,9 @@
 
 #include "../router.hpp"
 #include "../../routefunc.hpp"
-#include "../../arbiters/arbiter.hpp"
+#include "../../arbiters/matrix_arb.hpp"
+#include "../../arbiters/roundrobin_arb.hpp"
+#include "bypass_policies.hpp"
 
 namespace Booksim
 {
@@ -48,18 +62,19 @@ namespace Booksim
     class Credit;
     class Buffer;
     class BufferState;
-    class Allocator;
-    //class SwitchMonitor;
-    //class BufferMonitor;
 
 
-    class BypassNoArbFBFCLRouter : public Router {
+    template<class FlowControl, class Arbitration>
+    class BypassRouter : public Router {
         struct BypassOutput {
             int output_port;
             int dest_vc;
             OutputSet la_route_set;
-            //int pid;
         };
+        // Wormhole only: a head flit only takes an empty output VC
+        bool _empty_vc;
+        // Report flits older than 1000 cycles on stderr
+        bool _stale_flit_warnings;
 
         // Number of virtual channels per channel
         int _vcs;
@@ -83,55 +98,14 @@ namespace Booksim
         // SA-O input
         map<int, Flit *> _switch_arbiter_output_flits; // input, Flit
 
-        /*
-
-        /////////////////////////
-        // Stage communication //
-        /////////////////////////
-        // Input_Stage
-        // (input, flit)
-        map<int, Flit *> _buffer_write_flits;
-        // (time, (credit, output))
-        deque<pair<int, pair<Credit *, int> > > _proc_credits;
-        // (expanded_input, time)
-        map<int, int> _sa_input_vcs;
-
-        // Second Stage
-        // (expanded_input, time)
-        map<int, int> _sa_output_vcs;
-        // (time, (lookahead, input))
-        map<int, Lookahead *> _sa_output_la_inputs;
-
-        // Output Stage FIXME: addapt this to my new nomenclature
-        // (time, (Flit, (input, output))
-        deque<pair<int, pair<Flit *, pair<int, int>>>> _crossbar_flits;
-
-        // LT???
-        map<int, Credit *> _out_queue_credits;
-        map<int, Lookahead *> _out_queue_lookahead;
-        */
-
-
         // Input buffer (input VCs)
         vector<Buffer *> _buf;
         // output buffer state (output VCs)
         vector<BufferState *> _next_buf;
 
-        // SA arbiters
-        vector<Arbiter *> _switch_arbiter_input;
-        vector<Arbiter *> _switch_arbiter_output;
-
-
-        /*
-        // Allocators
-        //    SW-I as many allocators as inputs
-        vector<Allocator *> _sw_input_allocator;
-        //    To implement round roby policy. NOTE: Maybe there is a better solution using the arbiter class
-        vector<int> _sw_input_allocator_last_vc;
-
-        Allocator *_sw_output_allocator;
-        Allocator * _vc_allocator;
-        */
+        // SA arbiters (concrete types, so the per-cycle calls are not virtual)
+        vector<RoundRobinArbiter *> _switch_arbiter_input;
+        vector<MatrixArbiter *> _switch_arbiter_output;
 
         // Routing function
         tRoutingFunction _rf;
@@ -145,7 +119,6 @@ namespace Booksim
         bool _lookaheads_kill_flits;
                     
         // If a trail flit is stored the LAs of following flits are ignored
-        //vector<int> _lookahead_buffered_flits;
         map<int,bool> _lookahead_buffered_flits;
 
         // Output buffer size and output buffer
@@ -171,14 +144,19 @@ namespace Booksim
         void _SwitchArbiterOutput();
         void _LookAheadConflictCheck();
         void _LookAheadRouteCompute(Flit *f, int output_port);
+        // FBFCL: a packet that changes of dimension needs room for one more
+        // flit in the next router (the bubble). Always false for wormhole.
+        inline bool _DimensionChange(int input, int output) const {
+            return FlowControl::bubble && DimensionChange(input, output);
+        }
+
+        // Room checks of the head flits in SA-O (see Router::_CollectVCWaits)
+        virtual bool _HeadFits( BufferState const * dest_buf, int vc,
+                Flit const * f, int input, int output ) const;
 
         // Output_Stage: ST
-        void _Output_Stage();
         void _SwitchTraversal();
 
-        // pre-LT
-        void _OutputQueuing();
-
         // Used in WriteOuputs()
         void _SendFlits();
         void _SendCredits();
@@ -189,22 +167,24 @@ namespace Booksim
 
         // optimization for single flit packets
         bool _single_flit_optimization;
-        
-        string _switch_arbiter_input_policy;
+
+        // FBFCL only, wormhole routers always serve body flits first
+        SwitchArbiterInputPolicy _switch_arbiter_input_policy;
         vector<int> _switch_arbiter_input_winner;
 
         public:
 
-        BypassNoArbFBFCLRouter( Configuration const & config,
+        BypassRouter( Configuration const & config,
                 Module *parent, string const & name, int id,
                 int inputs, int outputs );
 
-        virtual ~BypassNoArbFBFCLRouter( );
+        virtual ~BypassRouter( );
 
         virtual void ReadInputs( );
         virtual void WriteOutputs( );
         
         void Display( ostream & os = cout ) const;
+        virtual void DeadlockWaits( vector<VCWait> & waits ) const;
 
         // FIXME: What is this shit.
         virtual int GetUsedCredit(int o) const { return 0;}
@@ -221,6 +201,16 @@ namespace Booksim
         virtual vector<int> MaxCredits() const { vector<int> result; return result;}
 
     };
+
+    typedef BypassRouter<WormholeFlowControl, LookaheadArbitration> BypassArbRouter;
+    typedef BypassRouter<WormholeFlowControl, NoLookaheadArbitration> BypassNoArbRouter;
+    typedef BypassRouter<FBFCLFlowControl, LookaheadArbitration> BypassArbFBFCLRouter;
+    typedef BypassRouter<FBFCLFlowControl, NoLookaheadArbitration> BypassNoArbFBFCLRouter;
+
+    extern template class BypassRouter<WormholeFlowControl, LookaheadArbitration>;
+    extern template class BypassRouter<WormholeFlowControl, NoLookaheadArbitration>;
+    extern template class BypassRouter<FBFCLFlowControl, LookaheadArbitration>;
+    extern template class BypassRouter<FBFCLFlowControl, NoLookaheadArbitration>;
 } // namespace Booksim
 
 #endif
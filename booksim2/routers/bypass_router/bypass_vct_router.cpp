@@ -53,7 +53,8 @@ namespace Booksim
 {
 
 
-    BypassVCTRouter::BypassVCTRouter( Configuration const & config, Module *parent, 
+    template<class FlowControl>
+    VCTBypassRouter<FlowControl>::VCTBypassRouter( Configuration const & config, Module *parent, 
             string const & name, int id, int inputs, int outputs )
     : Router( config, parent, name, id, inputs, outputs )
     {
@@ -105,7 +106,7 @@ namespace Booksim
         for(int input=0; input < _inputs; input++) {
             ostringstream module_name;
             module_name << "SA-I_" << input;
-            _switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "round_robin", _vcs);
+            _switch_arbiter_input[input] = new RoundRobinArbiter(this, module_name.str(), _vcs);
             //_switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "matrix", _vcs);
         }
 
@@ -116,7 +117,7 @@ namespace Booksim
         for(int output=0; output < _outputs; output++) {
             ostringstream module_name;
             module_name << "SA-O_" << output;
-            _switch_arbiter_output[output] = Arbiter::NewArbiter(this, module_name.str() , "matrix", _inputs);
+            _switch_arbiter_output[output] = new MatrixArbiter(this, module_name.str(), _inputs);
         }
 
         // Output queues
@@ -130,13 +131,6 @@ namespace Booksim
         // Option to deactivate bypass
         _disable_bypass = config.GetInt("disable_bypass");
         _regain_bypass = config.GetInt("regain_bypass");
-
-#ifdef TRACK_FLOWS
-        for(int c = 0; c < _classes; ++c) {
-            _stored_flits[c].resize(_inputs, 0);
-            _active_packets[c].resize(_inputs, 0);
-        }
-#endif
         // Guarantee message order
         _guarantee_order = config.GetInt("guarantee_order");
         // We track the number of packets that use a cer
@@ -144,9 +138,24 @@ namespace Booksim
         
         // Give priority to LA over flits: 1 or Flits over LA: 0
         _lookaheads_kill_flits = config.GetInt("lookaheads_kill_flits");
+
+        // Maximum packet size, required by bubble flow control
+        vector<int> packet_size;
+        string packet_size_str = config.GetStr("packet_size");
+        if(packet_size_str.empty()) {
+            packet_size.push_back(config.GetInt("packet_size"));
+        } else {
+            vector<string> packet_size_strings = tokenize_str(packet_size_str);
+            for(size_t i = 0; i < packet_size_strings.size(); ++i) {
+                vector<int> class_packet_size = tokenize_int(packet_size_strings[i]);
+                packet_size.push_back(*max_element(class_packet_size.begin(), class_packet_size.end()));
+            }
+        }
+        _max_packet_size = *max_element(packet_size.begin(), packet_size.end());
     }
 
-    BypassVCTRouter::~BypassVCTRouter( )
+    template<class FlowControl>
+    VCTBypassRouter<FlowControl>::~VCTBypassRouter( )
     {
         // Delete buffers
         for(int i = 0; i < _inputs; ++i) {
@@ -165,7 +174,8 @@ namespace Booksim
     // Read and prepare flits, credits and lookahead information for pipeline stages
     // FIXME
     // TODO: Same function than HybridRouter's
-    void BypassVCTRouter::ReadInputs()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::ReadInputs()
     {
         // Read incoming flits
         bool have_flits = _ReceiveFlits();
@@ -179,7 +189,8 @@ namespace Booksim
     }
 
     // TODO: Same function than HybridRouter's
-    void BypassVCTRouter::_InternalStep()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_InternalStep()
     {
         if(!_active){
             return;
@@ -202,7 +213,8 @@ namespace Booksim
     }
 
     // TODO: Same function than HybridRouter's
-    void BypassVCTRouter::WriteOutputs()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::WriteOutputs()
     {
         _SendFlits();
         _SendCredits();
@@ -213,7 +225,8 @@ namespace Booksim
     // read inputs
     //------------------------------------------------------------------------------
 
-    bool BypassVCTRouter::_ReceiveFlits()
+    template<class FlowControl>
+    bool VCTBypassRouter<FlowControl>::_ReceiveFlits()
     {
         bool activity = false;
 
@@ -222,9 +235,7 @@ namespace Booksim
             Flit * const f = _input_channels[input]->Receive();
             if(f) {
 
-#ifdef TRACK_FLOWS
-                ++_received_flits[f->cl][input];
-#endif
+                _flows.Inc(received_flits, f->cl, input);
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -248,7 +259,7 @@ namespace Booksim
                     OutputSet const * const route_set = cur_buf->GetRouteSet(in_vc);
 #ifdef FLIT_DEBUG
                 if(f->watch) {
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     for(auto route_iter : route) {
 
                         *gWatchOut  << "(line " << __LINE__ << ") | Cycle: " << GetSimTime() << " | Router: " << FullName()
@@ -322,7 +333,8 @@ namespace Booksim
         return activity;
     }
 
-    bool BypassVCTRouter::_ReceiveCredits()
+    template<class FlowControl>
+    bool VCTBypassRouter<FlowControl>::_ReceiveCredits()
     {
         bool activity = false;
 
@@ -356,7 +368,8 @@ namespace Booksim
         return activity;
     }
 
-    bool BypassVCTRouter::_ReceiveLookahead()
+    template<class FlowControl>
+    bool VCTBypassRouter<FlowControl>::_ReceiveLookahead()
     {
         bool activity = false;
 
@@ -394,7 +407,8 @@ namespace Booksim
         return activity;
     }
 
-    void BypassVCTRouter::_SwitchTraversal( )
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SwitchTraversal( )
     {
         // Read ready flits (flit, output port))
         for(auto const iter : _crossbar_flits) {
@@ -418,14 +432,13 @@ namespace Booksim
         _crossbar_flits.clear();
     }
 
-    void BypassVCTRouter::_SwitchArbiterOutput()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SwitchArbiterOutput()
     {
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_winner};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // Read flits that are in SA-O (expanded input)
         for(auto const iter : _switch_arbiter_output_flits) {
@@ -467,7 +480,7 @@ namespace Booksim
                 assert(cur_buf->GetState(in_vc) == VC::sa_output);
 
                 // Read packet route from input VC
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 
                 bool stop = false; // Used to point out an available destination VC
 
@@ -507,14 +520,18 @@ namespace Booksim
                         }
 #endif
                         // FIXME: With the new method GetAvailVCMinOccupancy(start_vc, end_vc) this is not required
-                        if((f->head && dest_buf->IsAvailableFor(dest_vc) && dest_buf->AvailableFor(dest_vc) >= f->packet_size) ||
+                        // Bubble: room for one more packet if the packet changes of dimension
+                        bool available_space = _DimensionChange(input, output_port) ?
+                            dest_buf->AvailableFor(dest_vc) >= f->packet_size + _max_packet_size :
+                            dest_buf->AvailableFor(dest_vc) >= f->packet_size;
+                        if((f->head && dest_buf->IsAvailableFor(dest_vc) && available_space) ||
                            (!f->head && dest_buf->IsAvailableFor(dest_vc) && dest_buf->AvailableFor(dest_vc) > 0)
                         ) {
 
-#ifdef TRACK_STALLS
-                            cs = ei_crossbar_conflicts;
-                            conflicts_record[input] = make_pair(cs,f->cl);
-#endif
+                            if(_stalls.Enabled()) {
+                                cs = ei_crossbar_conflicts;
+                                conflicts_record[input] = make_pair(cs,f->cl);
+                            }
                             // Add request to SA-O
                             if(f->head) {
                                 _switch_arbiter_output[output_port]->AddRequest(input, input*_vcs+f->vc, f->pri);
@@ -535,8 +552,7 @@ namespace Booksim
                             stop = true;
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -550,7 +566,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,f->cl);
                         }
-#endif
                         
                     }
 
@@ -588,7 +603,7 @@ namespace Booksim
                 // FIXME: I believe that in this architecture it is not necessary to check if the destination buffer
                 // is being used by the current packet, as body flits will be bypassed if head one is.
     //            if(dest_buf->AvailableFor(dest_vc) > 0 && dest_buf->UsedBy(dest_vc) == f->pid)
-                if(dest_buf->AvailableFor(dest_vc) > 0)
+                if(FlowControl::bubble ? dest_buf->UsedBy(dest_vc) == f->pid : dest_buf->AvailableFor(dest_vc) > 0)
                 {
 
 #ifdef FLIT_DEBUG
@@ -618,12 +633,12 @@ namespace Booksim
                 // Move flit to LA-CC stage
                 _lookahead_conflict_check_flits[output] = expanded_input;
 
-#ifdef TRACK_STALLS
-                int const input = expanded_input/_vcs;
-                Flit * fstall = _switch_arbiter_output_flits[input];
-                cs = ei_winner;
-                conflicts_record[input] = make_pair(cs,fstall->cl);
-#endif
+                if(_stalls.Enabled()) {
+                    int const input = expanded_input/_vcs;
+                    Flit * fstall = _switch_arbiter_output_flits[input];
+                    cs = ei_winner;
+                    conflicts_record[input] = make_pair(cs,fstall->cl);
+                }
 
 #ifdef FLIT_DEBUG
                 int const input = expanded_input / _vcs;
@@ -643,43 +658,42 @@ namespace Booksim
         // Cannot be more winners than outputs
         assert((int)_lookahead_conflict_check_flits.size() <= _outputs);
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_buffer_busy_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_buffer_reserved_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_buffer_full_stalls[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_crossbar_conflict_stalls[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_output_blocked_stalls[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(buffer_busy_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(buffer_reserved_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(buffer_full_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(crossbar_conflict_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(output_blocked_stalls, conflicts_record[i].second);
+                        break;
 
 
+                }
             }
         }
-#endif
     }
 
-    void BypassVCTRouter::_LookAheadConflictCheck()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_LookAheadConflictCheck()
     {
 
 #ifdef LOOKAHEAD_DEBUG
         bool watch_arbiter = false;
 #endif
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_ignore};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // Used to take lookahead winners from arbitration easily
         map<int, pair<Lookahead*, BypassOutput>> la_id_to_ptr;
@@ -700,10 +714,10 @@ namespace Booksim
             }
 #endif
 
-#ifdef TRACK_STALLS
-            cs = ei_crossbar_conflicts;
-            conflicts_record[input] = make_pair(cs,la->cl);
-#endif
+            if(_stalls.Enabled()) {
+                cs = ei_crossbar_conflicts;
+                conflicts_record[input] = make_pair(cs,la->cl);
+            }
 
             // This router works with lookaheads of packets (i.e. head flits)
             if(la->head) {
@@ -714,7 +728,7 @@ namespace Booksim
                 }
 
                 // Check if there is destination VC available from the route list 
-                set<OutputSet::sSetElement> const route = la->la_route_set.GetSet();
+                OutputSet::ElementList const route = la->la_route_set.GetSet();
 
                 bool stop = false; // To point out that a destination VC was found
 
@@ -756,7 +770,10 @@ namespace Booksim
                     if(dest_vc > -1) {
 
                         //for(int dest_vc = route_iter.vc_start; dest_vc <= route_iter.vc_end; dest_vc++)
-                        if(dest_buf->IsAvailableFor(dest_vc) && dest_buf->AvailableFor(dest_vc) >= la->packet_size ) {
+                        bool available_space = _DimensionChange(input, route_iter.output_port) ?
+                            dest_buf->AvailableFor(dest_vc) >= la->packet_size + _max_packet_size :
+                            dest_buf->AvailableFor(dest_vc) >= la->packet_size;
+                        if(dest_buf->IsAvailableFor(dest_vc) && available_space) {
 
                             // Save output port and destination for arbitration, if required
                             BypassOutput bypass_state;
@@ -784,8 +801,7 @@ namespace Booksim
                             // Stop destination VC loop
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -799,7 +815,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,la->cl);
                         }
-#endif
                     }
 
                     // A destination VC was found, stop search
@@ -904,7 +919,7 @@ namespace Booksim
 
                 BufferState * const dest_buf = _next_buf[output];
 
-                Lookahead * la_n = new Lookahead(la);
+                Lookahead * la_n = Lookahead::New(la);
                 la_n->vc = bypass_state.dest_vc;
 
                 Buffer * const cur_buf = _buf[input];
@@ -919,7 +934,7 @@ namespace Booksim
                     cur_buf->SetState(in_vc, VC::active);
                     // Save route and output in the input VC
                     //REMOVEME
-                    cur_buf->SetRouteSet(in_vc, &la_n->la_route_set);
+                    cur_buf->CopyRouteSet(in_vc, la_n->la_route_set);
                     cur_buf->SetOutput(in_vc,bypass_state.output_port, bypass_state.dest_vc);
 
                     // Take destination buffer
@@ -929,7 +944,7 @@ namespace Booksim
 
 #ifdef LOOKAHEAD_DEBUG
                     if(la->watch || watch_arbiter) {
-                        set<OutputSet::sSetElement> const route = cur_buf->GetRouteSet(in_vc)->GetSet();
+                        OutputSet::ElementList const route = cur_buf->GetRouteSet(in_vc)->GetSet();
                         for(auto route_iter : route) {
                         *gWatchOut << "(line " << __LINE__ << ") | Cycle: " << GetSimTime() << " | Router: " << FullName()
                             << " | Stage: LookAhead Conflict Check Winner (arbitration) | Lookahead: " << la->id << " pid "
@@ -951,17 +966,17 @@ namespace Booksim
                 // Decrease credit count
 #ifdef LOOKAHEAD_DEBUG
                     if(la->watch || watch_arbiter) {
-                        //set<OutputSet::sSetElement> const route = la_n->la_route_set.GetSet();
+                        //OutputSet::ElementList const route = la_n->la_route_set.GetSet();
                         *gWatchOut << "(line " << __LINE__ << ") | Cycle: " << GetSimTime() << " | Router: " << FullName() << " Sending Flit (LookAhead)"
                                    << std::endl;
                     }
 #endif
 
 
-#ifdef TRACK_STALLS
-                cs = ei_ignore;
-                conflicts_record[input] = make_pair(cs,la_n->cl);
-#endif
+                if(_stalls.Enabled()) {
+                    cs = ei_ignore;
+                    conflicts_record[input] = make_pair(cs,la_n->cl);
+                }
 
 #ifdef LOOKAHEAD_DEBUG
                 if(la->watch || watch_arbiter) {
@@ -1026,9 +1041,7 @@ namespace Booksim
                 if(_bypass_path[input*_vcs+vc]) bypass_next_cycle = true;
             }
             if(bypass_next_cycle) {
-#ifdef TRACK_STALLS
-                ++_la_sa_winners_killed[f->cl];
-#endif
+                _stalls.Inc(la_sa_winners_killed, f->cl);
                 continue;
             }
 
@@ -1076,7 +1089,7 @@ namespace Booksim
             }
 
             if(_regain_bypass){
-                Lookahead * la_n = new Lookahead(f_n);
+                Lookahead * la_n = Lookahead::New(f_n);
                 // Send Lookahead to the next router
                 _lookahead_buffer[output_port] = la_n;
             }
@@ -1136,27 +1149,27 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_la_buffer_busy[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_la_buffer_reserved[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_la_buffer_full[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_la_crossbar_conflict[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_la_output_blocked[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(la_buffer_busy, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(la_buffer_reserved, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(la_buffer_full, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(la_crossbar_conflict, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(la_output_blocked, conflicts_record[i].second);
+                        break;
+                }
             }
         }
-#endif
 
         // Free lookahead memory
         for(auto iter : _lookahead_conflict_check_lookaheads) 
@@ -1171,7 +1184,8 @@ namespace Booksim
     }
 
     // Next Hop Routing
-    void BypassVCTRouter::_LookAheadRouteCompute(Flit * f, int output_port) {
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_LookAheadRouteCompute(Flit * f, int output_port) {
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -1200,7 +1214,7 @@ namespace Booksim
 #ifdef FLIT_DEBUG
             if(f->watch) {
                 *gWatchOut << "HOLA: LINE" << __LINE__ << std::endl;
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 for(auto route_iter : route) {
                     string name_dest =  router->GetOutputChannel(route_iter.output_port)->GetSink() != NULL ? router->GetOutputChannel(route_iter.output_port)->GetSink()->FullName() : router->GetOutputChannel(route_iter.output_port)->FullName();
                     *gWatchOut  << "(line " << __LINE__ << ") | Cycle: " << GetSimTime() << " | Source Router: " << FullName() 
@@ -1214,7 +1228,8 @@ namespace Booksim
     }
 
     // Buffer Write
-    void BypassVCTRouter::_BufferWrite()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_BufferWrite()
     {
         // Read all flits in the input of the BW stage
         for(auto const iter : _buffer_write_flits) {
@@ -1230,7 +1245,7 @@ namespace Booksim
                 int output_port = -1;
                 
                 //FIXME: we are supposing that there is only one possibility.
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 for(auto iter : route) {
                     output_port = iter.output_port;
                 }
@@ -1239,10 +1254,8 @@ namespace Booksim
 
             Buffer * const cur_buf = _buf[input];
 
-#ifdef TRACK_FLOWS
-            ++_stored_flits[f->cl][input];
-            if(f->head) ++_active_packets[f->cl][input];
-#endif
+            _flows.Inc(stored_flits, f->cl, input);
+            if(f->head) _flows.Inc(active_packets, f->cl, input);
 
 #ifdef FLIT_DEBUG
             if(f->watch) {
@@ -1272,7 +1285,7 @@ namespace Booksim
             if(f->watch)
             {
                 *gWatchOut << "HOLA: LINE" << __LINE__ << std::endl;
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
 
                 for(auto route_iter : route) {
 
@@ -1292,12 +1305,11 @@ namespace Booksim
 
     }
 
-    void BypassVCTRouter::_SwitchArbiterInput()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SwitchArbiterInput()
     {
 
-#ifdef TRACK_STALLS
         int sa_i_conflicts[_classes] = {0};
-#endif
 
         // Read inputs in SA-I
         for(int expanded_input = 0; expanded_input < _inputs*_vcs; expanded_input++) {
@@ -1323,9 +1335,7 @@ namespace Booksim
             }
 #endif
 
-#ifdef TRACK_STALLS
             ++sa_i_conflicts[f->cl];
-#endif
             
             // We give full priority to body flits: once a packet is moving all the packet moves to the next hop in consecutive cycles.
             int priority = 0;
@@ -1361,9 +1371,7 @@ namespace Booksim
             Flit * const f = cur_buf->FrontFlit(in_vc);
             assert(f);
 
-#ifdef TRACK_STALLS
             --sa_i_conflicts[f->cl];
-#endif
 
 #ifdef FLIT_DEBUG
             if(f->watch) {
@@ -1381,19 +1389,20 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int cl=0; cl < _classes; cl++)
-        {
-            _switch_arbiter_input_stalls[cl] += sa_i_conflicts[cl];
+        if(_stalls.Enabled()) {
+            for(int cl=0; cl < _classes; cl++)
+            {
+                _stalls.Add(switch_arbiter_input_stalls, cl, 0, sa_i_conflicts[cl]);
+            }
         }
-#endif
     }
 
     //------------------------------------------------------------------------------
     // write outputs
     //------------------------------------------------------------------------------
 
-    void BypassVCTRouter::_SendFlits( )
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SendFlits( )
     {
         for(int output = 0; output < _outputs; ++output) {
             if(!_output_buffer[output].empty()) {
@@ -1404,9 +1413,7 @@ namespace Booksim
                 // Add flit to the output channel
                 _output_channels[output]->Send(f);
 
-#ifdef TRACK_FLOWS
-                ++_sent_flits[f->cl][output];
-#endif
+                _flows.Inc(sent_flits, f->cl, output);
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -1414,7 +1421,7 @@ namespace Booksim
                     BufferState * const dest_buf = _next_buf[output];
                 
                 *gWatchOut << "HOLA: LINE" << __LINE__ << std::endl;
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     for(auto route_iter : route) {
 
                         *gWatchOut  << "(line " << __LINE__ << ") | Cycle: " << GetSimTime() << " | Source Router: " << FullName()
@@ -1432,7 +1439,8 @@ namespace Booksim
         }
     }
 
-    void BypassVCTRouter::_SendCredits( )
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SendCredits( )
     {
         for(int input = 0; input < _inputs; ++input) {
             if(_credit_buffer[input] != NULL) {
@@ -1456,7 +1464,8 @@ namespace Booksim
         }
     }
 
-    void BypassVCTRouter::_SendLookahead()
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::_SendLookahead()
     {
         // IMPORTANT NOTE: Note that the loop doesn't iterate through the last output port which corresponds with the terminal node, because it doesn't handle lookaheads
         for(int output = 0; output < _outputs; ++output) {
@@ -1492,10 +1501,29 @@ namespace Booksim
     //-----------------------------------------------------------
     // misc.
     // ----------------------------------------------------------
-    void BypassVCTRouter::Display( ostream & os ) const
+    template<class FlowControl>
+    bool VCTBypassRouter<FlowControl>::_HeadFits( BufferState const * dest_buf, int vc,
+            Flit const * f, int input, int output ) const
+    {
+        bool available_space = _DimensionChange(input, output) ?
+            dest_buf->AvailableFor(vc) >= f->packet_size + _max_packet_size :
+            dest_buf->AvailableFor(vc) >= f->packet_size;
+        return dest_buf->IsAvailableFor(vc) && available_space;
+    }
+
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::DeadlockWaits( vector<VCWait> & waits ) const
+    {
+        _CollectVCWaits(_buf, _next_buf, true, waits);
+    }
+
+    template<class FlowControl>
+    void VCTBypassRouter<FlowControl>::Display( ostream & os ) const
     {
           for ( int input = 0; input < _inputs; ++input ) {
                   _buf[input]->Display( os );
                     }
     }
+    template class VCTBypassRouter<VCTFlowControl>;
+    template class VCTBypassRouter<BubbleFlowControl>;
 } // namespace Booksim
@@ -25,6 +25,16 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/*bypass_vct_router.hpp
+ *
+ *Bypass router with virtual cut-through flow control: a head flit only
+ *advances if there is room for the whole packet. The flow control is a
+ *template policy (see bypass_policies.hpp):
+ *
+ *  BypassVCTRouter        VCT (bypass_vct)
+ *  BypassVCTBubbleRouter  VCT with bubble flow control (bypass_vct_bubble)
+ */
+
 #ifndef _BYPASS_VCT_ROUTER_HPP_
 #define _BYPASS_VCT_ROUTER_HPP_
 
@@ -34,9 +44,11 @@
 #include <set>
 #include <map>
 
-#include "router.hpp"
-#include "../routefunc.hpp"
-#include "../arbiters/arbiter.hpp"
+#include "../router.hpp"
+#include "../../routefunc.hpp"
+#include "../../arbiters/matrix_arb.hpp"
+#include "../../arbiters/roundrobin_arb.hpp"
+#include "bypass_policies.hpp"
 
 namespace Booksim
 {
@@ -53,7 +65,10 @@ namespace Booksim
     //class BufferMonitor;
 
 
-    class BypassVCTRouter : public Router {
+    template<class FlowControl>
+    class VCTBypassRouter : public Router {
+        static_assert(FlowControl::vct, "VCTBypassRouter requires a VCT flow control");
+
         struct BypassOutput {
             int output_port;
             int dest_vc;
@@ -117,9 +132,9 @@ namespace Booksim
         // output buffer state (output VCs)
         vector<BufferState *> _next_buf;
 
-        // SA arbiters
-        vector<Arbiter *> _switch_arbiter_input;
-        vector<Arbiter *> _switch_arbiter_output;
+        // SA arbiters (concrete types, so the per-cycle calls are not virtual)
+        vector<RoundRobinArbiter *> _switch_arbiter_input;
+        vector<MatrixArbiter *> _switch_arbiter_output;
         // Round robin for dest buf
         vector<int> _sao_last_dest_vc_output;
         vector<int> _lacc_last_dest_vc_output;
@@ -195,19 +210,31 @@ namespace Booksim
         bool _guarantee_order;
         std::vector<std::vector<int>>_buffered_packet_outputs;
 
+        // Bubble flow control: a packet that changes of dimension needs room
+        // for one more packet in the next router. Always false for VCT.
+        int _max_packet_size;
+        inline bool _DimensionChange(int input, int output) const {
+            return FlowControl::bubble && DimensionChange(input, output);
+        }
+
+        // Room checks of the head flits in SA-O (see Router::_CollectVCWaits)
+        virtual bool _HeadFits( BufferState const * dest_buf, int vc,
+                Flit const * f, int input, int output ) const;
+
 
         public:
 
-        BypassVCTRouter( Configuration const & config,
+        VCTBypassRouter( Configuration const & config,
                 Module *parent, string const & name, int id,
                 int inputs, int outputs );
 
-        virtual ~BypassVCTRouter( );
+        virtual ~VCTBypassRouter( );
 
         virtual void ReadInputs( );
         virtual void WriteOutputs( );
         
         void Display( ostream & os = cout ) const;
+        virtual void DeadlockWaits( vector<VCWait> & waits ) const;
 
         // FIXME: What is this shit.
         virtual int GetUsedCredit(int o) const { return 0;}
@@ -224,6 +251,12 @@ namespace Booksim
         virtual vector<int> MaxCredits() const { vector<int> result; return result;}
 
     };
+
+    typedef VCTBypassRouter<VCTFlowControl> BypassVCTRouter;
+    typedef VCTBypassRouter<BubbleFlowControl> BypassVCTBubbleRouter;
+
+    extern template class VCTBypassRouter<VCTFlowControl>;
+    extern template class VCTBypassRouter<BubbleFlowControl>;
 } // namespace Booksim
 
 #endif
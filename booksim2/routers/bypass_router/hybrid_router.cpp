@@ -53,7 +53,8 @@ namespace Booksim
 {
 
 
-    HybridRouter::HybridRouter( Configuration const & config, Module *parent, 
+    template<class FlowControl>
+    HybridBypassRouter<FlowControl>::HybridBypassRouter( Configuration const & config, Module *parent, 
             string const & name, int id, int inputs, int outputs )
     : Router( config, parent, name, id, inputs, outputs )
     {
@@ -105,7 +106,7 @@ namespace Booksim
         for(int input=0; input < _inputs; input++) {
             ostringstream module_name;
             module_name << "SA-I_" << input;
-            _switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "round_robin", _vcs);
+            _switch_arbiter_input[input] = new RoundRobinArbiter(this, module_name.str(), _vcs);
             //_switch_arbiter_input[input] = Arbiter::NewArbiter(this, module_name.str(), "matrix", _vcs);
         }
 
@@ -116,7 +117,7 @@ namespace Booksim
         for(int output=0; output < _outputs; output++) {
             ostringstream module_name;
             module_name << "SA-O_" << output;
-            _switch_arbiter_output[output] = Arbiter::NewArbiter(this, module_name.str() , "matrix", _inputs);
+            _switch_arbiter_output[output] = new MatrixArbiter(this, module_name.str(), _inputs);
         }
 
         // Output queues
@@ -134,19 +135,18 @@ namespace Booksim
         // Give priority to LA over flits: 1 or Flits over LA: 0
         _lookaheads_kill_flits = config.GetInt("lookaheads_kill_flits");
 
-#ifdef TRACK_FLOWS
-        for(int c = 0; c < _classes; ++c) {
-            _stored_flits[c].resize(_inputs, 0);
-            _active_packets[c].resize(_inputs, 0);
-        }
-#endif
+        // Policy to place a request in the input switch arbiter
+        _switch_arbiter_input_policy = FlowControl::bubble ?
+            ParseSwitchArbiterInputPolicy(config.GetStr("switch_arbiter_input_policy")) : sai_body_first;
+        _switch_arbiter_input_winner.resize(_inputs,-1); // Used by round_robin_on_miss
         // Guarantee message order
         _guarantee_order = config.GetInt("guarantee_order");
         // We track the number of packets that use a cer
         _buffered_packet_outputs.resize(_inputs, vector<int>(_outputs, 0));
     }
 
-    HybridRouter::~HybridRouter( )
+    template<class FlowControl>
+    HybridBypassRouter<FlowControl>::~HybridBypassRouter( )
     {
         // Delete buffers
         for(int i = 0; i < _inputs; ++i) {
@@ -164,7 +164,8 @@ namespace Booksim
     // The following three methods are evaluated cycle by cycle
     // Read and prepare flits, credits and lookahead information for pipeline stages
     // FIXME
-    void HybridRouter::ReadInputs()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::ReadInputs()
     {
         // Read incoming flits
         bool have_flits = _ReceiveFlits();
@@ -177,7 +178,8 @@ namespace Booksim
         _active = _active || have_flits || have_credits || have_lookahead;
     }
 
-    void HybridRouter::_InternalStep()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_InternalStep()
     {
         if(!_active){
             return;
@@ -200,7 +202,8 @@ namespace Booksim
                   !_lookahead_conflict_check_lookaheads.empty();
     }
 
-    void HybridRouter::WriteOutputs()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::WriteOutputs()
     {
         _SendFlits();
         _SendCredits();
@@ -211,7 +214,8 @@ namespace Booksim
     // read inputs
     //------------------------------------------------------------------------------
 
-    bool HybridRouter::_ReceiveFlits()
+    template<class FlowControl>
+    bool HybridBypassRouter<FlowControl>::_ReceiveFlits()
     {
         bool activity = false;
 
@@ -220,9 +224,7 @@ namespace Booksim
             Flit * const f = _input_channels[input]->Receive();
             if(f) {
 
-#ifdef TRACK_FLOWS
-                ++_received_flits[f->cl][input];
-#endif
+                _flows.Inc(received_flits, f->cl, input);
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -307,7 +309,8 @@ namespace Booksim
         return activity;
     }
 
-    bool HybridRouter::_ReceiveCredits()
+    template<class FlowControl>
+    bool HybridBypassRouter<FlowControl>::_ReceiveCredits()
     {
         bool activity = false;
 
@@ -336,7 +339,8 @@ namespace Booksim
         return activity;
     }
 
-    bool HybridRouter::_ReceiveLookahead()
+    template<class FlowControl>
+    bool HybridBypassRouter<FlowControl>::_ReceiveLookahead()
     {
         bool activity = false;
 
@@ -374,7 +378,8 @@ namespace Booksim
         return activity;
     }
 
-    void HybridRouter::_SwitchTraversal( )
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SwitchTraversal( )
     {
         // Read ready flits (flit, output port))
         for(auto const iter : _crossbar_flits) {
@@ -398,14 +403,13 @@ namespace Booksim
         _crossbar_flits.clear();
     }
 
-    void HybridRouter::_SwitchArbiterOutput()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SwitchArbiterOutput()
     {
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_winner};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // Read flits that are in SA-O (expanded input)
         for(auto const iter : _switch_arbiter_output_flits) {
@@ -446,7 +450,7 @@ namespace Booksim
                 assert(cur_buf->GetState(in_vc) == VC::sa_output);
 
                 // Read packet route from input VC
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 
                 bool stop = false; // Used to point out an available destination VC
 
@@ -474,12 +478,15 @@ namespace Booksim
                         }
 #endif
                         // FIXME: With the new method GetAvailVCMinOccupancy(start_vc, end_vc) this is not required
-                        if(dest_buf->IsAvailableFor(dest_vc) && dest_buf->AvailableFor(dest_vc) > 0 ) {
-
-#ifdef TRACK_STALLS
-                            cs = ei_crossbar_conflicts;
-                            conflicts_record[input] = make_pair(cs,f->cl);
-#endif
+                        // FBFCL: room for the entire packet plus one flit if the packet changes of dimension
+                        bool available_space = _DimensionChange(input, output_port) ?
+                            dest_buf->AvailableFor(dest_vc) > f->packet_size : dest_buf->AvailableFor(dest_vc) > 0;
+                        if(dest_buf->IsAvailableFor(dest_vc) && available_space) {
+
+                            if(_stalls.Enabled()) {
+                                cs = ei_crossbar_conflicts;
+                                conflicts_record[input] = make_pair(cs,f->cl);
+                            }
                             //// Add request to SA-O
                             //if(f->head) {
                                 _switch_arbiter_output[output_port]->AddRequest(input, input*_vcs+f->vc, f->pri);
@@ -500,8 +507,7 @@ namespace Booksim
                             stop = true;
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -515,7 +521,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,f->cl);
                         }
-#endif
                         
                     }
 
@@ -582,12 +587,12 @@ namespace Booksim
                 // Move flit to LA-CC stage
                 _lookahead_conflict_check_flits[output] = expanded_input;
 
-#ifdef TRACK_STALLS
-                int const input = expanded_input/_vcs;
-                Flit * fstall = _switch_arbiter_output_flits[input];
-                cs = ei_winner;
-                conflicts_record[input] = make_pair(cs,fstall->cl);
-#endif
+                if(_stalls.Enabled()) {
+                    int const input = expanded_input/_vcs;
+                    Flit * fstall = _switch_arbiter_output_flits[input];
+                    cs = ei_winner;
+                    conflicts_record[input] = make_pair(cs,fstall->cl);
+                }
 
 #ifdef FLIT_DEBUG
                 int const input = expanded_input / _vcs;
@@ -607,43 +612,42 @@ namespace Booksim
         // Cannot be more winners than outputs
         assert((int)_lookahead_conflict_check_flits.size() <= _outputs);
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_buffer_busy_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_buffer_reserved_stalls[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_buffer_full_stalls[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_crossbar_conflict_stalls[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_output_blocked_stalls[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(buffer_busy_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(buffer_reserved_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(buffer_full_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(crossbar_conflict_stalls, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(output_blocked_stalls, conflicts_record[i].second);
+                        break;
 
 
+                }
             }
         }
-#endif
     }
 
-    void HybridRouter::_LookAheadConflictCheck()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_LookAheadConflictCheck()
     {
 
 #ifdef LOOKAHEAD_DEBUG
         bool watch_arbiter = false;
 #endif
 
-#ifdef TRACK_STALLS
         enum ConflictStates {ei_crossbar_conflicts, ei_buffer_busy, ei_buffer_reserved, ei_buffer_full, ei_output_blocked, ei_ignore};
         pair<int,int> conflicts_record[_inputs];
         ConflictStates cs = ei_crossbar_conflicts;
-#endif
 
         // Used to take lookahead winners from arbitration easily
         map<int, pair<Lookahead*, BypassOutput>> la_id_to_ptr;
@@ -664,10 +668,10 @@ namespace Booksim
             }
 #endif
 
-#ifdef TRACK_STALLS
-            cs = ei_crossbar_conflicts;
-            conflicts_record[input] = make_pair(cs,la->cl);
-#endif
+            if(_stalls.Enabled()) {
+                cs = ei_crossbar_conflicts;
+                conflicts_record[input] = make_pair(cs,la->cl);
+            }
 
             // This router works with lookaheads of packets (i.e. head flits)
             if(la->head) {
@@ -678,7 +682,7 @@ namespace Booksim
                 }
 
                 // Check if there is destination VC available from the route list 
-                set<OutputSet::sSetElement> const route = la->la_route_set.GetSet();
+                OutputSet::ElementList const route = la->la_route_set.GetSet();
 
                 bool stop = false; // To point out that a destination VC was found
 
@@ -713,11 +717,12 @@ namespace Booksim
                         //for(int dest_vc = route_iter.vc_start; dest_vc <= route_iter.vc_end; dest_vc++)
                         //{
                         bool cur_buf_empty = cur_buf->Empty(in_vc);
-                        if(dest_buf->IsAvailableFor(dest_vc) &&
-                                ( dest_buf->AvailableFor(dest_vc) >= la->packet_size ||
-                                  ( cur_buf_empty && dest_buf->AvailableFor(dest_vc) > 0 )
-                                )
-                          ) {
+                        // FBFCL: one more flit than the packet if it changes of dimension
+                        bool available_space = _DimensionChange(input, route_iter.output_port) ?
+                            dest_buf->AvailableFor(dest_vc) > la->packet_size :
+                            ( dest_buf->AvailableFor(dest_vc) >= la->packet_size ||
+                              ( cur_buf_empty && dest_buf->AvailableFor(dest_vc) > 0 ) );
+                        if(dest_buf->IsAvailableFor(dest_vc) && available_space) {
 
                             // Save output port and destination for arbitration, if required
                             BypassOutput bypass_state;
@@ -726,7 +731,7 @@ namespace Booksim
 
                             // Add lookahead request to Output arbiter
                             if(cur_buf_empty) {
-                                _switch_arbiter_output[bypass_state.output_port]->AddRequest(input, la->id , la->pri+INT_MAX/2);
+                                _switch_arbiter_output[bypass_state.output_port]->AddRequest(input, la->id , la->pri + (FlowControl::bubble ? 100 : INT_MAX/2));
                             } else {
                                 _switch_arbiter_output[bypass_state.output_port]->AddRequest(input, la->id , la->pri);
                             }
@@ -751,8 +756,7 @@ namespace Booksim
                             // Stop destination VC loop
                             break;
                         }
-#ifdef TRACK_STALLS
-                        else
+                        else if(_stalls.Enabled())
                         {
                             if(!dest_buf->IsAvailableFor(dest_vc)) {
                                 cs = ei_buffer_busy;
@@ -766,7 +770,6 @@ namespace Booksim
                             }
                             conflicts_record[input] = make_pair(cs,la->cl);
                         }
-#endif
                     }
 
                     // A destination VC was found, stop search
@@ -889,7 +892,7 @@ namespace Booksim
 
                 BufferState * const dest_buf = _next_buf[output];
                     
-                Lookahead * la_n = new Lookahead(la);
+                Lookahead * la_n = Lookahead::New(la);
                 la_n->vc = bypass_state.dest_vc;
                 
                 Buffer * const cur_buf = _buf[input];
@@ -905,7 +908,7 @@ namespace Booksim
                     // Change input VC state to active
                     cur_buf->SetState(in_vc, VC::active);
                     // Save route and output in the input VC
-                    cur_buf->SetRouteSet(in_vc, &la_n->la_route_set);
+                    cur_buf->CopyRouteSet(in_vc, la_n->la_route_set);
                     cur_buf->SetOutput(in_vc,bypass_state.output_port, bypass_state.dest_vc);
                     
                     
@@ -927,12 +930,12 @@ namespace Booksim
             }
                 
                 // Decrease credit count
-                dest_buf->SendingFlit(la_n, vct_request);
+                dest_buf->SendingFlit(la_n, vct_request || _DimensionChange(input, bypass_state.output_port));
 
-#ifdef TRACK_STALLS
-                    cs = ei_ignore;
-                    conflicts_record[input] = make_pair(cs,la_n->cl);
-#endif
+                    if(_stalls.Enabled()) {
+                        cs = ei_ignore;
+                        conflicts_record[input] = make_pair(cs,la_n->cl);
+                    }
                     
 #ifdef LOOKAHEAD_DEBUG
                 if(la->watch || watch_arbiter) {
@@ -984,9 +987,7 @@ namespace Booksim
                 if(_bypass_path[input*_vcs+vc]) bypass_next_cycle = true;
             }
             if(bypass_next_cycle) {
-#ifdef TRACK_STALLS
-               ++_la_sa_winners_killed[f->cl];
-#endif
+               _stalls.Inc(la_sa_winners_killed, f->cl);
                 continue;
             }
 
@@ -997,6 +998,8 @@ namespace Booksim
 
             // Move flit to ST
             _crossbar_flits.push_back(make_pair(f_n,output_port));
+            // Switch Arbiter Policy (round_robin_on_miss)
+            _switch_arbiter_input_winner[input] = in_vc;
             
             // Take destination VC and set ouput port, route and destination vc
             BufferState * const dest_buf = _next_buf[output_port];
@@ -1023,13 +1026,13 @@ namespace Booksim
             }
             
             if(_regain_bypass){
-                Lookahead * la_n = new Lookahead(f_n);
+                Lookahead * la_n = Lookahead::New(f_n);
                 // Send Lookahead to the next router
                 _lookahead_buffer[output_port] = la_n;
             }
 
             // Decrement destination VC credit count
-            dest_buf->SendingFlit(f_n);
+            dest_buf->SendingFlit(f_n, _DimensionChange(input, output_port));
             
             // Send credit.
             if(_credit_buffer[input])
@@ -1071,27 +1074,27 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int i = 0; i < _inputs; i++) {
-            switch(conflicts_record[i].first) {
-                case ei_buffer_busy:
-                    ++_la_buffer_busy[conflicts_record[i].second];
-                    break;
-                case ei_buffer_reserved:
-                    ++_la_buffer_reserved[conflicts_record[i].second];
-                    break;
-                case ei_buffer_full:
-                    ++_la_buffer_full[conflicts_record[i].second];
-                    break;
-                case ei_crossbar_conflicts:
-                    ++_la_crossbar_conflict[conflicts_record[i].second];
-                    break;
-                case ei_output_blocked:
-                    ++_la_output_blocked[conflicts_record[i].second];
-                    break;
+        if(_stalls.Enabled()) {
+            for(int i = 0; i < _inputs; i++) {
+                switch(conflicts_record[i].first) {
+                    case ei_buffer_busy:
+                        _stalls.Inc(la_buffer_busy, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_reserved:
+                        _stalls.Inc(la_buffer_reserved, conflicts_record[i].second);
+                        break;
+                    case ei_buffer_full:
+                        _stalls.Inc(la_buffer_full, conflicts_record[i].second);
+                        break;
+                    case ei_crossbar_conflicts:
+                        _stalls.Inc(la_crossbar_conflict, conflicts_record[i].second);
+                        break;
+                    case ei_output_blocked:
+                        _stalls.Inc(la_output_blocked, conflicts_record[i].second);
+                        break;
+                }
             }
         }
-#endif
 
         // Free lookahead memory
         for(auto iter : _lookahead_conflict_check_lookaheads) 
@@ -1106,7 +1109,8 @@ namespace Booksim
     }
 
     // Next Hop Routing
-    void HybridRouter::_LookAheadRouteCompute(Flit * f, int output_port) {
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_LookAheadRouteCompute(Flit * f, int output_port) {
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -1133,7 +1137,8 @@ namespace Booksim
     }
 
     // Buffer Write
-    void HybridRouter::_BufferWrite()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_BufferWrite()
     {
         // Read all flits in the input of the BW stage
         for(auto const iter : _buffer_write_flits) {
@@ -1149,7 +1154,7 @@ namespace Booksim
                 int output_port = -1;
                 
                 //FIXME: we are supposing that there is only one possibility.
-                set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                OutputSet::ElementList const route = f->la_route_set.GetSet();
                 for(auto iter : route) {
                     output_port = iter.output_port;
                 }
@@ -1158,10 +1163,8 @@ namespace Booksim
 
             Buffer * const cur_buf = _buf[input];
 
-#ifdef TRACK_FLOWS
-            ++_stored_flits[f->cl][input];
-            if(f->head) ++_active_packets[f->cl][input];
-#endif
+            _flows.Inc(stored_flits, f->cl, input);
+            if(f->head) _flows.Inc(active_packets, f->cl, input);
 
 #ifdef FLIT_DEBUG
             if(f->watch) {
@@ -1203,12 +1206,11 @@ namespace Booksim
 
     }
 
-    void HybridRouter::_SwitchArbiterInput()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SwitchArbiterInput()
     {
 
-#ifdef TRACK_STALLS
         int sa_i_conflicts[_classes] = {0};
-#endif
 
         // Read inputs in SA-I
         for(int expanded_input = 0; expanded_input < _inputs*_vcs; expanded_input++) {
@@ -1240,15 +1242,51 @@ namespace Booksim
             }
 #endif
             // Add request to the input arbiter
-            if(f->head) {
-             _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
-            } else {
-                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX);
+            switch(_switch_arbiter_input_policy) {
+            case sai_strict_round_robin:
+                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                break;
+            case sai_credit_based:
+                if(f->head) {
+                    //FIXME: Only working for determinist routing (1 port per hop) We are taking the first available output port
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
+                    for(auto iter : route)
+                    {
+                        int output_port = iter.output_port;
+                        // Check that there is room for the flit
+                        BufferState const * const dest_buf = _next_buf[output_port];
+                        int dest_vc = dest_buf->GetAvailVCMinOccupancy(iter.vc_start, iter.vc_end);
+                        if(dest_vc > -1) {
+                            if(dest_buf->IsAvailableFor(dest_vc)){
+                                _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri + dest_buf->AvailableFor(dest_vc));
+                                break;
+                            }
+                        }
+                    }
+                } else {
+                    int output_port = cur_buf->GetOutputPort(in_vc);
+                    BufferState const * const dest_buf = _next_buf[output_port];
+                    int dest_vc = cur_buf->GetOutputVC(in_vc);
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri + dest_buf->AvailableFor(dest_vc));
+                }
+                break;
+            case sai_round_robin_on_miss:
+                if(!f->head && _switch_arbiter_input_winner[input] == in_vc) {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX);
+                    _switch_arbiter_input_winner[input] = -1;
+                } else {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                }
+                break;
+            default:
+                if(f->head) {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
+                } else {
+                    _switch_arbiter_input[input]->AddRequest(in_vc, f->id, INT_MAX); // FIXME: This can be the cause of deadlocks in FBFCL
+                }
             }
 
-#ifdef TRACK_STALLS
             ++sa_i_conflicts[f->cl];
-#endif
             //_switch_arbiter_input[input]->AddRequest(in_vc, f->id, f->pri);
         }
 
@@ -1276,9 +1314,7 @@ namespace Booksim
             Flit * const f = cur_buf->FrontFlit(in_vc);
             assert(f);
 
-#ifdef TRACK_STALLS
             --sa_i_conflicts[f->cl];
-#endif
 
 #ifdef FLIT_DEBUG
             if(f->watch) {
@@ -1297,19 +1333,20 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_STALLS
-        for(int cl=0; cl < _classes; cl++)
-        {
-            _switch_arbiter_input_stalls[cl] += sa_i_conflicts[cl];
+        if(_stalls.Enabled()) {
+            for(int cl=0; cl < _classes; cl++)
+            {
+                _stalls.Add(switch_arbiter_input_stalls, cl, 0, sa_i_conflicts[cl]);
+            }
         }
-#endif
     }
 
     //------------------------------------------------------------------------------
     // write outputs
     //------------------------------------------------------------------------------
 
-    void HybridRouter::_SendFlits( )
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SendFlits( )
     {
         for(int output = 0; output < _outputs; ++output) {
             if(!_output_buffer[output].empty()) {
@@ -1320,9 +1357,7 @@ namespace Booksim
                 // Add flit to the output channel
                 _output_channels[output]->Send(f);
 
-#ifdef TRACK_FLOWS
-                ++_sent_flits[f->cl][output];
-#endif
+                _flows.Inc(sent_flits, f->cl, output);
 
 #ifdef FLIT_DEBUG
                 if(f->watch) {
@@ -1339,7 +1374,8 @@ namespace Booksim
         }
     }
 
-    void HybridRouter::_SendCredits( )
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SendCredits( )
     {
         for(int input = 0; input < _inputs; ++input) {
             if(_credit_buffer[input] != NULL) {
@@ -1361,7 +1397,8 @@ namespace Booksim
         }
     }
 
-    void HybridRouter::_SendLookahead()
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::_SendLookahead()
     {
         // IMPORTANT NOTE: Note that the loop doesn't iterate through the last output port which corresponds with the terminal node, because it doesn't handle lookaheads
         for(int output = 0; output < _outputs; ++output) {
@@ -1396,10 +1433,32 @@ namespace Booksim
     //-----------------------------------------------------------
     // misc.
     // ----------------------------------------------------------
-    void HybridRouter::Display( ostream & os ) const
+    template<class FlowControl>
+    bool HybridBypassRouter<FlowControl>::_HeadFits( BufferState const * dest_buf, int vc,
+            Flit const * f, int input, int output ) const
+    {
+        bool available_space = _DimensionChange(input, output) ?
+            dest_buf->AvailableFor(vc) > f->packet_size : dest_buf->AvailableFor(vc) > 0;
+        return dest_buf->IsAvailableFor(vc) && available_space;
+    }
+
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::DeadlockWaits( vector<VCWait> & waits ) const
+    {
+        size_t const first = waits.size();
+        _CollectVCWaits(_buf, _next_buf, true, waits);
+        if(_switch_arbiter_input_policy == sai_body_first) {
+            _CollectInputArbiterWaits(_buf, first, waits);
+        }
+    }
+
+    template<class FlowControl>
+    void HybridBypassRouter<FlowControl>::Display( ostream & os ) const
     {
           for ( int input = 0; input < _inputs; ++input ) {
                   _buf[input]->Display( os );
                     }
     }
+    template class HybridBypassRouter<WormholeFlowControl>;
+    template class HybridBypassRouter<FBFCLFlowControl>;
 } // namespace Booksim
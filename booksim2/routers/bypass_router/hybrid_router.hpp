@@ -25,6 +25,16 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/*hybrid_router.hpp
+ *
+ *Hybrid bypass router: lookaheads compete with the buffered flits in the
+ *output arbiters and a packet can regain the bypass. The flow control is a
+ *template policy (see bypass_policies.hpp):
+ *
+ *  HybridRouter       wormhole (hybrid)
+ *  HybridFBFCLRouter  FBFCL (hybrid_fbfcl)
+ */
+
 #ifndef _HYBRID_ROUTER_HPP_
 #define _HYBRID_ROUTER_HPP_
 
@@ -36,7 +46,9 @@
 
 #include "../router.hpp"
 #include "../../routefunc.hpp"
-#include "../../arbiters/arbiter.hpp"
+#include "../../arbiters/matrix_arb.hpp"
+#include "../../arbiters/roundrobin_arb.hpp"
+#include "bypass_policies.hpp"
 
 namespace Booksim
 {
@@ -53,7 +65,8 @@ namespace Booksim
     //class BufferMonitor;
 
 
-    class HybridRouter : public Router {
+    template<class FlowControl>
+    class HybridBypassRouter : public Router {
         struct BypassOutput {
             int output_port;
             int dest_vc;
@@ -117,9 +130,9 @@ namespace Booksim
         // output buffer state (output VCs)
         vector<BufferState *> _next_buf;
 
-        // SA arbiters
-        vector<Arbiter *> _switch_arbiter_input;
-        vector<Arbiter *> _switch_arbiter_output;
+        // SA arbiters (concrete types, so the per-cycle calls are not virtual)
+        vector<RoundRobinArbiter *> _switch_arbiter_input;
+        vector<MatrixArbiter *> _switch_arbiter_output;
 
 
         /*
@@ -172,6 +185,16 @@ namespace Booksim
         void _LookAheadConflictCheck();
         void _LookAheadRouteCompute(Flit *f, int output_port);
 
+        // FBFCL: a packet that changes of dimension needs room for one more
+        // flit in the next router (the bubble). Always false for wormhole.
+        inline bool _DimensionChange(int input, int output) const {
+            return FlowControl::bubble && DimensionChange(input, output);
+        }
+
+        // Room checks of the head flits in SA-O (see Router::_CollectVCWaits)
+        virtual bool _HeadFits( BufferState const * dest_buf, int vc,
+                Flit const * f, int input, int output ) const;
+
         // Output_Stage: ST
         void _Output_Stage();
         void _SwitchTraversal();
@@ -192,19 +215,24 @@ namespace Booksim
         bool _guarantee_order;
         std::vector<std::vector<int>>_buffered_packet_outputs;
 
+        // FBFCL only, wormhole routers always serve body flits first
+        SwitchArbiterInputPolicy _switch_arbiter_input_policy;
+        vector<int> _switch_arbiter_input_winner;
+
 
         public:
 
-        HybridRouter( Configuration const & config,
+        HybridBypassRouter( Configuration const & config,
                 Module *parent, string const & name, int id,
                 int inputs, int outputs );
 
-        virtual ~HybridRouter( );
+        virtual ~HybridBypassRouter( );
 
         virtual void ReadInputs( );
         virtual void WriteOutputs( );
         
         void Display( ostream & os = cout ) const;
+        virtual void DeadlockWaits( vector<VCWait> & waits ) const;
 
         // FIXME: What is this shit.
         virtual int GetUsedCredit(int o) const { return 0;}
@@ -221,6 +249,12 @@ namespace Booksim
         virtual vector<int> MaxCredits() const { vector<int> result; return result;}
 
     };
+
+    typedef HybridBypassRouter<WormholeFlowControl> HybridRouter;
+    typedef HybridBypassRouter<FBFCLFlowControl> HybridFBFCLRouter;
+
+    extern template class HybridBypassRouter<WormholeFlowControl>;
+    extern template class HybridBypassRouter<FBFCLFlowControl>;
 } // namespace Booksim
 
 #endif
@@ -86,9 +86,7 @@ namespace Booksim
             // Proceed if there is a flit
             if (f) {
 
-#ifdef TRACK_FLOWS
-             ++_received_flits[f->cl][input];
-#endif
+             _flows.Inc(received_flits, f->cl, input);
 
                 //Perform Buffer Write
                 BufferWrite(input, f);
@@ -397,9 +395,7 @@ namespace Booksim
     }
 
     void SMARTNEBBVCTLARouter::ReadFlit(int input, Flit * f) {
-#ifdef TRACK_FLOWS
-             ++_received_flits[f->cl][input];
-#endif
+             _flows.Inc(received_flits, f->cl, input);
 
         // Compute hop route
         OutputSet nos;
@@ -726,7 +722,7 @@ namespace Booksim
             if (write_sr) {
                 int distance = sr.distance;
 
-                vector<SMARTRequest> smart_requests = GetFlitRoute(sr.f,
+                vector<SMARTRequest> const & smart_requests = GetFlitRoute(sr.f,
                                                          sr.input_port,
                                                          sr.output_port);
                 // Place SMART Request to Switch Allocation Global of router X
@@ -772,9 +768,7 @@ namespace Booksim
 
     void SMARTNEBBVCTLARouter::SwitchAllocationLocal() {
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
         // Arbitrate among every flit in the front of a VC
         // TODO: change this to hold the VC until the whole packet is sent.
         for (int input = 0; input < _inputs; input++) {
@@ -784,7 +778,7 @@ namespace Booksim
                 // FIXME: For the moment this only works for single route routing algorithms.
                 Flit *of = _sal_to_sag[input];
 
-                set<OutputSet::sSetElement> const route = of->la_route_set.GetSet();
+                OutputSet::ElementList const route = of->la_route_set.GetSet();
                 // FIXME: pick last route's output port. With adaptive algorithms this
                 // doesn't work.
                 int o_output = -1;
@@ -793,7 +787,7 @@ namespace Booksim
                 }
                 assert(o_output > -1);
                 if (of->head) {
-                    vector<SMARTRequest> smart_requests = GetFlitRoute(of, input, o_output);
+                    vector<SMARTRequest> const & smart_requests = GetFlitRoute(of, input, o_output);
                     // Place SMART Request to Switch Allocation Global of router X
                     for (auto request : smart_requests) {
                         if (request.router->AddRequestSAG(request)) {
@@ -841,7 +835,7 @@ namespace Booksim
                     }
 
                     // Check if there is an available destination in one of the routes of the route set.
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     // FIXME: pick last route's output port. With adaptive algorithms this
                     // doesn't work.
                     if (f->head) {
@@ -925,11 +919,9 @@ namespace Booksim
 #endif 
 
             // FIXME: For the moment this only works for single route routing algorithms.
-            vector<SMARTRequest> smart_requests = GetFlitRoute(f, input, output);
+            vector<SMARTRequest> const & smart_requests = GetFlitRoute(f, input, output);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
             // Dequeue flit from input buffer and store it in the pipeline register
             cur_buf->RemoveFlit(vc); 
@@ -974,11 +966,9 @@ namespace Booksim
         }
         // Reset _sw_allocator_local
         _sw_allocator_local->Clear();
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sal_allocations++;
+            _flows.Inc(sal_allocations, 0);
         }
-#endif
     }
 
     void SMARTNEBBVCTLARouter::SwitchAllocationGlobal() {
@@ -997,9 +987,7 @@ namespace Booksim
 
         // Perform SA-G allocation
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
         for (int expanded_input = 0; expanded_input < _inputs*2; expanded_input++) {
 
             SMARTRouter::SMARTRequest sr = _sag_requestors[expanded_input];
@@ -1110,9 +1098,7 @@ namespace Booksim
 
             assert(sr.f);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
 #if defined(FLIT_DEBUG) || defined(PIPELINE_DEBUG)
             if (sr.f->watch) {
@@ -1211,11 +1197,9 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sag_allocations++;
+            _flows.Inc(sag_allocations, 0);
         }
-#endif
     }
 
     int SMARTNEBBVCTLARouter::IdleLocalBuf(int input, int vc_start, int vc_end, Flit * f) {
@@ -1236,7 +1220,7 @@ namespace Booksim
 
         if (f->head) {
             // FIXME: Read first route
-            set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+            OutputSet::ElementList const route = f->la_route_set.GetSet();
             int output = route.begin()->output_port;
 
             f->vc = FreeDestVC(input, output, gBeginVCs[f->cl], gEndVCs[f->cl], f, 0);
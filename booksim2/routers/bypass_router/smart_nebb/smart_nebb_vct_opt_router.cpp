@@ -78,9 +78,7 @@ namespace Booksim
             // Proceed if there is a flit
             if (f) {
                  ++_active;
-#ifdef TRACK_FLOWS
-                 ++_received_flits[f->cl][input];
-#endif
+                 _flows.Inc(received_flits, f->cl, input);
                 //Perform Buffer Write
                 BufferWrite(input, f);
             }
@@ -201,9 +199,7 @@ namespace Booksim
     }
 
     void SMARTNEBBVCTOPTRouter::ReadFlit(int input, Flit * f) {
-#ifdef TRACK_FLOWS
-        ++_received_flits[f->cl][input];
-#endif
+        _flows.Inc(received_flits, f->cl, input);
         ++_active;
 
         // Compute hop route
@@ -468,9 +464,7 @@ namespace Booksim
     }
 
     void SMARTNEBBVCTOPTRouter::SwitchAllocationLocal() {
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         // Arbitrate among every flit in the front of a VC
         // TODO: change this to hold the VC until the whole packet is sent.
@@ -480,7 +474,7 @@ namespace Booksim
                 // FIXME: For the moment this only works for single route routing algorithms.
                 Flit *of = _sal_to_sag[input];
 
-                set<OutputSet::sSetElement> const route = of->la_route_set.GetSet();
+                OutputSet::ElementList const route = of->la_route_set.GetSet();
                 // FIXME: pick last route's output port. With adaptive algorithms this
                 // doesn't work.
                 int o_output = -1;
@@ -488,7 +482,7 @@ namespace Booksim
                     o_output = iter.output_port;
                 }
                 assert(o_output > -1);
-                vector<SMARTRequest> smart_requests = GetFlitRoute(of, input, o_output);
+                vector<SMARTRequest> const & smart_requests = GetFlitRoute(of, input, o_output);
                 // Place SMART Request to Switch Allocation Global of router X
                 for (auto request : smart_requests) {
                     request.router->AddRequestSAG(request);
@@ -532,7 +526,7 @@ namespace Booksim
                     }
 
                     // Check if there is an available destination in one of the routes of the route set.
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     // FIXME: pick last route's output port. With adaptive algorithms this
                     // doesn't work.
                     if (f->head) {
@@ -654,13 +648,11 @@ namespace Booksim
         
             // FIXME: For the moment this only works for single route
             //        routing algorithms.
-            vector<SMARTRequest> smart_requests = GetFlitRoute(f,
+            vector<SMARTRequest> const & smart_requests = GetFlitRoute(f,
                                                                input,
                                                                output);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
             // Dequeue flit from input buffer and store it in the pipeline register
             cur_buf->RemoveFlit(vc);
@@ -706,11 +698,9 @@ namespace Booksim
         }
         // Reset _sw_allocator_local
         _sw_allocator_local->Clear();
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sal_allocations++;
+            _flows.Inc(sal_allocations, 0);
         }
-#endif
     }
 
     void SMARTNEBBVCTOPTRouter::SwitchAllocationGlobal() {
@@ -725,9 +715,7 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         for (int expanded_input = 0; expanded_input < _inputs*2; expanded_input++) {
 
@@ -851,9 +839,7 @@ namespace Booksim
 
             assert(sr.f);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
 #if defined(FLIT_DEBUG) || defined(PIPELINE_DEBUG)
             if (sr.f->watch) {
@@ -917,11 +903,9 @@ namespace Booksim
         // Reset _sw_allocator_global
         //_sw_allocator_global->Clear();
 
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sag_allocations++;
+            _flows.Inc(sag_allocations, 0);
         }
-#endif
     }
 
     int SMARTNEBBVCTOPTRouter::IdleLocalBuf(int input, int vc_start, int vc_end, Flit * f) {
@@ -946,7 +930,7 @@ namespace Booksim
 
         if (f->head) {
             // FIXME: Read first route
-            set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+            OutputSet::ElementList const route = f->la_route_set.GetSet();
             int output = route.begin()->output_port;
 
             f->vc = FreeDestVC(input, output, gBeginVCs[f->cl], gEndVCs[f->cl], f, 0);
@@ -128,9 +128,7 @@ namespace Booksim
     }
 
     void SMARTNEBBVCTRouter::ReadFlit(int input, Flit * f) {
-#ifdef TRACK_FLOWS
-             ++_received_flits[f->cl][input];
-#endif
+             _flows.Inc(received_flits, f->cl, input);
 
         // Compute hop route
         OutputSet nos;
@@ -155,7 +153,7 @@ namespace Booksim
                 //int output;
                 //if (f->head) {
                 //// FIXME: We are supposing that the routing is deterministic.
-                //    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                //    OutputSet::ElementList const route = f->la_route_set.GetSet();
                 //    for (auto iter : route) {
                 //    //  int vc = FreeDestVC(iter.output_port, iter.vc_start, iter.vc_end);
                 //    //  assert(vc > -1);
@@ -322,9 +320,7 @@ namespace Booksim
 
     void SMARTNEBBVCTRouter::SwitchAllocationLocal() {
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         // Arbitrate among every flit in the front of a VC
         // TODO: change this to hold the VC until the whole packet is sent.
@@ -333,7 +329,7 @@ namespace Booksim
                 // FIXME: For the moment this only works for single route routing algorithms.
                 Flit *of = _sal_to_sag[input];
 
-                set<OutputSet::sSetElement> const route = of->la_route_set.GetSet();
+                OutputSet::ElementList const route = of->la_route_set.GetSet();
                 // FIXME: pick last route's output port. With adaptive algorithms this
                 // doesn't work.
                 int o_output = -1;
@@ -341,7 +337,7 @@ namespace Booksim
                     o_output = iter.output_port;
                 }
                 assert(o_output > -1);
-                vector<SMARTRequest> smart_requests = GetFlitRoute(of, input, o_output);
+                vector<SMARTRequest> const & smart_requests = GetFlitRoute(of, input, o_output);
                 // Place SMART Request to Switch Allocation Global of router X
                 for (auto request : smart_requests) {
                     request.router->AddRequestSAG(request);
@@ -386,7 +382,7 @@ namespace Booksim
                     }
                     
                     // Check if there is an available destination in one of the routes of the route set.
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     // FIXME: pick last route's output port. With adaptive algorithms this
                     // doesn't work.
                     if (f->head) {
@@ -501,11 +497,9 @@ namespace Booksim
 #endif 
         
             // FIXME: For the moment this only works for single route routing algorithms.
-            vector<SMARTRequest> smart_requests = GetFlitRoute(f, input, output);
+            vector<SMARTRequest> const & smart_requests = GetFlitRoute(f, input, output);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
             // Dequeue flit from input buffer and store it in the pipeline register
             cur_buf->RemoveFlit(vc); 
@@ -547,11 +541,9 @@ namespace Booksim
         }
         // Reset _sw_allocator_local
         _sw_allocator_local->Clear();
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sal_allocations++;
+            _flows.Inc(sal_allocations, 0);
         }
-#endif
     }
 
     void SMARTNEBBVCTRouter::SwitchAllocationGlobal() {
@@ -566,9 +558,7 @@ namespace Booksim
         // Perform SA-G allocation
         // XXX: Request are placed by AddRequestSAG in SA-L
         //_sw_allocator_global->Allocate();
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         for (int expanded_input = 0; expanded_input < _inputs*2; expanded_input++) {
 
@@ -676,9 +666,7 @@ namespace Booksim
 
             assert(sr.f);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
 
             //_bypass_path[input] = -1;
@@ -752,11 +740,9 @@ namespace Booksim
         // Reset _sw_allocator_global
         //_sw_allocator_global->Clear();
 
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sag_allocations++;
+            _flows.Inc(sag_allocations, 0);
         }
-#endif
     }
 
     int SMARTNEBBVCTRouter::IdleLocalBuf(int input, int vc_start, int vc_end, Flit * f) {
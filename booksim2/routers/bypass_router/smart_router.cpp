@@ -51,6 +51,15 @@
 namespace Booksim
 {
 
+    // Routing functions whose path only depends on the current router, the
+    // destination and the class. The torus ones are not: they break the tie
+    // between both directions at random.
+    static bool _DeterministicRouting(string const & rf)
+    {
+        return (rf == "dor_mesh") || (rf == "dim_order_mesh") ||
+               (rf == "dor_cmesh") || (rf == "dim_order_cmesh") ||
+               (rf == "dor_smartcmesh") || (rf == "dim_order_smartcmesh");
+    }
 
     SMARTRouter::SMARTRouter(Configuration const & config, Module *parent, string
             const & name, int id, int inputs, int outputs) : Router( config, parent,
@@ -74,6 +83,9 @@ namespace Booksim
             Error("Invalid routing function: " + rf);
         }
         _rf = rf_iter->second;
+        _route_cache = (config.GetInt("smart_route_cache") > 0) &&
+                       _DeterministicRouting(rf);
+        _route_classes = config.GetInt("classes");
 
         // SMART initialization
         _hpc_max = config.GetInt("smart_max_hops");
@@ -151,15 +163,6 @@ namespace Booksim
 
         // Flits to buffer write
         _flits_to_BW.resize(_inputs);
-
-#ifdef TRACK_FLOWS
-        for (int c = 0; c < _classes; ++c) {
-            _stored_flits[c].resize(_inputs, 0);
-            _active_packets[c].resize(_inputs, 0);
-        }
-        _sal_allocations = 0;
-        _sag_allocations = 0;
-#endif
       
         _credit_buffer.resize(_inputs); 
         _smart_credit_buffer.resize(_inputs); 
@@ -205,9 +208,7 @@ namespace Booksim
             // Proceed if there is a flit
             if (f) {
                  ++_active;
-#ifdef TRACK_FLOWS
-                 ++_received_flits[f->cl][input];
-#endif
+                 _flows.Inc(received_flits, f->cl, input);
 
                 // FIXME: Only injection channels should enter here.
 
@@ -328,11 +329,9 @@ namespace Booksim
         
         Buffer * const cur_buf = _buf[input];
 
-#ifdef TRACK_FLOWS
-        ++_stored_flits[f->cl][input];
+        _flows.Inc(stored_flits, f->cl, input);
         if (f->head)
-            ++_active_packets[f->cl][input];
-#endif
+            _flows.Inc(active_packets, f->cl, input);
 
         cur_buf->AddFlit(in_vc, f);
 
@@ -396,9 +395,7 @@ namespace Booksim
     }
 
     void SMARTRouter::ReadFlit(int input, Flit * f) {
-#ifdef TRACK_FLOWS
-             ++_received_flits[f->cl][input];
-#endif
+             _flows.Inc(received_flits, f->cl, input);
         ++_active;
 
         // Compute hop route
@@ -505,9 +502,7 @@ namespace Booksim
 
     void SMARTRouter::SwitchAllocationLocal() {
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         // Arbitrate among every flit in the front of a VC
         // FIXME: for each input port choose a random VC. It has to have a flit.
@@ -518,7 +513,7 @@ namespace Booksim
                 // FIXME: For the moment this only works for single route routing algorithms.
                 Flit *of = _sal_to_sag[input];
 
-                set<OutputSet::sSetElement> const route = of->la_route_set.GetSet();
+                OutputSet::ElementList const route = of->la_route_set.GetSet();
                 // FIXME: pick last route's output port. With adaptive algorithms this
                 // doesn't work.
                 int o_output = -1;
@@ -526,7 +521,7 @@ namespace Booksim
                     o_output = iter.output_port;
                 }
                 assert(o_output > -1);
-                vector<SMARTRequest> smart_requests = GetFlitRoute(of, input, o_output);
+                vector<SMARTRequest> const & smart_requests = GetFlitRoute(of, input, o_output);
                 // Place SMART Request to Switch Allocation Global of router X
                 for (auto request : smart_requests) {
                     request.router->AddRequestSAG(request);
@@ -571,7 +566,7 @@ namespace Booksim
                     }
 
                     // Check if there is an available destination in one of the routes of the route set.
-                    set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+                    OutputSet::ElementList const route = f->la_route_set.GetSet();
                     // FIXME: pick last route's output port. With adaptive algorithms this
                     // doesn't work.
                     if (f->head) {
@@ -675,11 +670,9 @@ namespace Booksim
 #endif 
 
             // FIXME: For the moment this only works for single route routing algorithms.
-            vector<SMARTRequest> smart_requests = GetFlitRoute(f, input, output);
+            vector<SMARTRequest> const & smart_requests = GetFlitRoute(f, input, output);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
             // Dequeue flit from input buffer and store it in the pipeline register
             cur_buf->RemoveFlit(vc);
@@ -721,11 +714,9 @@ namespace Booksim
         }
         // Reset _sw_allocator_local
         _sw_allocator_local->Clear();
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sal_allocations++;
+            _flows.Inc(sal_allocations, 0);
         }
-#endif
     }
 
     void SMARTRouter::EvaluateFlitNextRouter()
@@ -747,9 +738,7 @@ namespace Booksim
         // Perform SA-G allocation
         // XXX: Request are placed by AddRequestSAG in SA-L
 
-#ifdef TRACK_FLOWS
         bool increase_allocations = false;
-#endif
 
         for (int expanded_input = 0; expanded_input < _inputs*2; expanded_input++) {
 
@@ -835,9 +824,7 @@ namespace Booksim
             assert(vc > -1);
             assert(sr.f);
 
-#ifdef TRACK_FLOWS
             increase_allocations = true;
-#endif
 
 
 #if defined(FLIT_DEBUG) || defined(PIPELINE_DEBUG)
@@ -870,11 +857,9 @@ namespace Booksim
             _sag_requestors[expanded_input] = {NULL, NULL, -1, -1, -1, -1, -1, -1, -1, -1};
         }
 
-#ifdef TRACK_FLOWS
         if (increase_allocations) {
-            _sag_allocations++;
+            _flows.Inc(sag_allocations, 0);
         }
-#endif
     }
 
     // Returns true to exit the calling loop
@@ -909,7 +894,7 @@ namespace Booksim
         //       Therefore, vc_start and vc_end are ignored.
         OutputSet nos;
         _rf(this, f, input, &nos, false);
-        set<OutputSet::sSetElement> const route = nos.GetSet();
+        OutputSet::ElementList const route = nos.GetSet();
         // FIXME: pick last route's output port. With adaptive algorithms this
         // doesn't work.
         int r_vc_start = -1;
@@ -963,28 +948,12 @@ namespace Booksim
      return -1;
     }
 
-    // Returns [(output_port, (vc_min, vc_max)), (output_port),
-    // (vc_min, vc_max), <infor hop2>, ... ]
-    vector<SMARTRouter::SMARTRequest> SMARTRouter::GetFlitRoute(Flit * f,
-                                            int input_port, int output_port) {
+    // Appends the hops after this router of the route to the destination of
+    // f through output_port.
+    void SMARTRouter::_ComputeFlitRoute(Flit * f, int output_port, vector<RouteHop> & hops) {
         // Clone flit to obtain whole route from this hop.  I use the Lookahead to
         // clone the flit.
-        assert(f);
-
-        Lookahead * la = new Lookahead(f);
-
-        vector<SMARTRequest> route_path;
-
-        //This hop also counts (distance 0)
-        set<OutputSet::sSetElement> const local_route = f->la_route_set.GetSet();
-
-        int vc_start = gBeginVCs[f->cl];
-        int vc_end = gEndVCs[f->cl];
-        assert(vc_start != -1 && vc_end != -1);
-        SMARTRequest sr_initial = {this, f, input_port, output_port,
-                                   input_port, f->vc, output_port, vc_start,
-                                   vc_end, 0};
-        route_path.push_back(sr_initial);
+        Lookahead * la = Lookahead::New(f);
 
         // Iterate over every hop in the route.
         // FIXME: I'm supposing that in all the
@@ -992,8 +961,6 @@ namespace Booksim
         int next_output_port = output_port;
         //const SMARTRouter * router = this;
         SMARTRouter * router = this;
-        int distance = 0;
-        int hops = 0;
         while (next_output_port < _outputs-gC) {
             la->la_route_set.Clear();
             // Load output channel and get next router
@@ -1009,34 +976,81 @@ namespace Booksim
                 la->vc = gBeginVCs[f->cl];
                 _rf(router, la, in_channel, &nos, false);
                 la->la_route_set = nos;
-                set<OutputSet::sSetElement> const route = nos.GetSet();
+                OutputSet::ElementList const route = nos.GetSet();
 
                 // Iterate through all the posible routes (output ports and destinations VCs)
-                distance++;
                 for (auto iter : route) {
                     next_output_port = iter.output_port;
                 }
-                int next_vc_start = gBeginVCs[f->cl];
-                int next_vc_end = gEndVCs[f->cl];
-                assert(next_vc_start > -1 && next_vc_end > -1);
-
-                SMARTRequest sr = {router, f, input_port, output_port, 
-                                   in_channel, f->vc,
-                                   next_output_port, next_vc_start,
-                                   next_vc_end, distance, -1};
-                route_path.push_back(sr);
-                hops++;
-            }
-            // Add total hops to every sr:
-            for (int i = 0; i < (int)route_path.size(); i++) {
-                route_path[i].hops = hops;
+                RouteHop hop = {router, in_channel, next_output_port};
+                hops.push_back(hop);
             }
         }
 
         la->Free();
+    }
+
+    // Returns [(output_port, (vc_min, vc_max)), (output_port),
+    // (vc_min, vc_max), <infor hop2>, ... ]
+    vector<SMARTRouter::SMARTRequest> const & SMARTRouter::GetFlitRoute(Flit * f,
+                                            int input_port, int output_port) {
+        assert(f);
+
+        int vc_start = gBeginVCs[f->cl];
+        int vc_end = gEndVCs[f->cl];
+        assert(vc_start != -1 && vc_end != -1);
+
+        // Watched flits do not use the cache, so the routing function traces
+        // every hop
+        size_t const end = _route_hops.size();
+        size_t first = end;
+        int hops = 0;
+        if (_route_cache && !f->watch) {
+            if (_route_index.empty()) {
+                _route_index.resize(_outputs * gNodes * _route_classes, make_pair(-1, -1));
+            }
+            pair<int, int> & entry = _route_index[(output_port * gNodes + f->dest) * _route_classes + f->cl];
+            if (entry.first < 0) {
+                _ComputeFlitRoute(f, output_port, _route_hops);
+                entry.first = _route_hops.size() - end;
+                entry.second = end;
+            }
+            hops = entry.first;
+            first = entry.second;
+        } else {
+            _ComputeFlitRoute(f, output_port, _route_hops);
+            hops = _route_hops.size() - end;
+        }
+
+        _route_path.clear();
+
+        //This hop also counts (distance 0)
+        SMARTRequest sr_initial = {this, f, input_port, output_port,
+                                   input_port, f->vc, output_port, vc_start,
+                                   vc_end, 0, hops};
+        _route_path.push_back(sr_initial);
+
+        for (int distance = 1; distance <= hops; distance++) {
+            RouteHop const & hop = _route_hops[first + distance - 1];
+            SMARTRequest sr = {hop.router, f, input_port, output_port,
+                               hop.input_port, f->vc,
+                               hop.output_port, vc_start,
+                               vc_end, distance, hops};
+            _route_path.push_back(sr);
+        }
+
+        if (!_route_cache || f->watch) {
+            _route_hops.resize(end);
+        }
 
         // Return list of output ports that conform the route.
-        return route_path;
+        return _route_path;
+    }
+
+    void SMARTRouter::InvalidateRouteCache()
+    {
+        _route_index.clear();
+        _route_hops.clear();
     }
 
     // TODO: Is there a better solution for these two fuctions?.
@@ -1059,7 +1073,7 @@ namespace Booksim
 
         if (f->head) {
             // FIXME: Read first route
-            set<OutputSet::sSetElement> const route = f->la_route_set.GetSet();
+            OutputSet::ElementList const route = f->la_route_set.GetSet();
             int output = route.begin()->output_port;
 
             f->vc = FreeDestVC(input, output, gBeginVCs[f->cl], gEndVCs[f->cl], f, 0);
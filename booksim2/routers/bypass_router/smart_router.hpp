@@ -130,6 +130,24 @@ namespace Booksim
 
         tRoutingFunction   _rf;
 
+        // Memoized GetFlitRoute() paths. With a deterministic routing
+        // function the path only depends on the output port, the destination
+        // and the class, so it is computed once per (output, dest, class).
+        struct RouteHop {
+          SMARTRouter * router;
+          int input_port;
+          int output_port;
+        };
+        bool _route_cache;
+        int _route_classes;
+        // (output, dest, class) -> path length and first hop in _route_hops
+        vector<pair<int, int> > _route_index;
+        vector<RouteHop> _route_hops;
+        // Storage of the vector returned by GetFlitRoute()
+        vector<SMARTRequest> _route_path;
+
+        void _ComputeFlitRoute(Flit * f, int output_port, vector<RouteHop> & hops);
+
         // Credit output buffer
         map<int, Credit *> _out_queue_credits;
         vector<queue<Credit *> > _credit_buffer;
@@ -185,7 +203,10 @@ namespace Booksim
         // FIXME: This is dirty way of obtaining the whole
         // route path, so we can send SSR without modifying
         // the flit/packet route info.
-        vector<SMARTRequest> GetFlitRoute(Flit * f, int input_port, int output_port);
+        // The result is only valid until the next call.
+        vector<SMARTRequest> const & GetFlitRoute(Flit * f, int input_port, int output_port);
+        // Drops the memoized paths, e.g. after changing the routes
+        void InvalidateRouteCache();
 
         // Used to obtain the whole route path.
         virtual SMARTRouter * GetNextRouter(int next_output_port);
@@ -165,6 +165,8 @@ namespace Booksim
       _output_buffer_size = config.GetInt("output_buffer_size");
       _output_buffer.resize(_outputs); 
       _credit_buffer.resize(_inputs); 
+      _in_queue_flits.Resize(_inputs);
+      _out_queue_credits.Resize(_inputs);
 
       // Switch configuration (when held for multiple cycles)
       _hold_switch_for_packet = (config.GetInt("hold_switch_for_packet") > 0);
@@ -175,13 +177,7 @@ namespace Booksim
       _bufferMonitor = new BufferMonitor(inputs, _classes);
       _switchMonitor = new SwitchMonitor(inputs, outputs, _classes);
 
-#ifdef TRACK_FLOWS
-      for(int c = 0; c < _classes; ++c) {
-        _stored_flits[c].resize(_inputs, 0);
-        _active_packets[c].resize(_inputs, 0);
-      }
       _outstanding_classes.resize(_outputs, vector<queue<int> >(_vcs));
-#endif
     }
 
     FBFCLRouter::~FBFCLRouter( )
@@ -292,6 +288,26 @@ namespace Booksim
       _SendCredits( );
     }
 
+    // Asleep, ReadInputs() would find no input, _InternalStep() returns at
+    // once and there is nothing left to send.
+    bool FBFCLRouter::Idle( ) const
+    {
+      if(_active || !_CanSleep( )) {
+        return false;
+      }
+      for ( int output = 0; output < _outputs; ++output ) {
+        if ( !_output_buffer[output].empty( ) ) {
+          return false;
+        }
+      }
+      for ( int input = 0; input < _inputs; ++input ) {
+        if ( !_credit_buffer[input].empty( ) ) {
+          return false;
+        }
+      }
+      return true;
+    }
+
 
     //------------------------------------------------------------------------------
     // read inputs
@@ -304,9 +320,7 @@ namespace Booksim
         Flit * const f = _input_channels[input]->Receive();
         if(f) {
 
-#ifdef TRACK_FLOWS
-          ++_received_flits[f->cl][input];
-#endif
+          _flows.Inc(received_flits, f->cl, input);
 
           if(f->watch) {
         *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -314,7 +328,7 @@ namespace Booksim
                << " from channel at input " << input
                << "." << endl;
           }
-          _in_queue_flits.insert(make_pair(input, f));
+          _in_queue_flits.Insert(input, f);
           activity = true;
         }
       }
@@ -342,14 +356,13 @@ namespace Booksim
 
     void FBFCLRouter::_InputQueuing( )
     {
-      for(map<int, Flit *>::const_iterator iter = _in_queue_flits.begin();
-          iter != _in_queue_flits.end();
-          ++iter) {
+      for(int input = _in_queue_flits.Next(0);
+          input >= 0;
+          input = _in_queue_flits.Next(input + 1)) {
 
-        int const input = iter->first;
         assert((input >= 0) && (input < _inputs));
 
-        Flit * const f = iter->second;
+        Flit * const f = _in_queue_flits.Get(input);
         assert(f);
 
         int const vc = f->vc;
@@ -373,10 +386,8 @@ namespace Booksim
         }
         cur_buf->AddFlit(vc, f);
 
-#ifdef TRACK_FLOWS
-        ++_stored_flits[f->cl][input];
-        if(f->head) ++_active_packets[f->cl][input];
-#endif
+        _flows.Inc(stored_flits, f->cl, input);
+        if(f->head) _flows.Inc(active_packets, f->cl, input);
 
         _bufferMonitor->write(input, f) ;
 
@@ -421,7 +432,7 @@ namespace Booksim
           }
         }
       }
-      _in_queue_flits.clear();
+      _in_queue_flits.Clear();
 
       while(!_proc_credits.empty()) {
         //BSMOD: Change time to long long
@@ -441,16 +452,16 @@ namespace Booksim
         
         BufferState * const dest_buf = _next_buf[output];
         
-#ifdef TRACK_FLOWS
-        for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-          int const vc = *iter;
-          assert(!_outstanding_classes[output][vc].empty());
-          int cl = _outstanding_classes[output][vc].front();
-          _outstanding_classes[output][vc].pop();
-          assert(_outstanding_credits[cl][output] > 0);
-          --_outstanding_credits[cl][output];
+        if(_flows.Enabled()) {
+          for(VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+            int const vc = *iter;
+            assert(!_outstanding_classes[output][vc].empty());
+            int cl = _outstanding_classes[output][vc].front();
+            _outstanding_classes[output][vc].pop();
+            assert(_flows.Get(outstanding_credits, cl, output) > 0);
+            _flows.Dec(outstanding_credits, cl, output);
+          }
         }
-#endif
 
         dest_buf->ProcessCredit(c);
         c->Free();
@@ -601,7 +612,7 @@ namespace Booksim
         assert(route_set);
 
         int const out_priority = cur_buf->GetPriority(vc);
-        set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+        OutputSet::ElementList const setlist = route_set->GetSet();
 
         bool elig = false;
         bool cred = false;
@@ -609,7 +620,7 @@ namespace Booksim
 
         assert(!_noq || (setlist.size() == 1));
 
-        for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+        for(OutputSet::ElementList::const_iterator iset = setlist.begin();
         iset != setlist.end();
         ++iset) {
 
@@ -924,15 +935,15 @@ namespace Booksim
                << "  No output VC allocated." << endl;
           }
 
-#ifdef TRACK_STALLS
-          assert((output_and_vc == STALL_BUFFER_BUSY) ||
-             (output_and_vc == STALL_BUFFER_CONFLICT));
-          if(output_and_vc == STALL_BUFFER_BUSY) {
-        ++_buffer_busy_stalls[f->cl];
-          } else if(output_and_vc == STALL_BUFFER_CONFLICT) {
-        ++_buffer_conflict_stalls[f->cl];
+          if(_stalls.Enabled()) {
+            assert((output_and_vc == STALL_BUFFER_BUSY) ||
+               (output_and_vc == STALL_BUFFER_CONFLICT));
+            if(output_and_vc == STALL_BUFFER_BUSY) {
+          _stalls.Inc(buffer_busy_stalls, f->cl);
+            } else if(output_and_vc == STALL_BUFFER_CONFLICT) {
+          _stalls.Inc(buffer_conflict_stalls, f->cl);
+            }
           }
-#endif
 
           _vc_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first, -1)));
         }
@@ -1086,10 +1097,8 @@ namespace Booksim
           
           cur_buf->RemoveFlit(vc);
 
-#ifdef TRACK_FLOWS
-          //--_stored_flits[f->cl][input];
-          if(f->tail) --_active_packets[f->cl][input];
-#endif
+          //_flows.Dec(stored_flits, f->cl, input);
+          if(f->tail) _flows.Dec(active_packets, f->cl, input);
 
           _bufferMonitor->read(input, f) ;
           
@@ -1131,19 +1140,19 @@ namespace Booksim
         }
           }
 
-#ifdef TRACK_FLOWS
-          ++_outstanding_credits[f->cl][output];
-          _outstanding_classes[output][f->vc].push(f->cl);
-#endif
+          if(_flows.Enabled()) {
+            _flows.Inc(outstanding_credits, f->cl, output);
+            _outstanding_classes[output][f->vc].push(f->cl);
+          }
 
           dest_buf->SendingFlit(f);
 
           _crossbar_flits.push_back(make_pair(-1, make_pair(f, make_pair(expanded_input, expanded_output))));
           
-          if(_out_queue_credits.count(input) == 0) {
-        _out_queue_credits.insert(make_pair(input, Credit::New()));
+          if(!_out_queue_credits.Occupied(input)) {
+        _out_queue_credits.Insert(input, Credit::New());
           }
-          _out_queue_credits.find(input)->second->vc.insert(vc);
+          _out_queue_credits.Get(input)->vc.insert(vc);
           
           if(cur_buf->Empty(vc)) {
         if(f->watch) {
@@ -1421,11 +1430,11 @@ namespace Booksim
         OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
         assert(route_set);
         
-        set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+        OutputSet::ElementList const setlist = route_set->GetSet();
         
         assert(!_noq || (setlist.size() == 1));
 
-        for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+        for(OutputSet::ElementList::const_iterator iset = setlist.begin();
         iset != setlist.end();
         ++iset) {
           
@@ -1766,7 +1775,7 @@ namespace Booksim
           OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
           assert(route_set);
 
-          set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+          OutputSet::ElementList const setlist = route_set->GetSet();
 
           bool busy = true;
           bool full = true;
@@ -1774,7 +1783,7 @@ namespace Booksim
 
           assert(!_noq || (setlist.size() == 1));
 
-          for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+          for(OutputSet::ElementList::const_iterator iset = setlist.begin();
               iset != setlist.end();
               ++iset) {
             if(iset->output_port == output) {
@@ -1922,11 +1931,11 @@ namespace Booksim
         int match_prio = numeric_limits<int>::min();
 
         const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-        set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+        OutputSet::ElementList const setlist = route_set->GetSet();
         
         assert(!_noq || (setlist.size() == 1));
         
-        for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+        for(OutputSet::ElementList::const_iterator iset = setlist.begin();
             iset != setlist.end();
             ++iset) {
           if(iset->output_port == output) {
@@ -2005,10 +2014,8 @@ namespace Booksim
 
           cur_buf->RemoveFlit(vc);
 
-#ifdef TRACK_FLOWS
-          //--_stored_flits[f->cl][input];
-          if(f->tail) --_active_packets[f->cl][input];
-#endif
+          //_flows.Dec(stored_flits, f->cl, input);
+          if(f->tail) _flows.Dec(active_packets, f->cl, input);
 
           _bufferMonitor->read(input, f) ;
 
@@ -2050,19 +2057,19 @@ namespace Booksim
         }
           }
 
-#ifdef TRACK_FLOWS
-          ++_outstanding_credits[f->cl][output];
-          _outstanding_classes[output][f->vc].push(f->cl);
-#endif
+          if(_flows.Enabled()) {
+            _flows.Inc(outstanding_credits, f->cl, output);
+            _outstanding_classes[output][f->vc].push(f->cl);
+          }
 
           dest_buf->SendingFlit(f);
 
           _crossbar_flits.push_back(make_pair(-1, make_pair(f, make_pair(expanded_input, expanded_output))));
 
-          if(_out_queue_credits.count(input) == 0) {
-        _out_queue_credits.insert(make_pair(input, Credit::New()));
+          if(!_out_queue_credits.Occupied(input)) {
+        _out_queue_credits.Insert(input, Credit::New());
           }
-          _out_queue_credits.find(input)->second->vc.insert(vc);
+          _out_queue_credits.Get(input)->vc.insert(vc);
 
           if(cur_buf->Empty(vc)) {
         if(f->tail) {
@@ -2127,25 +2134,25 @@ namespace Booksim
                << "  No output port allocated." << endl;
           }
 
-#ifdef TRACK_STALLS
-          assert((expanded_output == -1) || // for stalls that are accounted for in VC allocation path
-             (expanded_output == STALL_BUFFER_BUSY) ||
-             (expanded_output == STALL_BUFFER_CONFLICT) ||
-             (expanded_output == STALL_BUFFER_FULL) ||
-             (expanded_output == STALL_BUFFER_RESERVED) ||
-             (expanded_output == STALL_CROSSBAR_CONFLICT));
-          if(expanded_output == STALL_BUFFER_BUSY) {
-        ++_buffer_busy_stalls[f->cl];
-          } else if(expanded_output == STALL_BUFFER_CONFLICT) {
-        ++_buffer_conflict_stalls[f->cl];
-          } else if(expanded_output == STALL_BUFFER_FULL) {
-        ++_buffer_full_stalls[f->cl];
-          } else if(expanded_output == STALL_BUFFER_RESERVED) {
-        ++_buffer_reserved_stalls[f->cl];
-          } else if(expanded_output == STALL_CROSSBAR_CONFLICT) {
-        ++_crossbar_conflict_stalls[f->cl];
+          if(_stalls.Enabled()) {
+            assert((expanded_output == -1) || // for stalls that are accounted for in VC allocation path
+               (expanded_output == STALL_BUFFER_BUSY) ||
+               (expanded_output == STALL_BUFFER_CONFLICT) ||
+               (expanded_output == STALL_BUFFER_FULL) ||
+               (expanded_output == STALL_BUFFER_RESERVED) ||
+               (expanded_output == STALL_CROSSBAR_CONFLICT));
+            if(expanded_output == STALL_BUFFER_BUSY) {
+          _stalls.Inc(buffer_busy_stalls, f->cl);
+            } else if(expanded_output == STALL_BUFFER_CONFLICT) {
+          _stalls.Inc(buffer_conflict_stalls, f->cl);
+            } else if(expanded_output == STALL_BUFFER_FULL) {
+          _stalls.Inc(buffer_full_stalls, f->cl);
+            } else if(expanded_output == STALL_BUFFER_RESERVED) {
+          _stalls.Inc(buffer_reserved_stalls, f->cl);
+            } else if(expanded_output == STALL_CROSSBAR_CONFLICT) {
+          _stalls.Inc(crossbar_conflict_stalls, f->cl);
+            }
           }
-#endif
 
           _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first, -1)));
         }
@@ -2244,20 +2251,19 @@ namespace Booksim
 
     void FBFCLRouter::_OutputQueuing( )
     {
-      for(map<int, Credit *>::const_iterator iter = _out_queue_credits.begin();
-          iter != _out_queue_credits.end();
-          ++iter) {
+      for(int input = _out_queue_credits.Next(0);
+          input >= 0;
+          input = _out_queue_credits.Next(input + 1)) {
 
-        int const input = iter->first;
         assert((input >= 0) && (input < _inputs));
 
-        Credit * const c = iter->second;
+        Credit * const c = _out_queue_credits.Get(input);
         assert(c);
         assert(!c->vc.empty());
 
         _credit_buffer[input].push(c);
       }
-      _out_queue_credits.clear();
+      _out_queue_credits.Clear();
     }
 
     //------------------------------------------------------------------------------
@@ -2272,9 +2278,7 @@ namespace Booksim
           assert(f);
           _output_buffer[output].pop( );
 
-#ifdef TRACK_FLOWS
-          ++_sent_flits[f->cl][output];
-#endif
+          _flows.Inc(sent_flits, f->cl, output);
 
           if(f->watch)
         *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -2306,6 +2310,11 @@ namespace Booksim
     // misc.
     //------------------------------------------------------------------------------
 
+    void FBFCLRouter::DeadlockWaits( vector<VCWait> & waits ) const
+    {
+      _CollectVCWaits(_buf, _next_buf, false, waits);
+    }
+
     void FBFCLRouter::Display( ostream & os ) const
     {
       for ( int input = 0; input < _inputs; ++input ) {
@@ -2386,7 +2395,7 @@ namespace Booksim
       assert(f);
       assert(f->vc == vc);
       assert(f->head);
-      set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
+      OutputSet::ElementList sl = f->la_route_set.GetSet();
       assert(sl.size() == 1);
       int out_port = sl.begin()->output_port;
       const FlitChannel * channel = _output_channels[out_port];
@@ -37,6 +37,7 @@
 
 #include "router.hpp"
 #include "../routefunc.hpp"
+#include "../slot_array.hpp"
 
 namespace Booksim
 {
@@ -71,7 +72,7 @@ namespace Booksim
       int _vc_alloc_delay;
       int _sw_alloc_delay;
       
-      map<int, Flit *> _in_queue_flits;
+      SlotArray<Flit *> _in_queue_flits;
 
       //BSMOD: Change time to long long
       deque<pair<long long, pair<Credit *, int> > > _proc_credits;
@@ -83,7 +84,7 @@ namespace Booksim
       //BSMOD: Change time to long long
       deque<pair<long long, pair<Flit *, pair<int, int> > > > _crossbar_flits;
 
-      map<int, Credit *> _out_queue_credits;
+      SlotArray<Credit *> _out_queue_credits;
 
       vector<Buffer *> _buf;
       vector<BufferState *> _next_buf;
@@ -112,9 +113,7 @@ namespace Booksim
       vector<vector<int> > _noq_next_vc_start;
       vector<vector<int> > _noq_next_vc_end;
 
-#ifdef TRACK_FLOWS
       vector<vector<queue<int> > > _outstanding_classes;
-#endif
 
       bool _ReceiveFlits( );
       bool _ReceiveCredits( );
@@ -165,8 +164,11 @@ namespace Booksim
 
       virtual void ReadInputs( );
       virtual void WriteOutputs( );
+      virtual bool Idle( ) const;
+      virtual bool ParallelSafe( ) const { return true; }
       
       void Display( ostream & os = cout ) const;
+      virtual void DeadlockWaits( vector<VCWait> & waits ) const;
 
       virtual int GetUsedCredit(int o) const;
       virtual int GetUsedCreditVC(int o, int vc) const;
@@ -36,6 +36,7 @@
 
 #include "router.hpp"
 #include "../routefunc.hpp"
+#include "../slot_array.hpp"
 
 namespace Booksim
 {
@@ -75,7 +76,7 @@ namespace Booksim
         int _sw_alloc_delay;
 
         // Stage communication
-        map<int, Flit *> _in_queue_flits;
+        SlotArray<Flit *> _in_queue_flits;
         //BSMOD: Change time to long long
         deque<pair<long long, pair<Credit *, int> > > _proc_credits;
         //BSMOD: Change time to long long
@@ -86,7 +87,7 @@ namespace Booksim
         //BSMOD: Change time to long long
         deque<pair<long long, pair<Flit *, pair<int, int> > > > _crossbar_flits;
 
-        map<int, Credit *> _out_queue_credits;
+        SlotArray<Credit *> _out_queue_credits;
 
         // Input buffer (input VCs)
         vector<Buffer *> _buf;
@@ -123,9 +124,7 @@ namespace Booksim
         vector<vector<int> > _noq_next_vc_start;
         vector<vector<int> > _noq_next_vc_end;
 
-#ifdef TRACK_FLOWS
         vector<vector<queue<int> > > _outstanding_classes;
-#endif
 
         bool _ReceiveFlits( );
         bool _ReceiveCredits( );
@@ -178,8 +177,12 @@ namespace Booksim
 
         virtual void ReadInputs( );
         virtual void WriteOutputs( );
+        virtual bool Idle( ) const;
+        virtual long long NextActivity( long long now ) const;
+        virtual bool ParallelSafe( ) const { return true; }
 
         void Display( ostream & os = cout ) const;
+        virtual void DeadlockWaits( vector<VCWait> & waits ) const;
 
         //virtual int GetUsedCredit(int o) const {return 0;}
         //virtual int GetUsedCreditVC(int o, int vc) const {return 0;} //(I)
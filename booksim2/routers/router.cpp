@@ -42,7 +42,10 @@
 #include "booksim.hpp"
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include "router.hpp"
+#include "buffer.hpp"
+#include "buffer_state.hpp"
 
 //////////////////Sub router types//////////////////////
 #include "iq_router.hpp"
@@ -50,13 +53,9 @@
 #include "fbfcl_router.hpp"
 #include "event_router.hpp"
 #include "chaos_router.hpp"
-#include "bypass_router/bypass_no_arb_router.hpp" // Bypass router (Baseline without arb)
-#include "bypass_router/bypass_no_arb_fbfcl_router.hpp" // Bypass router (Torus-FBFCL; Baseline without arb)
-#include "bypass_router/bypass_arb_router.hpp" // Bypass router (Baseline with LA arb)
-#include "bypass_router/bypass_arb_fbfcl_router.hpp" // NEBB-VCT (Torus-FBFCL; Baseline with LA arb)
-#include "bypass_router/bypass_vct_router.hpp" // NEBB-VCT
-#include "bypass_router/bypass_vct_bubble_router.hpp" // NEBB-VCT (Torus-bubble)
-#include "bypass_router/hybrid_router.hpp" // NEBB-Hybrid
+#include "bypass_router/bypass_router.hpp" // Bypass router (Baseline with/without LA arb, Torus-FBFCL)
+#include "bypass_router/bypass_vct_router.hpp" // NEBB-VCT (and Torus-bubble)
+#include "bypass_router/hybrid_router.hpp" // NEBB-Hybrid (and Torus-FBFCL)
 #include "bypass_router/smart_router.hpp" // SMART
 #include "bypass_router/smart_nebb/smart_not_empty_realocation_router.hpp" //???
 #include "bypass_router/smart_nebb/smart_nebb_wh_router.hpp" // SMART (NEBB-WH)
@@ -67,7 +66,6 @@
 #include "bypass_router/smart_nebb/smart_nebb_vct_la_router.hpp" // S-SMART++
 #include "bypass_router/smart_nebb/smart_nebb_vct_la_bubble_router.hpp" // S-SMART++ Torus
 #include "bypass_router/smart_nebb/smart_nebb_wh_fbfcl_router.hpp"
-#include "bypass_router/hybrid_fbfcl_router.hpp"
 ///////////////////////////////////////////////////////
 
 namespace Booksim
@@ -93,31 +91,19 @@ namespace Booksim
         _internal_speedup = config.GetFloat( "internal_speedup" );
         _classes          = config.GetInt( "classes" );
 
-#ifdef TRACK_FLOWS
-        _received_flits.resize(_classes, vector<int>(_inputs, 0));
-        _stored_flits.resize(_classes);
-        _sent_flits.resize(_classes, vector<int>(_outputs, 0));
-        _active_packets.resize(_classes);
-        _outstanding_credits.resize(_classes, vector<int>(_outputs, 0));
-#endif
-
-#ifdef TRACK_STALLS
-        _switch_arbiter_input_stalls.resize(_classes, 0);
-        _buffer_busy_stalls.resize(_classes, 0);
-        _buffer_conflict_stalls.resize(_classes, 0);
-        _buffer_full_stalls.resize(_classes, 0);
-        _buffer_reserved_stalls.resize(_classes, 0);
-        _crossbar_conflict_stalls.resize(_classes, 0);
-        _output_blocked_stalls.resize(_classes,0);
-
-        _la_buffer_busy.resize(_classes, 0);
-        _la_buffer_conflict.resize(_classes, 0);
-        _la_buffer_full.resize(_classes, 0);
-        _la_buffer_reserved.resize(_classes, 0);
-        _la_crossbar_conflict.resize(_classes, 0);
-        _la_sa_winners_killed.resize(_classes, 0);
-        _la_output_blocked.resize(_classes,0);
-#endif
+        // Registered in eFlowCounter / eStallCounter order
+        _flows.Register(_classes, _inputs);  // received_flits
+        _flows.Register(_classes, _inputs);  // stored_flits
+        _flows.Register(_classes, _outputs); // sent_flits
+        _flows.Register(_classes, _outputs); // outstanding_credits
+        _flows.Register(_classes, _inputs);  // active_packets
+        _flows.Register(1);                  // sal_allocations
+        _flows.Register(1);                  // sag_allocations
+        for(int s = switch_arbiter_input_stalls; s <= la_output_blocked; ++s) {
+            _stalls.Register(_classes);
+        }
+        _flows.Enable(config.GetInt("track_flows") > 0);
+        _stalls.Enable(config.GetInt("track_stalls") > 0);
 
     }
 
@@ -126,6 +112,7 @@ namespace Booksim
         _input_channels.push_back( channel );
         _input_credits.push_back( backchannel );
         channel->SetSink( this, _input_channels.size() - 1 ) ;
+        channel->SetWakeSink( this );
     }
 
     void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel )
@@ -134,6 +121,7 @@ namespace Booksim
         _output_credits.push_back( backchannel );
         _channel_faults.push_back( false );
         channel->SetSource( this, _output_channels.size() - 1 ) ;
+        backchannel->SetWakeSink( this );
     }
 
     // With lookahead lines for bypass
@@ -143,6 +131,10 @@ namespace Booksim
         _input_credits.push_back( backchannel );
         _input_lookahead.push_back( lookahead_signals );
         channel->SetSink( this, _input_channels.size() - 1 ) ;
+        channel->SetWakeSink( this );
+        if( lookahead_signals ) {
+            lookahead_signals->SetWakeSink( this );
+        }
     }
 
     void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel, LookaheadChannel *lookahead_signals )
@@ -152,6 +144,14 @@ namespace Booksim
         _output_lookahead.push_back( lookahead_signals );
         _channel_faults.push_back( false );
         channel->SetSource( this, _output_channels.size() - 1 ) ;
+        backchannel->SetWakeSink( this );
+    }
+
+    bool Router::_CanSleep( ) const
+    {
+        // Evaluate() is skipped while asleep, which only preserves the phase
+        // of _partial_internal_cycles if the speedup is integral
+        return _internal_speedup == floor(_internal_speedup);
     }
 
     void Router::Evaluate( )
@@ -163,6 +163,110 @@ namespace Booksim
         }
     }
 
+    bool Router::_HeadFits( BufferState const * dest_buf, int vc,
+            Flit const * f, int input, int output ) const
+    {
+        return dest_buf->IsAvailableFor(vc) && !dest_buf->IsFullFor(vc, f);
+    }
+
+    void Router::_CollectVCWaits( vector<Buffer *> const & buf,
+            vector<BufferState *> const & next_buf,
+            bool lookahead_route, vector<VCWait> & waits ) const
+    {
+        for(int input = 0; input < _inputs; ++input) {
+            Buffer const * const cur_buf = buf[input];
+            int const vcs = cur_buf->NumVCs();
+            for(int vc = 0; vc < vcs; ++vc) {
+                if(cur_buf->Empty(vc)) {
+                    continue;
+                }
+                Flit const * const f = cur_buf->FrontFlit(vc);
+                VC::eVCState const state = cur_buf->GetState(vc);
+                VCWait w;
+                w.input = input;
+                w.vc = vc;
+                w.state = state;
+                w.flit = f;
+                w.input_vc = -1;
+                bool blocked = true;
+                if(f->head && (lookahead_route || (state == VC::vc_alloc))) {
+                    OutputSet const * const route = lookahead_route ?
+                        &f->la_route_set : cur_buf->GetRouteSet(vc);
+                    if(!route) {
+                        continue;
+                    }
+                    OutputSet::ElementList const & set = route->GetSet();
+                    for(OutputSet::ElementList::const_iterator iset = set.begin();
+                            blocked && (iset != set.end()); ++iset) {
+                        int const output = iset->output_port;
+                        if(!_output_channels[output]->GetSink()) {
+                            blocked = false; // ejection
+                            break;
+                        }
+                        for(int out_vc = max(iset->vc_start, 0); out_vc <= iset->vc_end; ++out_vc) {
+                            if(_HeadFits(next_buf[output], out_vc, f, input, output)) {
+                                blocked = false;
+                                break;
+                            }
+                            w.targets.push_back(make_pair(output, out_vc));
+                        }
+                    }
+                } else if(state == VC::active) {
+                    int const output = cur_buf->GetOutputPort(vc);
+                    int const out_vc = cur_buf->GetOutputVC(vc);
+                    if((output < 0) || (out_vc < 0) ||
+                            !_output_channels[output]->GetSink() ||
+                            (next_buf[output]->AvailableFor(out_vc) > 0)) {
+                        continue;
+                    }
+                    w.targets.push_back(make_pair(output, out_vc));
+                } else {
+                    // Routing or allocation still pending
+                    continue;
+                }
+                if(blocked && !w.targets.empty()) {
+                    waits.push_back(w);
+                }
+            }
+        }
+    }
+
+    void Router::_CollectInputArbiterWaits( vector<Buffer *> const & buf,
+            size_t first, vector<VCWait> & waits ) const
+    {
+        size_t const last = waits.size();
+        vector<bool> listed;
+        for(int input = 0; input < _inputs; ++input) {
+            Buffer const * const cur_buf = buf[input];
+            int const vcs = cur_buf->NumVCs();
+            int body_vc = -1;
+            listed.assign(vcs, false);
+            for(size_t i = first; i < last; ++i) {
+                if(waits[i].input == input) {
+                    listed[waits[i].vc] = true;
+                    if(!waits[i].flit->head) {
+                        body_vc = waits[i].vc;
+                    }
+                }
+            }
+            if(body_vc < 0) {
+                continue;
+            }
+            for(int vc = 0; vc < vcs; ++vc) {
+                if(listed[vc] || cur_buf->Empty(vc) || !cur_buf->FrontFlit(vc)->head) {
+                    continue;
+                }
+                VCWait w;
+                w.input = input;
+                w.vc = vc;
+                w.state = cur_buf->GetState(vc);
+                w.flit = cur_buf->FrontFlit(vc);
+                w.input_vc = body_vc;
+                waits.push_back(w);
+            }
+        }
+    }
+
     void Router::OutChannelFault( int c, bool fault )
     {
         assert( ( c >= 0 ) && ( (size_t)c < _channel_faults.size( ) ) );
@@ -38,6 +38,7 @@
 #include "flitchannel.hpp"
 #include "channel.hpp"
 #include "config_utils.hpp"
+#include "counter_block.hpp"
 
 namespace Booksim
 {
@@ -45,6 +46,9 @@ namespace Booksim
     typedef Channel<Credit> CreditChannel;
     typedef Channel<Lookahead> LookaheadChannel;
 
+    class Buffer;
+    class BufferState;
+
     class Router : public TimedModule {
 
         protected:
@@ -88,37 +92,57 @@ namespace Booksim
 
             // FIXME
             ////// Why are these here? //////
-#ifdef TRACK_FLOWS
-            vector<vector<int> > _received_flits;
-            vector<vector<int> > _stored_flits;
-            vector<vector<int> > _sent_flits;
-            vector<vector<int> > _outstanding_credits;
-            vector<vector<int> > _active_packets;
-            int _sal_allocations;
-            int _sag_allocations;
-#endif
-
-#ifdef TRACK_STALLS
-            vector<int> _switch_arbiter_input_stalls;
-            vector<int> _buffer_busy_stalls;
-            vector<int> _buffer_conflict_stalls;
-            vector<int> _buffer_full_stalls;
-            vector<int> _buffer_reserved_stalls;
-            vector<int> _crossbar_conflict_stalls;
-            vector<int> _output_blocked_stalls;
-
-            vector<int> _la_buffer_busy;
-            vector<int> _la_buffer_conflict;
-            vector<int> _la_buffer_full;
-            vector<int> _la_buffer_reserved;
-            vector<int> _la_crossbar_conflict;
-            vector<int> _la_sa_winners_killed;
-            vector<int> _la_output_blocked;
-#endif
+            // Flow counters [class][port] and stall counters [class]. They are
+            // only updated when track_flows / track_stalls are set.
+            enum eFlowCounter { received_flits, stored_flits, sent_flits,
+                outstanding_credits, active_packets, sal_allocations,
+                sag_allocations };
+            enum eStallCounter { switch_arbiter_input_stalls,
+                buffer_busy_stalls, buffer_conflict_stalls, buffer_full_stalls,
+                buffer_reserved_stalls, crossbar_conflict_stalls,
+                output_blocked_stalls, la_buffer_busy, la_buffer_conflict,
+                la_buffer_full, la_buffer_reserved, la_crossbar_conflict,
+                la_sa_winners_killed, la_output_blocked };
+            CounterBlock _flows;
+            CounterBlock _stalls;
             ///////////////////////////////////
 
             virtual void _InternalStep() = 0;
 
+            // Whether the router may leave the wake list (see TimedModule)
+            bool _CanSleep() const;
+
+        public:
+            // An input VC whose front flit cannot advance: every output VC
+            // it may take is held by another packet or has no room for it
+            struct VCWait {
+                int input;
+                int vc;
+                int state; // VC::eVCState
+                Flit const * flit;
+                vector<pair<int, int> > targets; // (output, output VC)
+                // VC of the same input that keeps winning the input arbiter
+                // over it, -1 if it waits for targets
+                int input_vc;
+            };
+
+        protected:
+            // Appends the blocked VCs of buf to waits. With lookahead_route
+            // the head flits take their route from the lookahead (bypass
+            // routers), otherwise from the VC once it reached VC allocation.
+            void _CollectVCWaits( vector<Buffer *> const & buf,
+                    vector<BufferState *> const & next_buf,
+                    bool lookahead_route, vector<VCWait> & waits ) const;
+            // Whether the head flit f that goes from input to output fits in
+            // the output VC vc of dest_buf
+            virtual bool _HeadFits( BufferState const * dest_buf, int vc,
+                    Flit const * f, int input, int output ) const;
+            // Routers whose input arbiters always serve the body flits first:
+            // appends the head flits that can only advance once a blocked
+            // body flit of their input (in waits from first on) does
+            void _CollectInputArbiterWaits( vector<Buffer *> const & buf,
+                    size_t first, vector<VCWait> & waits ) const;
+
         public:
             Router( const Configuration& config,
                     Module *parent, const string & name, int id,
@@ -147,6 +171,16 @@ namespace Booksim
             virtual void Evaluate( );
             virtual void WriteOutputs( ) = 0;
 
+            // Whether the router only touches its own state and its channels
+            // while it is clocked, so it can be clocked by any thread when
+            // sim_threads > 1
+            virtual bool ParallelSafe( ) const { return false; }
+
+            // Blocked input VCs, used by the deadlock monitor. The VCs of
+            // the routers that do not report them are never considered
+            // deadlocked.
+            virtual void DeadlockWaits( vector<VCWait> & waits ) const { }
+
             // Why are these 2 methods in this class
             void OutChannelFault( int c, bool fault = true );
             bool IsFaultyOutput( int c ) const;
@@ -170,130 +204,129 @@ namespace Booksim
             virtual int GetBufferOccupancyForClass(int input, int cl) const = 0;
 #endif
 
-#ifdef TRACK_FLOWS
             inline int const & GetInputsNumber() const {
                 return _inputs;
             }
 
-            inline vector<int> const & GetReceivedFlits(int c) const {
+            inline bool TracksFlows() const { return _flows.Enabled(); }
+            inline bool TracksStalls() const { return _stalls.Enabled(); }
+
+            inline vector<int> GetReceivedFlits(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _received_flits[c];
+                return _flows.Row(received_flits, c);
             }
-            inline vector<int> const & GetStoredFlits(int c) const {
+            inline vector<int> GetStoredFlits(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _stored_flits[c];
+                return _flows.Row(stored_flits, c);
             }
-            inline vector<int> const & GetSentFlits(int c) const {
+            inline vector<int> GetSentFlits(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _sent_flits[c];
+                return _flows.Row(sent_flits, c);
             }
-            inline vector<int> const & GetOutstandingCredits(int c) const {
+            inline vector<int> GetOutstandingCredits(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _outstanding_credits[c];
+                return _flows.Row(outstanding_credits, c);
             }
 
-            inline vector<int> const & GetActivePackets(int c) const {
+            inline vector<int> GetActivePackets(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _active_packets[c];
+                return _flows.Row(active_packets, c);
             }
             
             // FIXME: Used by SMART routers only so put in SMARTRouter. Check in
             // trafficmanager if the the router selected is a SMART Router.
-            inline int const & GetSwitchAllocationLocalAllocations() const {
-                return _sal_allocations;
+            inline int GetSwitchAllocationLocalAllocations() const {
+                return _flows.Get(sal_allocations, 0);
             }
             
-            inline int const & GetSwitchAllocationGlobalAllocations() const {
-                return _sag_allocations;
+            inline int GetSwitchAllocationGlobalAllocations() const {
+                return _flows.Get(sag_allocations, 0);
             }
 
             inline void ResetFlowStats(int c) {
                 assert((c >= 0) && (c < _classes));
-                _received_flits[c].assign(_received_flits[c].size(), 0);
-                _stored_flits[c].assign(_stored_flits[c].size(),0);
-                _sent_flits[c].assign(_sent_flits[c].size(), 0);
+                _flows.ClearRow(received_flits, c);
+                _flows.ClearRow(stored_flits, c);
+                _flows.ClearRow(sent_flits, c);
             }
-#endif
 
             virtual vector<int> UsedCredits() const = 0;
             virtual vector<int> FreeCredits() const = 0;
             virtual vector<int> MaxCredits() const = 0;
 
-#ifdef TRACK_STALLS
             inline int GetSwitchArbiterInputStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _switch_arbiter_input_stalls[c];
+                return _stalls.Get(switch_arbiter_input_stalls, c);
             }
             inline int GetBufferBusyStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _buffer_busy_stalls[c];
+                return _stalls.Get(buffer_busy_stalls, c);
             }
             inline int GetBufferConflictStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _buffer_conflict_stalls[c];
+                return _stalls.Get(buffer_conflict_stalls, c);
             }
             inline int GetBufferFullStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _buffer_full_stalls[c];
+                return _stalls.Get(buffer_full_stalls, c);
             }
             inline int GetBufferReservedStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _buffer_reserved_stalls[c];
+                return _stalls.Get(buffer_reserved_stalls, c);
             }
             inline int GetCrossbarConflictStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _crossbar_conflict_stalls[c];
+                return _stalls.Get(crossbar_conflict_stalls, c);
             }
             inline int GetOutputBlockedStalls(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _output_blocked_stalls[c];
+                return _stalls.Get(output_blocked_stalls, c);
             }
             
             inline int GetLABufferBusy(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_buffer_busy[c];
+                return _stalls.Get(la_buffer_busy, c);
             }
             inline int GetLABufferConflict(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_buffer_conflict[c];
+                return _stalls.Get(la_buffer_conflict, c);
             }
             inline int GetLABufferFull(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_buffer_full[c];
+                return _stalls.Get(la_buffer_full, c);
             }
             inline int GetLABufferReserved(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_buffer_reserved[c];
+                return _stalls.Get(la_buffer_reserved, c);
             }
             inline int GetLACrossbarConflict(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_crossbar_conflict[c];
+                return _stalls.Get(la_crossbar_conflict, c);
             }
             inline int GetLASAWinnersKilled(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_sa_winners_killed[c];
+                return _stalls.Get(la_sa_winners_killed, c);
             }
             inline int GetLAOutputBlocked(int c) const {
                 assert((c >= 0) && (c < _classes));
-                return _la_output_blocked[c];
+                return _stalls.Get(la_output_blocked, c);
             }
 
             inline void ResetStallStats(int c) {
                 assert((c >= 0) && (c < _classes));
-                _buffer_busy_stalls[c] = 0;
-                _buffer_conflict_stalls[c] = 0;
-                _buffer_full_stalls[c] = 0;
-                _buffer_reserved_stalls[c] = 0;
-                _crossbar_conflict_stalls[c] = 0;
-
-                _la_buffer_busy[c] = 0;
-                _la_buffer_conflict[c] = 0;
-                _la_buffer_full[c] = 0;
-                _la_buffer_reserved[c] = 0;
-                _la_crossbar_conflict[c] = 0;
-                _la_sa_winners_killed[c] = 0;
+                _stalls.ClearRow(buffer_busy_stalls, c);
+                _stalls.ClearRow(buffer_conflict_stalls, c);
+                _stalls.ClearRow(buffer_full_stalls, c);
+                _stalls.ClearRow(buffer_reserved_stalls, c);
+                _stalls.ClearRow(crossbar_conflict_stalls, c);
+
+                _stalls.ClearRow(la_buffer_busy, c);
+                _stalls.ClearRow(la_buffer_conflict, c);
+                _stalls.ClearRow(la_buffer_full, c);
+                _stalls.ClearRow(la_buffer_reserved, c);
+                _stalls.ClearRow(la_crossbar_conflict, c);
+                _stalls.ClearRow(la_sa_winners_killed, c);
             }
-#endif
 
             inline int NumInputs() const {return _inputs;}
             inline int NumOutputs() const {return _outputs;}
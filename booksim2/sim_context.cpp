@@ -0,0 +1,66 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*sim_context.cpp
+ *
+ *Per-simulation state
+ */
+
+#include "booksim.hpp"
+#include "sim_context.hpp"
+#include "flit.hpp"
+#include "lookahead.hpp"
+#include "credit.hpp"
+
+namespace Booksim
+{
+
+    thread_local SimContext * gSim = NULL;
+
+    SimContext::SimContext( )
+      : traffic_manager(NULL), print_activity(false), k(0), n(0),
+        // XXX: By default 1 instead of 0. It is relevant in lookahead bypass
+        // router models to avoid mem leaks.
+        c(1), nodes(0), trace(false), watch_out(NULL), ni(NULL),
+        num_vcs(0), num_classes(0), anynet(NULL)
+    {
+      dragonfly.p = dragonfly.a = dragonfly.g = 0;
+      flatfly.xcount = flatfly.ycount = flatfly.xrouter = flatfly.yrouter = 0;
+      cmesh.cx = cmesh.cy = 0;
+      cmesh.node_shift_x = cmesh.node_shift_y = cmesh.port_shift_y = 0;
+      flit_pool = new FlitPool<Flit>;
+      lookahead_pool = new FlitPool<Lookahead>;
+      credit_pool = new CreditPool;
+    }
+
+    SimContext::~SimContext( )
+    {
+      delete lookahead_pool;
+      delete flit_pool;
+      delete credit_pool;
+    }
+} // namespace Booksim
@@ -0,0 +1,112 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*sim_context.hpp
+ *
+ *State of one simulation that used to live in globals (main.cpp,
+ *routefunc.cpp, the topologies with static routing functions, and the
+ *flit and credit pools).
+ *
+ *gSim points to the context of the simulation run by the calling thread,
+ *so several simulations can share a process as long as each one runs on
+ *its own thread (see the sweep mode in main.cpp). The old names (gK,
+ *gNumVCs, ...) are kept as macros over the current context. ThreadPool
+ *workers inherit the context of the thread that runs the phase.
+ */
+
+#ifndef _SIM_CONTEXT_HPP_
+#define _SIM_CONTEXT_HPP_
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    class TrafficManager;
+    class NetworkInterface;
+    class Router;
+    class Flit;
+    class Lookahead;
+    class OutputSet;
+    class CreditPool;
+    class AnyNet;
+    template<class T> class FlitPool;
+
+    typedef void (*tRoutingFunction)( const Router *, const Flit *, int in_channel, OutputSet *, bool );
+
+    class SimContext {
+
+    public:
+      SimContext( );
+      ~SimContext( );
+
+      // main.cpp
+      TrafficManager * traffic_manager;
+      bool print_activity;
+      int k;
+      int n;
+      int c;
+      vector<int> k_vector;
+      vector<int> c_vector;
+      int nodes;
+      bool trace;
+      ostream * watch_out;
+      NetworkInterface * ni;
+
+      // routefunc.cpp
+      map<string, tRoutingFunction> routing_function_map;
+      int num_vcs;
+      int num_classes;
+      vector<int> begin_vcs;
+      vector<int> end_vcs;
+
+      // Topology parameters read by the static routing functions
+      struct { int p, a, g; } dragonfly;
+      struct { int xcount, ycount, xrouter, yrouter; } flatfly;
+      // Shared by CMesh and CKMesh
+      struct { int cx, cy, node_shift_x, node_shift_y, port_shift_y; } cmesh;
+      // Network whose tables min_anynet reads
+      AnyNet const * anynet;
+
+      FlitPool<Flit> * flit_pool;
+      FlitPool<Lookahead> * lookahead_pool;
+      CreditPool * credit_pool;
+
+    private:
+      SimContext( SimContext const & );
+      SimContext & operator=( SimContext const & );
+    };
+
+    extern thread_local SimContext * gSim;
+} // namespace Booksim
+
+#endif
@@ -0,0 +1,124 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*slot_array.hpp
+ *
+ *Fixed set of slots indexed by port or node, with an occupancy bitmap.
+ *
+ *Replaces the map<int, T> that collected the flits or credits of one cycle:
+ *storage is allocated once by Resize(), inserting and clearing only touch
+ *the slots and the bitmap, and Next() visits the occupied slots in
+ *increasing index order, as iterating over the map did.
+ *
+ *  for(int i = slots.Next(0); i >= 0; i = slots.Next(i + 1)) { ... }
+ */
+
+#ifndef _SLOT_ARRAY_HPP_
+#define _SLOT_ARRAY_HPP_
+
+#include <cassert>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    template<class T>
+    class SlotArray {
+
+    public:
+      SlotArray( ) : _count(0) {}
+
+      void Resize( int slots ) {
+        assert(_count == 0);
+        _slots.resize(slots);
+        _occupied.assign((slots + _word_bits - 1) / _word_bits, 0);
+      }
+      inline int Size( ) const { return (int)_slots.size(); }
+
+      inline bool Empty( ) const { return _count == 0; }
+      inline int Count( ) const { return _count; }
+
+      inline bool Occupied( int i ) const {
+        assert((i >= 0) && (i < Size()));
+        return (_occupied[i / _word_bits] >> (i % _word_bits)) & 1;
+      }
+
+      inline T const & Get( int i ) const {
+        assert(Occupied(i));
+        return _slots[i];
+      }
+      inline T & Get( int i ) {
+        assert(Occupied(i));
+        return _slots[i];
+      }
+
+      inline void Insert( int i, T const & value ) {
+        assert(!Occupied(i));
+        _slots[i] = value;
+        _occupied[i / _word_bits] |= (word_t)1 << (i % _word_bits);
+        ++_count;
+      }
+
+      // First occupied slot with index i or higher, -1 if there is none
+      inline int Next( int i ) const {
+        int w = i / _word_bits;
+        if(w >= (int)_occupied.size()) {
+          return -1;
+        }
+        word_t bits = _occupied[w] & (~(word_t)0 << (i % _word_bits));
+        while(!bits) {
+          if(++w == (int)_occupied.size()) {
+            return -1;
+          }
+          bits = _occupied[w];
+        }
+        return w * _word_bits + __builtin_ctzll(bits);
+      }
+
+      // Empties all the slots; the stored values are not destroyed
+      inline void Clear( ) {
+        if(_count) {
+          for(size_t w = 0; w < _occupied.size(); ++w) {
+            _occupied[w] = 0;
+          }
+          _count = 0;
+        }
+      }
+
+    private:
+      typedef unsigned long long word_t;
+      static const int _word_bits = 64;
+
+      vector<T> _slots;
+      vector<word_t> _occupied;
+      int _count;
+    };
+} // namespace Booksim
+
+#endif
@@ -40,6 +40,7 @@
 #include <limits>
 #include <cmath>
 #include <cstdio>
+#include <cassert>
 
 #include "stats.hpp"
 
@@ -48,18 +49,34 @@ namespace Booksim
 
     Stats::Stats( Module *parent, const string &name,
               double bin_size, int num_bins ) :
-      Module( parent, name ), _num_bins( num_bins ), _bin_size( bin_size )
+      Module( parent, name ), _type( Linear ), _num_bins( num_bins ),
+      _bin_size( bin_size ), _precision( 0 )
     {
       Clear();
     }
 
+    Stats::Stats( Module *parent, const string &name,
+              HistogramType type, int precision ) :
+      Module( parent, name ), _type( type ), _num_bins( 0 ), _bin_size( 1.0 ),
+      _precision( precision )
+    {
+      assert(type == LogLinear);
+      assert((precision >= 0) && (precision < 16));
+      Clear();
+    }
+
     void Stats::Clear( )
     {
       _num_samples = 0;
       _sample_sum  = 0.0;
       _sample_squared_sum = 0.0;
 
-      _hist.assign(_num_bins, 0);
+      if(_type == Linear) {
+        _hist.assign(_num_bins, 0);
+      } else {
+        // Keep the storage, it is likely to be needed again
+        _hist.clear();
+      }
 
       _min = numeric_limits<long double>::quiet_NaN();
       _max = -numeric_limits<long double>::quiet_NaN();
@@ -111,18 +128,128 @@ namespace Booksim
       _max = !(val <= _max) ? val : _max;
       _min = !(val >= _min) ? val : _min;
 
-      //double clamp between 0 and num_bins-1
-      int b = (int)fmax(floor( val / _bin_size ), 0.0);
-      b = (b >= _num_bins) ? (_num_bins - 1) : b;
-
+      int const b = _Bin( val );
+      if(b >= (int)_hist.size()) {
+        _hist.resize(b + 1, 0);
+      }
       _hist[b]++;
     }
 
+    int Stats::_Bin( long double val ) const
+    {
+      if(_type == Linear) {
+        //double clamp between 0 and num_bins-1
+        int b = (int)fmax(floor( val / _bin_size ), 0.0);
+        return (b >= _num_bins) ? (_num_bins - 1) : b;
+      }
+      // NOTE: also sends NaN values to bin 0
+      if(!(val >= 1.0)) {
+        return 0;
+      }
+      unsigned long long const top = 1ULL << 40;
+      unsigned long long const v = (val >= top) ? (top - 1) : (unsigned long long)val;
+      unsigned long long const sub = 1ULL << _precision;
+      if(v < sub) {
+        return (int)v;
+      }
+      int const shift = 63 - __builtin_clzll(v) - _precision;
+      return (int)((shift + 1) * sub + ((v >> shift) - sub));
+    }
+
+    double Stats::_BinTop( int b ) const
+    {
+      if(_type == Linear) {
+        return (b + 1) * _bin_size;
+      }
+      int const sub = 1 << _precision;
+      if(b < sub) {
+        return b;
+      }
+      int const shift = b / sub - 1;
+      unsigned long long const low = (unsigned long long)(sub + b % sub) << shift;
+      return (double)(low + (1ULL << shift) - 1);
+    }
+
+    double Stats::Percentile( double p ) const
+    {
+      if(_num_samples == 0) {
+        return numeric_limits<double>::quiet_NaN();
+      }
+      // Rank of the sample, starting at 1
+      double const rank = fmax(ceil(p / 100.0 * _num_samples), 1.0);
+      double seen = 0.0;
+      for(size_t b = 0; b < _hist.size(); ++b) {
+        seen += _hist[b];
+        if(seen >= rank) {
+          // The last linear bin also holds the values above the range
+          if((_type == Linear) && ((int)b == _num_bins - 1)) {
+            return _max;
+          }
+          return fmin(fmax(_BinTop(b), (double)_min), (double)_max);
+        }
+      }
+      return _max;
+    }
+
+    void Stats::Merge( Stats const & s )
+    {
+      assert((_type == s._type) && (_num_bins == s._num_bins) &&
+             (_bin_size == s._bin_size) && (_precision == s._precision));
+      if(s._num_samples == 0) {
+        return;
+      }
+      _num_samples += s._num_samples;
+      _sample_sum += s._sample_sum;
+      _sample_squared_sum += s._sample_squared_sum;
+      _max = !(s._max <= _max) ? s._max : _max;
+      _min = !(s._min >= _min) ? s._min : _min;
+      if(s._hist.size() > _hist.size()) {
+        _hist.resize(s._hist.size(), 0);
+      }
+      for(size_t b = 0; b < s._hist.size(); ++b) {
+        _hist[b] += s._hist[b];
+      }
+    }
+
     void Stats::Display( ostream & os ) const
     {
       os << *this << endl;
     }
 
+    template<class T>
+    static void WriteRaw( ostream & os, T val )
+    {
+      os.write(reinterpret_cast<char const *>(&val), sizeof(T));
+    }
+
+    void Stats::WriteBinary( ostream & os ) const
+    {
+      os.write("BSH1", 4);
+      string const & name = FullName();
+      WriteRaw<unsigned int>(os, name.size());
+      os.write(name.data(), name.size());
+      WriteRaw<unsigned char>(os, _type);
+      WriteRaw<unsigned char>(os, _precision);
+      WriteRaw<double>(os, _bin_size);
+      WriteRaw<int>(os, _num_bins);
+      WriteRaw<long long>(os, _num_samples);
+      WriteRaw<double>(os, _sample_sum);
+      WriteRaw<double>(os, _sample_squared_sum);
+      WriteRaw<double>(os, _min);
+      WriteRaw<double>(os, _max);
+      unsigned int used = 0;
+      for(size_t b = 0; b < _hist.size(); ++b) {
+        used += (_hist[b] != 0);
+      }
+      WriteRaw<unsigned int>(os, used);
+      for(size_t b = 0; b < _hist.size(); ++b) {
+        if(_hist[b]) {
+          WriteRaw<unsigned int>(os, b);
+          WriteRaw<unsigned int>(os, _hist[b]);
+        }
+      }
+    }
+
     ostream & operator<<(ostream & os, const Stats & s) {
       vector<int> const & v = s._hist;
       os << "\"[";
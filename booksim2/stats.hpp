@@ -35,6 +35,16 @@ namespace Booksim
 {
 
     class Stats : public Module {
+    public:
+      // Linear: _num_bins bins of _bin_size, the last one also counts the
+      // values above the range.
+      // LogLinear (HDR style): values below 2^precision get a bin each, and
+      // every power of two above is split in 2^precision bins, so the width
+      // of a bin is at most 1/2^precision of its values. Bins are allocated
+      // up to the largest value seen, so an unused histogram takes no space.
+      enum HistogramType { Linear, LogLinear };
+
+    private:
       int    _num_samples;
       double _sample_sum;
       double _sample_squared_sum;
@@ -43,14 +53,22 @@ namespace Booksim
       long double _min;
       long double _max;
 
+      HistogramType _type;
       int    _num_bins;
       double _bin_size;
+      int    _precision;
 
       vector<int> _hist;
 
+      int _Bin( long double val ) const;
+      // Largest value counted in bin b
+      double _BinTop( int b ) const;
+
     public:
       Stats( Module *parent, const string &name,
          double bin_size = 1.0, int num_bins = 10 );
+      Stats( Module *parent, const string &name,
+         HistogramType type, int precision );
 
       void Clear( );
 
@@ -62,6 +80,18 @@ namespace Booksim
       double SquaredSum( ) const;
       int    NumSamples( ) const;
 
+      // Smallest value that is not exceeded by p percent of the samples,
+      // rounded up to the top of its bin
+      double Percentile( double p ) const;
+      inline double P50( ) const { return Percentile( 50.0 ); }
+      inline double P99( ) const { return Percentile( 99.0 ); }
+      inline double P999( ) const { return Percentile( 99.9 ); }
+
+      inline HistogramType Type( ) const { return _type; }
+
+      // Adds the samples of s, which must have the same histogram layout
+      void Merge( Stats const & s );
+
       //BSMOD: Change time to long long
       void AddSample( long double val );
       inline void AddSample( int val ) {
@@ -74,10 +104,17 @@ namespace Booksim
         AddSample( (long double)val );
       }
 
-      int GetBin(int b){ return _hist[b];}
+      int GetBin(int b){ return (b < (int)_hist.size()) ? _hist[b] : 0;}
 
       void Display( ostream & os = cout ) const;
 
+      // Compact binary dump, see scripts/util/histogram_dump.py:
+      //   "BSH1", u32 name length, name, u8 type, u8 precision,
+      //   f64 bin size, i32 bins, i64 samples, f64 sum, f64 squared sum,
+      //   f64 min, f64 max, u32 non-empty bins, then (u32 bin, u32 count)
+      //   for each of them. Numbers use the byte order of the host.
+      void WriteBinary( ostream & os ) const;
+
       friend ostream & operator<<(ostream & os, const Stats & s);
 
     };
@@ -25,10 +25,12 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cassert>
 #include <cmath>
 #include <sstream>
 
 #include "steadystatetrafficmanager.hpp"
+#include "random_utils.hpp"
 
 namespace Booksim
 {
@@ -56,6 +58,15 @@ namespace Booksim
         _injection_process[c] = InjectionProcess::New(_injection[c], _nodes, _load[c], &config);
       }
 
+      _skip_ahead = (config.GetInt("injection_skip_ahead") > 0);
+      _skip_ahead_class.resize(_classes, false);
+      if(_skip_ahead) {
+        for(int c = 0; c < _classes; ++c) {
+          _skip_ahead_class[c] = ((_request_class[c] < 0) &&
+                                  _injection_process[c]->skip_ahead());
+        }
+      }
+
       _measure_latency = (config.GetStr("sim_type") == "latency");
 
       _sample_period = config.GetInt( "sample_period" );
@@ -91,6 +102,58 @@ namespace Booksim
         _acc_stopping_threshold.push_back(config.GetFloat("acc_stopping_thres"));
       }
       _acc_stopping_threshold.resize(_classes, _acc_stopping_threshold.back());
+
+      _saturation_detect = (config.GetInt("saturation_detect") > 0);
+      _saturation_periods = config.GetInt("saturation_periods");
+      if(_saturation_detect && (_saturation_periods < 2)) {
+        cout << "Error: saturation_periods must be at least 2." << endl;
+        exit(-1);
+      }
+      _saturation_margin = config.GetFloat("saturation_margin");
+      _saturated.resize(_classes, 0);
+      _offered_history.resize(_classes);
+      _growth_history.resize(_classes);
+      _last_offered.resize(_classes, 0);
+      _last_backlog.resize(_classes, 0);
+
+      _warmup_forks = config.GetInt("warmup_forks");
+      vector<double> const fork_rates = config.GetFloatArray("warmup_fork_rates");
+      if(!fork_rates.empty()) {
+        _warmup_forks = (int)fork_rates.size();
+      }
+      if(_warmup_forks > 1) {
+        if(config.GetInt("sim_threads") > 1) {
+          cout << "Error: warmup_forks cannot be combined with sim_threads." << endl;
+          exit(-1);
+        }
+        if(config.GetStr("sweep_param") != "") {
+          cout << "Error: warmup_forks is not supported in sweep mode." << endl;
+          exit(-1);
+        }
+        string const stats_out = config.GetStr("stats_out");
+        string const watch_out = config.GetStr("watch_out");
+        if(((stats_out != "") && (stats_out != "-")) ||
+           ((watch_out != "") && (watch_out != "-")) ||
+           (config.GetStr("histogram_out") != "")) {
+          cout << "Error: warmup_forks requires stats_out and watch_out to be "
+               << "empty or \"-\", and histogram_out to be empty." << endl;
+          exit(-1);
+        }
+      }
+      _forked = false;
+      _fork_load.resize(fork_rates.size());
+      _fork_injection_process.resize(fork_rates.size());
+      for(size_t f = 0; f < fork_rates.size(); ++f) {
+        _fork_load[f].resize(_classes);
+        _fork_injection_process[f].resize(_classes);
+        for(int c = 0; c < _classes; ++c) {
+          _fork_load[f][c] = fork_rates[f];
+          if(config.GetInt("injection_rate_uses_flits")) {
+            _fork_load[f][c] /= _GetAveragePacketSize(c);
+          }
+          _fork_injection_process[f][c] = InjectionProcess::New(_injection[c], _nodes, _fork_load[f][c], &config);
+        }
+      }
     }
 
     SteadyStateTrafficManager::~SteadyStateTrafficManager( )
@@ -98,21 +161,74 @@ namespace Booksim
       for ( int c = 0; c < _classes; ++c ) {
         delete _injection_process[c];
       }
+      for ( size_t f = 0; f < _fork_injection_process.size(); ++f ) {
+        for ( int c = 0; c < _classes; ++c ) {
+          delete _fork_injection_process[f][c];
+        }
+      }
     }
 
     int SteadyStateTrafficManager::_IssuePacket( int source, int cl )
     {
       if(_injection_process[cl]->test(source)) {
-        int dest = _traffic_pattern[cl]->dest(source);
-        int size = _GetNextPacketSize(cl);
-        // FIXME: I don't exactly know the cause of why I have to decrease by 1
-        //  the latency of qtime to obtain correct results
-        long time = ((_include_queuing == 1) ? _qtime[cl][source]-1 : _time);
-        return _GeneratePacket(source, dest, size, cl, time);
+        return _InjectPacket(source, cl);
       }
       return -1;
     }
 
+    int SteadyStateTrafficManager::_InjectPacket( int source, int cl )
+    {
+      int dest = _traffic_pattern[cl]->dest(source);
+      int size = _GetNextPacketSize(cl);
+      // FIXME: I don't exactly know the cause of why I have to decrease by 1
+      //  the latency of qtime to obtain correct results
+      long time = ((_include_queuing == 1) ? _qtime[cl][source]-1 : _time);
+      return _GeneratePacket(source, dest, size, cl, time);
+    }
+
+    void SteadyStateTrafficManager::_ScheduleInjection( int source, int cl, long long time )
+    {
+      long const next = _injection_process[cl]->next(source, (long)time);
+      if(next >= 0) {
+        _injection_events.push(make_pair((long long)next, make_pair(cl, source)));
+      }
+    }
+
+    void SteadyStateTrafficManager::_Inject( )
+    {
+      if(!_skip_ahead) {
+        SyntheticTrafficManager::_Inject();
+        return;
+      }
+
+      // Heap order matches the (class, source) order of the polling loop,
+      // so packet ids are handed out in the same order within a cycle.
+      for(int c = 0; c < _classes; ++c) {
+        if(!_skip_ahead_class[c]) {
+          for(int source = 0; source < _nodes; ++source) {
+            _PollInjection(source, c);
+          }
+          continue;
+        }
+        while(!_injection_events.empty() &&
+              (_injection_events.top().first <= _time) &&
+              (_injection_events.top().second.first == c)) {
+          int const source = _injection_events.top().second.second;
+          _injection_events.pop();
+          _qtime[c][source] = _time + 1;
+          if(_InjectPacket(source, c) >= 0) {
+            _requests_outstanding[c][source]++;
+            _packet_seq_no[c][source]++;
+          }
+          _ScheduleInjection(source, c, _time + 1);
+        }
+        // Every source of the class has been sampled up to this cycle
+        if(_sim_state == draining) {
+          _qdrained[c].assign(_nodes, true);
+        }
+      }
+    }
+
     void SteadyStateTrafficManager::_ResetSim( )
     {
       SyntheticTrafficManager::_ResetSim();
@@ -120,6 +236,122 @@ namespace Booksim
       for(int c = 0; c < _classes; ++c) {
         _injection_process[c]->reset();
       }
+
+      _saturated.assign(_classes, 0);
+      for(int c = 0; c < _classes; ++c) {
+        _offered_history[c].clear();
+        _growth_history[c].clear();
+      }
+      _last_offered.assign(_classes, 0);
+      _last_backlog.assign(_classes, 0);
+
+      _RescheduleInjections();
+    }
+
+    void SteadyStateTrafficManager::_RescheduleInjections( )
+    {
+      _injection_events = priority_queue<InjectionEvent, vector<InjectionEvent>, greater<InjectionEvent> >();
+      for(int c = 0; c < _classes; ++c) {
+        if(_skip_ahead_class[c]) {
+          _qtime[c].assign(_nodes, _time);
+          for(int source = 0; source < _nodes; ++source) {
+            _ScheduleInjection(source, c, _time);
+          }
+        }
+      }
+    }
+
+    void SteadyStateTrafficManager::_StartWarmupForks( )
+    {
+      _forked = true;
+      int const f = _ForkMeasurements(_warmup_forks);
+      if(f > 0) {
+        // Every fork draws the same value here, so offset it by the index
+        RandomSeed((long)(RandomIntLong() + f));
+      }
+      bool rewarm = false;
+      if(!_fork_load.empty()) {
+        for(int c = 0; c < _classes; ++c) {
+          rewarm |= (_fork_load[f][c] != _load[c]);
+          _load[c] = _fork_load[f][c];
+          delete _injection_process[c];
+          _injection_process[c] = _fork_injection_process[f][c];
+          _fork_injection_process[f][c] = NULL;
+        }
+        if(_skip_ahead) {
+          _RescheduleInjections();
+        }
+      }
+      cout << "Warm-up fork " << f << " of " << _warmup_forks;
+      if(rewarm) {
+        // Start from the shared network state but converge again at the new load
+        cout << ", warming up again at injection rate " << _load[0];
+        _sim_state = warming_up;
+      }
+      cout << endl;
+    }
+
+    // One-sided 99.9% critical values of Student's t distribution
+    static double TCritical(int dof)
+    {
+      static double const table[] = {
+        318.31, 22.327, 10.215, 7.173, 5.893, 5.208, 4.785, 4.501, 4.297, 4.144,
+        4.025, 3.930, 3.852, 3.787, 3.733, 3.686, 3.646, 3.610, 3.579, 3.552,
+        3.527, 3.505, 3.485, 3.467, 3.450, 3.435, 3.421, 3.408, 3.396, 3.385
+      };
+      assert(dof > 0);
+      return (dof <= 30) ? table[dof - 1] : 3.090;
+    }
+
+    int SteadyStateTrafficManager::_DetectSaturation( )
+    {
+      // A class is saturated when, over the last _saturation_periods sample
+      // periods, its backlog grew in a statistically significant way (t-test
+      // on the per-period growth) and the network accepted less than
+      // (1 - _saturation_margin) of the offered flits.
+      int saturated_class = -1;
+      for(int c = 0; c < _classes; ++c) {
+        long long const backlog = _total_in_flight_flits[c].Size() + _refused_flits[c];
+        _offered_history[c].push_back((double)(_offered_flits[c] - _last_offered[c]));
+        _growth_history[c].push_back((double)(backlog - _last_backlog[c]));
+        _last_offered[c] = _offered_flits[c];
+        _last_backlog[c] = backlog;
+        if((int)_growth_history[c].size() > _saturation_periods) {
+          _offered_history[c].pop_front();
+          _growth_history[c].pop_front();
+        }
+        if(!_measure_stats[c] || (saturated_class >= 0) ||
+           ((int)_growth_history[c].size() < _saturation_periods)) {
+          continue;
+        }
+
+        double offered = 0.0;
+        double growth = 0.0;
+        for(int i = 0; i < _saturation_periods; ++i) {
+          offered += _offered_history[c][i];
+          growth += _growth_history[c][i];
+        }
+        if((offered <= 0.0) || (growth <= _saturation_margin * offered)) {
+          continue;
+        }
+        double const mean = growth / (double)_saturation_periods;
+        double var = 0.0;
+        for(int i = 0; i < _saturation_periods; ++i) {
+          double const d = _growth_history[c][i] - mean;
+          var += d * d;
+        }
+        var /= (double)(_saturation_periods - 1);
+        double const t = mean / sqrt(var / (double)_saturation_periods);
+        if((var == 0.0) || (t > TCritical(_saturation_periods - 1))) {
+          cout << "Class " << c << " saturated: accepted "
+               << (offered - growth) / offered * 100.0
+               << "% of the offered flits over the last " << _saturation_periods
+               << " sample periods (backlog growth t = " << t << ")." << endl;
+          _saturated[c] = 1;
+          saturated_class = c;
+        }
+      }
+      return saturated_class;
     }
 
     bool SteadyStateTrafficManager::_SingleSim( )
@@ -184,7 +416,7 @@ namespace Booksim
           double count = (double)_plat_stats[c]->NumSamples();
           
           //BSMOD: Change flit and packet id to long
-          map<long, Flit *>::const_iterator iter;
+          IdMap<Flit>::const_iterator iter;
           for(iter = _total_in_flight_flits[c].begin(); 
           iter != _total_in_flight_flits[c].end(); 
           iter++) {
@@ -230,12 +462,21 @@ namespace Booksim
         if ( _measure_latency && ( lat_exc_class >= 0 ) ) {
           
           cout << "Average latency for class " << lat_exc_class << " exceeded " << _latency_thres[lat_exc_class] << " cycles. Aborting simulation." << endl;
+          _saturated[lat_exc_class] = 1;
           converged = 0; 
           _sim_state  = draining;
           _drain_time = _time;
           break;
           
         }
+
+        if ( _measure_latency && _saturation_detect && ( _DetectSaturation( ) >= 0 ) ) {
+          cout << "Aborting simulation." << endl;
+          converged = 0;
+          _sim_state  = draining;
+          _drain_time = _time;
+          break;
+        }
         
         if ( _sim_state == warming_up ) {
           if ( ( _warmup_periods > 0 ) ? 
@@ -245,6 +486,9 @@ namespace Booksim
         cout << "Warmed up ..." <<  "Time used is " << _time << " cycles" <<endl;
         clear_last = true;
         _sim_state = running;
+        if ( ( _warmup_forks > 1 ) && !_forked ) {
+          _StartWarmupForks( );
+        }
           }
         } else if(_sim_state == running) {
           if ( ( !_measure_latency || ( lat_chg_exc_class < 0 ) ) &&
@@ -287,7 +531,7 @@ namespace Booksim
             double acc_count = (double)_plat_stats[c]->NumSamples();
             
             //BSMOD: Change flit and packet id to long
-            map<long, Flit *>::const_iterator iter;
+            IdMap<Flit>::const_iterator iter;
             for(iter = _total_in_flight_flits[c].begin(); 
             iter != _total_in_flight_flits[c].end(); 
             iter++) {
@@ -324,7 +568,8 @@ namespace Booksim
     {
       ostringstream os;
       os << "load"
-         << ',' << SyntheticTrafficManager::_OverallStatsHeaderCSV();
+         << ',' << SyntheticTrafficManager::_OverallStatsHeaderCSV()
+         << ',' << "saturated";
       return os.str();
     }
 
@@ -332,7 +577,8 @@ namespace Booksim
     {
       ostringstream os;
       os << _load[c]
-         << ',' << SyntheticTrafficManager::_OverallClassStatsCSV(c);
+         << ',' << SyntheticTrafficManager::_OverallClassStatsCSV(c)
+         << ',' << _saturated[c];
       return os.str();
     }
 } // namespace Booksim
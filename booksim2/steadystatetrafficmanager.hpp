@@ -29,6 +29,8 @@
 #define _STEADYSTATETRAFFICMANAGER_HPP_
 
 #include <vector>
+#include <queue>
+#include <deque>
 
 #include "synthetictrafficmanager.hpp"
 #include "injection.hpp"
@@ -45,6 +47,18 @@ namespace Booksim
       vector<string> _injection;
       vector<InjectionProcess *> _injection_process;
 
+      // Skip-ahead injection: classes whose process supports it are not
+      // polled every cycle; instead each source sits in a min-heap keyed by
+      // the cycle of its next injection, ordered by (cycle, class, source)
+      // like the polling loop.
+      bool _skip_ahead;
+      vector<bool> _skip_ahead_class;
+      typedef pair<long long, pair<int, int> > InjectionEvent;
+      priority_queue<InjectionEvent, vector<InjectionEvent>, greater<InjectionEvent> > _injection_events;
+
+      void _ScheduleInjection( int source, int cl, long long time );
+      int _InjectPacket( int source, int cl );
+
       bool _measure_latency;
 
       int   _sample_period;
@@ -59,7 +73,32 @@ namespace Booksim
       vector<double> _warmup_threshold;
       vector<double> _acc_warmup_threshold;
 
+      // Saturation detection: per sample period, the flits offered to the
+      // source queues and the growth of the backlog (flits queued or in
+      // flight plus refused flits) over the last _saturation_periods periods
+      bool _saturation_detect;
+      int _saturation_periods;
+      double _saturation_margin;
+      vector<int> _saturated;
+      vector<deque<double> > _offered_history;
+      vector<deque<double> > _growth_history;
+      vector<long long> _last_offered;
+      vector<long long> _last_backlog;
+
+      int _DetectSaturation( );
+
+      // Warm-up forks: measurement runs that share the first warm-up, each
+      // with its own random stream and, optionally, its own offered load
+      int _warmup_forks;
+      bool _forked;
+      vector<vector<double> > _fork_load;
+      vector<vector<InjectionProcess *> > _fork_injection_process;
+
+      void _StartWarmupForks( );
+      void _RescheduleInjections( );
+
       virtual int _IssuePacket( int source, int cl );
+      virtual void _Inject( );
 
       virtual void _ResetSim( );
 
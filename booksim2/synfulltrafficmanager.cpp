@@ -26,6 +26,7 @@
 */
 
 #include <sstream>
+#include <limits>
 
 #include "synfulltrafficmanager.hpp"
 #include "NetworkInterface.h"
@@ -44,6 +45,23 @@ namespace Booksim
       _channel_width = config.GetInt( "channel_width" );
       _max_length = 0;
 
+      // A packet spends at least its injection and ejection channel delays in
+      // the network, so nothing injected during a quantum of at most that
+      // many cycles can eject within it: batched clients never miss an
+      // ejection they could have reacted to.
+      int lookahead = numeric_limits<int>::max();
+      for(int s = 0; s < _subnets; ++s) {
+        for(int n = 0; n < _nodes; ++n) {
+          lookahead = min(lookahead, _net[s]->GetInject(n)->GetLatency() +
+                          _net[s]->GetEject(n)->GetLatency());
+        }
+      }
+      lookahead = max(lookahead, 1);
+      int quantum = config.GetInt( "synfull_quantum" );
+      if(quantum <= 0) {
+        quantum = lookahead;
+      }
+      gNI->SetQuantum(quantum, lookahead);
 
     }
 
@@ -98,7 +116,7 @@ namespace Booksim
       cout << "Beginning measurements..." << endl;
      
 
-      while(ni->Step(&_injection_queue_messages, &_ejection_queue_messages) == 0) {
+      while(gNI->Step(&_injection_queue_messages, &_ejection_queue_messages) == 0) {
        _Step();
         
         if((_time % _sample_period) == 0) {
@@ -216,29 +216,34 @@ namespace Booksim
                 // Hardcoded one queue
                 //if ( _partial_packets[c][source].empty() ) {
                 //if ( _partial_packets[0][source].empty() ) {
-                    if(_request_class[c] >= 0) {
-                        _qtime[c][source] = _time;
-                    } else {
-                        while(_qtime[c][source] <= _time) {
-                            ++_qtime[c][source];
-                            if(_IssuePacket(source, c) >= 0) { //generate a packet
-                                _requests_outstanding[c][source]++;
-                                _packet_seq_no[c][source]++;
-                                //cout << "LINE " << __LINE__ << " Cycle: " << GetSimTime()
-                                //     << " Class: " << c << " Source " << source
-                                //     << " Packet sequence no: " << _packet_seq_no[c][source] << endl;
-                                break;
-                            }
-                        }
-                    }
-                    if((_sim_state == draining) && (_qtime[c][source] > _drain_time)) {
-                        _qdrained[c][source] = true;
-                    }
+                    _PollInjection(source, c);
                 //}
             }
         }
     }
 
+    void SyntheticTrafficManager::_PollInjection( int source, int c )
+    {
+        if(_request_class[c] >= 0) {
+            _qtime[c][source] = _time;
+        } else {
+            while(_qtime[c][source] <= _time) {
+                ++_qtime[c][source];
+                if(_IssuePacket(source, c) >= 0) { //generate a packet
+                    _requests_outstanding[c][source]++;
+                    _packet_seq_no[c][source]++;
+                    //cout << "LINE " << __LINE__ << " Cycle: " << GetSimTime()
+                    //     << " Class: " << c << " Source " << source
+                    //     << " Packet sequence no: " << _packet_seq_no[c][source] << endl;
+                    break;
+                }
+            }
+        }
+        if((_sim_state == draining) && (_qtime[c][source] > _drain_time)) {
+            _qdrained[c][source] = true;
+        }
+    }
+
     bool SyntheticTrafficManager::_PacketsOutstanding( ) const
     {
       if(TrafficManager::_PacketsOutstanding()) {
@@ -246,7 +251,7 @@ namespace Booksim
       }
       for ( int c = 0; c < _classes; ++c ) {
         if ( _measure_stats[c] ) {
-          assert( _measured_in_flight_flits[c].empty() );
+          assert( _measured_in_flight_flits[c].Empty() );
           for ( int s = 0; s < _nodes; ++s ) {
             if ( !_qdrained[c][s] ) {
               return true;
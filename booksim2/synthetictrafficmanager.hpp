@@ -71,6 +71,7 @@ namespace Booksim
       virtual int _IssuePacket( int source, int cl ) = 0;
 
       virtual void _Inject( );
+      void _PollInjection( int source, int cl );
 
       virtual bool _PacketsOutstanding( ) const;
 
@@ -0,0 +1,119 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*thread_pool.cpp
+ *
+ *Barrier-synchronized worker threads used to run the phases of a cycle
+ *in parallel
+ */
+
+#include <cstdlib>
+#include <iostream>
+
+#include "booksim.hpp"
+#include "thread_pool.hpp"
+#include "globals.hpp"
+
+namespace Booksim
+{
+
+    thread_local int ThreadPool::_thread_id = 0;
+    thread_local bool ThreadPool::_in_phase = false;
+
+    // Busy-wait iterations before a waiting thread starts yielding the CPU
+    static int const kSpinLimit = 4096;
+
+    ThreadPool::ThreadPool( int threads )
+      : _threads(threads), _job(NULL), _context(NULL), _generation(0), _pending(0), _stop(false)
+    {
+      for(int t = 1; t < _threads; ++t) {
+        _workers.push_back(thread(&ThreadPool::_Worker, this, t));
+      }
+    }
+
+    ThreadPool::~ThreadPool( )
+    {
+      _stop.store(true);
+      _generation.fetch_add(1, memory_order_release);
+      for(size_t t = 0; t < _workers.size(); ++t) {
+        _workers[t].join();
+      }
+    }
+
+    void ThreadPool::_RunJob( int id )
+    {
+      gSim = _context;
+      _in_phase = true;
+      (*_job)(id);
+      _in_phase = false;
+    }
+
+    void ThreadPool::Run( function<void(int)> const & job )
+    {
+      _job = &job;
+      _context = gSim;
+      _pending.store(_threads - 1, memory_order_relaxed);
+      _generation.fetch_add(1, memory_order_release);
+      _RunJob(0);
+      int spins = 0;
+      while(_pending.load(memory_order_acquire) > 0) {
+        if(++spins > kSpinLimit) {
+          this_thread::yield();
+        }
+      }
+      _job = NULL;
+    }
+
+    void ThreadPool::_Worker( int id )
+    {
+      _thread_id = id;
+      unsigned generation = 0;
+      while(true) {
+        int spins = 0;
+        unsigned next;
+        while((next = _generation.load(memory_order_acquire)) == generation) {
+          if(++spins > kSpinLimit) {
+            this_thread::yield();
+          }
+        }
+        generation = next;
+        if(_stop.load()) {
+          return;
+        }
+        _RunJob(id);
+        _pending.fetch_sub(1, memory_order_release);
+      }
+    }
+
+    void ThreadPool::SharedStateError( string const & what )
+    {
+      cout << GetSimTime() << " Error: the " << what
+           << " was used by a router while running with sim_threads > 1."
+           << " This configuration can only be simulated with sim_threads = 1." << endl;
+      exit(-1);
+    }
+} // namespace Booksim
@@ -0,0 +1,93 @@
+// $Id$
+
+/*
+ Copyright (c) 2014-2020, Trustees of The University of Cantabria
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this
+ list of conditions and the following disclaimer in the documentation and/or
+ other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*thread_pool.hpp
+ *
+ *Worker threads for sim_threads > 1 (see Network).
+ *
+ *Run() executes a job on every thread of the pool, the calling thread being
+ *thread 0, and returns when all of them are done, so each call is one phase
+ *of the cycle with a barrier at its end. Workers spin between phases (and
+ *yield if the phase does not come soon), since a cycle only lasts a few
+ *microseconds. Workers run the job in the simulation context (gSim) of the
+ *calling thread.
+ */
+
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Booksim
+{
+
+    using namespace std;
+
+    class SimContext;
+
+    class ThreadPool {
+
+    public:
+      ThreadPool( int threads );
+      ~ThreadPool( );
+
+      inline int Threads( ) const { return _threads; }
+
+      void Run( function<void(int)> const & job );
+
+      // Index of the calling thread in the pool (0 outside of the pool)
+      static inline int ThreadId( ) { return _thread_id; }
+      // True while the calling thread runs a phase
+      static inline bool InPhase( ) { return _in_phase; }
+
+      // Abort: state shared by all routers was used inside a phase, which
+      // would make the results depend on the thread schedule
+      static void SharedStateError( string const & what );
+
+    private:
+      int _threads;
+      vector<thread> _workers;
+
+      function<void(int)> const * _job;
+      SimContext * _context;
+      atomic<unsigned> _generation;
+      atomic<int> _pending;
+      atomic<bool> _stop;
+
+      static thread_local int _thread_id;
+      static thread_local bool _in_phase;
+
+      void _Worker( int id );
+      void _RunJob( int id );
+    };
+} // namespace Booksim
+
+#endif
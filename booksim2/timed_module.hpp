@@ -28,21 +28,165 @@
 #ifndef _TIMED_MODULE_HPP_
 #define _TIMED_MODULE_HPP_
 
+#include <vector>
+#include <cassert>
+
 #include "module.hpp"
 
 namespace Booksim
 {
 
+    class TimedModule;
+
+    // Modules waiting for a given cycle, in buckets indexed by the cycle
+    // modulo the (power of two) size of the wheel. Entries beyond the
+    // horizon stay in their bucket until their cycle comes.
+    class TimingWheel {
+    public:
+      TimingWheel() : _mask(0), _pending(0) { _buckets.resize(1); }
+
+      // Sizes the wheel for delays up to horizon cycles; must be empty
+      void Resize(int horizon);
+      void Schedule(TimedModule * module, long long time);
+      // Wakes the modules waiting for time
+      void WakeDue(long long time);
+      inline bool Empty() const { return !_pending; }
+      // Earliest cycle a module is waiting for (-1 if none)
+      long long Next() const;
+
+    private:
+      vector<vector<pair<long long, TimedModule *> > > _buckets;
+      long long _mask;
+      size_t _pending;
+    };
+
+    // Set while a thread runs a parallel phase (sim_threads > 1): wakes are
+    // only recorded there and applied by the network after the phase
+    extern thread_local vector<TimedModule *> * gDeferredWakes;
+
     class TimedModule : public Module {
 
     public:
-      TimedModule(Module * parent, string const & name) : Module(parent, name) {}
+      TimedModule(Module * parent, string const & name)
+        : Module(parent, name), _wake_list(NULL), _timing_wheel(NULL),
+          _schedule_order(-1), _awake(false), _woken(false) {}
       virtual ~TimedModule() {}
       
       virtual void ReadInputs() = 0;
       virtual void Evaluate() = 0;
       virtual void WriteOutputs() = 0;
+
+      // Activity-driven scheduling (see Network): the module is only clocked
+      // while it is on its wake list. Wake() puts it there whenever it gets
+      // work, and the scheduler drops it at the end of a cycle in which it
+      // was not woken and Idle() holds.
+      inline void SetWakeList(vector<TimedModule *> * wake_list, int order,
+                              TimingWheel * timing_wheel = NULL) {
+        _wake_list = wake_list;
+        _timing_wheel = timing_wheel;
+        _schedule_order = order;
+        _awake = false;
+      }
+      inline int ScheduleOrder() const { return _schedule_order; }
+      inline bool HasTimingWheel() const { return _timing_wheel != NULL; }
+
+      inline void Wake() {
+        if(gDeferredWakes) {
+          gDeferredWakes->push_back(this);
+          return;
+        }
+        _woken = true;
+        if(_wake_list && !_awake) {
+          _awake = true;
+          _wake_list->push_back(this);
+        }
+      }
+
+      // True if clocking the module would not change its state until it is
+      // woken again
+      virtual bool Idle() const { return false; }
+      // Cycle at which an idle module must be woken again (-1 if none).
+      // Only used with a timing wheel.
+      virtual long long NextEvent() const { return -1; }
+      // Conservative lower bound of the first cycle, from now on, in which
+      // clocking the module may change its state (-1: not before it is
+      // woken). Cycles before it can be skipped without clocking it.
+      virtual long long NextActivity(long long now) const {
+        return Idle() ? -1 : now;
+      }
+
+      // End of cycle: returns false if the module leaves the wake list
+      inline bool StayAwake() {
+        _awake = _woken || !Idle();
+        _woken = false;
+        if(!_awake && _timing_wheel) {
+          long long const time = NextEvent();
+          if(time >= 0) {
+            _timing_wheel->Schedule(this, time);
+          }
+        }
+        return _awake;
+      }
+
+    private:
+      vector<TimedModule *> * _wake_list;
+      TimingWheel * _timing_wheel;
+      int _schedule_order;
+      bool _awake;
+      bool _woken;
     };
+
+    inline void TimingWheel::Resize(int horizon)
+    {
+      assert(!_pending);
+      size_t slots = 1;
+      while((long long)slots <= horizon) {
+        slots *= 2;
+      }
+      _buckets.assign(slots, vector<pair<long long, TimedModule *> >());
+      _mask = slots - 1;
+    }
+
+    inline void TimingWheel::Schedule(TimedModule * module, long long time)
+    {
+      ++_pending;
+      _buckets[time & _mask].push_back(make_pair(time, module));
+    }
+
+    inline long long TimingWheel::Next() const
+    {
+      long long next = -1;
+      if(!_pending) {
+        return next;
+      }
+      for(size_t b = 0; b < _buckets.size(); ++b) {
+        vector<pair<long long, TimedModule *> > const & bucket = _buckets[b];
+        for(size_t i = 0; i < bucket.size(); ++i) {
+          if((next < 0) || (bucket[i].first < next)) {
+            next = bucket[i].first;
+          }
+        }
+      }
+      return next;
+    }
+
+    inline void TimingWheel::WakeDue(long long time)
+    {
+      if(!_pending) {
+        return;
+      }
+      vector<pair<long long, TimedModule *> > & bucket = _buckets[time & _mask];
+      size_t kept = 0;
+      for(size_t i = 0; i < bucket.size(); ++i) {
+        if(bucket[i].first <= time) {
+          bucket[i].second->Wake();
+          --_pending;
+        } else {
+          bucket[kept++] = bucket[i];
+        }
+      }
+      bucket.resize(kept);
+    }
 } // namespace Booksim
 
 #endif
@@ -30,6 +30,8 @@
 #include <fstream>
 #include <limits>
 #include <string>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "booksim.hpp"
 #include "booksim_config.hpp"
@@ -40,6 +42,7 @@
 #include "synfulltrafficmanager.hpp"
 #include "random_utils.hpp" 
 #include "vc.hpp"
+#include "lookahead.hpp"
 
 namespace Booksim
 {
@@ -90,6 +93,9 @@ namespace Booksim
         _bypass_router |= _router_type == "hybrid_fbfcl";
         _bypass_router |= _router_type == "hybrid_simplified_fbfcl";
         // TODO: add more bypass routers.
+        _swift_router = _router_type == "swift";
+        // Head flits are only injected if the whole packet fits
+        _whole_packet_injection = _router_type == "bypass" || _router_type == "fbfcl_bypass";
         
         // Used by smart_nebb_vct_opt
         string smart_type = config.GetStr("smart_type");
@@ -107,6 +113,10 @@ namespace Booksim
 
 
         _vcs = config.GetInt("num_vcs");
+        if(_vcs > VCSet::kMaxVCs) {
+            cout << "Error: at most " << VCSet::kMaxVCs << " VCs are supported (num_vcs = " << _vcs << ")." << endl;
+            exit(-1);
+        }
         _subnets = config.GetInt("subnets");
 
         // ============ Message priorities ============ 
@@ -190,16 +200,16 @@ namespace Booksim
             }
         }
 
-#ifdef TRACK_FLOWS
-        _outstanding_credits.resize(_classes);
-        for(int c = 0; c < _classes; ++c) {
-            _outstanding_credits[c].resize(_subnets, vector<int>(_nodes, 0));
-        }
+        // Registered in eFlowCounter order
+        _flows.Register(_classes, _nodes);            // injected_flits
+        _flows.Register(_classes, _nodes);            // ejected_flits
+        _flows.Register(_classes, _subnets * _nodes); // outstanding_credits
+        _flows.Enable(config.GetInt("track_flows") > 0);
+        _track_stalls = (config.GetInt("track_stalls") > 0);
         _outstanding_classes.resize(_nodes);
         for(int n = 0; n < _nodes; ++n) {
             _outstanding_classes[n].resize(_subnets, vector<queue<int> >(_vcs));
         }
-#endif
 
         // ============ Injection queues ============ 
         //BSMOD: Retrieve and check the number of injection queues
@@ -215,6 +225,10 @@ namespace Booksim
         //BSMOD: new loop to initialize injection queues
         for ( int iq = 0; iq < _injection_queues; ++iq ) {
             _partial_packets[iq].resize(_nodes);
+            // Preallocate the source rings; very large queue sizes grow on demand
+            for ( int n = 0; n < _nodes; ++n ) {
+                _partial_packets[iq][n].Reserve(min(_inj_size, 4096U));
+            }
         }
 
         for ( int c = 0; c < _classes; ++c ) {
@@ -228,9 +242,21 @@ namespace Booksim
         _retired_packets.resize(_classes);
         //BSMOD: Add bounded ejection queue
         _consumption_queue.resize(_subnets, vector<queue<Flit *>>(_nodes, queue<Flit *>()));
+        _ejection_slots.resize(_subnets);
+        for (int i = 0; i < _subnets; ++i) {
+            _ejection_slots[i].Resize(_nodes);
+        }
 
         _hold_switch_for_packet = config.GetInt("hold_switch_for_packet");
 
+        // ============ Flit pool ============ 
+
+        _flit_pool_per_subnet = (config.GetInt("flit_pool_per_subnet") > 0);
+        int const pool_arenas = _flit_pool_per_subnet ? _subnets : 1;
+        bool const pool_debug = (config.GetInt("flit_pool_debug") > 0);
+        Flit::ConfigurePool(pool_arenas, pool_debug);
+        Lookahead::ConfigurePool(pool_arenas, pool_debug);
+
         // ============ Simulation parameters ============ 
 
         _total_sims = config.GetInt( "sim_count" );
@@ -257,10 +283,30 @@ namespace Booksim
         _measure_stats.resize(_classes, _measure_stats.back());
         _pair_stats = (config.GetInt("pair_stats")==1);
 
+        string const latency_histogram = config.GetStr("latency_histogram");
+        if(latency_histogram == "linear") {
+            _latency_histogram = Stats::Linear;
+        } else if(latency_histogram == "log") {
+            _latency_histogram = Stats::LogLinear;
+        } else {
+            cout << "Error: unknown latency_histogram: " << latency_histogram << endl;
+            exit(-1);
+        }
+        _latency_histogram_precision = config.GetInt("latency_histogram_precision");
+        if((_latency_histogram_precision < 0) || (_latency_histogram_precision > 15)) {
+            cout << "Error: latency_histogram_precision must be between 0 and 15." << endl;
+            exit(-1);
+        }
+
         _include_queuing = config.GetInt( "include_queuing" );
 
         _print_csv_results = config.GetInt( "print_csv_results" );
         _deadlock_warn_timeout = config.GetInt( "deadlock_warn_timeout" );
+        _deadlock_monitor = NULL;
+        if(config.GetInt( "deadlock_check_period" ) > 0) {
+            _deadlock_monitor = new DeadlockMonitor(config, _router);
+        }
+        _fast_forward = (config.GetInt( "fast_forward" ) > 0);
 
         string watch_file = config.GetStr( "watch_file" );
         if((watch_file != "") && (watch_file != "-")) {
@@ -279,6 +325,35 @@ namespace Booksim
 
         _watch_every_packet = config.GetInt("watch_every_packet");
 
+        // ============ Simulation threads ============ 
+
+        _sim_threads = config.GetInt("sim_threads");
+        _thread_pool = NULL;
+        if(_sim_threads < 1) {
+            cout << "Error: sim_threads must be at least 1." << endl;
+            exit(-1);
+        }
+        if(_sim_threads > 1) {
+            if(gTrace || !_flits_to_watch.empty() || !_packets_to_watch.empty() || _watch_every_packet) {
+                cout << "Error: watched flits and viewer traces require sim_threads = 1." << endl;
+                exit(-1);
+            }
+            for (int i = 0; i < _subnets; ++i) {
+                for (int r = 0; r < _routers; ++r) {
+                    if(!_net[i]->GetRouter(r)->ParallelSafe()) {
+                        cout << "Error: router " << _router_type
+                             << " cannot be simulated with sim_threads > 1." << endl;
+                        exit(-1);
+                    }
+                }
+            }
+            _thread_pool = new ThreadPool(_sim_threads);
+            for (int i = 0; i < _subnets; ++i) {
+                _net[i]->SetThreadPool(_thread_pool);
+            }
+        }
+        Credit::ConfigurePool(_sim_threads);
+
         string stats_out_file = config.GetStr( "stats_out" );
         if(stats_out_file == "") {
             _stats_out = NULL;
@@ -289,196 +364,229 @@ namespace Booksim
             config.WriteMatlabFile(_stats_out);
         }
 
-#ifdef TRACK_FLOWS
-        _injected_flits.resize(_classes, vector<int>(_nodes, 0));
-        _ejected_flits.resize(_classes, vector<int>(_nodes, 0));
+        string histogram_out_file = config.GetStr( "histogram_out" );
+        if(histogram_out_file == "") {
+            _histogram_out = NULL;
+        } else {
+            _histogram_out = new ofstream(histogram_out_file.c_str(), ios::binary);
+        }
 
-    //    _bypassed_flits.resize(_classes, vector<double>(_subnets*_routers, 0.0));
+        if(_flows.Enabled()) {
+        //    _bypassed_flits.resize(_classes, vector<double>(_subnets*_routers, 0.0));
 
-        // Headers:
-        ostringstream header_input;
-        header_input << "time,class";
-        for(int router = 0; router < _routers; ++router) {
-            header_input << ",r_" << router;
-        }
-        header_input << "\n";
+            // Headers:
+            ostringstream header_input;
+            header_input << "time,class";
+            for(int router = 0; router < _routers; ++router) {
+                header_input << ",r_" << router;
+            }
+            header_input << "\n";
 
-        string injected_flits_out_file = config.GetStr( "injected_flits_out" );
-        if(injected_flits_out_file == "") {
-            _injected_flits_out = NULL;
-        } else {
-            _injected_flits_out = new ofstream(injected_flits_out_file.c_str());
-            *_injected_flits_out << header_input.str();
-        }
-        string ejected_flits_out_file = config.GetStr( "ejected_flits_out" );
-        if(ejected_flits_out_file == "") {
-            _ejected_flits_out = NULL;
-        } else {
-            _ejected_flits_out = new ofstream(ejected_flits_out_file.c_str());
-            *_ejected_flits_out << header_input.str(); 
-        }
+            string injected_flits_out_file = config.GetStr( "injected_flits_out" );
+            if(injected_flits_out_file == "") {
+                _injected_flits_out = NULL;
+            } else {
+                _injected_flits_out = new ofstream(injected_flits_out_file.c_str());
+                *_injected_flits_out << header_input.str();
+            }
+            string ejected_flits_out_file = config.GetStr( "ejected_flits_out" );
+            if(ejected_flits_out_file == "") {
+                _ejected_flits_out = NULL;
+            } else {
+                _ejected_flits_out = new ofstream(ejected_flits_out_file.c_str());
+                *_ejected_flits_out << header_input.str(); 
+            }
         
-        ostringstream header_subnet_input;
-        header_subnet_input << "time,class,subnet";
-        for(int router = 0; router < _routers; ++router) {
-            for(int input = 0; input < _router[0][router]->GetInputsNumber(); ++input ) {
-                header_subnet_input << ",r_" << router << "_i_" << input;
+            ostringstream header_subnet_input;
+            header_subnet_input << "time,class,subnet";
+            for(int router = 0; router < _routers; ++router) {
+                for(int input = 0; input < _router[0][router]->GetInputsNumber(); ++input ) {
+                    header_subnet_input << ",r_" << router << "_i_" << input;
+                }
             }
-        }
-        header_subnet_input << "\n";
+            header_subnet_input << "\n";
         
-        string received_flits_out_file = config.GetStr( "received_flits_out" );
-        if(received_flits_out_file == "") {
-            _received_flits_out = NULL;
+            string received_flits_out_file = config.GetStr( "received_flits_out" );
+            if(received_flits_out_file == "") {
+                _received_flits_out = NULL;
+            } else {
+                _received_flits_out = new ofstream(received_flits_out_file.c_str());
+                *_received_flits_out << header_subnet_input.str();
+            }
+            string stored_flits_out_file = config.GetStr( "stored_flits_out" );
+            if(stored_flits_out_file == "") {
+                _stored_flits_out = NULL;
+            } else {
+                _stored_flits_out = new ofstream(stored_flits_out_file.c_str());
+                *_stored_flits_out << header_subnet_input.str(); 
+            }
+            string sent_flits_out_file = config.GetStr( "sent_flits_out" );
+            if(sent_flits_out_file == "") {
+                _sent_flits_out = NULL;
+            } else {
+                _sent_flits_out = new ofstream(sent_flits_out_file.c_str());
+                *_sent_flits_out << header_subnet_input.str(); 
+            }
+            string outstanding_credits_out_file = config.GetStr( "outstanding_credits_out" );
+            if(outstanding_credits_out_file == "") {
+                _outstanding_credits_out = NULL;
+            } else {
+                _outstanding_credits_out = new ofstream(outstanding_credits_out_file.c_str());
+                *_outstanding_credits_out << header_subnet_input.str(); 
+            }
+            string active_packets_out_file = config.GetStr( "active_packets_out" );
+            if(active_packets_out_file == "") {
+                _active_packets_out = NULL;
+            } else {
+                _active_packets_out = new ofstream(active_packets_out_file.c_str());
+                *_active_packets_out << header_subnet_input.str(); 
+            }
         } else {
-            _received_flits_out = new ofstream(received_flits_out_file.c_str());
-            *_received_flits_out << header_subnet_input.str();
-        }
-        string stored_flits_out_file = config.GetStr( "stored_flits_out" );
-        if(stored_flits_out_file == "") {
+            _injected_flits_out = NULL;
+            _received_flits_out = NULL;
             _stored_flits_out = NULL;
-        } else {
-            _stored_flits_out = new ofstream(stored_flits_out_file.c_str());
-            *_stored_flits_out << header_subnet_input.str(); 
-        }
-        string sent_flits_out_file = config.GetStr( "sent_flits_out" );
-        string outstanding_credits_out_file = config.GetStr( "outstanding_credits_out" );
-        if(outstanding_credits_out_file == "") {
+            _sent_flits_out = NULL;
             _outstanding_credits_out = NULL;
-        } else {
-            _outstanding_credits_out = new ofstream(outstanding_credits_out_file.c_str());
-            *_outstanding_credits_out << header_subnet_input.str(); 
-        }
-        string active_packets_out_file = config.GetStr( "active_packets_out" );
-        if(active_packets_out_file == "") {
+            _ejected_flits_out = NULL;
             _active_packets_out = NULL;
-        } else {
-            _active_packets_out = new ofstream(active_packets_out_file.c_str());
-            *_active_packets_out << header_subnet_input.str(); 
         }
-#endif
 
-#ifdef TRACK_STALLS
-        // Headers:
-        ostringstream header_stalls_input;
-        header_stalls_input << "time,class,subnet";
-        for(int router = 0; router < _routers; ++router) {
-            header_stalls_input << ",r_" << router;
-        }
-        header_stalls_input << "\n";
+        if(_track_stalls) {
+            // Headers:
+            ostringstream header_stalls_input;
+            header_stalls_input << "time,class,subnet";
+            for(int router = 0; router < _routers; ++router) {
+                header_stalls_input << ",r_" << router;
+            }
+            header_stalls_input << "\n";
 
-        string switch_arbiter_input_stalls_out_file = config.GetStr( "switch_arbiter_input_stalls_out" );
-        if(switch_arbiter_input_stalls_out_file == "") {
-            _switch_arbiter_input_stalls_out = NULL;
-        } else {
-            _switch_arbiter_input_stalls_out = new ofstream(switch_arbiter_input_stalls_out_file.c_str());
-            *_switch_arbiter_input_stalls_out << header_stalls_input.str(); 
-        }
+            string switch_arbiter_input_stalls_out_file = config.GetStr( "switch_arbiter_input_stalls_out" );
+            if(switch_arbiter_input_stalls_out_file == "") {
+                _switch_arbiter_input_stalls_out = NULL;
+            } else {
+                _switch_arbiter_input_stalls_out = new ofstream(switch_arbiter_input_stalls_out_file.c_str());
+                *_switch_arbiter_input_stalls_out << header_stalls_input.str(); 
+            }
 
-        string buffer_busy_stalls_out_file = config.GetStr( "buffer_busy_stalls_out" );
-        if(buffer_busy_stalls_out_file == "") {
-            _buffer_busy_stalls_out = NULL;
-        } else {
-            _buffer_busy_stalls_out = new ofstream(buffer_busy_stalls_out_file.c_str());
-            *_buffer_busy_stalls_out << header_stalls_input.str(); 
-        }
+            string buffer_busy_stalls_out_file = config.GetStr( "buffer_busy_stalls_out" );
+            if(buffer_busy_stalls_out_file == "") {
+                _buffer_busy_stalls_out = NULL;
+            } else {
+                _buffer_busy_stalls_out = new ofstream(buffer_busy_stalls_out_file.c_str());
+                *_buffer_busy_stalls_out << header_stalls_input.str(); 
+            }
         
-        string buffer_conflict_stalls_out_file = config.GetStr( "buffer_conflict_stalls_out" );
-        if(buffer_conflict_stalls_out_file == "") {
-            _buffer_conflict_stalls_out = NULL;
-        } else {
-            _buffer_conflict_stalls_out = new ofstream(buffer_conflict_stalls_out_file.c_str());
-            *_buffer_conflict_stalls_out << header_stalls_input.str(); 
-        }
+            string buffer_conflict_stalls_out_file = config.GetStr( "buffer_conflict_stalls_out" );
+            if(buffer_conflict_stalls_out_file == "") {
+                _buffer_conflict_stalls_out = NULL;
+            } else {
+                _buffer_conflict_stalls_out = new ofstream(buffer_conflict_stalls_out_file.c_str());
+                *_buffer_conflict_stalls_out << header_stalls_input.str(); 
+            }
         
-        string buffer_full_stalls_out_file = config.GetStr( "buffer_full_stalls_out" );
-        if(buffer_full_stalls_out_file == "") {
-            _buffer_full_stalls_out = NULL;
-        } else {
-            _buffer_full_stalls_out = new ofstream(buffer_full_stalls_out_file.c_str());
-            *_buffer_full_stalls_out << header_stalls_input.str(); 
-        }
+            string buffer_full_stalls_out_file = config.GetStr( "buffer_full_stalls_out" );
+            if(buffer_full_stalls_out_file == "") {
+                _buffer_full_stalls_out = NULL;
+            } else {
+                _buffer_full_stalls_out = new ofstream(buffer_full_stalls_out_file.c_str());
+                *_buffer_full_stalls_out << header_stalls_input.str(); 
+            }
         
-        string buffer_reserved_stalls_out_file = config.GetStr( "buffer_reserved_stalls_out" );
-        if(buffer_reserved_stalls_out_file == "") {
-            _buffer_reserved_stalls_out = NULL;
-        } else {
-            _buffer_reserved_stalls_out = new ofstream(buffer_reserved_stalls_out_file.c_str());
-            *_buffer_reserved_stalls_out << header_stalls_input.str(); 
-        }
+            string buffer_reserved_stalls_out_file = config.GetStr( "buffer_reserved_stalls_out" );
+            if(buffer_reserved_stalls_out_file == "") {
+                _buffer_reserved_stalls_out = NULL;
+            } else {
+                _buffer_reserved_stalls_out = new ofstream(buffer_reserved_stalls_out_file.c_str());
+                *_buffer_reserved_stalls_out << header_stalls_input.str(); 
+            }
         
-        string crossbar_conflict_stalls_out_file = config.GetStr( "crossbar_conflict_stalls_out" );
-        if(crossbar_conflict_stalls_out_file == "") {
-            _crossbar_conflict_stalls_out = NULL;
-        } else {
-            _crossbar_conflict_stalls_out = new ofstream(crossbar_conflict_stalls_out_file.c_str());
-            *_crossbar_conflict_stalls_out << header_stalls_input.str(); 
-        }
+            string crossbar_conflict_stalls_out_file = config.GetStr( "crossbar_conflict_stalls_out" );
+            if(crossbar_conflict_stalls_out_file == "") {
+                _crossbar_conflict_stalls_out = NULL;
+            } else {
+                _crossbar_conflict_stalls_out = new ofstream(crossbar_conflict_stalls_out_file.c_str());
+                *_crossbar_conflict_stalls_out << header_stalls_input.str(); 
+            }
         
-        string output_blocked_stalls_out_file = config.GetStr( "output_blocked_stalls_out" );
-        if(output_blocked_stalls_out_file == "") {
-            _output_blocked_stalls_out = NULL;
-        } else {
-            _output_blocked_stalls_out = new ofstream(output_blocked_stalls_out_file.c_str());
-            *_output_blocked_stalls_out << header_stalls_input.str(); 
-        }
+            string output_blocked_stalls_out_file = config.GetStr( "output_blocked_stalls_out" );
+            if(output_blocked_stalls_out_file == "") {
+                _output_blocked_stalls_out = NULL;
+            } else {
+                _output_blocked_stalls_out = new ofstream(output_blocked_stalls_out_file.c_str());
+                *_output_blocked_stalls_out << header_stalls_input.str(); 
+            }
         
-        string la_buffer_busy_out_file = config.GetStr( "la_buffer_busy_out" );
-        if(la_buffer_busy_out_file == "") {
-            _la_buffer_busy_out = NULL;
-        } else {
-            _la_buffer_busy_out = new ofstream(la_buffer_busy_out_file.c_str());
-            *_la_buffer_busy_out << header_stalls_input.str(); 
-        }
+            string la_buffer_busy_out_file = config.GetStr( "la_buffer_busy_out" );
+            if(la_buffer_busy_out_file == "") {
+                _la_buffer_busy_out = NULL;
+            } else {
+                _la_buffer_busy_out = new ofstream(la_buffer_busy_out_file.c_str());
+                *_la_buffer_busy_out << header_stalls_input.str(); 
+            }
         
-        string la_buffer_conflict_out_file = config.GetStr( "la_buffer_conflict_out" );
-        if(la_buffer_conflict_out_file == "") {
-            _la_buffer_conflict_out = NULL;
-        } else {
-            _la_buffer_conflict_out = new ofstream(la_buffer_conflict_out_file.c_str());
-            *_la_buffer_conflict_out << header_stalls_input.str(); 
-        }
+            string la_buffer_conflict_out_file = config.GetStr( "la_buffer_conflict_out" );
+            if(la_buffer_conflict_out_file == "") {
+                _la_buffer_conflict_out = NULL;
+            } else {
+                _la_buffer_conflict_out = new ofstream(la_buffer_conflict_out_file.c_str());
+                *_la_buffer_conflict_out << header_stalls_input.str(); 
+            }
         
-        string la_buffer_full_out_file = config.GetStr( "la_buffer_full_out" );
-        if(la_buffer_full_out_file == "") {
-            _la_buffer_full_out = NULL;
-        } else {
-            _la_buffer_full_out = new ofstream(la_buffer_full_out_file.c_str());
-            *_la_buffer_full_out << header_stalls_input.str(); 
-        }
+            string la_buffer_full_out_file = config.GetStr( "la_buffer_full_out" );
+            if(la_buffer_full_out_file == "") {
+                _la_buffer_full_out = NULL;
+            } else {
+                _la_buffer_full_out = new ofstream(la_buffer_full_out_file.c_str());
+                *_la_buffer_full_out << header_stalls_input.str(); 
+            }
         
-        string la_buffer_reserved_out_file = config.GetStr( "la_buffer_reserved_out" );
-        if(la_buffer_reserved_out_file == "") {
-            _la_buffer_reserved_out = NULL;
-        } else {
-            _la_buffer_reserved_out = new ofstream(la_buffer_reserved_out_file.c_str());
-            *_la_buffer_reserved_out << header_stalls_input.str(); 
-        }
+            string la_buffer_reserved_out_file = config.GetStr( "la_buffer_reserved_out" );
+            if(la_buffer_reserved_out_file == "") {
+                _la_buffer_reserved_out = NULL;
+            } else {
+                _la_buffer_reserved_out = new ofstream(la_buffer_reserved_out_file.c_str());
+                *_la_buffer_reserved_out << header_stalls_input.str(); 
+            }
         
-        string la_crossbar_conflict_out_file = config.GetStr( "la_crossbar_conflict_out" );
-        if(la_crossbar_conflict_out_file == "") {
-            _la_crossbar_conflict_out = NULL;
-        } else {
-            _la_crossbar_conflict_out = new ofstream(la_crossbar_conflict_out_file.c_str());
-            *_la_crossbar_conflict_out << header_stalls_input.str(); 
-        }
+            string la_crossbar_conflict_out_file = config.GetStr( "la_crossbar_conflict_out" );
+            if(la_crossbar_conflict_out_file == "") {
+                _la_crossbar_conflict_out = NULL;
+            } else {
+                _la_crossbar_conflict_out = new ofstream(la_crossbar_conflict_out_file.c_str());
+                *_la_crossbar_conflict_out << header_stalls_input.str(); 
+            }
         
-        string la_sa_winners_killed_out_file = config.GetStr( "la_sa_winners_killed_out" );
-        if(la_sa_winners_killed_out_file == "") {
-            _la_sa_winners_killed_out = NULL;
-        } else {
-            _la_sa_winners_killed_out = new ofstream(la_sa_winners_killed_out_file.c_str());
-            *_la_sa_winners_killed_out << header_stalls_input.str(); 
-        }
+            string la_sa_winners_killed_out_file = config.GetStr( "la_sa_winners_killed_out" );
+            if(la_sa_winners_killed_out_file == "") {
+                _la_sa_winners_killed_out = NULL;
+            } else {
+                _la_sa_winners_killed_out = new ofstream(la_sa_winners_killed_out_file.c_str());
+                *_la_sa_winners_killed_out << header_stalls_input.str(); 
+            }
         
-        string la_output_blocked_out_file = config.GetStr( "la_output_blocked_out" );
-        if(la_output_blocked_out_file == "") {
-            _la_output_blocked_out = NULL;
+            string la_output_blocked_out_file = config.GetStr( "la_output_blocked_out" );
+            if(la_output_blocked_out_file == "") {
+                _la_output_blocked_out = NULL;
+            } else {
+                _la_output_blocked_out = new ofstream(la_output_blocked_out_file.c_str());
+                *_la_output_blocked_out << header_stalls_input.str(); 
+            }
         } else {
-            _la_output_blocked_out = new ofstream(la_output_blocked_out_file.c_str());
-            *_la_output_blocked_out << header_stalls_input.str(); 
+            _switch_arbiter_input_stalls_out = NULL;
+            _buffer_busy_stalls_out = NULL;
+            _buffer_conflict_stalls_out = NULL;
+            _buffer_full_stalls_out = NULL;
+            _buffer_reserved_stalls_out = NULL;
+            _crossbar_conflict_stalls_out = NULL;
+            _output_blocked_stalls_out = NULL;
+            _la_buffer_busy_out = NULL;
+            _la_buffer_conflict_out = NULL;
+            _la_buffer_full_out = NULL;
+            _la_buffer_reserved_out = NULL;
+            _la_crossbar_conflict_out = NULL;
+            _la_sa_winners_killed_out = NULL;
+            _la_output_blocked_out = NULL;
         }
-#endif
 
 #ifdef TRACK_CREDITS
         string used_credits_out_file = config.GetStr( "used_credits_out" );
@@ -551,6 +659,10 @@ namespace Booksim
         _overall_min_sent_packets.resize(_classes, 0.0);
         _overall_avg_sent_packets.resize(_classes, 0.0);
         _overall_max_sent_packets.resize(_classes, 0.0);
+        _refused_packets.resize(_classes);
+        _overall_avg_refused_packets.resize(_classes, 0.0);
+        _offered_flits.resize(_classes, 0);
+        _refused_flits.resize(_classes, 0);
         _accepted_packets.resize(_classes);
         _overall_min_accepted_packets.resize(_classes, 0.0);
         _overall_avg_accepted_packets.resize(_classes, 0.0);
@@ -565,15 +677,12 @@ namespace Booksim
         _overall_avg_accepted.resize(_classes, 0.0);
         _overall_max_accepted.resize(_classes, 0.0);
 
-#ifdef TRACK_STALLS
         _overall_stored_flits.resize(_classes, 0.0);
         _overall_received_flits.resize(_classes, 0);
         _overall_bypassed_flits.resize(_classes, 0);
         _overall_sal_allocations = 0;
         _overall_sag_allocations = 0;
-#endif
 
-#ifdef TRACK_STALLS
         _switch_arbiter_input_stalls.resize(_classes);
         _buffer_busy_stalls.resize(_classes);
         _buffer_conflict_stalls.resize(_classes);
@@ -604,23 +713,21 @@ namespace Booksim
         _overall_la_sa_winners_killed.resize(_classes, 0);
         _overall_la_output_blocked.resize(_classes, 0);
 
-#endif
-
         for ( int c = 0; c < _classes; ++c ) {
             ostringstream tmp_name;
 
             tmp_name << "plat_stat_" << c;
-            _plat_stats[c] = new Stats( this, tmp_name.str( ), 50.0, 250 );
+            _plat_stats[c] = _NewLatencyStats( tmp_name.str( ), 50.0, 250 );
             _stats[tmp_name.str()] = _plat_stats[c];
             tmp_name.str("");
 
             tmp_name << "nlat_stat_" << c;
-            _nlat_stats[c] = new Stats( this, tmp_name.str( ), 50.0, 250 );
+            _nlat_stats[c] = _NewLatencyStats( tmp_name.str( ), 50.0, 250 );
             _stats[tmp_name.str()] = _nlat_stats[c];
             tmp_name.str("");
 
             tmp_name << "flat_stat_" << c;
-            _flat_stats[c] = new Stats( this, tmp_name.str( ), 50.0, 250 );
+            _flat_stats[c] = _NewLatencyStats( tmp_name.str( ), 50.0, 250 );
             _stats[tmp_name.str()] = _flat_stats[c];
             tmp_name.str("");
 
@@ -651,11 +758,11 @@ namespace Booksim
             }
 
             _sent_packets[c].resize(_nodes, 0);
+            _refused_packets[c].resize(_nodes, 0);
             _accepted_packets[c].resize(_nodes, 0);
             _sent_flits[c].resize(_nodes, 0);
             _accepted_flits[c].resize(_nodes, 0);
 
-#ifdef TRACK_STALLS
             _switch_arbiter_input_stalls[c].resize(_subnets*_routers, 0);
             _buffer_busy_stalls[c].resize(_subnets*_routers, 0);
             _buffer_conflict_stalls[c].resize(_subnets*_routers, 0);
@@ -671,22 +778,21 @@ namespace Booksim
             _la_crossbar_conflict[c].resize(_subnets*_routers, 0);
             _la_sa_winners_killed[c].resize(_subnets*_routers, 0);
             _la_output_blocked[c].resize(_subnets*_routers, 0);
-#endif
             if(_pair_stats){
                 for ( int i = 0; i < _nodes; ++i ) {
                     for ( int j = 0; j < _nodes; ++j ) {
                         tmp_name << "pair_plat_stat_" << c << "_" << i << "_" << j;
-                        _pair_plat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
+                        _pair_plat[c][i*_nodes+j] = _NewLatencyStats( tmp_name.str( ), 1.0, 250 );
                         _stats[tmp_name.str()] = _pair_plat[c][i*_nodes+j];
                         tmp_name.str("");
 
                         tmp_name << "pair_nlat_stat_" << c << "_" << i << "_" << j;
-                        _pair_nlat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
+                        _pair_nlat[c][i*_nodes+j] = _NewLatencyStats( tmp_name.str( ), 1.0, 250 );
                         _stats[tmp_name.str()] = _pair_nlat[c][i*_nodes+j];
                         tmp_name.str("");
 
                         tmp_name << "pair_flat_stat_" << c << "_" << i << "_" << j;
-                        _pair_flat[c][i*_nodes+j] = new Stats( this, tmp_name.str( ), 1.0, 250 );
+                        _pair_flat[c][i*_nodes+j] = _NewLatencyStats( tmp_name.str( ), 1.0, 250 );
                         _stats[tmp_name.str()] = _pair_flat[c][i*_nodes+j];
                         tmp_name.str("");
                     }
@@ -732,8 +838,8 @@ namespace Booksim
 
         if(gWatchOut && (gWatchOut != &cout)) delete gWatchOut;
         if(_stats_out && (_stats_out != &cout)) delete _stats_out;
+        if(_histogram_out) delete _histogram_out;
 
-#ifdef TRACK_FLOWS
         if(_injected_flits_out) delete _injected_flits_out;
         if(_received_flits_out) delete _received_flits_out;
         if(_stored_flits_out) delete _stored_flits_out;
@@ -741,7 +847,21 @@ namespace Booksim
         if(_outstanding_credits_out) delete _outstanding_credits_out;
         if(_ejected_flits_out) delete _ejected_flits_out;
         if(_active_packets_out) delete _active_packets_out;
-#endif
+
+        if(_switch_arbiter_input_stalls_out) delete _switch_arbiter_input_stalls_out;
+        if(_buffer_busy_stalls_out) delete _buffer_busy_stalls_out;
+        if(_buffer_conflict_stalls_out) delete _buffer_conflict_stalls_out;
+        if(_buffer_full_stalls_out) delete _buffer_full_stalls_out;
+        if(_buffer_reserved_stalls_out) delete _buffer_reserved_stalls_out;
+        if(_crossbar_conflict_stalls_out) delete _crossbar_conflict_stalls_out;
+        if(_output_blocked_stalls_out) delete _output_blocked_stalls_out;
+        if(_la_buffer_busy_out) delete _la_buffer_busy_out;
+        if(_la_buffer_conflict_out) delete _la_buffer_conflict_out;
+        if(_la_buffer_full_out) delete _la_buffer_full_out;
+        if(_la_buffer_reserved_out) delete _la_buffer_reserved_out;
+        if(_la_crossbar_conflict_out) delete _la_crossbar_conflict_out;
+        if(_la_sa_winners_killed_out) delete _la_sa_winners_killed_out;
+        if(_la_output_blocked_out) delete _la_output_blocked_out;
 
 #ifdef TRACK_CREDITS
         if(_used_credits_out) delete _used_credits_out;
@@ -749,21 +869,32 @@ namespace Booksim
         if(_max_credits_out) delete _max_credits_out;
 #endif
 
+        // The networks may already be deleted (see Simulate() in main.cpp),
+        // and they are not clocked after the traffic manager is gone
+        if(_thread_pool) {
+            delete _thread_pool;
+        }
+        if(_deadlock_monitor) {
+            delete _deadlock_monitor;
+        }
+
         Flit::FreeAll();
+        Lookahead::FreeAll();
         Credit::FreeAll();
     }
 
 
     void TrafficManager::_RetireFlit( Flit *f, int dest )
     {
+        f->CheckLive();
         _deadlock_timer = 0;
 
-        assert(_total_in_flight_flits[f->cl].count(f->id) > 0);
-        _total_in_flight_flits[f->cl].erase(f->id);
+        assert(_total_in_flight_flits[f->cl].Find(f->id) == f);
+        _total_in_flight_flits[f->cl].Erase(f->id);
 
         if(f->record) {
-            assert(_measured_in_flight_flits[f->cl].count(f->id) > 0);
-            _measured_in_flight_flits[f->cl].erase(f->id);
+            assert(_measured_in_flight_flits[f->cl].Find(f->id) == f);
+            _measured_in_flight_flits[f->cl].Erase(f->id);
         }
 
         if ( f->watch ) { 
@@ -800,10 +931,8 @@ namespace Booksim
                 head = f;
             } else {
                 //BSMOD: Change flit and packet id to long
-                map<long, Flit *>::iterator iter = _retired_packets[f->cl].find(f->pid);
-                assert(iter != _retired_packets[f->cl].end());
-                head = iter->second;
-                _retired_packets[f->cl].erase(iter);
+                head = _retired_packets[f->cl].Erase(f->pid);
+                assert(head);
                 assert(head->head);
                 assert(f->pid == head->pid);
             }
@@ -854,7 +983,7 @@ namespace Booksim
         }
 
         if(f->head && !f->tail) {
-            _retired_packets[f->cl].insert(make_pair(f->pid, f));
+            _retired_packets[f->cl].Insert(f->pid, f);
         } else {
             f->Free();
         }
@@ -888,12 +1017,14 @@ namespace Booksim
 
         //BSMOD: Evaluation of the number of injection queues is added
         if(_injection_queues == 1) {
-            if(_partial_packets[0][source].size() >= _inj_size) {
+            if(_partial_packets[0][source].Size() >= _inj_size) {
+                _RefusePacket(source, size, cl);
                 return -1;
             }
         } else {
             //BSMOD: original code without outer if-else
-            if(_partial_packets[cl][source].size() >= _inj_size) {
+            if(_partial_packets[cl][source].Size() >= _inj_size) {
+                _RefusePacket(source, size, cl);
                 return -1;
             }
         }
@@ -902,6 +1033,7 @@ namespace Booksim
         {
             return -1;
         }
+        _offered_flits[cl] += size;
         assert((source >= 0) && (source < _nodes));
         assert((dest >= 0) && (dest < _nodes));
 
@@ -929,7 +1061,7 @@ namespace Booksim
             long id = _cur_id++;
             assert(_cur_id);
 
-            Flit * f = Flit::New();
+            Flit * f = Flit::New(_flit_pool_per_subnet ? _subnet[cl] : 0);
 
             f->id = id;
             f->pid = pid;
@@ -972,9 +1104,9 @@ namespace Booksim
             }
             assert(f->pri >= 0);
 
-            _total_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+            _total_in_flight_flits[f->cl].Insert(f->id, f);
             if(record) {
-                _measured_in_flight_flits[f->cl].insert(make_pair(f->id, f));
+                _measured_in_flight_flits[f->cl].Insert(f->id, f);
             }
 
             if(gTrace) {
@@ -992,21 +1124,36 @@ namespace Booksim
 
             //BSMOD: evaluation of the number of injectino queues is added
             if(_injection_queues == 1) {
-                _partial_packets[0][source].push_back(f);
+                _partial_packets[0][source].PushBack(f);
             } else {
                 //BSMOD: original code without outer if-else
-                _partial_packets[cl][source].push_back(f);
+                _partial_packets[cl][source].PushBack(f);
             }
         }
         return pid;
     }
 
+    void TrafficManager::_RefusePacket( int source, int size, int cl )
+    {
+        _offered_flits[cl] += size;
+        _refused_flits[cl] += size;
+        if((_sim_state == warming_up) || (_sim_state == running)) {
+            ++_refused_packets[cl][source];
+        }
+    }
+
     void TrafficManager::_Step( )
     {
 
         bool flits_in_flight = false;
         for(int c = 0; c < _classes; ++c) {
-            flits_in_flight |= !_total_in_flight_flits[c].empty();
+            flits_in_flight |= !_total_in_flight_flits[c].Empty();
+        }
+        if(flits_in_flight && _deadlock_monitor && _deadlock_monitor->Due(_time) &&
+                _deadlock_monitor->Check()) {
+            _deadlock_monitor->Report(cout, _time);
+            cout << "Aborted because of a network deadlock." << endl;
+            exit(-1);
         }
         if(flits_in_flight && (_deadlock_timer++ >= _deadlock_warn_timeout)) {
             // IVAN: Deadlock debuger
@@ -1023,8 +1170,6 @@ namespace Booksim
         }
 
 
-        vector<map<int, Flit *> > flits(_subnets);
-
         for ( int subnet = 0; subnet < _subnets; ++subnet ) {
             for ( int n = 0; n < _nodes; ++n ) {
                 Flit * const f = _net[subnet]->ReadFlit( n );
@@ -1037,7 +1182,7 @@ namespace Booksim
                             << " from VC " << f->vc
                             << "." << endl;
                     }
-                    flits[subnet].insert(make_pair(n, f));
+                    _ejection_slots[subnet].Insert(n, f);
                     if((_sim_state == warming_up) || (_sim_state == running)) {
                         ++_accepted_flits[f->cl][n];
                         if(f->tail) {
@@ -1048,16 +1193,16 @@ namespace Booksim
 
                 Credit * const c = _net[subnet]->ReadCredit( n );
                 if ( c ) {
-#ifdef TRACK_FLOWS
-                    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-                        int const vc = *iter;
-                        assert(!_outstanding_classes[n][subnet][vc].empty());
-                        int cl = _outstanding_classes[n][subnet][vc].front();
-                        _outstanding_classes[n][subnet][vc].pop();
-                        assert(_outstanding_credits[cl][subnet][n] > 0);
-                        --_outstanding_credits[cl][subnet][n];
+                    if(_flows.Enabled()) {
+                        for(VCSet::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+                            int const vc = *iter;
+                            assert(!_outstanding_classes[n][subnet][vc].empty());
+                            int cl = _outstanding_classes[n][subnet][vc].front();
+                            _outstanding_classes[n][subnet][vc].pop();
+                            assert(_flows.Get(outstanding_credits, cl, subnet*_nodes+n) > 0);
+                            _flows.Dec(outstanding_credits, cl, subnet*_nodes+n);
+                        }
                     }
-#endif
                     _buf_states[n][subnet]->ProcessCredit(c, _vct);
                     c->Free();
                 }
@@ -1082,13 +1227,13 @@ namespace Booksim
                 int class_limit = _classes;
 
                 if(_hold_switch_for_packet) {
-                    list<Flit *> const & pp = _partial_packets[last_class][n];
-                    if(!pp.empty() && !pp.front()->head && (
-                            !dest_buf->IsFullFor(pp.front()->vc, pp.front())
+                    RingQueue<Flit *> const & pp = _partial_packets[last_class][n];
+                    if(!pp.Empty() && !pp.Front()->head && (
+                            !dest_buf->IsFullFor(pp.Front()->vc, pp.Front())
                             || _vct)
                       
                     ) {
-                        f = pp.front();
+                        f = pp.Front();
                         assert(f->vc == _last_vc[n][subnet][last_class]);
 
                         // if we're holding the connection, we don't need to check that class 
@@ -1107,13 +1252,13 @@ namespace Booksim
                             continue;
                         }
 
-                        list<Flit *> const & pp = _partial_packets[c][n];
+                        RingQueue<Flit *> const & pp = _partial_packets[c][n];
 
-                        if(pp.empty()) {
+                        if(pp.Empty()) {
                             continue;
                         }
 
-                        Flit * const cf = pp.front();
+                        Flit * const cf = pp.Front();
                         assert(cf);
 
                         if(_injection_queues == 1)
@@ -1129,7 +1274,7 @@ namespace Booksim
 
                             OutputSet route_set;
                             _rf(NULL, cf, -1, &route_set, true);
-                            set<OutputSet::sSetElement> const & os = route_set.GetSet();
+                            OutputSet::ElementList const & os = route_set.GetSet();
                             assert(os.size() == 1);
                             OutputSet::sSetElement const & se = *os.begin();
                             assert(se.output_port == -1);
@@ -1156,7 +1301,7 @@ namespace Booksim
                                         << "Generating lookahead routing info for flit " << cf->id
                                         << " (NOQ)." << endl;
                                 }
-                                set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+                                OutputSet::ElementList const sl = cf->la_route_set.GetSet();
                                 assert(sl.size() == 1);
                                 int next_output = sl.begin()->output_port;
                                 vc_count /= router->NumOutputs();
@@ -1227,7 +1372,7 @@ namespace Booksim
                                         f = cf;    
                                     }
                                 }
-                                else if(_router_type == "bypass" || _router_type == "fbfcl_bypass")
+                                else if(_whole_packet_injection)
                                 {
                                     if((dest_buf->AvailableFor(cf->vc) >= cf->packet_size && cf->head) || !cf->head)
                                     {
@@ -1278,14 +1423,14 @@ namespace Booksim
                     _last_class[n][subnet] = c;
 
                     if(_injection_queues == 1)
-                        _partial_packets[0][n].pop_front();
+                        _partial_packets[0][n].PopFront();
                     else //BSMOD: original code without outer if-else
-                        _partial_packets[c][n].pop_front();
+                        _partial_packets[c][n].PopFront();
 
-#ifdef TRACK_FLOWS
-                    ++_outstanding_credits[c][subnet][n];
-                    _outstanding_classes[n][subnet][f->vc].push(c);
-#endif
+                    if(_flows.Enabled()) {
+                        _flows.Inc(outstanding_credits, c, subnet*_nodes+n);
+                        _outstanding_classes[n][subnet][f->vc].push(c);
+                    }
 
                     dest_buf->SendingFlit(f, _vct);
 
@@ -1314,14 +1459,14 @@ namespace Booksim
 
                     // Pass VC "back"
                     if(_injection_queues == 1) {
-                        if(!_partial_packets[0][n].empty() && !f->tail) {
+                        if(!_partial_packets[0][n].Empty() && !f->tail) {
                             
-                            Flit * const nf = _partial_packets[0][n].front();
+                            Flit * const nf = _partial_packets[0][n].Front();
                             nf->vc = f->vc;
                         }
                     } else { //BSMOD: original code without outer if-else
-                        if(!_partial_packets[c][n].empty() && !f->tail) {
-                            Flit * const nf = _partial_packets[c][n].front();
+                        if(!_partial_packets[c][n].Empty() && !f->tail) {
+                            Flit * const nf = _partial_packets[c][n].Front();
                             nf->vc = f->vc;
                         }
                     }
@@ -1333,9 +1478,7 @@ namespace Booksim
                         }
                     }
 
-#ifdef TRACK_FLOWS
-                    ++_injected_flits[c][n];
-#endif
+                    _flows.Inc(injected_flits, c, n);
                     _net[subnet]->WriteFlit(f, n);
 
 
@@ -1343,7 +1486,7 @@ namespace Booksim
                     // lookahead channel.
                     if(_bypass_router)
                     {
-                        Lookahead * la = new Lookahead(f);
+                        Lookahead * la = Lookahead::New(f);
                         //la->SetLookahead(f);
                         _net[subnet]->WriteLookahead(la, n);
                     }
@@ -1352,17 +1495,15 @@ namespace Booksim
         }
 
         for(int subnet = 0; subnet < _subnets; ++subnet) {
-            for(int n = 0; n < _nodes; ++n) {
-                map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-                if(iter != flits[subnet].end()) {
-                    Flit * const f = iter->second;
-                    f->atime = _time;
-                    //BSMOD: Add bounded ejection queue
-                    // Enqueue all received flits, the channel is managed by credits
-                    _consumption_queue[subnet][n].push(f);
-                }
+            SlotArray<Flit *> & ejected = _ejection_slots[subnet];
+            for(int n = ejected.Next(0); n >= 0; n = ejected.Next(n + 1)) {
+                Flit * const f = ejected.Get(n);
+                f->atime = _time;
+                //BSMOD: Add bounded ejection queue
+                // Enqueue all received flits, the channel is managed by credits
+                _consumption_queue[subnet][n].push(f);
             }
-            flits[subnet].clear();
+            ejected.Clear();
             _net[subnet]->Evaluate( );
             _net[subnet]->WriteOutputs( );
         }
@@ -1386,9 +1527,7 @@ namespace Booksim
                     c->vc.insert(f->vc);
                     c->id = f->id;
                     _net[subnet]->WriteCredit(c, n);
-#ifdef TRACK_FLOWS
-                    ++_ejected_flits[f->cl][n];
-#endif
+                    _flows.Inc(ejected_flits, f->cl, n);
                     _RetireFlit(f, n);
                     _consumption_queue[subnet][n].pop();
                 }
@@ -1403,10 +1542,102 @@ namespace Booksim
 
     }
 
+    bool TrafficManager::_Quiescent( ) const
+    {
+        for(int c = 0; c < _classes; ++c) {
+            if(!_total_in_flight_flits[c].Empty()) {
+                return false;
+            }
+        }
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            if(!_net[subnet]->Quiescent()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TrafficManager::_Advance( long long limit )
+    {
+        assert(limit > _time);
+        // The per-cycle trace output must not lose any cycle
+        if(_fast_forward && !gTrace) {
+            long const idle = _IdleCycles();
+            if((idle != 0) && _Quiescent()) {
+                long long const skip = (idle < 0) ? (limit - _time) : min((long long)idle, limit - _time);
+                _SkipCycles((long)skip);
+                _time += skip;
+                return;
+            }
+        }
+        _Step();
+    }
+
+    long long TrafficManager::_NextEventCycle( ) const
+    {
+        // The trace output and the injection queues act every cycle
+        if(gTrace) {
+            return _time;
+        }
+        for(int c = 0; c < _injection_queues; ++c) {
+            for(int n = 0; n < _nodes; ++n) {
+                if(!_partial_packets[c][n].Empty()) {
+                    return _time;
+                }
+            }
+        }
+        long long next = -1;
+        for(int subnet = 0; subnet < _subnets; ++subnet) {
+            for(int n = 0; n < _nodes; ++n) {
+                if(!_consumption_queue[subnet][n].empty()) {
+                    return _time;
+                }
+            }
+            long long const net_next = _net[subnet]->NextEventCycle();
+            if(net_next == _time) {
+                return _time;
+            }
+            if((net_next >= 0) && ((next < 0) || (net_next < next))) {
+                next = net_next;
+            }
+        }
+        bool flits_in_flight = false;
+        for(int c = 0; c < _classes; ++c) {
+            flits_in_flight |= !_total_in_flight_flits[c].Empty();
+        }
+        if(flits_in_flight) {
+            // Cycle in which the deadlock warning is due
+            long long const warn = _time + max(_deadlock_warn_timeout - _deadlock_timer, 0);
+            if((next < 0) || (warn < next)) {
+                next = warn;
+            }
+            if(_deadlock_monitor) {
+                long long const check = _deadlock_monitor->NextCheck(_time);
+                if((next < 0) || (check < next)) {
+                    next = check;
+                }
+            }
+        }
+        return next;
+    }
+
+    void TrafficManager::_SkipTo( long long cycle )
+    {
+        assert(cycle >= _time);
+        bool flits_in_flight = false;
+        for(int c = 0; c < _classes; ++c) {
+            flits_in_flight |= !_total_in_flight_flits[c].Empty();
+        }
+        if(flits_in_flight) {
+            _deadlock_timer += (int)(cycle - _time);
+        }
+        _time = cycle;
+    }
+
     bool TrafficManager::_PacketsOutstanding( ) const
     {
         for ( int c = 0; c < _classes; ++c ) {
-            if ( !_measured_in_flight_flits[c].empty() ) {
+            if ( !_measured_in_flight_flits[c].Empty() ) {
                 return true;
             }
         }
@@ -1417,6 +1648,9 @@ namespace Booksim
     {
         _time = 0;
 
+        _offered_flits.assign(_classes, 0);
+        _refused_flits.assign(_classes, 0);
+
         //remove any pending request from the previous simulations
         for ( int c = 0; c < _classes; ++c ) {
             _requests_outstanding[c].assign(_nodes, 0);
@@ -1437,6 +1671,7 @@ namespace Booksim
             _frag_stats[c]->Clear( );
 
             _sent_packets[c].assign(_nodes, 0);
+            _refused_packets[c].assign(_nodes, 0);
             _accepted_packets[c].assign(_nodes, 0);
             _sent_flits[c].assign(_nodes, 0);
             _accepted_flits[c].assign(_nodes, 0);
@@ -1445,7 +1680,6 @@ namespace Booksim
     //        _bypassed_flits[c].assign(_subnets*_routers,0.0);
     //#endif
 
-#ifdef TRACK_STALLS
             _switch_arbiter_input_stalls[c].assign(_subnets*_routers, 0);
             _buffer_busy_stalls[c].assign(_subnets*_routers, 0);
             _buffer_conflict_stalls[c].assign(_subnets*_routers, 0);
@@ -1461,7 +1695,6 @@ namespace Booksim
             _la_crossbar_conflict[c].assign(_subnets*_routers, 0);
             _la_sa_winners_killed[c].assign(_subnets*_routers, 0);
             _la_output_blocked[c].assign(_subnets*_routers, 0);
-#endif
             if(_pair_stats){
                 for ( int i = 0; i < _nodes; ++i ) {
                     for ( int j = 0; j < _nodes; ++j ) {
@@ -1524,7 +1757,7 @@ namespace Booksim
         for(int c = 0; c < _classes; ++c) {
 
             //BSMOD: Change flit and packet id to long
-            map<long, Flit *>::const_iterator iter;
+            IdMap<Flit>::const_iterator iter;
             int i;
 
             os << "Cycle: " << GetSimTime() << " Class " << c << ":" << endl;
@@ -1535,10 +1768,10 @@ namespace Booksim
                     iter++, i++ ) {
                 os << iter->first << " ";
             }
-            if(_total_in_flight_flits[c].size() > 10)
+            if(_total_in_flight_flits[c].Size() > 10)
                 os << "[...] ";
 
-            os << "(" << _total_in_flight_flits[c].size() << " flits)" << endl;
+            os << "(" << _total_in_flight_flits[c].Size() << " flits)" << endl;
 
             os << "Measured flits: ";
             for ( iter = _measured_in_flight_flits[c].begin( ), i = 0;
@@ -1546,10 +1779,10 @@ namespace Booksim
                     iter++, i++ ) {
                 os << iter->first << " ";
             }
-            if(_measured_in_flight_flits[c].size() > 10)
+            if(_measured_in_flight_flits[c].Size() > 10)
                 os << "[...] ";
 
-            os << "(" << _measured_in_flight_flits[c].size() << " flits)" << endl;
+            os << "(" << _measured_in_flight_flits[c].Size() << " flits)" << endl;
 
         }
     }
@@ -1563,6 +1796,15 @@ namespace Booksim
             _ClearStats( );
 
             if ( !_SingleSim( ) ) {
+                _JoinForks();
+                if(_print_csv_results) {
+                    cout << "Simulation unstable, ending ..." << endl;
+                    // Report the aborted load point with the stats gathered so
+                    // far. It goes last, as the launcher scripts keep the tail
+                    _UpdateOverallStats();
+                    DisplayOverallStatsCSV();
+                    return false;
+                }
                 ostringstream new_lines;
                 for(int c=0; c < _classes; c++){// Ivan: The new lines are neccesary for booksim launcher's scripts which reads the last output line
                     new_lines << "\n";
@@ -1578,7 +1820,7 @@ namespace Booksim
 
             bool packets_left = false;
             for(int c = 0; c < _classes; ++c) {
-                packets_left |= !_total_in_flight_flits[c].empty();
+                packets_left |= !_total_in_flight_flits[c].Empty();
             }
 
             while( packets_left ) { 
@@ -1592,7 +1834,7 @@ namespace Booksim
 
                 packets_left = false;
                 for(int c = 0; c < _classes; ++c) {
-                    packets_left |= !_total_in_flight_flits[c].empty();
+                    packets_left |= !_total_in_flight_flits[c].Empty();
                 }
             }
             //wait until all the credits are drained as well
@@ -1608,6 +1850,9 @@ namespace Booksim
             if(_stats_out) {
                 WriteStats(*_stats_out);
             }
+            if(_histogram_out) {
+                _WriteHistograms(*_histogram_out);
+            }
             _UpdateOverallStats();
         }
 
@@ -1616,9 +1861,74 @@ namespace Booksim
             DisplayOverallStatsCSV();
         }
 
+        _JoinForks();
+
         return true;
     }
 
+    int TrafficManager::_ForkMeasurements( int forks )
+    {
+        assert(_fork_pids.empty());
+
+        // Whatever is still buffered would be written by every process
+        cout.flush();
+        cerr.flush();
+        fflush(NULL);
+        if(gWatchOut) {
+            gWatchOut->flush();
+        }
+        if(_stats_out) {
+            _stats_out->flush();
+        }
+
+        for(int f = 1; f < forks; ++f) {
+            FILE * const out = tmpfile();
+            if(!out) {
+                cout << "Error: Unable to create the output file of warm-up fork " << f << "." << endl;
+                exit(-1);
+            }
+            pid_t const pid = fork();
+            if(pid < 0) {
+                cout << "Error: Unable to create warm-up fork " << f << "." << endl;
+                exit(-1);
+            }
+            if(pid == 0) {
+                for(size_t i = 0; i < _fork_outputs.size(); ++i) {
+                    fclose(_fork_outputs[i]);
+                }
+                _fork_outputs.clear();
+                _fork_pids.clear();
+                dup2(fileno(out), STDOUT_FILENO);
+                fclose(out);
+                return f;
+            }
+            _fork_pids.push_back(pid);
+            _fork_outputs.push_back(out);
+        }
+        return 0;
+    }
+
+    void TrafficManager::_JoinForks( )
+    {
+        for(size_t i = 0; i < _fork_pids.size(); ++i) {
+            int status = 0;
+            waitpid(_fork_pids[i], &status, 0);
+            cout << "====== Warm-up fork " << i + 1 << " ======" << endl;
+            rewind(_fork_outputs[i]);
+            char buf[4096];
+            size_t n;
+            while((n = fread(buf, 1, sizeof(buf), _fork_outputs[i])) > 0) {
+                cout.write(buf, n);
+            }
+            fclose(_fork_outputs[i]);
+            if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+                cout << "Warm-up fork " << i + 1 << " did not finish successfully." << endl;
+            }
+        }
+        _fork_pids.clear();
+        _fork_outputs.clear();
+    }
+
     void TrafficManager::DisplayOverallStats(ostream & os) const
     {
         for ( int c = 0; c < _classes; ++c ) {
@@ -1631,10 +1941,13 @@ namespace Booksim
 
     void TrafficManager::DisplayOverallStatsCSV(ostream & os) const
     {
-        os << "class," << _OverallStatsHeaderCSV() << endl;
+        // avg_refused_packets goes after the columns of every subclass so
+        // the older columns keep their positions
+        os << "class," << _OverallStatsHeaderCSV() << ",avg_refused_packets" << endl;
         for(int c = 0; c < _classes; ++c) {
             if(_measure_stats[c]) {
-                os << c << ',' << _OverallClassStatsCSV(c) << endl;
+                os << c << ',' << _OverallClassStatsCSV(c)
+                   << ',' << _overall_avg_refused_packets[c] / (double)_total_sims << endl;
             }
         }
     }
@@ -1685,6 +1998,8 @@ namespace Booksim
             _overall_min_sent_packets[c] += rate_min;
             _overall_avg_sent_packets[c] += rate_avg;
             _overall_max_sent_packets[c] += rate_max;
+            _ComputeStats( _refused_packets[c], &count_sum );
+            _overall_avg_refused_packets[c] += (double)count_sum / time_delta / (double)_nodes;
             _ComputeStats( _accepted_flits[c], &count_sum, &count_min, &count_max );
             rate_min = (double)count_min / time_delta;
             rate_sum = (double)count_sum / time_delta;
@@ -1702,253 +2017,226 @@ namespace Booksim
             _overall_avg_accepted_packets[c] += rate_avg;
             _overall_max_accepted_packets[c] += rate_max;
 
-#ifdef TRACK_STALLS
-            //_ComputeStats(_bypassed_flits[c], &count_sum);
-            ////rate_sum = (double)count_sum / time_delta;
-            ////rate_avg = rate_sum / (double)(_subnets*_routers);
-            //rate_avg = (double)count_sum / (double)(_subnets*_routers);
-            //_overall_bypassed_flits[c] += rate_avg;
-            _overall_bypassed_flits[c] += (double)(_overall_received_flits[c] - _overall_stored_flits[c])/_overall_received_flits[c];
-#endif
+            if(_flows.Enabled()) {
+                //_ComputeStats(_bypassed_flits[c], &count_sum);
+                ////rate_sum = (double)count_sum / time_delta;
+                ////rate_avg = rate_sum / (double)(_subnets*_routers);
+                //rate_avg = (double)count_sum / (double)(_subnets*_routers);
+                //_overall_bypassed_flits[c] += rate_avg;
+                _overall_bypassed_flits[c] += (double)(_overall_received_flits[c] - _overall_stored_flits[c])/_overall_received_flits[c];
+            }
             
-#ifdef TRACK_STALLS
-            _ComputeStats(_switch_arbiter_input_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_switch_arbiter_input_stalls[c] += rate_avg;
-            _ComputeStats(_buffer_busy_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_buffer_busy_stalls[c] += rate_avg;
-            _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_buffer_conflict_stalls[c] += rate_avg;
-            _ComputeStats(_buffer_full_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_buffer_full_stalls[c] += rate_avg;
-            _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_buffer_reserved_stalls[c] += rate_avg;
-            _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_crossbar_conflict_stalls[c] += rate_avg;
-            _ComputeStats(_output_blocked_stalls[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_output_blocked_stalls[c] += rate_avg;
+            if(_track_stalls) {
+                _ComputeStats(_switch_arbiter_input_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_switch_arbiter_input_stalls[c] += rate_avg;
+                _ComputeStats(_buffer_busy_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_buffer_busy_stalls[c] += rate_avg;
+                _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_buffer_conflict_stalls[c] += rate_avg;
+                _ComputeStats(_buffer_full_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_buffer_full_stalls[c] += rate_avg;
+                _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_buffer_reserved_stalls[c] += rate_avg;
+                _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_crossbar_conflict_stalls[c] += rate_avg;
+                _ComputeStats(_output_blocked_stalls[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_output_blocked_stalls[c] += rate_avg;
             
-            _ComputeStats(_la_buffer_busy[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_buffer_busy[c] += rate_avg;
-            _ComputeStats(_la_buffer_conflict[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_buffer_conflict[c] += rate_avg;
-            _ComputeStats(_la_buffer_full[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_buffer_full[c] += rate_avg;
-            _ComputeStats(_la_buffer_reserved[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_buffer_reserved[c] += rate_avg;
-            _ComputeStats(_la_crossbar_conflict[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_crossbar_conflict[c] += rate_avg;
-            _ComputeStats(_la_sa_winners_killed[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_sa_winners_killed[c] += rate_avg;
-            _ComputeStats(_la_output_blocked[c], &count_sum);
-            rate_sum = (double)count_sum / time_delta;
-            rate_avg = rate_sum / (double)(_subnets*_routers);
-            _overall_la_output_blocked[c] += rate_avg;
-#endif
+                _ComputeStats(_la_buffer_busy[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_buffer_busy[c] += rate_avg;
+                _ComputeStats(_la_buffer_conflict[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_buffer_conflict[c] += rate_avg;
+                _ComputeStats(_la_buffer_full[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_buffer_full[c] += rate_avg;
+                _ComputeStats(_la_buffer_reserved[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_buffer_reserved[c] += rate_avg;
+                _ComputeStats(_la_crossbar_conflict[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_crossbar_conflict[c] += rate_avg;
+                _ComputeStats(_la_sa_winners_killed[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_sa_winners_killed[c] += rate_avg;
+                _ComputeStats(_la_output_blocked[c], &count_sum);
+                rate_sum = (double)count_sum / time_delta;
+                rate_avg = rate_sum / (double)(_subnets*_routers);
+                _overall_la_output_blocked[c] += rate_avg;
+            }
 
         }
     }
 
     void TrafficManager::UpdateStats() {
-#if defined(TRACK_FLOWS) || defined(TRACK_STALLS)
-    /*
-#ifdef TRACK_FLOWS
-
-        if(_injected_flits_out) *_injected_flits_out  << _time << ",";
-        if(_received_flits_out) *_received_flits_out << _time << ",";
-        if(_stored_flits_out) *_stored_flits_out << _time << ",";
-        if(_sent_flits_out) *_sent_flits_out << _time << ",";
-        if(_outstanding_credits_out) *_outstanding_credits_out << _time << ",";
-        if(_ejected_flits_out) *_ejected_flits_out << _time << ",";
-        if(_active_packets_out) *_active_packets_out << _time << ",";
-
-#endif
-
-#ifdef TRACK_STALLS
-
-        if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out  << _time << ",";
-        if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out  << _time << ",";
-        if(_buffer_full_stalls_out) *_buffer_full_stalls_out  << _time << ",";
-        if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out  << _time << ",";
-        if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out  << _time << ",";
-
-        if(_la_buffer_busy_out) *_la_buffer_busy_out  << _time << ",";
-        if(_la_buffer_conflict_out) *_la_buffer_conflict_out  << _time << ",";
-        if(_la_buffer_full_out) *_la_buffer_full_out  << _time << ",";
-        if(_la_buffer_reserved_out) *_la_buffer_reserved_out  << _time << ",";
-        if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out  << _time << ",";
-        if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out  << _time << ",";
-#endif
-    */
+        bool const track_flows = _flows.Enabled();
 
         for(int c = 0; c < _classes; ++c) {
-#ifdef TRACK_FLOWS
-            {
+            if(track_flows) {
     //            char trail_char = (c == _classes - 1) ? '\n' : ';';
                 char trail_char = '\n';
-                if(_injected_flits_out) *_injected_flits_out << c << ',' << _injected_flits[c] << trail_char;
-                _injected_flits[c].assign(_nodes, 0);
-                if(_ejected_flits_out) *_ejected_flits_out << c << ',' <<_ejected_flits[c] << trail_char;
-                _ejected_flits[c].assign(_nodes, 0);
+                if(_injected_flits_out) *_injected_flits_out << c << ',' << _flows.Row(injected_flits, c) << trail_char;
+                _flows.ClearRow(injected_flits, c);
+                if(_ejected_flits_out) *_ejected_flits_out << c << ',' << _flows.Row(ejected_flits, c) << trail_char;
+                _flows.ClearRow(ejected_flits, c);
             }
-#endif
             for(int subnet = 0; subnet < _subnets; ++subnet) {
-#ifdef TRACK_FLOWS
-                if(_outstanding_credits_out) *_outstanding_credits_out << _outstanding_credits[c][subnet] << ',';
-                if(_stored_flits_out) *_stored_flits_out << vector<int>(_nodes, 0) << ';';
-
-                if(_received_flits_out) *_received_flits_out << _time << ',' << c << ',' << subnet << ',';
-                if(_stored_flits_out) *_stored_flits_out << _time << ',' << c << ',' << subnet << ',';
-                if(_sent_flits_out) *_sent_flits_out << _time << ',' << c << ',' << subnet << ',';
-                if(_outstanding_credits_out) *_outstanding_credits_out << _time << ',' << c << ',' << subnet << ',';
-                if(_active_packets_out) *_active_packets_out << _time << ',' << c << ',' << subnet << ',';
-#endif
+                if(track_flows) {
+                    if(_outstanding_credits_out) {
+                        vector<int> const credits = _flows.Row(outstanding_credits, c);
+                        *_outstanding_credits_out << vector<int>(credits.begin() + subnet * _nodes,
+                                                                 credits.begin() + (subnet + 1) * _nodes) << ',';
+                    }
+                    if(_stored_flits_out) *_stored_flits_out << vector<int>(_nodes, 0) << ';';
 
-#ifdef TRACK_STALLS
-                // Iván: added to generate heatmaps of stalls
-                if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_buffer_full_stalls_out) *_buffer_full_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                if(_output_blocked_stalls_out) *_output_blocked_stalls_out << _time << ',' << c << ',' << subnet << ',';
-                
-                if(_la_buffer_busy_out) *_la_buffer_busy_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_buffer_conflict_out) *_la_buffer_conflict_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_buffer_full_out) *_la_buffer_full_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_buffer_reserved_out) *_la_buffer_reserved_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << _time << ',' << c << ',' << subnet << ',';
-                if(_la_output_blocked_out) *_la_output_blocked_out << _time << ',' << c << ',' << subnet << ',';
-#endif
+                    if(_received_flits_out) *_received_flits_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_stored_flits_out) *_stored_flits_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_sent_flits_out) *_sent_flits_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_outstanding_credits_out) *_outstanding_credits_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_active_packets_out) *_active_packets_out << _time << ',' << c << ',' << subnet << ',';
+                }
+
+                if(_track_stalls) {
+                    // Iván: added to generate heatmaps of stalls
+                    if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_buffer_full_stalls_out) *_buffer_full_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_output_blocked_stalls_out) *_output_blocked_stalls_out << _time << ',' << c << ',' << subnet << ',';
+                    
+                    if(_la_buffer_busy_out) *_la_buffer_busy_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_buffer_conflict_out) *_la_buffer_conflict_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_buffer_full_out) *_la_buffer_full_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_buffer_reserved_out) *_la_buffer_reserved_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << _time << ',' << c << ',' << subnet << ',';
+                    if(_la_output_blocked_out) *_la_output_blocked_out << _time << ',' << c << ',' << subnet << ',';
+                }
 
                 for(int router = 0; router < _routers; ++router) {
                     Router * const r = _router[subnet][router];
                     char trail_char = (router == _routers - 1) ? '\n' : ',';
-#ifdef TRACK_FLOWS
-                    if(_received_flits_out) *_received_flits_out << r->GetReceivedFlits(c) << trail_char;
-                    if(_stored_flits_out) *_stored_flits_out << r->GetStoredFlits(c) << trail_char;
-                    if(_sent_flits_out) *_sent_flits_out << r->GetSentFlits(c) << trail_char;
-                    if(_outstanding_credits_out) *_outstanding_credits_out << r->GetOutstandingCredits(c) << trail_char;
-                    if(_active_packets_out) *_active_packets_out << r->GetActivePackets(c) << trail_char;
-
-                    int const router_inputs = r->GetInputsNumber();
-                    vector<int> const stored_flits = r->GetStoredFlits(c);
-                    vector<int> const received_flits = r->GetReceivedFlits(c);
-                    
-                    int total_stored_flits = 0; 
-                    int total_received_flits = 0; 
-                    for(int input = 0; input < router_inputs; input++){
-                        total_stored_flits += stored_flits[input];
-                        total_received_flits += received_flits[input];
+                    if(track_flows) {
+                        vector<int> const stored_flits = r->GetStoredFlits(c);
+                        vector<int> const received_flits = r->GetReceivedFlits(c);
+
+                        if(_received_flits_out) *_received_flits_out << received_flits << trail_char;
+                        if(_stored_flits_out) *_stored_flits_out << stored_flits << trail_char;
+                        if(_sent_flits_out) *_sent_flits_out << r->GetSentFlits(c) << trail_char;
+                        if(_outstanding_credits_out) *_outstanding_credits_out << r->GetOutstandingCredits(c) << trail_char;
+                        if(_active_packets_out) *_active_packets_out << r->GetActivePackets(c) << trail_char;
+
+                        int const router_inputs = r->GetInputsNumber();
+                        
+                        int total_stored_flits = 0; 
+                        int total_received_flits = 0; 
+                        for(int input = 0; input < router_inputs; input++){
+                            total_stored_flits += stored_flits[input];
+                            total_received_flits += received_flits[input];
+                        }
+                       // std::cout << "router: " << r << " received_flits " << total_received_flits << " stored_flits " << total_stored_flits << " bypass percentage " << (double) (total_received_flits - total_stored_flits) / total_received_flits << std::endl;
+                           
+                        //_bypassed_flits[c][subnet*_routers+router] = (double) (total_received_flits - total_stored_flits) / (double) total_received_flits;
+                        _overall_stored_flits[c] += total_stored_flits;
+                        _overall_received_flits[c] += total_received_flits;
+
+                        // BSMOD: this only if they are SMART routers
+                        if(_router_type == "smart"){
+                          _overall_sal_allocations += r->GetSwitchAllocationLocalAllocations();
+                          _overall_sag_allocations += r->GetSwitchAllocationGlobalAllocations();
+                        }
+                        
+                        r->ResetFlowStats(c);
                     }
-                   // std::cout << "router: " << r << " received_flits " << total_received_flits << " stored_flits " << total_stored_flits << " bypass percentage " << (double) (total_received_flits - total_stored_flits) / total_received_flits << std::endl;
-                       
-                    //_bypassed_flits[c][subnet*_routers+router] = (double) (total_received_flits - total_stored_flits) / (double) total_received_flits;
-                    _overall_stored_flits[c] += total_stored_flits;
-                    _overall_received_flits[c] += total_received_flits;
-
-                    // BSMOD: this only if they are SMART routers
-                    if(_router_type == "smart"){
-                      _overall_sal_allocations += r->GetSwitchAllocationLocalAllocations();
-                      _overall_sag_allocations += r->GetSwitchAllocationGlobalAllocations();
+                    if(_track_stalls) {
+                        // Iván: added to generate heatmaps of stalls
+                        if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << r->GetSwitchArbiterInputStalls(c) << trail_char;
+                        if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << r->GetBufferBusyStalls(c) << trail_char;
+                        if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << r->GetBufferConflictStalls(c) << trail_char;
+                        if(_buffer_full_stalls_out) *_buffer_full_stalls_out << r->GetBufferFullStalls(c) << trail_char;
+                        if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << r->GetBufferReservedStalls(c) << trail_char;
+                        if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << r->GetCrossbarConflictStalls(c) << trail_char;
+                        if(_output_blocked_stalls_out) *_output_blocked_stalls_out << r->GetOutputBlockedStalls(c) << trail_char;
+                        
+                        if(_la_buffer_busy_out) *_la_buffer_busy_out << r->GetLABufferBusy(c) << trail_char;
+                        if(_la_buffer_conflict_out) *_la_buffer_conflict_out << r->GetLABufferConflict(c) << trail_char;
+                        if(_la_buffer_full_out) *_la_buffer_full_out << r->GetLABufferFull(c) << trail_char;
+                        if(_la_buffer_reserved_out) *_la_buffer_reserved_out << r->GetLABufferReserved(c) << trail_char;
+                        if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << r->GetLACrossbarConflict(c) << trail_char;
+                        if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << r->GetLASAWinnersKilled(c) << trail_char;
+                        if(_la_output_blocked_out) *_la_output_blocked_out << r->GetLAOutputBlocked(c) << trail_char;
+
+                        _switch_arbiter_input_stalls[c][subnet*_routers+router] += r->GetSwitchArbiterInputStalls(c);
+                        _buffer_busy_stalls[c][subnet*_routers+router] += r->GetBufferBusyStalls(c);
+                        _buffer_conflict_stalls[c][subnet*_routers+router] += r->GetBufferConflictStalls(c);
+                        _buffer_full_stalls[c][subnet*_routers+router] += r->GetBufferFullStalls(c);
+                        _buffer_reserved_stalls[c][subnet*_routers+router] += r->GetBufferReservedStalls(c);
+                        _crossbar_conflict_stalls[c][subnet*_routers+router] += r->GetCrossbarConflictStalls(c);
+                        _output_blocked_stalls[c][subnet*_routers+router] += r->GetOutputBlockedStalls(c);
+                        
+                        _la_buffer_busy[c][subnet*_routers+router] += r->GetLABufferBusy(c);
+                        _la_buffer_conflict[c][subnet*_routers+router] += r->GetLABufferConflict(c);
+                        _la_buffer_full[c][subnet*_routers+router] += r->GetLABufferFull(c);
+                        _la_buffer_reserved[c][subnet*_routers+router] += r->GetLABufferReserved(c);
+                        _la_crossbar_conflict[c][subnet*_routers+router] += r->GetLACrossbarConflict(c);
+                        _la_sa_winners_killed[c][subnet*_routers+router] += r->GetLASAWinnersKilled(c);
+                        _la_output_blocked[c][subnet*_routers+router] += r->GetLAOutputBlocked(c);
+
+                        r->ResetStallStats(c);
                     }
-                    
-                    r->ResetFlowStats(c);
-#endif
-#ifdef TRACK_STALLS
-                    // Iván: added to generate heatmaps of stalls
-                    if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << r->GetBufferBusyStalls(c) << trail_char;
-                    if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << r->GetBufferBusyStalls(c) << trail_char;
-                    if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << r->GetBufferConflictStalls(c) << trail_char;
-                    if(_buffer_full_stalls_out) *_buffer_full_stalls_out << r->GetBufferFullStalls(c) << trail_char;
-                    if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << r->GetBufferReservedStalls(c) << trail_char;
-                    if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << r->GetCrossbarConflictStalls(c) << trail_char;
-                    if(_output_blocked_stalls_out) *_output_blocked_stalls_out << r->GetOutputBlockedStalls(c) << trail_char;
-                    
-                    if(_la_buffer_busy_out) *_la_buffer_busy_out << r->GetLABufferBusy(c) << trail_char;
-                    if(_la_buffer_conflict_out) *_la_buffer_conflict_out << r->GetLABufferConflict(c) << trail_char;
-                    if(_la_buffer_full_out) *_la_buffer_full_out << r->GetLABufferFull(c) << trail_char;
-                    if(_la_buffer_reserved_out) *_la_buffer_reserved_out << r->GetLABufferReserved(c) << trail_char;
-                    if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << r->GetLACrossbarConflict(c) << trail_char;
-                    if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << r->GetLASAWinnersKilled(c) << trail_char;
-                    if(_la_output_blocked_out) *_la_output_blocked_out << r->GetLAOutputBlocked(c) << trail_char;
-
-                    _switch_arbiter_input_stalls[c][subnet*_routers+router] += r->GetSwitchArbiterInputStalls(c);
-                    _buffer_busy_stalls[c][subnet*_routers+router] += r->GetBufferBusyStalls(c);
-                    _buffer_conflict_stalls[c][subnet*_routers+router] += r->GetBufferConflictStalls(c);
-                    _buffer_full_stalls[c][subnet*_routers+router] += r->GetBufferFullStalls(c);
-                    _buffer_reserved_stalls[c][subnet*_routers+router] += r->GetBufferReservedStalls(c);
-                    _crossbar_conflict_stalls[c][subnet*_routers+router] += r->GetCrossbarConflictStalls(c);
-                    _output_blocked_stalls[c][subnet*_routers+router] += r->GetOutputBlockedStalls(c);
-                    
-                    _la_buffer_busy[c][subnet*_routers+router] += r->GetLABufferBusy(c);
-                    _la_buffer_conflict[c][subnet*_routers+router] += r->GetLABufferConflict(c);
-                    _la_buffer_full[c][subnet*_routers+router] += r->GetLABufferFull(c);
-                    _la_buffer_reserved[c][subnet*_routers+router] += r->GetLABufferReserved(c);
-                    _la_crossbar_conflict[c][subnet*_routers+router] += r->GetLACrossbarConflict(c);
-                    _la_sa_winners_killed[c][subnet*_routers+router] += r->GetLASAWinnersKilled(c);
-                    _la_output_blocked[c][subnet*_routers+router] += r->GetLAOutputBlocked(c);
-
-                    r->ResetStallStats(c);
-#endif
                 }
             }
         }
-#ifdef TRACK_FLOWS
-        if(_injected_flits_out) *_injected_flits_out << flush;
-        if(_received_flits_out) *_received_flits_out << flush;
-        if(_stored_flits_out) *_stored_flits_out << flush;
-        if(_sent_flits_out) *_sent_flits_out << flush;
-        if(_outstanding_credits_out) *_outstanding_credits_out << flush;
-        if(_ejected_flits_out) *_ejected_flits_out << flush;
-        if(_active_packets_out) *_active_packets_out << flush;
-#endif
-
-#ifdef TRACK_STALLS
-        if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << flush;
-        if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << flush;
-        if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << flush;
-        if(_buffer_full_stalls_out) *_buffer_full_stalls_out << flush;
-        if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << flush;
-        if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << flush;
-        if(_output_blocked_stalls_out) *_output_blocked_stalls_out << flush;
-        
-        if(_la_buffer_busy_out) *_la_buffer_busy_out << flush;
-        if(_la_buffer_conflict_out) *_la_buffer_conflict_out << flush;
-        if(_la_buffer_full_out) *_la_buffer_full_out << flush;
-        if(_la_buffer_reserved_out) *_la_buffer_reserved_out << flush;
-        if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << flush;
-        if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << flush;
-        if(_la_output_blocked_out) *_la_output_blocked_out << flush;
-#endif
-#endif
+        if(track_flows) {
+            if(_injected_flits_out) *_injected_flits_out << flush;
+            if(_received_flits_out) *_received_flits_out << flush;
+            if(_stored_flits_out) *_stored_flits_out << flush;
+            if(_sent_flits_out) *_sent_flits_out << flush;
+            if(_outstanding_credits_out) *_outstanding_credits_out << flush;
+            if(_ejected_flits_out) *_ejected_flits_out << flush;
+            if(_active_packets_out) *_active_packets_out << flush;
+        }
+
+        if(_track_stalls) {
+            if(_switch_arbiter_input_stalls_out) *_switch_arbiter_input_stalls_out << flush;
+            if(_buffer_busy_stalls_out) *_buffer_busy_stalls_out << flush;
+            if(_buffer_conflict_stalls_out) *_buffer_conflict_stalls_out << flush;
+            if(_buffer_full_stalls_out) *_buffer_full_stalls_out << flush;
+            if(_buffer_reserved_stalls_out) *_buffer_reserved_stalls_out << flush;
+            if(_crossbar_conflict_stalls_out) *_crossbar_conflict_stalls_out << flush;
+            if(_output_blocked_stalls_out) *_output_blocked_stalls_out << flush;
+            
+            if(_la_buffer_busy_out) *_la_buffer_busy_out << flush;
+            if(_la_buffer_conflict_out) *_la_buffer_conflict_out << flush;
+            if(_la_buffer_full_out) *_la_buffer_full_out << flush;
+            if(_la_buffer_reserved_out) *_la_buffer_reserved_out << flush;
+            if(_la_crossbar_conflict_out) *_la_crossbar_conflict_out << flush;
+            if(_la_sa_winners_killed_out) *_la_sa_winners_killed_out << flush;
+            if(_la_output_blocked_out) *_la_output_blocked_out << flush;
+        }
 
 #ifdef TRACK_CREDITS
         for(int s = 0; s < _subnets; ++s) {
@@ -1989,6 +2277,25 @@ namespace Booksim
                 _DisplayClassStats(c, os);
             }
         }
+
+        // Tail latency of the whole traffic, merging the class histograms
+        if((_latency_histogram == Stats::LogLinear) && (_classes > 1)) {
+            Stats plat(NULL, "plat_all", Stats::LogLinear, _latency_histogram_precision);
+            Stats nlat(NULL, "nlat_all", Stats::LogLinear, _latency_histogram_precision);
+            for(int c = 0; c < _classes; ++c) {
+                if(_measure_stats[c]) {
+                    plat.Merge(*_plat_stats[c]);
+                    nlat.Merge(*_nlat_stats[c]);
+                }
+            }
+            os << "All classes:" << endl;
+            os << "Packet latency p50 = " << plat.P50()
+               << " p99 = " << plat.P99()
+               << " p99.9 = " << plat.P999() << endl;
+            os << "Network latency p50 = " << nlat.P50()
+               << " p99 = " << nlat.P99()
+               << " p99.9 = " << nlat.P999() << endl;
+        }
     }
 
     void TrafficManager::_DisplayClassStats(int c, ostream & os) const {
@@ -1997,17 +2304,32 @@ namespace Booksim
         os << "Average packet latency = " << _plat_stats[c]->Average() << endl;
         os << "Variance packet latency = " << _plat_stats[c]->Variance() << endl;
         os << "Maximum packet latency = " << _plat_stats[c]->Max() << endl;
+        if(_latency_histogram == Stats::LogLinear) {
+            os << "Packet latency p50 = " << _plat_stats[c]->P50()
+               << " p99 = " << _plat_stats[c]->P99()
+               << " p99.9 = " << _plat_stats[c]->P999() << endl;
+        }
         os << "Packet Latency Histogram = " << endl;
         _plat_stats[c]->Display(os);
         os << "Minimum network latency = " << _nlat_stats[c]->Min() << endl;
         os << "Average network latency = " << _nlat_stats[c]->Average() << endl;
         os << "Variance network latency = " << _nlat_stats[c]->Variance() << endl;
         os << "Maximum network latency = " << _nlat_stats[c]->Max() << endl;
+        if(_latency_histogram == Stats::LogLinear) {
+            os << "Network latency p50 = " << _nlat_stats[c]->P50()
+               << " p99 = " << _nlat_stats[c]->P99()
+               << " p99.9 = " << _nlat_stats[c]->P999() << endl;
+        }
         os << "Slowest packet = " << _slowest_packet[c] << endl;
         os << "Minimum flit latency = " << _flat_stats[c]->Min() << endl;
         os << "Average flit latency = " << _flat_stats[c]->Average() << endl;
         os << "Variance flit latency = " << _flat_stats[c]->Variance() << endl;
         os << "Maximum flit latency = " << _flat_stats[c]->Max() << endl;
+        if(_latency_histogram == Stats::LogLinear) {
+            os << "Flit latency p50 = " << _flat_stats[c]->P50()
+               << " p99 = " << _flat_stats[c]->P99()
+               << " p99.9 = " << _flat_stats[c]->P999() << endl;
+        }
         os << "Slowest flit = " << _slowest_flit[c] << endl;
         os << "Minimum fragmentation = " << _frag_stats[c]->Min() << endl;
         os << "Average fragmentation = " << _frag_stats[c]->Average() << endl;
@@ -2077,65 +2399,65 @@ namespace Booksim
         os << "Average number of hops per cycle = " << _hpc_stats[c]->Average() << endl;
         os << "Average number of smart hops = " << _smart_hop_stats[c]->Average() << endl;
 
-        os << "Total in-flight flits = " << _total_in_flight_flits[c].size()
-            << " (" << _measured_in_flight_flits[c].size() << " measured)"
+        os << "Total in-flight flits = " << _total_in_flight_flits[c].Size()
+            << " (" << _measured_in_flight_flits[c].Size() << " measured)"
             << endl;
 
-#ifdef TRACK_STALLS
-        _ComputeStats(_buffer_busy_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer busy stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer conflict stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_full_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer full stall rate = " << rate_avg << endl;
-        _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Buffer reserved stall rate = " << rate_avg << endl;
-        _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Crossbar conflict stall rate = " << rate_avg << endl;
-        _ComputeStats(_output_blocked_stalls[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "Output blocked stall rate = " << rate_avg << endl;
+        if(_track_stalls) {
+            _ComputeStats(_buffer_busy_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer busy stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer conflict stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_full_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer full stall rate = " << rate_avg << endl;
+            _ComputeStats(_buffer_reserved_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Buffer reserved stall rate = " << rate_avg << endl;
+            _ComputeStats(_crossbar_conflict_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Crossbar conflict stall rate = " << rate_avg << endl;
+            _ComputeStats(_output_blocked_stalls[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "Output blocked stall rate = " << rate_avg << endl;
         
-        _ComputeStats(_la_buffer_busy[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Buffer busy rate = " << rate_avg << endl;
-        _ComputeStats(_la_buffer_conflict[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Buffer conflict rate = " << rate_avg << endl;
-        _ComputeStats(_la_buffer_full[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Buffer full rate = " << rate_avg << endl;
-        _ComputeStats(_la_buffer_reserved[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Buffer reserved rate = " << rate_avg << endl;
-        _ComputeStats(_la_crossbar_conflict[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Crossbar conflict rate = " << rate_avg << endl;
-        _ComputeStats(_la_sa_winners_killed[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA SA-O winners killed rate = " << rate_avg << endl;
-        _ComputeStats(_la_output_blocked[c], &count_sum);
-        rate_sum = (double)count_sum / time_delta;
-        rate_avg = rate_sum / (double)(_subnets*_routers);
-        os << "LA Output blocked rate = " << rate_avg << endl;
-#endif
+            _ComputeStats(_la_buffer_busy[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Buffer busy rate = " << rate_avg << endl;
+            _ComputeStats(_la_buffer_conflict[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Buffer conflict rate = " << rate_avg << endl;
+            _ComputeStats(_la_buffer_full[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Buffer full rate = " << rate_avg << endl;
+            _ComputeStats(_la_buffer_reserved[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Buffer reserved rate = " << rate_avg << endl;
+            _ComputeStats(_la_crossbar_conflict[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Crossbar conflict rate = " << rate_avg << endl;
+            _ComputeStats(_la_sa_winners_killed[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA SA-O winners killed rate = " << rate_avg << endl;
+            _ComputeStats(_la_output_blocked[c], &count_sum);
+            rate_sum = (double)count_sum / time_delta;
+            rate_avg = rate_sum / (double)(_subnets*_routers);
+            os << "LA Output blocked rate = " << rate_avg << endl;
+        }
     }
 
     void TrafficManager::WriteStats(ostream & os) const {
@@ -2223,77 +2545,77 @@ namespace Booksim
         }
         os << "];" << endl;
 
-#ifdef TRACK_STALLS
-        os << "switch_arbiter_input_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_switch_arbiter_input_stalls[c][d] / time_delta << " ";
-        }
-        os << "buffer_busy_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_busy_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "buffer_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_conflict_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "buffer_full_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_full_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "buffer_reserved_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_buffer_reserved_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_crossbar_conflict_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "output_blocked_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_output_blocked_stalls[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_buffer_busy_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_buffer_busy[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_buffer_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_buffer_conflict[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_buffer_full_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_buffer_full[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_buffer_reserved_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_buffer_reserved[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_crossbar_conflict[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_sa_winners_killed(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_sa_winners_killed[c][d] / time_delta << " ";
-        }
-        os << "];" << endl
-            << "la_output_blocked_stalls(" << c+1 << ",:) = [ ";
-        for ( int d = 0; d < _subnets*_routers; ++d ) {
-            os << (double)_la_output_blocked[c][d] / time_delta << " ";
+        if(_track_stalls) {
+            os << "switch_arbiter_input_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_switch_arbiter_input_stalls[c][d] / time_delta << " ";
+            }
+            os << "buffer_busy_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_busy_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "buffer_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_conflict_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "buffer_full_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_full_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "buffer_reserved_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_buffer_reserved_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_crossbar_conflict_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "output_blocked_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_output_blocked_stalls[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_buffer_busy_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_buffer_busy[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_buffer_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_buffer_conflict[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_buffer_full_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_buffer_full[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_buffer_reserved_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_buffer_reserved[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_crossbar_conflict_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_crossbar_conflict[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_sa_winners_killed(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_sa_winners_killed[c][d] / time_delta << " ";
+            }
+            os << "];" << endl
+                << "la_output_blocked_stalls(" << c+1 << ",:) = [ ";
+            for ( int d = 0; d < _subnets*_routers; ++d ) {
+                os << (double)_la_output_blocked[c][d] / time_delta << " ";
+            }
+            os << "];" << endl;
         }
-        os << "];" << endl;
-#endif
     }
 
     void TrafficManager::_DisplayOverallClassStats( int c, ostream & os ) const {
@@ -2332,6 +2654,8 @@ namespace Booksim
             << " (" << _total_sims << " samples)" << endl;
         os << "Overall maximum injected packet rate = " << _overall_max_sent_packets[c] / (double)_total_sims
             << " (" << _total_sims << " samples)" << endl;
+        os << "Overall average refused packet rate = " << _overall_avg_refused_packets[c] / (double)_total_sims
+            << " (" << _total_sims << " samples)" << endl;
 
         os << "Overall minimum accepted packet rate = " << _overall_min_accepted_packets[c] / (double)_total_sims
             << " (" << _total_sims << " samples)" << endl;
@@ -2367,48 +2691,48 @@ namespace Booksim
         os << "Overall average SMART hops = " << _overall_smart_hop_stats[c] / (double)_total_sims
             << " (" << _total_sims << " samples)" << endl;
 
-#ifdef TRACK_FLOWS
-        os << "Overall bypassed flits = " << (double) _overall_bypassed_flits[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl;
-        int total_received_flits = 0;
-        for(int iter_c=0; iter_c < _classes; iter_c++){
-          total_received_flits += _overall_received_flits[c];
+        if(_flows.Enabled()) {
+            os << "Overall bypassed flits = " << (double) _overall_bypassed_flits[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl;
+            int total_received_flits = 0;
+            for(int iter_c=0; iter_c < _classes; iter_c++){
+              total_received_flits += _overall_received_flits[c];
+            }
+            os << "Overall SAL allocations = " << (double) _overall_sal_allocations / ((double) _total_sims * total_received_flits )<< endl;
+            os << "Overall SAG allocations = " << (double) _overall_sag_allocations / ((double) _total_sims * total_received_flits) << endl;
+        }
+
+        if(_track_stalls) {
+            os << "Overall switch arbiter input stalls = " << (double)_overall_switch_arbiter_input_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall buffer busy stalls = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall buffer conflict stalls = " << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall buffer full stalls = " << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall buffer reserved stalls = " << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall crossbar conflict stalls = " << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall output blocked stalls = " << (double)_overall_output_blocked_stalls[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+
+                << "Overall LA buffer busy = " << (double)_overall_la_buffer_busy[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA buffer conflict = " << (double)_overall_la_buffer_conflict[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA buffer full = " << (double)_overall_la_buffer_full[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA buffer reserved = " << (double)_overall_la_buffer_reserved[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA crossbar conflict = " << (double)_overall_la_crossbar_conflict[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA SA-O winners killed = " << (double)_overall_la_sa_winners_killed[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl
+                << "Overall LA output blocked = " << (double)_overall_la_output_blocked[c] / (double)_total_sims
+                << " (" << _total_sims << " samples)" << endl;
         }
-        os << "Overall SAL allocations = " << (double) _overall_sal_allocations / ((double) _total_sims * total_received_flits )<< endl;
-        os << "Overall SAG allocations = " << (double) _overall_sag_allocations / ((double) _total_sims * total_received_flits) << endl;
-#endif
-
-#ifdef TRACK_STALLS
-        os << "Overall switch arbiter input stalls = " << (double)_overall_switch_arbiter_input_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall buffer busy stalls = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall buffer conflict stalls = " << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall buffer full stalls = " << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall buffer reserved stalls = " << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall crossbar conflict stalls = " << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall output blocked stalls = " << (double)_overall_output_blocked_stalls[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-
-            << "Overall LA buffer busy = " << (double)_overall_la_buffer_busy[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA buffer conflict = " << (double)_overall_la_buffer_conflict[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA buffer full = " << (double)_overall_la_buffer_full[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA buffer reserved = " << (double)_overall_la_buffer_reserved[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA crossbar conflict = " << (double)_overall_la_crossbar_conflict[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA SA-O winners killed = " << (double)_overall_la_sa_winners_killed[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl
-            << "Overall LA output blocked = " << (double)_overall_la_output_blocked[c] / (double)_total_sims
-            << " (" << _total_sims << " samples)" << endl;
-#endif
 
     }
 
@@ -2451,29 +2775,35 @@ namespace Booksim
             << ',' << "smart_hops"
             << ',' << "his_smart_hops";
 
-#ifdef TRACK_FLOWS
-        os << ',' << "bypassed_flits";
-        os << ',' << "sal_alloc_per_flit";
-        os << ',' << "sag_alloc_per_flit";
-#endif
+        if(_latency_histogram == Stats::LogLinear) {
+            os << ',' << "p50_plat" << ',' << "p99_plat" << ',' << "p999_plat"
+               << ',' << "p50_nlat" << ',' << "p99_nlat" << ',' << "p999_nlat"
+               << ',' << "p50_flat" << ',' << "p99_flat" << ',' << "p999_flat";
+        }
 
-#ifdef TRACK_STALLS
-        os << ',' << "switch_arbiter_input_conflict"
-            << ',' << "buffer_busy"
-            << ',' << "buffer_conflict"
-            << ',' << "buffer_full"
-            << ',' << "buffer_reserved"
-            << ',' << "crossbar_conflict"
-            << ',' << "output_blocked";
+        if(_flows.Enabled()) {
+            os << ',' << "bypassed_flits";
+            os << ',' << "sal_alloc_per_flit";
+            os << ',' << "sag_alloc_per_flit";
+        }
+
+        if(_track_stalls) {
+            os << ',' << "switch_arbiter_input_conflict"
+                << ',' << "buffer_busy"
+                << ',' << "buffer_conflict"
+                << ',' << "buffer_full"
+                << ',' << "buffer_reserved"
+                << ',' << "crossbar_conflict"
+                << ',' << "output_blocked";
        
-        os << ',' << "la_buffer_busy"
-            << ',' << "la_buffer_conflict"
-            << ',' << "la_buffer_full"
-            << ',' << "la_buffer_reserved"
-            << ',' << "la_crossbar_conflict"
-            << ',' << "la_sa_winners_killed"
-            << ',' << "la_output_blocked";
-#endif
+            os << ',' << "la_buffer_busy"
+                << ',' << "la_buffer_conflict"
+                << ',' << "la_buffer_full"
+                << ',' << "la_buffer_reserved"
+                << ',' << "la_crossbar_conflict"
+                << ',' << "la_sa_winners_killed"
+                << ',' << "la_output_blocked";
+        }
         return os.str();
     }
 
@@ -2516,36 +2846,73 @@ namespace Booksim
             << ',' << _overall_smart_hop_stats[c] / (double)_total_sims
             << ',' << *_smart_hop_stats[c];
 
-#ifdef TRACK_FLOWS
-        os << ',' << (double)_overall_bypassed_flits[c] / (double)_total_sims;
-        int total_received_flits = 0;
-        for(int iter_c=0; iter_c < _classes; iter_c++){
-          total_received_flits += _overall_received_flits[c];
+        if(_latency_histogram == Stats::LogLinear) {
+            os << ',' << _plat_stats[c]->P50() << ',' << _plat_stats[c]->P99() << ',' << _plat_stats[c]->P999()
+               << ',' << _nlat_stats[c]->P50() << ',' << _nlat_stats[c]->P99() << ',' << _nlat_stats[c]->P999()
+               << ',' << _flat_stats[c]->P50() << ',' << _flat_stats[c]->P99() << ',' << _flat_stats[c]->P999();
         }
-        os << ',' << (double)_overall_sal_allocations / ((double)_total_sims * total_received_flits);
-        os << ',' << (double)_overall_sag_allocations / ((double)_total_sims * total_received_flits);
-#endif
 
-#ifdef TRACK_STALLS
-        os << ',' << (double)_overall_switch_arbiter_input_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_output_blocked_stalls[c] / (double)_total_sims
-            << ',' << (double)_overall_la_buffer_busy[c] / (double)_total_sims
-            << ',' << (double)_overall_la_buffer_conflict[c] / (double)_total_sims
-            << ',' << (double)_overall_la_buffer_full[c] / (double)_total_sims
-            << ',' << (double)_overall_la_buffer_reserved[c] / (double)_total_sims
-            << ',' << (double)_overall_la_crossbar_conflict[c] / (double)_total_sims
-            << ',' << (double)_overall_la_sa_winners_killed[c] / (double)_total_sims
-            << ',' << (double)_overall_la_output_blocked[c] / (double)_total_sims;
-#endif
+        if(_flows.Enabled()) {
+            os << ',' << (double)_overall_bypassed_flits[c] / (double)_total_sims;
+            int total_received_flits = 0;
+            for(int iter_c=0; iter_c < _classes; iter_c++){
+              total_received_flits += _overall_received_flits[c];
+            }
+            os << ',' << (double)_overall_sal_allocations / ((double)_total_sims * total_received_flits);
+            os << ',' << (double)_overall_sag_allocations / ((double)_total_sims * total_received_flits);
+        }
+
+        if(_track_stalls) {
+            os << ',' << (double)_overall_switch_arbiter_input_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_buffer_conflict_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_buffer_full_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_buffer_reserved_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_crossbar_conflict_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_output_blocked_stalls[c] / (double)_total_sims
+                << ',' << (double)_overall_la_buffer_busy[c] / (double)_total_sims
+                << ',' << (double)_overall_la_buffer_conflict[c] / (double)_total_sims
+                << ',' << (double)_overall_la_buffer_full[c] / (double)_total_sims
+                << ',' << (double)_overall_la_buffer_reserved[c] / (double)_total_sims
+                << ',' << (double)_overall_la_crossbar_conflict[c] / (double)_total_sims
+                << ',' << (double)_overall_la_sa_winners_killed[c] / (double)_total_sims
+                << ',' << (double)_overall_la_output_blocked[c] / (double)_total_sims;
+        }
 
         return os.str();
     }
 
+    Stats * TrafficManager::_NewLatencyStats( string const & name, double bin_size, int num_bins )
+    {
+        if(_latency_histogram == Stats::LogLinear) {
+            return new Stats( this, name, Stats::LogLinear, _latency_histogram_precision );
+        }
+        return new Stats( this, name, bin_size, num_bins );
+    }
+
+    void TrafficManager::_WriteHistograms( ostream & os ) const
+    {
+        for(int c = 0; c < _classes; ++c) {
+            if(!_measure_stats[c]) {
+                continue;
+            }
+            _plat_stats[c]->WriteBinary(os);
+            _nlat_stats[c]->WriteBinary(os);
+            _flat_stats[c]->WriteBinary(os);
+            if(_pair_stats) {
+                for(int i = 0; i < _nodes * _nodes; ++i) {
+                    // Pairs without traffic would only add headers
+                    if(_pair_plat[c][i]->NumSamples() > 0) {
+                        _pair_plat[c][i]->WriteBinary(os);
+                        _pair_nlat[c][i]->WriteBinary(os);
+                        _pair_flat[c][i]->WriteBinary(os);
+                    }
+                }
+            }
+        }
+        os.flush();
+    }
+
     //read the watchlist
     void TrafficManager::_LoadWatchList(const string & filename){
         ifstream watch_list;
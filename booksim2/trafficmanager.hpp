@@ -33,6 +33,8 @@
 #include <map>
 #include <set>
 #include <queue>
+#include <cstdio>
+#include <sys/types.h>
 
 #include "module.hpp"
 #include "config_utils.hpp"
@@ -42,6 +44,11 @@
 #include "stats.hpp"
 #include "routefunc.hpp"
 #include "outputset.hpp"
+#include "id_map.hpp"
+#include "slot_array.hpp"
+#include "ring_queue.hpp"
+#include "counter_block.hpp"
+#include "deadlock_monitor.hpp"
 
 namespace Booksim
 {
@@ -57,6 +64,7 @@ namespace Booksim
       // Are we using bypass routers? If yes flits generate lookahead signals
       bool _bypass_router;
       bool _swift_router;
+      bool _whole_packet_injection;
       string _router_type;
 
       // FIXME
@@ -85,10 +93,7 @@ namespace Booksim
       // ============ Injection VC states  ============ 
 
       vector<vector<BufferState *> > _buf_states;
-#ifdef TRACK_FLOWS
-      vector<vector<vector<int> > > _outstanding_credits;
       vector<vector<vector<queue<int> > > > _outstanding_classes;
-#endif
       vector<vector<vector<int> > > _last_vc;
 
       // ============ Routing ============ 
@@ -102,23 +107,38 @@ namespace Booksim
       //BSMOD: Define the number of injection queues
       int _injection_queues;
 
-      vector<vector<list<Flit *> > > _partial_packets;
+      vector<vector<RingQueue<Flit *> > > _partial_packets;
 
       //BSMOD: Change flit and packet id to long
-      vector<map<long, Flit *> > _total_in_flight_flits;
-      vector<map<long, Flit *> > _measured_in_flight_flits;
-      vector<map<long, Flit *> > _retired_packets;
+      vector<IdMap<Flit> > _total_in_flight_flits;
+      vector<IdMap<Flit> > _measured_in_flight_flits;
+      vector<IdMap<Flit> > _retired_packets;
       //BSMOD: Add bounded ejection queue
       vector<vector<queue<Flit *> > > _consumption_queue;
+      // Flits ejected in the current cycle, per subnet and node
+      vector<SlotArray<Flit *> > _ejection_slots;
 
       bool _empty_network;
 
       bool _hold_switch_for_packet;
 
+      // Carve the flits of each subnet from their own pool arena
+      bool _flit_pool_per_subnet;
+
+      // Threads that clock the routers and channels (sim_threads)
+      int _sim_threads;
+      ThreadPool * _thread_pool;
+
       // ============ deadlock ==========
 
       int _deadlock_timer;
       int _deadlock_warn_timeout;
+      // Wait-for graph checks (deadlock_check_period), NULL if disabled
+      DeadlockMonitor * _deadlock_monitor;
+
+      // ============ fast-forward ==========
+
+      bool _fast_forward;
 
       // ============ request & replies ==========================
 
@@ -163,6 +183,12 @@ namespace Booksim
       vector<double> _overall_min_sent_packets;
       vector<double> _overall_avg_sent_packets;
       vector<double> _overall_max_sent_packets;
+      // Packets dropped by _GeneratePacket() because the source queue was full
+      vector<vector<int> > _refused_packets;
+      vector<double> _overall_avg_refused_packets;
+      // Flits offered to and refused by the source queues since _ResetSim()
+      vector<long long> _offered_flits;
+      vector<long long> _refused_flits;
       vector<vector<int> > _accepted_packets;
       vector<double> _overall_min_accepted_packets;
       vector<double> _overall_avg_accepted_packets;
@@ -176,7 +202,6 @@ namespace Booksim
       vector<double> _overall_avg_accepted;
       vector<double> _overall_max_accepted;
 
-#ifdef TRACK_STALLS
       vector<vector<int> > _switch_arbiter_input_stalls;
       vector<vector<int> > _buffer_busy_stalls;
       vector<vector<int> > _buffer_conflict_stalls;
@@ -206,7 +231,6 @@ namespace Booksim
       vector<double> _overall_la_crossbar_conflict;
       vector<double> _overall_la_sa_winners_killed;
       vector<double> _overall_la_output_blocked;
-#endif
 
       //BSMOD: Change flit and packet id to long
       vector<long> _slowest_packet;
@@ -230,6 +254,9 @@ namespace Booksim
       vector<int> _measure_stats;
       bool _pair_stats;
 
+      Stats::HistogramType _latency_histogram;
+      int _latency_histogram_precision;
+
       //BSMOD: Change flit and packet id to long
       long _cur_id;
       long _cur_pid;
@@ -245,9 +272,15 @@ namespace Booksim
       //flits to watch
       ostream * _stats_out;
 
-#ifdef TRACK_FLOWS
-      vector<vector<int> > _injected_flits;
-      vector<vector<int> > _ejected_flits;
+      ostream * _histogram_out;
+
+      // Flow and stall instrumentation (track_flows / track_stalls). The
+      // node counters are [class][node], outstanding_credits is
+      // [class][subnet * nodes + node].
+      enum eFlowCounter { injected_flits, ejected_flits, outstanding_credits };
+      CounterBlock _flows;
+      bool _track_stalls;
+
       vector<int> _overall_stored_flits;
       vector<int> _overall_received_flits;
       vector<double> _overall_bypassed_flits;
@@ -260,9 +293,7 @@ namespace Booksim
       ostream * _outstanding_credits_out;
       ostream * _ejected_flits_out;
       ostream * _active_packets_out;
-#endif
 
-#ifdef TRACK_STALLS
       ostream * _switch_arbiter_input_stalls_out;
       ostream * _buffer_busy_stalls_out;
       ostream * _buffer_conflict_stalls_out;
@@ -278,7 +309,6 @@ namespace Booksim
       ostream * _la_crossbar_conflict_out;
       ostream * _la_sa_winners_killed_out;
       ostream * _la_output_blocked_out;
-#endif
 
 #ifdef TRACK_CREDITS
       ostream * _used_credits_out;
@@ -308,12 +338,38 @@ namespace Booksim
       
       void _Step( );
 
+      // Fast-forward: _Advance() jumps over up to limit - _time cycles when
+      // nothing is in flight and _IdleCycles() says no packet is due before
+      // (-1: never), otherwise it is a plain _Step(). _SkipCycles() moves
+      // the traffic source over the cycles that are not simulated.
+      virtual long _IdleCycles( ) const { return 0; }
+      virtual void _SkipCycles( long cycles ) { }
+      bool _Quiescent( ) const;
+      void _Advance( long long limit );
+
+      // Conservative lower bound of the next cycle in which _Step() may do
+      // anything besides advancing the time (-1: not before an injection)
+      long long _NextEventCycle( ) const;
+      // Jumps to cycle, which must not be after _NextEventCycle()
+      void _SkipTo( long long cycle );
+
       virtual bool _PacketsOutstanding( ) const;
       
       //BSMOD: Change time to long long
       //BSMOD: Change flit and packet id to long
       //BSMOD: Add AcmeVectorMemoryTrafficPattern
       long _GeneratePacket( int source, int dest, int size, int cl, long long time, int chain_aux = -1 );
+      void _RefusePacket( int source, int size, int cl );
+
+      // Warm-up forks: copies of a warmed-up simulation made with fork(),
+      // each writing its output to a temporary file that the original
+      // process appends to its own output once the copy has exited
+      vector<pid_t> _fork_pids;
+      vector<FILE *> _fork_outputs;
+
+      // Returns the index of the calling process, 0 for the original one
+      int _ForkMeasurements( int forks );
+      void _JoinForks( );
 
       virtual void _ResetSim( );
 
@@ -327,6 +383,10 @@ namespace Booksim
       
       void _LoadWatchList(const string & filename);
 
+      // Latency stats use the histogram selected by latency_histogram
+      Stats * _NewLatencyStats( string const & name, double bin_size, int num_bins );
+      void _WriteHistograms( ostream & os ) const;
+
       virtual void _UpdateOverallStats();
 
       virtual string _OverallStatsHeaderCSV() const;
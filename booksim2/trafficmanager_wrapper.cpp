@@ -41,6 +41,9 @@ namespace Booksim
         {
             _ejection_queue[cl].resize(_nodes);
         }
+        _next_seq = 0;
+        _ejected_packets = 0;
+        _ejected_class_packets.resize(_classes, 0);
         //BSMOD: Add bounded ejection queue
         assert(_subnets == 1);
         _ejection_queue_free_flits.resize(_nodes, config.GetInt("ejection_queue_size"));
@@ -100,18 +103,25 @@ namespace Booksim
         assert(head->pid == tail->pid);
         assert(head->cl == tail->cl);
         
-        //_ejection_queue[head->cl][head->dest].push(head->pid);
-        
-        // Create retired packet
-        //RetiredPacket rp = {head->pid, 
-        //                                      head->cl,
-        //                                      head->packet_size,
-        //                                      tail->atime-head->ctime,
-        //                                      tail->atime-head->itime,
-        //                                      head->hops,
-        //                                      head->hpc.size(),
-        //                                      0};
-        _ejection_queue[head->cl][head->dest].push(make_pair(*head, *tail));
+        // Only keep what the host needs, copying the flits is expensive
+        EjectedPacket ep;
+        ep.seq = _next_seq++;
+        RetiredPacket rp = {head->pid,
+                            head->src,
+                            head->dest,
+                            head->cl,
+                            head->packet_size,
+                            (int)(tail->atime-head->ctime),
+                            (int)(tail->atime-head->itime),
+                            head->hops,
+                            (int)head->hpc.size(),
+                            0};
+        ep.packet = rp;
+        _ejection_queue[head->cl][head->dest].push(ep);
+        ReadyPacket ready = {head->cl, head->dest, ep.seq};
+        _ready.push_back(ready);
+        ++_ejected_packets;
+        ++_ejected_class_packets[head->cl];
     }
 
     //BSMOD: Add bounded ejection queue
@@ -132,74 +142,117 @@ namespace Booksim
         return _ejection_queue_free_flits[node] > 0;
     }
 
-    // FIXME: check type of returning data
+    // Removes the first packet of an ejection queue
+    TrafficManagerWrapper::RetiredPacket
+    TrafficManagerWrapper::_PopPacket(int cl, int dst)
+    {
+        RetiredPacket rp = _ejection_queue[cl][dst].front().packet;
+        _ejection_queue[cl][dst].pop();
+        //BSMOD: Add bounded ejection queue
+        // Increase the available size after removing a packet from the queue
+        _ejection_queue_free_flits[dst] += rp.ps;
+        --_ejected_packets;
+        --_ejected_class_packets[cl];
+        return rp;
+    }
+
+    static TrafficManagerWrapper::RetiredPacket NoPacket()
+    {
+        TrafficManagerWrapper::RetiredPacket rp = {-1, -1, -1, -1, 0, 0, 0, 0, 0, 0};
+        return rp;
+    }
+
     // This function must be called until it returns -1;
     // XXX: I belive that the best way is to declare a hash table in the caller to
     // map the PID (returning value) with the message type used in it.
     // E.g., in gem5 MsgPtr (or Message) so that way external info to BookSim can be
     // save with ease.
-    std::pair<Flit, Flit>
+    TrafficManagerWrapper::RetiredPacket
     TrafficManagerWrapper::RetirePacket()
     {
-        //std::cout << GetSimTime() << " TrafficManagerWrapper:RetirePacket" << std::endl;
         // XXX: in this implementation class 0 has priority
-        for (int cl=0; cl < _classes; cl++){
+        for (int cl=0; (cl < _classes) && (_ejected_packets > 0); cl++){
+            if(_ejected_class_packets[cl] == 0) {
+                continue;
+            }
             for (int dst=0; dst < _nodes; dst++)
             {
                 if(!_ejection_queue[cl][dst].empty()) {
-                    //Flit * head = _ejection_queue[cl][dst].front();
-                    pair<Flit,Flit> rp = _ejection_queue[cl][dst].front();
-                    //std::cout << GetSimTime() << " TrafficManagerWrapper:RetirePacket | Front pid: " << pid << std::endl;
-                    _ejection_queue[cl][dst].pop();
-                    //BSMOD: Add bounded ejection queue
-                    // Increase the available size after removing a packet from the queue
-                    _ejection_queue_free_flits[dst] += rp.first.packet_size;
-
-                    //Flit head = rp.first;
-                    //Flit tail = rp.second;
-
+                    RetiredPacket rp = _PopPacket(cl, dst);
+                    _CompactReady();
                     return rp;
                 }
             }
         }
-        Flit head = Flit();
-        head.pid = -1;
-        return make_pair(head, head);
+        return NoPacket();
     }
 
     //BSMOD: Retire for a host
-    std::pair<Flit, Flit>
+    TrafficManagerWrapper::RetiredPacket
     TrafficManagerWrapper::RetirePacket(int dst)
     {
         assert(dst >= 0 && dst < _nodes);
-        for (int cl=0; cl < _classes; cl++){
+        for (int cl=0; (cl < _classes) && (_ejected_packets > 0); cl++){
             if(!_ejection_queue[cl][dst].empty()) {
-                pair<Flit,Flit> rp = _ejection_queue[cl][dst].front();
-                _ejection_queue[cl][dst].pop();
-                //BSMOD: Add bounded ejection queue
-                // Increase the available size after removing a packet from the queue
-                _ejection_queue_free_flits[dst] += rp.first.packet_size;
+                RetiredPacket rp = _PopPacket(cl, dst);
+                _CompactReady();
                 return rp;
             }
         }
-        Flit head = Flit();
-        head.pid = -1;
-        return make_pair(head, head);
+        return NoPacket();
     }
 
-    std::pair<Flit, Flit>
+    TrafficManagerWrapper::RetiredPacket
     TrafficManagerWrapper::NextPacket(int dst)
     {
         assert(dst >= 0 && dst < _nodes);
-        for (int cl=0; cl < _classes; cl++){
+        for (int cl=0; (cl < _classes) && (_ejected_packets > 0); cl++){
             if(!_ejection_queue[cl][dst].empty()) {
-                pair<Flit,Flit> rp = _ejection_queue[cl][dst].front();
-                return rp;
+                return _ejection_queue[cl][dst].front().packet;
+            }
+        }
+        return NoPacket();
+    }
+
+    int
+    TrafficManagerWrapper::RetirePackets(function<void(RetiredPacket const &)> const & callback)
+    {
+        int retired = 0;
+        for(size_t i = 0; i < _ready.size(); ++i) {
+            ReadyPacket const & r = _ready[i];
+            queue<EjectedPacket> const & q = _ejection_queue[r.cl][r.dst];
+            // Queues are FIFO: if the front is younger, this packet was
+            // already taken by RetirePacket()
+            if(!q.empty() && (q.front().seq == r.seq)) {
+                callback(_PopPacket(r.cl, r.dst));
+                ++retired;
+            }
+        }
+        _ready.clear();
+        return retired;
+    }
+
+    // Drops the entries of _ready whose packets were already retired, so it
+    // does not grow when the host only uses RetirePacket()
+    void
+    TrafficManagerWrapper::_CompactReady()
+    {
+        if(_ejected_packets == 0) {
+            _ready.clear();
+            return;
+        }
+        if(_ready.size() < 2 * (size_t)_ejected_packets + 64) {
+            return;
+        }
+        size_t kept = 0;
+        for(size_t i = 0; i < _ready.size(); ++i) {
+            ReadyPacket const & r = _ready[i];
+            queue<EjectedPacket> const & q = _ejection_queue[r.cl][r.dst];
+            if(!q.empty() && (q.front().seq <= r.seq)) {
+                _ready[kept++] = r;
             }
         }
-        Flit head = Flit();
-        head.pid = -1;
-        return make_pair(head, head);
+        _ready.resize(kept);
     }
 
     void
@@ -209,6 +262,34 @@ namespace Booksim
         {
             _Step();
         }
+        _PrintPeriodicStats();
+    }
+
+    long long
+    TrafficManagerWrapper::NextEventCycle() const
+    {
+        return _NextEventCycle();
+    }
+
+    // Same as RunCycles(cycle - GetSimTime()), but the spans in which the
+    // network has nothing to do are jumped over instead of stepped
+    void
+    TrafficManagerWrapper::RunUntil(long long cycle)
+    {
+        while(_time < cycle) {
+            long long const next = _NextEventCycle();
+            if(next == _time) {
+                _Step();
+            } else {
+                _SkipTo(((next < 0) || (next > cycle)) ? cycle : next);
+            }
+        }
+        _PrintPeriodicStats();
+    }
+
+    void
+    TrafficManagerWrapper::_PrintPeriodicStats()
+    {
         if(_print_csv_results && _sample_period < GetSimTime() - _last_print)
         {
             std::cout << " Cur PID: " << _cur_pid << std::endl;
@@ -218,16 +299,16 @@ namespace Booksim
             DisplayOverallStats();
             _ClearStats();
 
-#ifdef TRACK_FLOWS
-            for(int subnet = 0; subnet < _subnets; ++subnet) {
-                for(int router = 0; router < _routers; ++router) {
-                    Router * const r = _router[subnet][router];
-                    for(int c = 0; c < _classes; ++c) {
-                        r->ResetFlowStats(c);
+            if(_flows.Enabled()) {
+                for(int subnet = 0; subnet < _subnets; ++subnet) {
+                    for(int router = 0; router < _routers; ++router) {
+                        Router * const r = _router[subnet][router];
+                        for(int c = 0; c < _classes; ++c) {
+                            r->ResetFlowStats(c);
+                        }
                     }
                 }
             }
-#endif // TRACK_FLOWS
 
             _last_print = GetSimTime();
         }
@@ -237,25 +318,12 @@ namespace Booksim
     bool
     TrafficManagerWrapper::CheckInFlightPackets()
     {
-        bool in_flight_packets = false;
+        // Packets waiting in the ejection queues
+        bool in_flight_packets = (_ejected_packets > 0);
         //*gWatchOut << __LINE__ << " In flight packets: " << in_flight_packets << " _classes: " << _classes << std::endl;
-        for (int cl=0; cl < _classes; cl++)
+        for (int cl=0; (cl < _classes) && !in_flight_packets; cl++)
         {
-            in_flight_packets |= !_total_in_flight_flits[cl].empty();
-            //*gWatchOut << __LINE__ << " In flight packets: " << in_flight_packets << std::endl;
-            
-            if (in_flight_packets) {
-                break;
-            }
-        
-            for (int dst=0; dst < _nodes; dst++)
-            {
-                in_flight_packets |= !_ejection_queue[cl][dst].empty();
-                if (in_flight_packets) {
-                    break;
-                }
-            }
-            
+            in_flight_packets |= !_total_in_flight_flits[cl].Empty();
         }
 
         return in_flight_packets;
@@ -280,9 +348,9 @@ namespace Booksim
         int cur_occupancy;
         //BSMOD: Evaluation of the number of injection queues is added
         if(_injection_queues == 1) {
-            cur_occupancy = _partial_packets[0][source].size();
+            cur_occupancy = _partial_packets[0][source].Size();
         } else {
-            cur_occupancy = _partial_packets[cl][source].size();
+            cur_occupancy = _partial_packets[cl][source].Size();
         }
         return _inj_size - cur_occupancy;
     }
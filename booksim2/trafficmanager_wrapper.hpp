@@ -31,7 +31,9 @@
 // TODO: Include necessary headers
 #include <vector>
 #include <queue>
+#include <functional>
 #include "trafficmanager.hpp"
+#include "booksim_wrapper.hpp"
 //#include "stats.hpp"
 
 namespace Booksim
@@ -47,8 +49,28 @@ namespace Booksim
             // Pure virtual method called by Run() in main.cpp
             virtual bool _SingleSim( ) { return true; }
 
+        public:
+            typedef BooksimWrapper::RetiredPacket RetiredPacket;
+
         private:
-            vector<vector<queue<pair<Flit,Flit>>>> _ejection_queue;
+            struct EjectedPacket {
+                long seq; // ejection order
+                RetiredPacket packet;
+            };
+            vector<vector<queue<EjectedPacket> > > _ejection_queue;
+            // (class, destination, seq) of the ejected packets in ejection
+            // order, drained by RetirePackets(). The entries of the packets
+            // taken by RetirePacket(dst) are skipped.
+            struct ReadyPacket {
+                int cl;
+                int dst;
+                long seq;
+            };
+            vector<ReadyPacket> _ready;
+            long _next_seq;
+            // Packets in the ejection queues, in total and per class
+            int _ejected_packets;
+            vector<int> _ejected_class_packets;
             //BSMOD: Add bounded ejection queue
             vector<int> _ejection_queue_free_flits;
             virtual bool _NodeCanConsume( int node );
@@ -56,6 +78,10 @@ namespace Booksim
 
             virtual void _RetirePacket(Flit * head, Flit * tail);
 
+            RetiredPacket _PopPacket(int cl, int dst);
+            void _CompactReady();
+            void _PrintPeriodicStats();
+
             //BSMOD: Change time to long long
             long long _last_print;
 
@@ -77,11 +103,15 @@ namespace Booksim
             bool CheckEjectionQueue();
             // TODO: check type of returning data
             //int RetirePacket();
-            pair<Flit,Flit> RetirePacket();
+            RetiredPacket RetirePacket();
             //BSMOD: Retire for a host
-            pair<Flit,Flit> RetirePacket(int destination);
-            pair<Flit,Flit> NextPacket(int destination);
+            RetiredPacket RetirePacket(int destination);
+            RetiredPacket NextPacket(int destination);
+            // Retires every ejected packet in ejection order
+            int RetirePackets(function<void(RetiredPacket const &)> const & callback);
             void RunCycles(int cycles);
+            long long NextEventCycle() const;
+            void RunUntil(long long cycle);
             bool CheckInFlightPackets();
             void ClearStats();
             void UpdateSimTime(int cycles);
@@ -83,6 +83,7 @@ namespace Booksim
     void VC::AddFlit( Flit *f )
     {
       assert(f);
+      f->CheckLive();
 
       // Check that the trail flits are written in sequence.
      
@@ -150,7 +151,7 @@ namespace Booksim
     void VC::SetRouteSet( OutputSet * output_set )
     {
       _route_set = output_set;
-      //    set<OutputSet::sSetElement> const route = output_set->GetSet();
+      //    OutputSet::ElementList const route = output_set->GetSet();
       //    for(auto route_iter : route) {
       //  *gWatchOut << "VC:SetRouteSet " << FullName() << " cycle " << GetSimTime() << " ptr: " << output_set << " output port: " << route_iter.output_port << std::endl;
       //    }
@@ -158,6 +159,12 @@ namespace Booksim
       _out_vc = -1;
     }
 
+    void VC::CopyRouteSet( OutputSet const & output_set )
+    {
+      _la_route_set = output_set;
+      SetRouteSet(&_la_route_set);
+    }
+
     void VC::SetOutput( int port, int vc )
     {
       //std::cout << "VC:SetOutput " << FullName() << " port " << port << " vc "  << " cycle " << GetSimTime() << vc << std::endl;
@@ -60,6 +60,9 @@ namespace Booksim
 
             // Output port + VC range
             OutputSet *_route_set;
+            // Route set copied from a lookahead, which is freed before the
+            // flit it announces arrives
+            OutputSet _la_route_set;
             // ???
             int _out_port, _out_vc;
             //BSMOD: Change flit and packet id to long
@@ -130,6 +133,8 @@ namespace Booksim
             const OutputSet *GetRouteSet( ) const;
             // Set route set of the leading flit
             void SetRouteSet( OutputSet * output_set );
+            // Set route set of the leading flit from a copy of the lookahead's one
+            void CopyRouteSet( OutputSet const & output_set );
 
             // Set output (output port and output vc) of the leading flit
             void SetOutput( int port, int vc );
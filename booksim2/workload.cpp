@@ -27,6 +27,11 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "workload.hpp"
 #include "random_utils.hpp"
@@ -162,6 +167,13 @@ namespace Booksim
       }
     }
 
+    void Workload::skipCycles(long cycles)
+    {
+      for(long i = 0; i < cycles; ++i) {
+        advanceTime();
+      }
+    }
+
     bool Workload::empty() const
     {
       return _pending_nodes.empty();
@@ -313,13 +325,16 @@ namespace Booksim
                      vector<int> const & packet_sizes, 
                      int limit, unsigned int skip, unsigned int scale)
       : Workload(nodes), 
-        _packet_sizes(packet_sizes), _limit(limit), _scale(scale), _skip(skip)
+        _packet_sizes(packet_sizes), _trace(NULL), _map(NULL), _map_size(0),
+        _records(NULL), _num_records(0), _limit(limit), _scale(scale), _skip(skip)
     {
       _ready_packets.resize(nodes);
-      _trace = new ifstream(filename.c_str());
-      if(!_trace->is_open()) {
-        cerr << "Unable to open trace file: " << filename << endl;
-        exit(-1);
+      if(!_OpenBinary(filename)) {
+        _trace = new ifstream(filename.c_str());
+        if(!_trace->is_open()) {
+          cerr << "Unable to open trace file: " << filename << endl;
+          exit(-1);
+        }
       }
     }
 
@@ -331,15 +346,87 @@ namespace Booksim
         }
         delete _trace;
       }
+      if(_map) {
+        munmap(_map, _map_size);
+      }
+    }
+
+    // Records whose pages are requested ahead of the reader
+    static unsigned long long const trace_prefetch_records = 1 << 16;
+
+    bool TraceWorkload::_OpenBinary(string const & filename)
+    {
+      static char const magic[8] = {'B', 'S', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+      int const fd = open(filename.c_str(), O_RDONLY);
+      if(fd < 0) {
+        return false;
+      }
+      struct stat st;
+      BinaryTraceHeader header;
+      if((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(header)) ||
+         (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) ||
+         memcmp(header.magic, magic, sizeof(magic))) {
+        close(fd);
+        return false;
+      }
+      if((header.version != 1) || (header.record_size != sizeof(BinaryTraceRecord)) ||
+         ((size_t)st.st_size < sizeof(header) + header.records * sizeof(BinaryTraceRecord))) {
+        cerr << "Invalid binary trace file: " << filename << endl;
+        exit(-1);
+      }
+      _map_size = (size_t)st.st_size;
+      _map = mmap(NULL, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if(_map == MAP_FAILED) {
+        cerr << "Unable to map trace file: " << filename << endl;
+        exit(-1);
+      }
+      madvise(_map, _map_size, MADV_SEQUENTIAL);
+      _records = (BinaryTraceRecord const *)((char const *)_map + sizeof(header));
+      _num_records = header.records;
+      return true;
+    }
+
+    bool TraceWorkload::_ReadRecord(int & delay, int & source, int & dest, int & type)
+    {
+      if(!_map) {
+        if(_trace->eof()) {
+          return false;
+        }
+        *_trace >> delay >> source >> dest >> type;
+        // Trailing whitespace makes the last read fail instead of eof()
+        return !_trace->fail();
+      }
+      if(_next_record >= _num_records) {
+        return false;
+      }
+      if(_next_record >= _prefetched) {
+        // Ask for the pages of the next batch of records ahead of time
+        size_t const page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t begin = (char const *)(_records + _next_record) - (char const *)_map;
+        begin -= begin % page;
+        _prefetched = min(_next_record + trace_prefetch_records, _num_records);
+        size_t const end = (char const *)(_records + _prefetched) - (char const *)_map;
+        madvise((char *)_map + begin, end - begin, MADV_WILLNEED);
+      }
+      BinaryTraceRecord const & record = _records[_next_record++];
+      assert(record.time >= _last_time);
+      delay = (int)(record.time - _last_time);
+      _last_time = record.time;
+      source = record.source;
+      dest = record.dest;
+      type = record.type;
+      return true;
     }
 
     void TraceWorkload::_refill()
     {
       unsigned long time = _time;
-      while(((_limit < 0) || (_count < (unsigned int)_limit)) && !_trace->eof()) {
+      int delay, source, dest, type;
+      while(((_limit < 0) || (_count < (unsigned int)_limit)) &&
+            _ReadRecord(delay, source, dest, type)) {
         ++_count;
-        int delay, source, dest, type;
-        *_trace >> delay >> source >> dest >> type;
         assert(delay >= 0);
         assert((source >= 0) && (source < _nodes));
         assert((dest >= 0) && (dest < _nodes));
@@ -368,15 +455,22 @@ namespace Booksim
     {
       Workload::reset();
       _time = 0;
-      _trace->seekg(0);
-      unsigned int count = 0;
-      while((count < _skip) && !_trace->eof()) {
-        ++count;
-        int delay, source, dest, type;
-        *_trace >> delay >> source >> dest >> type;
-        assert(delay >= 0);
-        assert((source >= 0) && (source < _nodes));
-        assert((dest >= 0) && (dest < _nodes));
+      if(_map) {
+        // Skipped records do not add to the time of the first one played
+        _next_record = min((unsigned long long)_skip, _num_records);
+        _last_time = _next_record ? _records[_next_record - 1].time : 0;
+        _prefetched = _next_record;
+      } else {
+        _trace->seekg(0);
+        unsigned int count = 0;
+        while((count < _skip) && !_trace->eof()) {
+          ++count;
+          int delay, source, dest, type;
+          *_trace >> delay >> source >> dest >> type;
+          assert(delay >= 0);
+          assert((source >= 0) && (source < _nodes));
+          assert((dest >= 0) && (dest < _nodes));
+        }
       }
       _count = 0;
       _next_source = -1;
@@ -404,6 +498,27 @@ namespace Booksim
       }
     }
 
+    long TraceWorkload::idleCycles() const
+    {
+      if(!_pending_nodes.empty() || !_deferred_nodes.empty()) {
+        return 0;
+      }
+      if(_next_source < 0) {
+        return -1;
+      }
+      assert(_next_packet.time > _time);
+      return (long)((_next_packet.time - _time + _scale - 1) / _scale);
+    }
+
+    void TraceWorkload::skipCycles(long cycles)
+    {
+      assert(cycles > 0);
+      assert((idleCycles() < 0) || (cycles <= idleCycles()));
+      // Nothing happens before the last call
+      _time += (unsigned long)(cycles - 1) * _scale;
+      advanceTime();
+    }
+
     bool TraceWorkload::completed() const
     {
       return (_pending_nodes.empty() && _deferred_nodes.empty() && 
@@ -837,6 +952,41 @@ namespace Booksim
       }
     }
 
+    /*! Returns the calls to advanceTime() until the next queued or waiting
+     *  packet is due. Stalled packets only wake up when a packet retires.*/
+    long NetraceWorkload::idleCycles() const
+    {
+      if(!_pending_nodes.empty() || !_deferred_nodes.empty() || 
+         !_check_packets.empty()) {
+        return 0;
+      }
+      bool event = false;
+      unsigned long long int time = 0;
+      if(!_future_packets.empty()) {
+        event = true;
+        time = _future_packets.front()->cycle;
+      }
+      if(_next_packet) {
+        // Waiting packets are queued as soon as they enter the window
+        unsigned long long int const next = _enforce_lats ? 
+          (_next_packet->cycle - _window_size + 1) : _next_packet->cycle;
+        time = event ? min(time, next) : next;
+        event = true;
+      }
+      if(!event) {
+        return -1;
+      }
+      assert(time > _time);
+      return (long)((time - _time + _scale - 1) / _scale);
+    }
+
+    void NetraceWorkload::skipCycles(long cycles)
+    {
+      assert(cycles > 0);
+      assert((idleCycles() < 0) || (cycles <= idleCycles()));
+      _time += (unsigned long long int)(cycles - 1) * _scale;
+      advanceTime();
+    }
 
     /*! Returns true when there are not more packets in the trace to inject*/
     bool NetraceWorkload::completed() const
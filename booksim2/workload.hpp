@@ -60,6 +60,12 @@ namespace Booksim
                 Configuration const * const config = NULL);
       virtual void reset();
       virtual void advanceTime();
+      // Calls to advanceTime() until (and including) the one that may make a
+      // node pending; 0 if unknown, -1 if no node will ever be pending again
+      virtual long idleCycles() const {return 0;}
+      // Same as calling advanceTime() cycles times; must not be called past
+      // idleCycles()
+      virtual void skipCycles(long cycles);
       virtual bool empty() const;
       virtual bool completed() const = 0;
       virtual int source() const;
@@ -134,6 +140,36 @@ namespace Booksim
       vector<queue<PacketInfo> > _ready_packets;
 
       ifstream * _trace;
+
+      // Binary traces (scripts/util/trace_convert.py) are mapped into memory.
+      // Records have a fixed size and hold the absolute injection cycle, so
+      // skip and limit jump straight to the right record.
+#pragma pack(push,1)
+      struct BinaryTraceHeader {
+        char magic[8];
+        unsigned int version;
+        unsigned int record_size;
+        unsigned long long records;
+        unsigned long long reserved;
+      };
+      struct BinaryTraceRecord {
+        unsigned long long time;
+        int source;
+        int dest;
+        int type;
+      };
+#pragma pack(pop)
+
+      void * _map;
+      size_t _map_size;
+      BinaryTraceRecord const * _records;
+      unsigned long long _num_records;
+      unsigned long long _next_record;
+      unsigned long long _prefetched;
+      unsigned long long _last_time;
+
+      bool _OpenBinary(string const & filename);
+      bool _ReadRecord(int & delay, int & source, int & dest, int & type);
       
       unsigned int _count;
       int _limit;
@@ -152,6 +188,8 @@ namespace Booksim
       virtual ~TraceWorkload();
       virtual void reset();
       virtual void advanceTime();
+      virtual long idleCycles() const;
+      virtual void skipCycles(long cycles);
       virtual bool completed() const;
       virtual int dest() const;
       virtual int size() const;
@@ -217,6 +255,8 @@ namespace Booksim
       virtual ~NetraceWorkload();
       virtual void reset();
       virtual void advanceTime();
+      virtual long idleCycles() const;
+      virtual void skipCycles(long cycles);
       virtual bool completed() const;
       virtual int dest() const;
       virtual int size() const;
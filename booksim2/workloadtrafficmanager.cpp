@@ -64,7 +64,7 @@ namespace Booksim
         Workload * const wl = _workload[c];
         while(!wl->empty()) {
           int const source = wl->source();
-          if(_partial_packets[c][source].empty()) {
+          if(_partial_packets[c][source].Empty()) {
         ++_requests_outstanding[c][source];
         ++_packet_seq_no[c][source];
         int const dest = wl->dest();
@@ -99,6 +99,35 @@ namespace Booksim
       }
     }
 
+    long WorkloadTrafficManager::_IdleCycles( ) const
+    {
+      if(_empty_network) {
+        // The workloads are not advanced at all
+        return -1;
+      }
+      long idle = -1;
+      for(int c = 0; c < _classes; ++c) {
+        long const cycles = _workload[c]->idleCycles();
+        if(cycles == 0) {
+          return 0;
+        }
+        if((cycles > 0) && ((idle < 0) || (cycles < idle))) {
+          idle = cycles;
+        }
+      }
+      return idle;
+    }
+
+    void WorkloadTrafficManager::_SkipCycles( long cycles )
+    {
+      if(_empty_network) {
+        return;
+      }
+      for(int c = 0; c < _classes; ++c) {
+        _workload[c]->skipCycles(cycles);
+      }
+    }
+
     bool WorkloadTrafficManager::_SingleSim( )
     {
       _sim_state = warming_up;
@@ -110,7 +139,7 @@ namespace Booksim
         
         while(_time < _warmup_periods * _sample_period) {
           
-          _Step();
+          _Advance((_time / _sample_period + 1) * _sample_period);
           
           if((_time % _sample_period) == 0) {
         UpdateStats();
@@ -134,7 +163,8 @@ namespace Booksim
         ((_max_samples < 0) || 
          (_time < (_warmup_periods + _max_samples) * _sample_period))) {
         
-        _Step();
+        // Never jumps over the end of a sample period
+        _Advance((_time / _sample_period + 1) * _sample_period);
         
         if((_time % _sample_period) == 0) {
           UpdateStats();
@@ -155,7 +185,7 @@ namespace Booksim
     {
       for(int c = 0; c < _classes; ++c) {
         if(_measure_stats[c] &&
-           (!_workload[c]->completed() || !_measured_in_flight_flits[c].empty())) {
+           (!_workload[c]->completed() || !_measured_in_flight_flits[c].Empty())) {
           return false;
         }
       }
@@ -55,6 +55,9 @@ namespace Booksim
       virtual void _ResetSim( );
       virtual bool _SingleSim( );
 
+      virtual long _IdleCycles( ) const;
+      virtual void _SkipCycles( long cycles );
+
       bool _Completed( );
 
       virtual void _UpdateOverallStats( );
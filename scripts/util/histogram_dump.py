@@ -0,0 +1,159 @@
+#!/usr/bin/python
+
+# Copyright (c) 2014-2020, University of Cantabria
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+# Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+# Reads the binary latency histograms written by BookSim (histogram_out)
+# and prints the samples, average and percentiles of each of them.
+# Histograms with the same name (e.g. the same stat of several simulations
+# or dump files) are merged.
+
+# Usage: ./histogram_dump.py <histogram_file>... [-m <name_regex>]
+# With -m, the histograms whose name contains a match of the regex are
+# merged into a single one (e.g. -m "pair_plat_stat_0_" for all the pairs).
+
+import re
+import struct
+import sys
+from math import ceil
+
+LINEAR = 0
+
+class Histogram:
+    def __init__(self, name, hist_type, precision, bin_size, num_bins):
+        self.name = name
+        self.hist_type = hist_type
+        self.precision = precision
+        self.bin_size = bin_size
+        self.num_bins = num_bins
+        self.samples = 0
+        self.total = 0.0
+        self.minimum = float('nan')
+        self.maximum = float('nan')
+        self.bins = dict()
+
+    def merge(self, other):
+        assert (self.hist_type, self.precision, self.bin_size, self.num_bins) == \
+            (other.hist_type, other.precision, other.bin_size, other.num_bins)
+        self.samples += other.samples
+        self.total += other.total
+        # NOTE: min/max skip NaN values, like Stats::Merge()
+        self.minimum = min(v for v in (self.minimum, other.minimum, float('inf')) if v == v)
+        self.maximum = max(v for v in (self.maximum, other.maximum, float('-inf')) if v == v)
+        for b, count in other.bins.items():
+            self.bins[b] = self.bins.get(b, 0) + count
+
+    def bin_top(self, b):
+        if self.hist_type == LINEAR:
+            return (b + 1) * self.bin_size
+        sub = 1 << self.precision
+        if b < sub:
+            return b
+        shift = b // sub - 1
+        return ((sub + b % sub) << shift) + (1 << shift) - 1
+
+    # Same definition as Stats::Percentile()
+    def percentile(self, p):
+        if self.samples == 0:
+            return float('nan')
+        rank = max(ceil(p / 100.0 * self.samples), 1)
+        seen = 0
+        for b in sorted(self.bins):
+            seen += self.bins[b]
+            if seen >= rank:
+                if self.hist_type == LINEAR and b == self.num_bins - 1:
+                    return self.maximum
+                return min(max(self.bin_top(b), self.minimum), self.maximum)
+        return self.maximum
+
+
+def read(f, fmt):
+    size = struct.calcsize(fmt)
+    data = f.read(size)
+    if len(data) < size:
+        raise EOFError
+    return struct.unpack(fmt, data)
+
+
+def load(file_name, histograms):
+    with open(file_name, 'rb') as f:
+        while True:
+            magic = f.read(4)
+            if not magic:
+                return
+            if magic != b'BSH1':
+                sys.exit("Error: " + file_name + " is not a BookSim histogram dump")
+            (name_len,) = read(f, '=I')
+            name = f.read(name_len).decode()
+            hist_type, precision, bin_size, num_bins = read(f, '=BBdi')
+            h = Histogram(name, hist_type, precision, bin_size, num_bins)
+            h.samples, h.total, _, h.minimum, h.maximum = read(f, '=qdddd')
+            (used,) = read(f, '=I')
+            for _ in range(used):
+                b, count = read(f, '=II')
+                h.bins[b] = count
+            if name in histograms:
+                histograms[name].merge(h)
+            else:
+                histograms[name] = h
+
+
+def show(h):
+    avg = h.total / h.samples if h.samples else float('nan')
+    print("%s: samples = %d avg = %g min = %g max = %g p50 = %g p99 = %g p99.9 = %g"
+          % (h.name, h.samples, avg, h.minimum, h.maximum,
+             h.percentile(50.0), h.percentile(99.0), h.percentile(99.9)))
+
+
+def main():
+    args = sys.argv[1:]
+    pattern = None
+    if "-m" in args:
+        i = args.index("-m")
+        pattern = re.compile(args[i + 1])
+        del args[i:i + 2]
+    if not args:
+        sys.exit("Usage: " + sys.argv[0] + " <histogram_file>... [-m <name_regex>]")
+
+    histograms = dict()
+    for file_name in args:
+        load(file_name, histograms)
+
+    merged = None
+    for name in sorted(histograms):
+        h = histograms[name]
+        if pattern and pattern.search(name):
+            if merged is None:
+                merged = Histogram(pattern.pattern, h.hist_type, h.precision,
+                                   h.bin_size, h.num_bins)
+            merged.merge(h)
+            continue
+        show(h)
+    if merged is not None:
+        show(merged)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/bash
+
+# Copyright (c) 2014-2020, University of Cantabria
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+# Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# Author: Ivan Perez
+
+# This script measures the simulation speed (simulated cycles per second) of
+# one or more BookSim binaries on the same configuration, e.g. to compare a
+# build before and after a change. Each binary runs <runs> times and the best
+# speed is reported, which filters out most of the noise of a shared machine.
+
+# Usage: ./simulation_speed.sh <cfg_file> <runs> <booksim_binary>... [-- <option>...]
+# Example: ./simulation_speed.sh ../../examples/8x8_mesh_IQ.cfg 5 ./booksim_old ../../booksim2/booksim
+
+CONFIG_FILE=$1
+RUNS=$2
+shift 2
+
+BINARIES=()
+while [ $# -gt 0 ] && [ "$1" != "--" ];
+do
+    BINARIES+=("$1")
+    shift
+done
+[ "$1" == "--" ] && shift
+
+for binary in "${BINARIES[@]}";
+do
+    best=0
+    for run in $(seq ${RUNS});
+    do
+        speed=$(${binary} ${CONFIG_FILE} "$@" 2>&1 >/dev/null \
+            | grep "Simulated cycles per second" | awk '{print $NF}')
+        best=$(echo "${speed} ${best}" | awk '{print ($1 > $2) ? $1 : $2}')
+    done
+    echo "${binary}: ${best} cycles/s"
+done
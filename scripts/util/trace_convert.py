@@ -0,0 +1,127 @@
+#!/usr/bin/python
+
+# Copyright (c) 2014-2020, University of Cantabria
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+# Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+# Converts a trace for the trace() workload, or a netrace trace, into the
+# binary trace format that TraceWorkload maps into memory.
+#
+# Text traces have one "delay source dest type" record per line. Netrace
+# packets keep their cycle, source and destination; their type becomes 0 for
+# 8-byte (control) packets and 1 for 72-byte (data) packets, so they are
+# replayed with e.g. trace(file.btr,{1,5}). Dependencies are dropped.
+#
+# Binary format (little endian): a 32-byte header (magic "BSTRACE\0",
+# version, record size, number of records, reserved) followed by 20-byte
+# records (absolute cycle, source, dest, type).
+
+# Usage: ./trace_convert.py <input trace> <output file>
+# Netrace traces (bzip2 compressed) are detected automatically.
+
+import bz2
+import struct
+import sys
+
+HEADER = struct.Struct('<8sIIQQ')
+RECORD = struct.Struct('<Qiii')
+MAGIC = b'BSTRACE\0'
+
+# Packet sizes in bytes of the netrace packet types (-1: invalid type)
+NT_PACKET_SIZES = [-1, 8, 72, 72, 72, 8, 72, -1, -1, -1, -1, -1, -1, 8, 8, 8,
+                   72, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 8, 8, 8, 72]
+NT_MAGIC = 0x484A5455
+NT_HEADER = struct.Struct('<If30sBBQQII8s')
+NT_REGION = struct.Struct('<QQQ')
+NT_PACKET = struct.Struct('<QIIBBBBB')
+
+
+def read(f, s):
+    data = f.read(s.size)
+    if not data:
+        return None
+    if len(data) < s.size:
+        sys.exit("Error: truncated trace file")
+    return s.unpack(data)
+
+
+def text_records(file_name):
+    time = 0
+    with open(file_name) as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+            delay, source, dest, ptype = (int(v) for v in fields[:4])
+            time += delay
+            yield time, source, dest, ptype
+
+
+def netrace_records(file_name):
+    with bz2.open(file_name, 'rb') as f:
+        header = read(f, NT_HEADER)
+        if header is None or header[0] != NT_MAGIC:
+            sys.exit("Error: " + file_name + " is not a netrace trace")
+        notes_length, num_regions = header[7], header[8]
+        if 0 < notes_length < 8192:
+            f.read(notes_length)
+        for _ in range(num_regions):
+            read(f, NT_REGION)
+        while True:
+            packet = read(f, NT_PACKET)
+            if packet is None:
+                return
+            cycle, _, _, ptype, source, dest, _, num_deps = packet
+            f.read(4 * num_deps)
+            size = NT_PACKET_SIZES[ptype] if ptype < len(NT_PACKET_SIZES) else -1
+            yield cycle, source, dest, (-1 if size < 0 else (0 if size == 8 else 1))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("Usage: " + sys.argv[0] + " <input trace> <output file>")
+    in_name, out_name = sys.argv[1:]
+    with open(in_name, 'rb') as f:
+        netrace = f.read(3) == b'BZh'
+    records = netrace_records(in_name) if netrace else text_records(in_name)
+
+    count = 0
+    with open(out_name, 'wb') as out:
+        out.write(HEADER.pack(MAGIC, 1, RECORD.size, 0, 0))
+        batch = []
+        for record in records:
+            batch.append(RECORD.pack(*record))
+            if len(batch) == 65536:
+                out.write(b''.join(batch))
+                count += len(batch)
+                batch = []
+        out.write(b''.join(batch))
+        count += len(batch)
+        out.seek(0)
+        out.write(HEADER.pack(MAGIC, 1, RECORD.size, count, 0))
+    print("%d records written to %s" % (count, out_name))
+
+
+if __name__ == "__main__":
+    main()